@@ -62,8 +62,8 @@ void set_decode_white_item_name(::WhiteItem &item, const name_fn &write_name) {
     }
     auto name     = Name{};
     const auto &w = *reinterpret_cast<name_fn *>(*arg);
-    // the 0x00 in the end?
-    name.name.resize(stream->bytes_left + 1);
+    // std::string keeps its own zero terminator
+    name.name.resize(stream->bytes_left);
     if (!pb_read(stream, reinterpret_cast<pb_byte_t *>(name.name.data()), stream->bytes_left)) {
       LOG_ERR("white_list", "failed to read name");
       return false;
@@ -148,14 +148,17 @@ bool marshal_white_list_response(pb_ostream_t *ostream, ::WhiteListResponse &pb_
 /**
  * @brief Get the tag from istream without mutating it. Useful for oneof.
  * @param istream the stream to get tag from (usually is a parameter from a decode callback)
+ * @return the tag, 0 (which is never a valid tag) if failed to decode
  */
 uint32_t pb_get_tag(pb_istream_t *istream) {
   pb_wire_type_t wire_type;
-  uint32_t tag;
+  uint32_t tag = 0;
   // `pb_decode_tag` will mutate the original stream, create a copy
   pb_istream_t s_copy = *istream;
-  bool eof;
-  pb_decode_tag(&s_copy, &wire_type, &tag, &eof);
+  bool eof            = false;
+  if (!pb_decode_tag(&s_copy, &wire_type, &tag, &eof)) {
+    return 0;
+  }
   return tag;
 }
 
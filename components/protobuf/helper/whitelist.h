@@ -7,7 +7,7 @@
 
 #include <variant>
 #include <string>
-#include <regex>
+#include <vector>
 #include <etl/array.h>
 #include <etl/optional.h>
 #include <ble.pb.h>
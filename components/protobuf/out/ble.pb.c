@@ -15,6 +15,9 @@ PB_BIND(WhiteList, WhiteList, AUTO)
 PB_BIND(bluetooth_device_pb, bluetooth_device_pb, AUTO)
 
 
+PB_BIND(scan_result_pb, scan_result_pb, AUTO)
+
+
 PB_BIND(WhiteListResponse, WhiteListResponse, AUTO)
 
 
@@ -41,6 +41,11 @@ typedef struct _bluetooth_device_pb {
     char name[21];
 } bluetooth_device_pb;
 
+/* the devices seen in a while, packed into a notification */
+typedef struct _scan_result_pb {
+    pb_callback_t devices;
+} scan_result_pb;
+
 typedef struct _WhiteListResponse {
     bool has_list;
     WhiteList list;
@@ -79,11 +84,13 @@ extern "C" {
 #define WhiteItem_init_default                   {0, {{{NULL}, NULL}}}
 #define WhiteList_init_default                   {{{NULL}, NULL}}
 #define bluetooth_device_pb_init_default         {{{NULL}, NULL}, ""}
+#define scan_result_pb_init_default              {{{NULL}, NULL}}
 #define WhiteListResponse_init_default           {false, WhiteList_init_default, _WhiteListErrorCode_MIN}
 #define WhiteListRequest_init_default            {_WhiteListCommand_MIN, false, WhiteList_init_default}
 #define WhiteItem_init_zero                      {0, {{{NULL}, NULL}}}
 #define WhiteList_init_zero                      {{{NULL}, NULL}}
 #define bluetooth_device_pb_init_zero            {{{NULL}, NULL}, ""}
+#define scan_result_pb_init_zero                 {{{NULL}, NULL}}
 #define WhiteListResponse_init_zero              {false, WhiteList_init_zero, _WhiteListErrorCode_MIN}
 #define WhiteListRequest_init_zero               {_WhiteListCommand_MIN, false, WhiteList_init_zero}
 
@@ -93,6 +100,7 @@ extern "C" {
 #define WhiteList_items_tag                      1
 #define bluetooth_device_pb_mac_tag              1
 #define bluetooth_device_pb_name_tag             2
+#define scan_result_pb_devices_tag               1
 #define WhiteListResponse_list_tag               1
 #define WhiteListResponse_code_tag               2
 #define WhiteListRequest_command_tag             1
@@ -117,6 +125,12 @@ X(a, STATIC,   SINGULAR, STRING,   name,              2)
 #define bluetooth_device_pb_CALLBACK pb_default_field_callback
 #define bluetooth_device_pb_DEFAULT NULL
 
+#define scan_result_pb_FIELDLIST(X, a) \
+X(a, CALLBACK, REPEATED, MESSAGE,  devices,           1)
+#define scan_result_pb_CALLBACK pb_default_field_callback
+#define scan_result_pb_DEFAULT NULL
+#define scan_result_pb_devices_MSGTYPE bluetooth_device_pb
+
 #define WhiteListResponse_FIELDLIST(X, a) \
 X(a, STATIC,   OPTIONAL, MESSAGE,  list,              1) \
 X(a, STATIC,   SINGULAR, UENUM,    code,              2)
@@ -134,6 +148,7 @@ X(a, STATIC,   OPTIONAL, MESSAGE,  set,               2)
 extern const pb_msgdesc_t WhiteItem_msg;
 extern const pb_msgdesc_t WhiteList_msg;
 extern const pb_msgdesc_t bluetooth_device_pb_msg;
+extern const pb_msgdesc_t scan_result_pb_msg;
 extern const pb_msgdesc_t WhiteListResponse_msg;
 extern const pb_msgdesc_t WhiteListRequest_msg;
 
@@ -141,6 +156,7 @@ extern const pb_msgdesc_t WhiteListRequest_msg;
 #define WhiteItem_fields &WhiteItem_msg
 #define WhiteList_fields &WhiteList_msg
 #define bluetooth_device_pb_fields &bluetooth_device_pb_msg
+#define scan_result_pb_fields &scan_result_pb_msg
 #define WhiteListResponse_fields &WhiteListResponse_msg
 #define WhiteListRequest_fields &WhiteListRequest_msg
 
@@ -148,6 +164,7 @@ extern const pb_msgdesc_t WhiteListRequest_msg;
 /* WhiteItem_size depends on runtime parameters */
 /* WhiteList_size depends on runtime parameters */
 /* bluetooth_device_pb_size depends on runtime parameters */
+/* scan_result_pb_size depends on runtime parameters */
 /* WhiteListResponse_size depends on runtime parameters */
 /* WhiteListRequest_size depends on runtime parameters */
 
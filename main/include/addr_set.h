@@ -0,0 +1,218 @@
+#ifndef BLE_LORA_ADAPTER_ADDR_SET_H
+#define BLE_LORA_ADAPTER_ADDR_SET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace addr_set {
+constexpr size_t ADDR_SIZE = 6;
+
+/**
+ * @brief a 48-bit address in the lower bits
+ */
+constexpr uint64_t pack(const uint8_t *addr) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < ADDR_SIZE; ++i) {
+    v = v << 8 | addr[i];
+  }
+  return v;
+}
+
+constexpr void unpack(uint64_t v, uint8_t *addr) {
+  for (size_t i = ADDR_SIZE; i > 0; --i) {
+    addr[i - 1] = static_cast<uint8_t>(v);
+    v >>= 8;
+  }
+}
+
+/**
+ * @brief a 64-bit integer hash with good avalanche (SplitMix64 finalizer)
+ */
+constexpr uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+/**
+ * @brief a set of BLE addresses with open addressing (linear probing), in
+ *        fixed memory
+ *
+ * `contains` hashes the address and probes a couple of slots on average,
+ * since the load factor is kept at most 1/2.
+ *
+ * @tparam Slots a power of two; holds at most `Slots / 2` addresses
+ * @note no removal; build a new set instead
+ */
+template <size_t Slots>
+class AddrSet {
+  static_assert(Slots >= 2 && (Slots & (Slots - 1)) == 0, "Slots should be a power of two");
+  // never a 48-bit address
+  static constexpr uint64_t EMPTY = UINT64_MAX;
+  std::array<uint64_t, Slots> slots{};
+  size_t _size = 0;
+
+  [[nodiscard]] constexpr size_t find(uint64_t v) const {
+    auto i = static_cast<size_t>(mix64(v)) & (Slots - 1);
+    while (slots[i] != EMPTY && slots[i] != v) {
+      i = (i + 1) & (Slots - 1);
+    }
+    return i;
+  }
+
+public:
+  static constexpr size_t max_size = Slots / 2;
+
+  constexpr AddrSet() {
+    slots.fill(EMPTY);
+  }
+
+  /**
+   * @return false if the set is full
+   */
+  constexpr bool insert(const uint8_t *addr) {
+    const auto v = pack(addr);
+    const auto i = find(v);
+    if (slots[i] == v) {
+      return true;
+    }
+    if (_size >= max_size) {
+      return false;
+    }
+    slots[i] = v;
+    _size += 1;
+    return true;
+  }
+
+  [[nodiscard]] constexpr bool contains(const uint8_t *addr) const {
+    const auto v = pack(addr);
+    return slots[find(v)] == v;
+  }
+
+  constexpr void clear() {
+    slots.fill(EMPTY);
+    _size = 0;
+  }
+
+  [[nodiscard]] constexpr size_t size() const {
+    return _size;
+  }
+
+  [[nodiscard]] constexpr bool empty() const {
+    return _size == 0;
+  }
+
+  /**
+   * @brief call `f` with each address (a `const uint8_t *` of `ADDR_SIZE` bytes), in no particular order
+   */
+  template <typename F>
+  constexpr void for_each(F &&f) const {
+    for (const auto v : slots) {
+      if (v != EMPTY) {
+        uint8_t addr[ADDR_SIZE] = {0};
+        unpack(v, addr);
+        f(static_cast<const uint8_t *>(addr));
+      }
+    }
+  }
+
+  /**
+   * @brief the addresses one after another
+   */
+  [[nodiscard]] constexpr size_t blob_size() const {
+    return _size * ADDR_SIZE;
+  }
+
+  /**
+   * @return the size written, 0 if `buffer` is too small
+   */
+  constexpr size_t to_blob(std::span<uint8_t> buffer) const {
+    if (buffer.size() < blob_size()) {
+      return 0;
+    }
+    size_t offset = 0;
+    for_each([&](const uint8_t *addr) {
+      for (size_t i = 0; i < ADDR_SIZE; ++i) {
+        buffer[offset++] = addr[i];
+      }
+    });
+    return offset;
+  }
+
+  /**
+   * @brief replace the content with the addresses in `blob`
+   * @return false if `blob` is malformed or has too many addresses
+   */
+  constexpr bool from_blob(std::span<const uint8_t> blob) {
+    clear();
+    if (blob.size() % ADDR_SIZE != 0) {
+      return false;
+    }
+    for (size_t offset = 0; offset < blob.size(); offset += ADDR_SIZE) {
+      if (!insert(blob.data() + offset)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+namespace static_tests {
+  constexpr uint8_t a[ADDR_SIZE] = {0xc0, 0x11, 0x22, 0x33, 0x44, 0x55};
+  constexpr uint8_t b[ADDR_SIZE] = {0xc0, 0x11, 0x22, 0x33, 0x44, 0x56};
+  constexpr uint8_t z[ADDR_SIZE] = {0, 0, 0, 0, 0, 0};
+  constexpr uint8_t f[ADDR_SIZE] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+  static_assert(pack(a) == 0xc01122334455ull);
+  static_assert([] {
+    uint8_t out[ADDR_SIZE] = {0};
+    unpack(pack(b), out);
+    return out[0] == 0xc0 && out[5] == 0x56;
+  }());
+
+  static_assert([] {
+    auto s = AddrSet<4>{};
+    bool ok = s.insert(a) && s.insert(z) && s.insert(a);
+    // full at half of the slots
+    ok = ok && !s.insert(f) && s.size() == 2;
+    return ok && s.contains(a) && s.contains(z) && !s.contains(b) && !s.contains(f);
+  }());
+
+  // every address is found after collisions and wrap-around
+  static_assert([] {
+    auto s = AddrSet<64>{};
+    for (uint8_t i = 0; i < 32; ++i) {
+      const uint8_t addr[ADDR_SIZE] = {0xc0, 0, 0, 0, 0, i};
+      if (!s.insert(addr)) {
+        return false;
+      }
+    }
+    for (uint8_t i = 0; i < 64; ++i) {
+      const uint8_t addr[ADDR_SIZE] = {0xc0, 0, 0, 0, 0, i};
+      if (s.contains(addr) != (i < 32)) {
+        return false;
+      }
+    }
+    return s.size() == 32;
+  }());
+
+  static_assert([] {
+    auto s = AddrSet<8>{};
+    s.insert(a);
+    s.insert(b);
+    uint8_t blob[2 * ADDR_SIZE] = {0};
+    const auto sz               = s.to_blob(blob);
+    auto t                      = AddrSet<8>{};
+    return sz == sizeof(blob) && t.from_blob(std::span<const uint8_t>{blob, sz}) &&
+           t.contains(a) && t.contains(b) && t.size() == 2 &&
+           !t.from_blob(std::span<const uint8_t>{blob, 5});
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_ADDR_SET_H
@@ -0,0 +1,157 @@
+#ifndef BLE_LORA_ADAPTER_AIRTIME_H
+#define BLE_LORA_ADAPTER_AIRTIME_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief accounting of the time spent on transmitting, to stay in the
+ *        duty cycle limit of the band
+ * @sa ETSI EN 300 220 (433.05 - 434.79 MHz, 10% duty cycle)
+ */
+namespace airtime {
+/**
+ * @brief what to give up first when the budget runs low
+ */
+enum class traffic_class : uint8_t {
+  /**
+   * @brief responses to the gateway, e.g. `repeater_status`
+   */
+  control,
+  /**
+   * @brief `named_hr_data`, with which the gateway learns the name map
+   */
+  named,
+  /**
+   * @brief `hr_data`, `hr_batch` and `hr_rr`; there's always a newer one coming
+   */
+  bulk,
+};
+
+constexpr size_t TRAFFIC_CLASS_COUNT = 3;
+
+struct config_t {
+  uint32_t window_ms;
+  /**
+   * @brief duty cycle in 1/1000
+   */
+  uint16_t duty_permille;
+  /**
+   * @brief the share of the budget that `traffic_class::named` and
+   *        `traffic_class::bulk` could use, in 1/1000
+   * @note the rest is reserved for `traffic_class::control`
+   */
+  uint16_t named_permille = 900;
+  uint16_t bulk_permille  = 750;
+};
+
+/**
+ * @brief airtime in a sliding window, kept in `Buckets` buckets
+ * @note the window slides by a bucket at a time, so the oldest bucket is
+ *       forgotten at once; more buckets make it smoother
+ */
+template <size_t Buckets>
+class Ledger {
+  config_t config;
+  std::array<uint32_t, Buckets> buckets{};
+  /**
+   * @brief the index of the bucket of the latest record, counted from 0 ms
+   */
+  uint32_t head     = 0;
+  uint64_t total_us = 0;
+
+  [[nodiscard]] constexpr uint32_t bucket_ms() const {
+    return config.window_ms / Buckets;
+  }
+
+  /**
+   * @brief forget the buckets older than the window
+   */
+  constexpr void advance(uint32_t now_ms) {
+    const auto idx = now_ms / bucket_ms();
+    if (idx == head) {
+      return;
+    }
+    const auto n = idx - head >= Buckets ? Buckets : idx - head;
+    for (uint32_t i = 1; i <= n; ++i) {
+      buckets[(head + i) % Buckets] = 0;
+    }
+    head = idx;
+  }
+
+public:
+  constexpr explicit Ledger(config_t config) : config(config) {}
+
+  [[nodiscard]] constexpr uint32_t budget_us() const {
+    return static_cast<uint32_t>(uint64_t{config.window_ms} * config.duty_permille);
+  }
+
+  [[nodiscard]] constexpr uint32_t budget_us(traffic_class cls) const {
+    switch (cls) {
+      case traffic_class::named:
+        return static_cast<uint32_t>(uint64_t{budget_us()} * config.named_permille / 1000);
+      case traffic_class::bulk:
+        return static_cast<uint32_t>(uint64_t{budget_us()} * config.bulk_permille / 1000);
+      default:
+        return budget_us();
+    }
+  }
+
+  /**
+   * @brief airtime used in the window ending at `now_ms`
+   */
+  [[nodiscard]] constexpr uint32_t used_us(uint32_t now_ms) {
+    advance(now_ms);
+    uint32_t sum = 0;
+    for (const auto b : buckets) {
+      sum += b;
+    }
+    return sum;
+  }
+
+  /**
+   * @brief airtime used since the beginning, in microseconds
+   */
+  [[nodiscard]] constexpr uint64_t total() const {
+    return total_us;
+  }
+
+  /**
+   * @brief whether a frame of `cls` that takes `airtime_us` is allowed now
+   */
+  [[nodiscard]] constexpr bool admit(traffic_class cls, uint32_t airtime_us, uint32_t now_ms) {
+    return used_us(now_ms) + airtime_us <= budget_us(cls);
+  }
+
+  constexpr void record(uint32_t airtime_us, uint32_t now_ms) {
+    advance(now_ms);
+    buckets[head % Buckets] += airtime_us;
+    total_us += airtime_us;
+  }
+};
+
+namespace static_tests {
+  // 1% of 10 s, i.e. 100 ms
+  constexpr auto config = config_t{.window_ms = 10'000, .duty_permille = 10};
+  // bulk traffic gives up first and control keeps the reserve
+  static_assert([] {
+    auto l = Ledger<10>{config};
+    l.record(70'000, 0);
+    return !l.admit(traffic_class::bulk, 10'000, 0) &&
+           l.admit(traffic_class::named, 10'000, 0) &&
+           l.admit(traffic_class::control, 30'000, 0) &&
+           !l.admit(traffic_class::control, 40'000, 0);
+  }());
+  // the airtime is forgotten after the window
+  static_assert([] {
+    auto l = Ledger<10>{config};
+    l.record(50'000, 500);
+    l.record(50'000, 5'500);
+    return l.used_us(9'999) == 100'000 && l.used_us(10'000) == 50'000 &&
+           l.used_us(100'000) == 0 && l.total() == 100'000;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_AIRTIME_H
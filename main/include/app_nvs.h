@@ -6,6 +6,7 @@
 #define BLE_LORA_ADAPTER_APP_NVS_H
 
 #include <etl/array.h>
+#include <span>
 #include <nvs_handle.hpp>
 #include <nvs_flash.h>
 #include <esp_check.h>
@@ -29,6 +30,47 @@ esp_err_t get_addr(addr_t *addr_ptr);
 
 esp_err_t set_addr(const addr_t &addr);
 
+/**
+ * @brief get the addresses of the target devices, one after another
+ * @param [out] buffer
+ * @param [out] size_ptr the size read
+ * @return error code; ESP_ERR_NVS_INVALID_LENGTH if `buffer` is too small
+ */
+esp_err_t get_whitelist(std::span<uint8_t> buffer, size_t *size_ptr);
+
+/**
+ * @param blob the addresses one after another; erase it if empty
+ */
+esp_err_t set_whitelist(std::span<const uint8_t> blob);
+
+/**
+ * @brief get the name patterns of the whitelist
+ * @param [out] buffer
+ * @param [out] size_ptr the size read
+ * @return error code; ESP_ERR_NVS_INVALID_LENGTH if `buffer` is too small
+ * @sa pattern_blob
+ */
+esp_err_t get_name_patterns(std::span<uint8_t> buffer, size_t *size_ptr);
+
+/**
+ * @param blob the patterns as `pattern_blob` writes; erase it if empty
+ */
+esp_err_t set_name_patterns(std::span<const uint8_t> blob);
+
+/**
+ * @brief get the name map keys of the target devices
+ * @param [out] buffer
+ * @param [out] size_ptr the size read
+ * @return error code; ESP_ERR_NVS_INVALID_LENGTH if `buffer` is too small
+ * @sa blue::ScanManager::export_keys
+ */
+esp_err_t get_device_keys(std::span<uint8_t> buffer, size_t *size_ptr);
+
+/**
+ * @param blob the address and the key of each device; erase it if empty
+ */
+esp_err_t set_device_keys(std::span<const uint8_t> blob);
+
 /**
  * @brief initialize nvs flash
  * @return ESP_OK on success
@@ -0,0 +1,399 @@
+#ifndef BLE_LORA_ADAPTER_ARQ_H
+#define BLE_LORA_ADAPTER_ARQ_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include "hr_lora.h"
+
+/**
+ * @brief automatic repeat request for control messages, on top of
+ *        `HrLoRa::reliable` and `HrLoRa::ack`
+ * @note heart rate data is never sent this way; a lost sample is replaced by
+ *       the next one anyway
+ */
+namespace arq {
+using addr_t = HrLoRa::addr_t;
+
+struct config_t {
+  /**
+   * @brief including the first transmission
+   */
+  uint8_t max_attempts = 4;
+  /**
+   * @brief the wait after the first transmission, doubled after each retransmission
+   * @note frames are only transmitted in `poll`; it should be a bit shorter than
+   *       the polling period if that's periodic
+   */
+  uint32_t base_backoff_ms = 1000;
+  uint32_t max_backoff_ms  = 60'000;
+};
+
+struct stats_t {
+  uint32_t submitted     = 0;
+  uint32_t acked         = 0;
+  uint32_t retransmitted = 0;
+  /**
+   * @brief no ack after `config_t::max_attempts`
+   */
+  uint32_t given_up = 0;
+  /**
+   * @brief no room in the in-flight table
+   */
+  uint32_t rejected = 0;
+  /**
+   * @brief received again, i.e. our ack is lost
+   */
+  uint32_t duplicated = 0;
+};
+
+/**
+ * @brief the in-flight table of frames waiting for ack, and the sequence
+ *        numbers of the peers, all in fixed memory
+ *
+ * The sender side: `submit` wraps a frame into `HrLoRa::reliable` and keeps it
+ * until `on_ack`. `poll` transmits the new ones and retransmits the ones whose
+ * backoff is over, and gives up after `config_t::max_attempts`. The sequence
+ * numbers are counted for all the peers together, so that a peer forgotten
+ * and met again doesn't start over from a number it has just received.
+ *
+ * The receiver side: `accept` tells whether a `HrLoRa::reliable` is new or a
+ * retransmission of what has been received (which should be acked again but
+ * not handled again). The last 32 sequence numbers of each peer are remembered;
+ * a number further behind than that starts the window over, as a sender
+ * that has restarted would.
+ *
+ * @tparam Peers the number of peers to remember; the least recently used one is forgotten
+ * @tparam Slots the number of frames in flight
+ * @tparam MaxFrameSize of the wrapped frame, i.e. including the envelope
+ * @note not thread safe
+ */
+template <size_t Peers, size_t Slots, size_t MaxFrameSize>
+class Endpoint {
+public:
+  struct entry_t {
+    bool in_use      = false;
+    addr_t peer      = {};
+    uint8_t seq      = 0;
+    uint8_t attempts = 0;
+    uint32_t due_ms  = 0;
+    size_t size      = 0;
+    std::array<uint8_t, MaxFrameSize> data{};
+
+    [[nodiscard]] constexpr std::span<const uint8_t> frame() const {
+      return std::span<const uint8_t>{data.data(), size};
+    }
+  };
+
+private:
+  struct peer_t {
+    bool in_use       = false;
+    addr_t addr       = {};
+    uint32_t used_ms  = 0;
+    bool has_rx       = false;
+    uint8_t rx_latest = 0;
+    /**
+     * @brief bit i is set if `rx_latest - i` is received
+     */
+    uint32_t rx_mask = 0;
+  };
+
+  addr_t self;
+  config_t config;
+  std::array<peer_t, Peers> peers{};
+  std::array<entry_t, Slots> entries{};
+  uint8_t next_seq = 0;
+  stats_t _stats{};
+
+  constexpr peer_t &peer_of(const addr_t &addr, uint32_t now_ms) {
+    peer_t *victim = &peers[0];
+    for (auto &p : peers) {
+      if (p.in_use && p.addr == addr) {
+        p.used_ms = now_ms;
+        return p;
+      }
+      if (!p.in_use) {
+        victim = &p;
+      } else if (victim->in_use && now_ms - p.used_ms > now_ms - victim->used_ms) {
+        victim = &p;
+      }
+    }
+    *victim = peer_t{.in_use = true, .addr = addr, .used_ms = now_ms};
+    return *victim;
+  }
+
+  /**
+   * @param attempts at least 1
+   */
+  [[nodiscard]] constexpr uint32_t backoff_ms(uint8_t attempts) const {
+    const auto shift = std::min<uint8_t>(attempts - 1, 16);
+    return std::min(config.base_backoff_ms << shift, config.max_backoff_ms);
+  }
+
+public:
+  constexpr Endpoint(const addr_t &self, config_t config)
+      : self(self), config(config) {}
+
+  constexpr void set_self(const addr_t &addr) {
+    self = addr;
+  }
+
+  [[nodiscard]] constexpr const addr_t &self_addr() const {
+    return self;
+  }
+
+  /**
+   * @brief wrap `payload` for `peer` and keep it until acked
+   * @return false if the table is full or the frame is too large
+   * @note it's transmitted in the next `poll`
+   */
+  constexpr bool submit(const addr_t &peer, std::span<const uint8_t> payload, uint32_t now_ms) {
+    auto it = std::find_if(entries.begin(), entries.end(), [](const auto &e) { return !e.in_use; });
+    if (it == entries.end() || HrLoRa::reliable::header_size + payload.size() > MaxFrameSize) {
+      _stats.rejected += 1;
+      return false;
+    }
+    const auto v  = HrLoRa::reliable::view{.src = self, .dst = peer, .seq = next_seq, .payload = payload};
+    const auto sz = HrLoRa::reliable::marshal(v, it->data);
+    if (sz == 0) {
+      _stats.rejected += 1;
+      return false;
+    }
+    it->in_use   = true;
+    it->peer     = peer;
+    it->seq      = next_seq;
+    it->attempts = 0;
+    it->due_ms   = now_ms;
+    it->size     = sz;
+    next_seq += 1;
+    _stats.submitted += 1;
+    return true;
+  }
+
+  /**
+   * @brief `peer` has received `seq`
+   * @return whether a frame in flight is acked
+   * @note an ack from a broadcast is matched by the sequence number only
+   */
+  constexpr bool on_ack(const addr_t &peer, uint8_t seq) {
+    for (auto &e : entries) {
+      const auto match_peer = e.peer == peer || e.peer == HrLoRa::broadcast_addr;
+      if (e.in_use && e.seq == seq && match_peer) {
+        e.in_use = false;
+        _stats.acked += 1;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief transmit the frames which are due, and drop the ones which have
+   *        been tried `config_t::max_attempts` times
+   * @param send called with the frame to be transmitted; if it returns
+   *        `false` (no room, e.g. the slot is full), that frame and the rest
+   *        stay due for the next `poll`
+   * @return the number of frames transmitted
+   */
+  template <typename F>
+  constexpr size_t poll(uint32_t now_ms, F &&send) {
+    size_t n = 0;
+    for (auto &e : entries) {
+      if (!e.in_use || static_cast<int32_t>(now_ms - e.due_ms) < 0) {
+        continue;
+      }
+      if (e.attempts >= config.max_attempts) {
+        e.in_use = false;
+        _stats.given_up += 1;
+        continue;
+      }
+      if constexpr (std::is_same_v<std::invoke_result_t<F, std::span<const uint8_t>>, bool>) {
+        if (!send(e.frame())) {
+          break;
+        }
+      } else {
+        send(e.frame());
+      }
+      if (e.attempts > 0) {
+        _stats.retransmitted += 1;
+      }
+      e.attempts += 1;
+      e.due_ms = now_ms + backoff_ms(e.attempts);
+      n += 1;
+    }
+    return n;
+  }
+
+  /**
+   * @brief a `HrLoRa::reliable` with `seq` is received from `peer`
+   * @return false if it has been received before
+   * @note ack it either way
+   */
+  constexpr bool accept(const addr_t &peer, uint8_t seq, uint32_t now_ms) {
+    auto &p = peer_of(peer, now_ms);
+    if (!p.has_rx) {
+      p.has_rx    = true;
+      p.rx_latest = seq;
+      p.rx_mask   = 1;
+      return true;
+    }
+    const auto diff = static_cast<int8_t>(seq - p.rx_latest);
+    if (diff > 0) {
+      p.rx_mask   = diff >= 32 ? 1 : (p.rx_mask << diff) | 1;
+      p.rx_latest = seq;
+      return true;
+    }
+    const auto age = static_cast<uint8_t>(-diff);
+    if (age >= 32) {
+      // too old to tell, or the sender has started over; handling it again
+      // is safer than dropping a new one
+      p.rx_latest = seq;
+      p.rx_mask   = 1;
+      return true;
+    }
+    if (p.rx_mask & (uint32_t{1} << age)) {
+      _stats.duplicated += 1;
+      return false;
+    }
+    p.rx_mask |= uint32_t{1} << age;
+    return true;
+  }
+
+  [[nodiscard]] constexpr size_t in_flight() const {
+    return std::count_if(entries.begin(), entries.end(), [](const auto &e) { return e.in_use; });
+  }
+
+  [[nodiscard]] constexpr const stats_t &stats() const {
+    return _stats;
+  }
+};
+
+namespace static_tests {
+  constexpr auto gateway  = addr_t{0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+  constexpr auto repeater = addr_t{0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
+  using endpoint_t        = Endpoint<2, 4, 32>;
+
+  /**
+   * @brief a channel that loses the frames in `pattern` (bit i for the i-th frame)
+   */
+  struct lossy_channel_t {
+    uint32_t pattern;
+    uint32_t count = 0;
+
+    constexpr bool pass() {
+      return (pattern & (uint32_t{1} << (count++ % 32))) == 0;
+    }
+  };
+
+  /**
+   * @brief send a frame from the repeater to the gateway over `channel`,
+   *        one superframe (1 s) at a time, both ways lossy
+   * @return whether the gateway handled the frame exactly once, and the
+   *         repeater learned that
+   */
+  constexpr bool deliver(lossy_channel_t channel, uint8_t max_attempts) {
+    auto tx          = endpoint_t{repeater, config_t{.max_attempts = max_attempts, .base_backoff_ms = 1000}};
+    auto rx          = endpoint_t{gateway, config_t{}};
+    uint32_t handled = 0;
+    // the gateway receives and acks
+    auto transmit    = [&](std::span<const uint8_t> frame, uint32_t now_ms) {
+      if (!channel.pass()) {
+        return;
+      }
+      const auto v = HrLoRa::reliable::unmarshal_view(frame);
+      if (!v || v->dst != gateway) {
+        return;
+      }
+      if (rx.accept(v->src, v->seq, now_ms)) {
+        handled += 1;
+      }
+      if (channel.pass()) {
+        tx.on_ack(gateway, v->seq);
+      }
+    };
+    constexpr uint8_t payload[] = {HrLoRa::repeater_status::magic, 0};
+    if (!tx.submit(gateway, payload, 0)) {
+      return false;
+    }
+    for (uint32_t now = 0; now < 60'000; now += 1000) {
+      tx.poll(now, [&](std::span<const uint8_t> frame) { transmit(frame, now); });
+    }
+    return handled == 1 && tx.in_flight() == 0 && tx.stats().acked == 1;
+  }
+
+  // nothing lost
+  static_assert(deliver(lossy_channel_t{.pattern = 0}, 4));
+  // the first frame, then the first ack are lost
+  static_assert(deliver(lossy_channel_t{.pattern = 0b0101}, 4));
+  // lost more than it could retry
+  static_assert(!deliver(lossy_channel_t{.pattern = 0b01'0101}, 3));
+
+  // transmitted at once, retransmitted at 1 s, 3 s and 7 s, then given up
+  static_assert([] {
+    auto tx                     = endpoint_t{repeater, config_t{.max_attempts = 4, .base_backoff_ms = 1000}};
+    constexpr uint8_t payload[] = {0x47};
+    tx.submit(gateway, payload, 0);
+    uint32_t sent_at[4] = {};
+    size_t n            = 0;
+    for (uint32_t now = 0; now < 20'000; now += 100) {
+      tx.poll(now, [&](auto) { sent_at[n++] = now; });
+    }
+    return n == 4 && sent_at[0] == 0 && sent_at[1] == 1000 && sent_at[2] == 3000 &&
+           sent_at[3] == 7000 && tx.stats().given_up == 1 && tx.in_flight() == 0;
+  }());
+
+  // a frame refused for want of room stays due, and isn't counted as an attempt
+  static_assert([] {
+    auto tx                     = endpoint_t{repeater, config_t{.max_attempts = 2, .base_backoff_ms = 1000}};
+    constexpr uint8_t payload[] = {0x47};
+    tx.submit(gateway, payload, 0);
+    tx.submit(gateway, payload, 0);
+    const auto refused = tx.poll(0, [](auto) { return false; });
+    auto once          = true;
+    const auto first   = tx.poll(10, [&](auto) { return std::exchange(once, false); });
+    const auto second  = tx.poll(20, [](auto) { return true; });
+    return refused == 0 && first == 1 && second == 1 && tx.stats().retransmitted == 0 && tx.in_flight() == 2;
+  }());
+
+  // a peer forgotten (here for two others) doesn't start over from 0, which
+  // the receiver would take for a duplicate
+  static_assert([] {
+    constexpr auto other        = addr_t{0x21, 0x22, 0x23, 0x24, 0x25, 0x26};
+    constexpr uint8_t payload[] = {0x47};
+    auto tx                     = endpoint_t{repeater, config_t{}};
+    auto rx                     = endpoint_t{gateway, config_t{}};
+    auto seq                    = uint8_t{0};
+    auto last_seq               = [&seq](std::span<const uint8_t> frame) { seq = HrLoRa::reliable::unmarshal_view(frame)->seq; };
+    tx.submit(gateway, payload, 0);
+    tx.poll(0, last_seq);
+    auto ok = rx.accept(repeater, seq, 0);
+    tx.on_ack(gateway, seq);
+    tx.accept(other, 9, 10);
+    tx.accept(repeater, 9, 20);
+    tx.submit(gateway, payload, 30);
+    tx.poll(30, last_seq);
+    return ok && rx.accept(repeater, seq, 30) && rx.stats().duplicated == 0;
+  }());
+
+  // a sequence number far behind starts the window over
+  static_assert([] {
+    auto rx = endpoint_t{gateway, config_t{}};
+    bool ok = rx.accept(repeater, 100, 0) && rx.accept(repeater, 50, 0) && !rx.accept(repeater, 50, 0);
+    return ok && rx.accept(repeater, 51, 0) && rx.stats().duplicated == 1;
+  }());
+
+  // duplicates are told apart across the wrap of the sequence number
+  static_assert([] {
+    auto rx = endpoint_t{gateway, config_t{}};
+    bool ok = rx.accept(repeater, 254, 0) && rx.accept(repeater, 255, 0) && rx.accept(repeater, 1, 0);
+    ok      = ok && !rx.accept(repeater, 255, 0) && rx.accept(repeater, 0, 0) && !rx.accept(repeater, 0, 0);
+    return ok && rx.stats().duplicated == 2;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_ARQ_H
@@ -0,0 +1,143 @@
+#ifndef BLE_LORA_ADAPTER_CHANNEL_PLAN_H
+#define BLE_LORA_ADAPTER_CHANNEL_PLAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief spread the uplink of repeaters over several channels
+ *
+ * On top of `tdma`, repeaters whose keys fall into the same slot are put
+ * into different lanes, i.e. `key / slot_count`. In every superframe, the
+ * lanes of a slot are mapped to the channels with an offset derived from
+ * the superframe index and the slot (a hop), so the same lane never sits on
+ * the same channel for long, while lanes of a slot never collide with each
+ * other. With `channel_count` channels, `slot_count * channel_count` keys
+ * could transmit without collision.
+ *
+ * The downlink (from the gateway) always uses channel 0, which is what
+ * repeaters receive with. A gateway with `n` receivers listens to the first
+ * `n` lanes of each slot with `Plan::listen_channel`; with a receiver per
+ * channel, the capacity grows linearly with the number of channels.
+ */
+namespace channel_plan {
+struct config_t {
+  /**
+   * @brief the frequency of channel 0, in MHz
+   */
+  float base_freq_mhz;
+  float spacing_mhz;
+  uint8_t channel_count;
+  /**
+   * @brief should be the same as `tdma::config_t::slot_count`
+   */
+  uint16_t slot_count;
+};
+
+/**
+ * @brief a 32-bit integer hash with good avalanche (MurmurHash3 finalizer)
+ */
+constexpr uint32_t mix32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
+
+class Plan {
+  config_t config;
+
+public:
+  constexpr explicit Plan(config_t config) : config(config) {
+    if (this->config.channel_count == 0) {
+      this->config.channel_count = 1;
+    }
+  }
+
+  [[nodiscard]] constexpr uint8_t channel_count() const {
+    return config.channel_count;
+  }
+
+  /**
+   * @brief the number of keys that could transmit without collision
+   */
+  [[nodiscard]] constexpr uint32_t capacity() const {
+    return uint32_t{config.slot_count} * config.channel_count;
+  }
+
+  [[nodiscard]] constexpr float freq_of(uint8_t channel) const {
+    return config.base_freq_mhz + config.spacing_mhz * static_cast<float>(channel);
+  }
+
+  [[nodiscard]] constexpr uint8_t lane_of(uint8_t key) const {
+    return (key / config.slot_count) % config.channel_count;
+  }
+
+  /**
+   * @brief the offset of the lanes of `slot` in the superframe
+   */
+  [[nodiscard]] constexpr uint8_t hop(uint32_t superframe, uint16_t slot) const {
+    return mix32(superframe * config.slot_count + slot) % config.channel_count;
+  }
+
+  /**
+   * @brief the uplink channel of `key` in the superframe
+   */
+  [[nodiscard]] constexpr uint8_t channel_of(uint8_t key, uint32_t superframe) const {
+    const uint16_t slot = key % config.slot_count;
+    return (lane_of(key) + hop(superframe, slot)) % config.channel_count;
+  }
+
+  [[nodiscard]] constexpr float freq_mhz(uint8_t key, uint32_t superframe) const {
+    return freq_of(channel_of(key, superframe));
+  }
+
+  /**
+   * @brief for the gateway: the channel that the `receiver`-th receiver
+   *        listens to in `slot` of the superframe, i.e. the lane `receiver`
+   */
+  [[nodiscard]] constexpr uint8_t listen_channel(uint8_t receiver, uint16_t slot, uint32_t superframe) const {
+    return (receiver + hop(superframe, slot)) % config.channel_count;
+  }
+};
+
+namespace static_tests {
+  constexpr auto plan = Plan{config_t{.base_freq_mhz = 433.2f, .spacing_mhz = 0.5f, .channel_count = 3, .slot_count = 4}};
+  static_assert(plan.capacity() == 12);
+  static_assert(plan.freq_of(2) == 434.2f);
+
+  // keys of the same slot never share a channel, and the receiver of the
+  // lane always hears them
+  static_assert([] {
+    for (uint32_t sf = 0; sf < 64; ++sf) {
+      for (uint8_t key = 0; key < plan.capacity(); ++key) {
+        for (uint8_t other = key + 1; other < plan.capacity(); ++other) {
+          if (key % 4 == other % 4 && plan.channel_of(key, sf) == plan.channel_of(other, sf)) {
+            return false;
+          }
+        }
+        if (plan.listen_channel(plan.lane_of(key), key % 4, sf) != plan.channel_of(key, sf)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }());
+
+  // a key visits every channel
+  static_assert([] {
+    bool seen[3] = {};
+    for (uint32_t sf = 0; sf < 64; ++sf) {
+      seen[plan.channel_of(5, sf)] = true;
+    }
+    return seen[0] && seen[1] && seen[2];
+  }());
+
+  // a single channel is what it used to be
+  static_assert(Plan{config_t{.base_freq_mhz = 433.2f, .spacing_mhz = 0.5f, .channel_count = 1, .slot_count = 32}}.freq_mhz(77, 12345) == 433.2f);
+}
+}
+
+#endif // BLE_LORA_ADAPTER_CHANNEL_PLAN_H
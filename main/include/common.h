@@ -36,23 +36,135 @@ namespace pin {
 #endif
 }
 
-static const char *BLE_CHAR_WHITE_LIST_UUID     = "12a481f0-9384-413d-b002-f8660566d3b0";
-static const char *BLE_CHAR_DEVICE_UUID         = "a2f05114-fdb6-4549-ae2a-845b4be1ac48";
-static const char *BLE_STANDARD_HR_SERVICE_UUID = "180d";
-static const char *BLE_STANDARD_HR_CHAR_UUID    = "2a37";
-static const char *BLE_CHAR_HR_SERVICE_UUID     = BLE_STANDARD_HR_SERVICE_UUID;
-static const char *BLE_CHAR_HR_CHAR_UUID        = BLE_STANDARD_HR_CHAR_UUID;
-constexpr auto BLE_NAME                         = "LoRA-Adapter";
-constexpr auto SCAN_TIME                        = std::chrono::milliseconds(2500);
+inline constexpr const char *BLE_CHAR_WHITE_LIST_UUID     = "12a481f0-9384-413d-b002-f8660566d3b0";
+inline constexpr const char *BLE_CHAR_DEVICE_UUID         = "a2f05114-fdb6-4549-ae2a-845b4be1ac48";
+/**
+ * @brief `HrLoRa::link_stats` of the LoRa link, updated in every slot of this repeater
+ */
+inline constexpr const char *BLE_CHAR_LINK_STATS_UUID     = "025ca169-ec77-4303-b23f-5e066947dab5";
+inline constexpr const char *BLE_STANDARD_HR_SERVICE_UUID = "180d";
+inline constexpr const char *BLE_STANDARD_HR_CHAR_UUID    = "2a37";
+inline constexpr const char *BLE_CHAR_HR_SERVICE_UUID     = BLE_STANDARD_HR_SERVICE_UUID;
+inline constexpr const char *BLE_CHAR_HR_CHAR_UUID        = BLE_STANDARD_HR_CHAR_UUID;
+constexpr auto BLE_NAME                                   = "LoRA-Adapter";
+constexpr auto SCAN_TIME                                  = std::chrono::milliseconds(2500);
 // scan time + sleep time
-constexpr auto SCAN_TOTAL_TIME               = std::chrono::milliseconds(5000);
-static auto MAX_RF_MSG_SCHEDULE_DELAY_MS     = 3000;
-static uint32_t INTERVAL_SEND_NAMED_HR_COUNT = 15;
+constexpr auto SCAN_TOTAL_TIME = std::chrono::milliseconds(5000);
 static_assert(SCAN_TOTAL_TIME > SCAN_TIME);
+/**
+ * @brief the budget of the scan results notified to the phone, a second on
+ *        average and at once
+ * @sa seen_cache::config_t
+ */
+constexpr uint16_t SCAN_RESULT_PER_SECOND = 4;
+constexpr uint16_t SCAN_RESULT_BURST      = 8;
+/**
+ * @brief the number of devices remembered for the scan results
+ */
+constexpr size_t MAX_SEEN_DEVICE_NUM = 32;
+/**
+ * @brief the longest name of a scan result, i.e. `bluetooth_device_pb::name`
+ */
+constexpr size_t SEEN_NAME_SIZE = 20;
+/**
+ * @brief the longest a scan result waits to be packed with others
+ */
+constexpr auto SCAN_RESULT_FLUSH_INTERVAL = std::chrono::milliseconds(1000);
+/**
+ * @brief number of slots in a TDMA superframe
+ * @note repeaters whose name map keys are equal modulo this would share a slot
+ */
+constexpr uint16_t TDMA_SLOT_COUNT = 32;
+/**
+ * @brief should be long enough for a `hr_batch`, a `hr_rr` and a `named_hr_data`
+ *        (or a `repeater_status`) at SF10/500kHz
+ */
+constexpr auto TDMA_SLOT_TIME = std::chrono::milliseconds(500);
+/**
+ * @brief the end of a slot left unused: the beacon of the gateway (70 ms at
+ *        SF10/500kHz) runs into the last slot, and the slot timer and LBT
+ *        start a frame a bit late
+ * @sa slot_plan::Budget
+ */
+constexpr auto TDMA_SLOT_GUARD_TIME = std::chrono::milliseconds(100);
+/**
+ * @brief run CAD before each transmission
+ * @sa lbt::config_t
+ */
+constexpr bool LBT_ENABLED = true;
+/**
+ * @brief whether the gateway could receive other spreading factors than
+ *        `radio_profile::DEFAULT_PROFILE`; if not, only the TX power is adapted
+ */
+constexpr bool GATEWAY_MULTI_SF = false;
+/**
+ * @brief the number of uplink channels, from the frequency of
+ *        `radio_profile::DEFAULT_PROFILE` and `CHANNEL_SPACING_MHZ` apart
+ * @note the gateway should listen as `channel_plan::Plan::listen_channel` tells;
+ *       1 for a gateway with a single channel
+ */
+constexpr uint8_t CHANNEL_COUNT     = 1;
+constexpr float CHANNEL_SPACING_MHZ = 0.5f;
+/**
+ * @brief receive in duty cycle to save power, instead of continuously
+ * @note the gateway should send downlink frames with a preamble of
+ *       `WAKE_PREAMBLE_LEN` symbols
+ * @sa radio::sniff_config_t
+ * @sa power_model
+ */
+constexpr bool RX_DUTY_CYCLED        = false;
+constexpr uint16_t WAKE_PREAMBLE_LEN = 64;
+/**
+ * @brief the SPI clock of the radio; LLCC68 supports up to 16 MHz, but
+ *        long wires might not
+ * @sa ESPHal::config_t
+ */
+constexpr int RADIO_SPI_CLOCK_HZ = 2'000'000;
+/**
+ * @brief 10% in any hour for 433.05 - 434.79 MHz
+ * @sa airtime::config_t
+ */
+constexpr auto DUTY_CYCLE_WINDOW       = std::chrono::milliseconds(3'600'000);
+constexpr uint16_t DUTY_CYCLE_PERMILLE = 100;
+/**
+ * @brief the frames of heart rate data sent in a slot, shared by the devices
+ *        whose keys fall in it
+ * @sa TDMA_SLOT_TIME
+ */
+constexpr size_t LORA_FRAMES_PER_SLOT = 3;
+/**
+ * @brief the devices a repeater connects to and sends over LoRa at the same
+ *        time
+ * @note each device with a key of its own sends in the slot of that key, so
+ *       the slots aren't what limits them, but the duty cycle is: the
+ *       hr_batch and hr_rr of a device take about 2.2% of the airtime at
+ *       SF10/500kHz, and `traffic_class::bulk` could use 7.5% of it
+ *       (`DUTY_CYCLE_PERMILLE` less the reserve of `airtime::config_t`). With
+ *       a fourth device the frames are dropped by the duty cycle within the
+ *       hour (measured with test/sim, multi.sim)
+ * @sa slot_plan
+ */
+constexpr size_t MAX_BRIDGED_DEVICES = 3;
+/**
+ * @brief the RR intervals of a superframe at this heart rate fit in a
+ *        `HrLoRa::hr_rr`, which is sent once a superframe
+ */
+constexpr uint16_t MAX_HEART_RATE_BPM = 220;
+// send `HrLoRa::named_hr_data` in the slot of every N superframes
+constexpr uint32_t INTERVAL_SEND_NAMED_HR_SUPERFRAMES = 2;
+/**
+ * @brief transmissions of a `HrLoRa::reliable` before giving up, retransmitted
+ *        in the slot of 1, 2, 4... superframes later
+ * @sa arq::config_t
+ */
+constexpr uint8_t RELIABLE_MAX_ATTEMPTS = 4;
 
 static constexpr auto PREF_PARTITION_LABEL        = "st";
 static constexpr auto PREF_NAME_MAP_KEY_WORD8_KEY = "nmk";
 static constexpr auto PREF_ADDR_BLOB_KEY          = "addr";
+static constexpr auto PREF_WHITELIST_BLOB_KEY     = "wl";
+static constexpr auto PREF_NAME_PATTERN_BLOB_KEY  = "wln";
+static constexpr auto PREF_DEVICE_KEY_BLOB_KEY    = "wlk";
 }
 
 #endif // BLE_LORA_ADAPTER_COMMON_H
@@ -61,6 +61,49 @@ uint32_t spiFrequencyToClockDiv(uint32_t freq);
 // and implement all of its virtual methods
 // this is pretty much just copied from Arduino ESP32 core
 class ESPHal : public RadioLibHal {
+public:
+  struct config_t {
+    /**
+     * @brief LLCC68 supports up to 16 MHz
+     */
+    int clock_hz = 2'000'000;
+    /**
+     * @brief in bytes; should hold the whole FIFO (256 bytes) and the command
+     */
+    int max_transfer_sz = 512;
+    /**
+     * @brief hold the bus from `spiBeginTransaction` to `spiEndTransaction`,
+     *        instead of acquiring it for each transfer
+     */
+    bool hold_bus = true;
+    /**
+     * @brief transfers longer than this are queued (`spi_device_queue_trans`),
+     *        so that the task blocks on the interrupt of the transfer done and
+     *        yields the CPU; the shorter ones are polled
+     *        (`spi_device_polling_transmit`), i.e. the task spins, which has
+     *        less overhead for a few bytes
+     * @note both go through DMA, since the bus is initialized with it
+     */
+    size_t queued_threshold = 32;
+    int queue_size       = 4;
+  };
+
+  /**
+   * @brief since `init`
+   */
+  struct spi_stats_t {
+    uint32_t transactions = 0;
+    /**
+     * @brief the ones queued, see `config_t::queued_threshold`
+     */
+    uint32_t queued_transactions = 0;
+    uint32_t bytes               = 0;
+    /**
+     * @brief time spent in transfers, including waiting for the bus
+     */
+    uint32_t busy_us = 0;
+  };
+
 private:
   // the HAL can contain any additional private members
   static constexpr decltype(SPI2_HOST) SPI_HOST = SPI2_HOST;
@@ -68,12 +111,51 @@ private:
   int8_t spiMISO;
   int8_t spiMOSI;
   spi_device_handle_t spi;
+  config_t config;
+  bool bus_held = false;
+  // written by the task that owns the radio only
+  spi_stats_t _spi_stats{};
+
+  /**
+   * @param arg a `void (*)()`
+   */
+  static void call_without_arg(void *arg);
+
+  void transmit(spi_transaction_t &trans, size_t len) {
+    const auto start = esp_timer_get_time();
+    if (!bus_held) {
+      // acquire finite time not supported now
+      spi_device_acquire_bus(spi, portMAX_DELAY);
+    }
+    esp_err_t ret;
+    if (len > config.queued_threshold) {
+      ret = spi_device_queue_trans(spi, &trans, portMAX_DELAY);
+      if (ret == ESP_OK) {
+        spi_transaction_t *done = nullptr;
+        ret                     = spi_device_get_trans_result(spi, &done, portMAX_DELAY);
+      }
+      _spi_stats.queued_transactions += 1;
+    } else {
+      ret = spi_device_polling_transmit(spi, &trans);
+    }
+    ESP_ERROR_CHECK(ret);
+    if (!bus_held) {
+      spi_device_release_bus(spi);
+    }
+    _spi_stats.transactions += 1;
+    _spi_stats.bytes += len;
+    _spi_stats.busy_us += esp_timer_get_time() - start;
+  }
 
 public:
   // default constructor - initializes the base HAL and any needed private members
-  ESPHal(int8_t sck, int8_t miso, int8_t mosi)
+  ESPHal(int8_t sck, int8_t miso, int8_t mosi, config_t config = {})
       : RadioLibHal(INPUT, OUTPUT, LOW, HIGH, RISING, FALLING),
-        spiSCK(sck), spiMISO(miso), spiMOSI(mosi) {
+        spiSCK(sck), spiMISO(miso), spiMOSI(mosi), config(config) {
+  }
+
+  [[nodiscard]] spi_stats_t spi_stats() const {
+    return _spi_stats;
   }
 
   void init() override {
@@ -120,17 +202,40 @@ public:
     return (gpio_get_level((gpio_num_t)pin));
   }
 
-  void attachInterrupt(uint32_t interruptNum, void (*interruptCb)(), uint32_t mode) override {
+  /**
+   * @brief install the GPIO ISR service, with the handlers in IRAM
+   * @note only the first call installs it; it's shared by all the pins
+   */
+  static esp_err_t install_isr_service();
+
+  /**
+   * @brief attach `handler` with a context pointer to `interruptNum`
+   * @param handler should be IRAM_ATTR, and only call functions that are in
+   *        IRAM as well (e.g. `xTaskNotifyFromISR`, `esp_timer_get_time`)
+   * @param mode `RISING` or `FALLING`
+   */
+  void attach_interrupt(uint32_t interruptNum, gpio_isr_t handler, void *arg, uint32_t mode) {
+    constexpr auto TAG = "ESPHal::attach_interrupt";
     if (interruptNum == RADIOLIB_NC) {
       return;
     }
-
-    gpio_install_isr_service((int)ESP_INTR_FLAG_IRAM);
+    if (install_isr_service() != ESP_OK) {
+      return;
+    }
     gpio_set_intr_type((gpio_num_t)interruptNum, (gpio_int_type_t)(mode & 0x7));
+    auto ret = gpio_isr_handler_add((gpio_num_t)interruptNum, handler, arg);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "pin %lu: %s", interruptNum, esp_err_to_name(ret));
+    }
+  }
 
-    // this uses function typecasting, which is not defined when the functions have different signatures
-    // untested and might not work
-    gpio_isr_handler_add((gpio_num_t)interruptNum, (void (*)(void *))interruptCb, nullptr);
+  /**
+   * @note RadioLib's callback has no argument; it's called through a trampoline
+   *       that takes it as the argument, and it should be IRAM_ATTR as well
+   * @sa attach_interrupt
+   */
+  void attachInterrupt(uint32_t interruptNum, void (*interruptCb)(), uint32_t mode) override {
+    attach_interrupt(interruptNum, call_without_arg, reinterpret_cast<void *>(interruptCb), mode);
   }
 
   void detachInterrupt(uint32_t interruptNum) override {
@@ -196,7 +301,7 @@ public:
         .sclk_io_num     = this->spiSCK,
         .quadwp_io_num   = -1,
         .quadhd_io_num   = -1,
-        .max_transfer_sz = 32,
+        .max_transfer_sz = config.max_transfer_sz,
     };
 
     // it might be initialized already
@@ -209,16 +314,20 @@ public:
         .command_bits   = 0,
         .address_bits   = 0,
         .mode           = 0,
-        .clock_speed_hz = 2000000,
+        .clock_speed_hz = config.clock_hz,
         .spics_io_num   = -1, // trigger CS manually
-        .queue_size     = 7};
+        .queue_size     = config.queue_size};
     ret = spi_bus_add_device(SPI_HOST, &dev_cfg, &spi);
     ESP_ERROR_CHECK(ret);
   }
 
   void spiBeginTransaction() override {
-    // not needed - in ESP32 Arduino core, this function
-    // repeats clock div, mode and bit-order configuration
+    // clock div, mode and bit-order are configured once in `spiBegin`;
+    // RadioLib brackets each command with this and `spiEndTransaction`
+    if (config.hold_bus && !bus_held) {
+      spi_device_acquire_bus(spi, portMAX_DELAY);
+      bus_held = true;
+    }
   }
 
   uint8_t spiTransferByte(uint8_t b) {
@@ -228,12 +337,9 @@ public:
         .length   = 8,
         .rxlength = 8,
     };
+    trans.flags      = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
     trans.tx_data[0] = b;
-    // acquire finite time not supported now
-    spi_device_acquire_bus(spi, portMAX_DELAY);
-    auto ret = spi_device_polling_transmit(spi, &trans);
-    ESP_ERROR_CHECK(ret);
-    spi_device_release_bus(spi);
+    transmit(trans, 1);
     return trans.rx_data[0];
   }
 
@@ -247,14 +353,14 @@ public:
         .tx_buffer = out,
         .rx_buffer = in,
     };
-    spi_device_acquire_bus(spi, portMAX_DELAY);
-    auto ret = spi_device_polling_transmit(spi, &trans);
-    ESP_ERROR_CHECK(ret);
-    spi_device_release_bus(spi);
+    transmit(trans, len);
   }
 
   void spiEndTransaction() override {
-    // nothing needs to be done here
+    if (bus_held) {
+      spi_device_release_bus(spi);
+      bus_held = false;
+    }
   }
 
   void spiEnd() override {
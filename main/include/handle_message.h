@@ -0,0 +1,95 @@
+#ifndef BLE_LORA_ADAPTER_HANDLE_MESSAGE_H
+#define BLE_LORA_ADAPTER_HANDLE_MESSAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <etl/optional.h>
+#include "hr_lora.h"
+
+/**
+ * @brief the max size of a frame passed to `handle_message_callbacks_t::schedule`
+ * @note the same as `radio::RadioTask::MAX_FRAME_SIZE`, which is not included
+ *       here to keep RadioLib out
+ */
+constexpr size_t HANDLE_MESSAGE_MAX_FRAME_SIZE = 128;
+
+/**
+ * @brief a heart rate device bridged by this repeater
+ */
+struct bridged_device_t {
+  HrLoRa::hr_device::t device;
+  /**
+   * @brief its own name map key, if the gateway has given one
+   */
+  etl::optional<HrLoRa::name_map_key_t> key;
+};
+
+/**
+ * @brief everything `handle_message` needs from the rest of the firmware
+ * @note nothing here depends on NimBLE, the radio or FreeRTOS, so that the
+ *       message handling could be driven by something other than the board
+ *       (e.g. a simulated medium)
+ */
+struct handle_message_callbacks_t {
+  /**
+   * @brief send the data in the next slot of this repeater, after at least `interval_ms`
+   */
+  std::function<void(uint8_t *data, size_t size, size_t interval_ms)> schedule = nullptr;
+  /**
+   * @brief the heart rate device this repeater is connected to, if any
+   */
+  std::function<etl::optional<HrLoRa::hr_device::t>()> get_device = nullptr;
+  /**
+   * @brief the device at `addr`, if it's connected to this repeater
+   */
+  std::function<etl::optional<bridged_device_t>(const HrLoRa::addr_t &addr)> find_device = nullptr;
+  /**
+   * @brief the address of this repeater, i.e. its BLE address
+   */
+  std::function<HrLoRa::addr_t()> get_self_addr = nullptr;
+  /**
+   * @brief set and persist the name map key
+   */
+  std::function<void(HrLoRa::name_map_key_t)> set_name_map_key = nullptr;
+  std::function<HrLoRa::name_map_key_t()> get_name_map_key     = nullptr;
+  /**
+   * @brief set the name map key of a connected device
+   * @return false if `addr` is not a device of this repeater, then the key is
+   *         for the repeater itself if `addr` is its own (or the broadcast)
+   *         address, and ignored otherwise
+   */
+  std::function<bool(const HrLoRa::addr_t &addr, HrLoRa::name_map_key_t)> set_device_key = nullptr;
+  /**
+   * @brief appended to `repeater_status` if there's room
+   */
+  std::function<HrLoRa::link_stats::t()> get_link_stats = nullptr;
+  /**
+   * @brief a frame from the gateway is received, which is used to align the TDMA superframe
+   */
+  std::function<void()> on_gateway_frame = nullptr;
+  /**
+   * @brief send `data` to `peer` in `HrLoRa::reliable`, retransmitted until acked
+   */
+  std::function<void(const HrLoRa::addr_t &peer, std::span<const uint8_t> data)> send_reliable = nullptr;
+  /**
+   * @brief a `HrLoRa::reliable` with `seq` is received from `peer`
+   * @return false if it's a retransmission of what has been handled
+   */
+  std::function<bool(const HrLoRa::addr_t &peer, uint8_t seq)> accept_reliable = nullptr;
+  std::function<void(const HrLoRa::addr_t &peer, uint8_t seq)> on_ack          = nullptr;
+};
+
+/**
+ * @brief handle the message received from LoRa
+ * @param data the data received
+ * @param size the size of the data
+ * @param callbacks the callbacks to handle the message. This function would do nothing if any of the callback is empty.
+ * @param reply_to the sender of the `HrLoRa::reliable` that `data` is unwrapped from,
+ *                 to which the response is sent reliably; nullptr if `data` is not wrapped
+ */
+void handle_message(const uint8_t *data, size_t size, const handle_message_callbacks_t &callbacks,
+                    const HrLoRa::addr_t *reply_to = nullptr);
+
+#endif // BLE_LORA_ADAPTER_HANDLE_MESSAGE_H
@@ -0,0 +1,137 @@
+#ifndef BLE_LORA_ADAPTER_HR_MEASUREMENT_H
+#define BLE_LORA_ADAPTER_HR_MEASUREMENT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+/**
+ * @brief parser of the Heart Rate Measurement characteristic (0x2A37)
+ * @sa 3.103 Heart Rate Measurement of GATT Specification Supplement
+ * @sa https://community.home-assistant.io/t/ble-heartrate-monitor/300354/43
+ */
+namespace blue::hr_measurement {
+namespace flag {
+  // 0: uint8; 1: uint16 (little endian)
+  constexpr uint8_t HR_FORMAT_U16       = 1 << 0;
+  constexpr uint8_t SENSOR_CONTACT      = 1 << 1;
+  constexpr uint8_t SENSOR_CONTACT_SUPP = 1 << 2;
+  constexpr uint8_t ENERGY_EXPENDED     = 1 << 3;
+  constexpr uint8_t RR_INTERVAL         = 1 << 4;
+}
+
+/**
+ * @brief a notification could carry as many RR intervals as the MTU allows,
+ *        the ones beyond this would be dropped (the newest ones are at the end)
+ */
+constexpr size_t MAX_RR_COUNT = 16;
+
+enum class sensor_contact : uint8_t {
+  not_supported,
+  not_detected,
+  detected,
+};
+
+struct t {
+  uint16_t hr              = 0;
+  sensor_contact contact   = sensor_contact::not_supported;
+  bool has_energy_expended = false;
+  // in kilo Joules
+  uint16_t energy_expended = 0;
+  // in 1/1024 seconds, from the oldest to the newest
+  std::array<uint16_t, MAX_RR_COUNT> rr{};
+  uint8_t rr_count = 0;
+  // number of RR intervals that don't fit in `rr`
+  uint8_t rr_dropped = 0;
+
+  [[nodiscard]] constexpr std::span<const uint16_t> rr_intervals() const {
+    return std::span<const uint16_t>{rr.data(), rr_count};
+  }
+};
+
+constexpr uint16_t read_le16(const uint8_t *p) {
+  return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+/**
+ * @brief parse the value of a Heart Rate Measurement notification
+ * @param data the value of the characteristic
+ * @param[out] out the parsed result
+ * @return false if the data is truncated
+ */
+constexpr bool parse(std::span<const uint8_t> data, t &out) {
+  out = t{};
+  if (data.empty()) {
+    return false;
+  }
+  const auto flags = data[0];
+  size_t offset    = 1;
+  if (flags & flag::HR_FORMAT_U16) {
+    if (data.size() < offset + 2) {
+      return false;
+    }
+    out.hr = read_le16(data.data() + offset);
+    offset += 2;
+  } else {
+    if (data.size() < offset + 1) {
+      return false;
+    }
+    out.hr = data[offset];
+    offset += 1;
+  }
+  if (flags & flag::SENSOR_CONTACT_SUPP) {
+    out.contact = (flags & flag::SENSOR_CONTACT) ? sensor_contact::detected : sensor_contact::not_detected;
+  }
+  if (flags & flag::ENERGY_EXPENDED) {
+    if (data.size() < offset + 2) {
+      return false;
+    }
+    out.has_energy_expended = true;
+    out.energy_expended     = read_le16(data.data() + offset);
+    offset += 2;
+  }
+  if (flags & flag::RR_INTERVAL) {
+    // a trailing odd byte is ignored
+    while (data.size() >= offset + 2) {
+      if (out.rr_count < MAX_RR_COUNT) {
+        out.rr[out.rr_count++] = read_le16(data.data() + offset);
+      } else if (out.rr_dropped < UINT8_MAX) {
+        out.rr_dropped += 1;
+      }
+      offset += 2;
+    }
+  }
+  return true;
+}
+
+namespace static_tests {
+  constexpr auto parse_(std::span<const uint8_t> data) {
+    auto res = t{};
+    auto ok  = parse(data, res);
+    return std::make_pair(ok, res);
+  }
+  // uint8 hr, no contact feature
+  static_assert([] {
+    constexpr uint8_t d[] = {0x00, 72};
+    auto [ok, r]          = parse_(d);
+    return ok && r.hr == 72 && r.contact == sensor_contact::not_supported && r.rr_count == 0;
+  }());
+  // uint16 hr, contact detected, energy expended and two RR intervals
+  static_assert([] {
+    constexpr uint8_t d[] = {0x1f, 0x2c, 0x01, 0x10, 0x00, 0x00, 0x04, 0x20, 0x03};
+    auto [ok, r]          = parse_(d);
+    return ok && r.hr == 300 && r.contact == sensor_contact::detected &&
+           r.has_energy_expended && r.energy_expended == 16 &&
+           r.rr_count == 2 && r.rr[0] == 1024 && r.rr[1] == 800;
+  }());
+  // truncated
+  static_assert([] {
+    constexpr uint8_t d[] = {0x01, 0x2c};
+    return !parse_(d).first;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_HR_MEASUREMENT_H
@@ -0,0 +1,76 @@
+#ifndef BLE_LORA_ADAPTER_LBT_H
+#define BLE_LORA_ADAPTER_LBT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <etl/optional.h>
+
+/**
+ * @brief listen before talk with channel activity detection (CAD)
+ *
+ * What to do when CAD finds the channel busy, apart from the radio, so that
+ * the simulation (see `test/sim`) backs off as `radio::RadioTask` does.
+ */
+namespace lbt {
+struct config_t {
+  bool enabled = false;
+  /**
+   * @brief how many times to back off before dropping the frame
+   */
+  uint8_t max_retries = 4;
+  /**
+   * @brief back off a random number of CAD periods in [1, max_backoff_periods]
+   */
+  uint8_t max_backoff_periods = 8;
+  /**
+   * @brief roughly the time of a CAD (a couple of symbols) plus a preamble, in milliseconds
+   */
+  uint32_t cad_period_ms = 20;
+};
+
+/**
+ * @brief the retries of a frame
+ */
+class Backoff {
+  config_t config;
+  uint8_t retries = 0;
+
+public:
+  constexpr explicit Backoff(config_t config) : config(config) {}
+
+  /**
+   * @brief start over for a new frame
+   */
+  constexpr void reset() {
+    retries = 0;
+  }
+
+  /**
+   * @brief the channel is found busy
+   * @param random a random number, e.g. from `esp_random`
+   * @return how long to wait before the next CAD, in milliseconds;
+   *         nullopt if the frame should be dropped
+   */
+  constexpr etl::optional<uint32_t> on_busy(uint32_t random) {
+    if (retries >= config.max_retries) {
+      return etl::nullopt;
+    }
+    retries += 1;
+    const uint32_t periods = 1 + random % std::max<uint8_t>(config.max_backoff_periods, 1);
+    return periods * config.cad_period_ms;
+  }
+};
+
+namespace static_tests {
+  static_assert([] {
+    auto b        = Backoff{config_t{.enabled = true, .max_retries = 2, .max_backoff_periods = 8, .cad_period_ms = 20}};
+    const auto d0 = b.on_busy(0);
+    const auto d1 = b.on_busy(15);
+    const auto d2 = b.on_busy(3);
+    b.reset();
+    return d0 && *d0 == 20 && d1 && *d1 == 160 && !d2 && b.on_busy(3).has_value();
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_LBT_H
@@ -0,0 +1,124 @@
+#ifndef BLE_LORA_ADAPTER_LINK_QUALITY_H
+#define BLE_LORA_ADAPTER_LINK_QUALITY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "hr_lora.h"
+
+/**
+ * @brief RSSI and SNR of the received frames, in fixed memory
+ * @sa HrLoRa::link_stats
+ */
+namespace link_quality {
+/**
+ * @brief exponentially weighted moving average
+ */
+class Ewma {
+  float alpha;
+  float _value = 0;
+  bool has     = false;
+
+public:
+  /**
+   * @param alpha weight of the new sample, in (0, 1]
+   */
+  constexpr explicit Ewma(float alpha) : alpha(alpha) {}
+
+  constexpr void add(float sample) {
+    _value = has ? _value + alpha * (sample - _value) : sample;
+    has    = true;
+  }
+
+  [[nodiscard]] constexpr float value() const {
+    return _value;
+  }
+
+  [[nodiscard]] constexpr bool has_value() const {
+    return has;
+  }
+};
+
+/**
+ * @brief counts of samples in `N` buckets
+ * @note all the counts are halved when one of them would overflow, so the
+ *       shape is kept and the old samples weigh less
+ */
+template <size_t N>
+class Histogram {
+  std::array<uint16_t, N> _counts{};
+
+public:
+  constexpr void add(size_t bucket) {
+    if (bucket >= N) {
+      return;
+    }
+    if (_counts[bucket] == UINT16_MAX) {
+      for (auto &c : _counts) {
+        c /= 2;
+      }
+    }
+    _counts[bucket] += 1;
+  }
+
+  [[nodiscard]] constexpr const std::array<uint16_t, N> &counts() const {
+    return _counts;
+  }
+};
+
+class Monitor {
+  using link_stats = HrLoRa::link_stats;
+  Ewma rssi;
+  Ewma snr;
+  Histogram<link_stats::buckets> rssi_hist{};
+  Histogram<link_stats::buckets> snr_hist{};
+
+public:
+  constexpr explicit Monitor(float alpha = 0.125f) : rssi(alpha), snr(alpha) {}
+
+  /**
+   * @brief feed a frame that is received
+   */
+  constexpr void add(float rssi_dbm, float snr_db) {
+    rssi.add(rssi_dbm);
+    snr.add(snr_db);
+    rssi_hist.add(link_stats::rssi_bucket(rssi_dbm));
+    snr_hist.add(link_stats::snr_bucket(snr_db));
+  }
+
+  /**
+   * @brief fill the averages and the histograms of `out`
+   * @note the counters are left as they are
+   */
+  constexpr void fill(link_stats::t &out) const {
+    out.rssi_avg_dbm = rssi.value();
+    out.snr_avg_db   = snr.value();
+    for (size_t i = 0; i < link_stats::buckets; ++i) {
+      out.rssi_hist[i] = rssi_hist.counts()[i];
+      out.snr_hist[i]  = snr_hist.counts()[i];
+    }
+  }
+};
+
+namespace static_tests {
+  static_assert([] {
+    auto e = Ewma{0.5f};
+    e.add(-100);
+    e.add(-80);
+    return e.has_value() && e.value() == -90;
+  }());
+  // halved instead of overflow
+  static_assert([] {
+    auto h = Histogram<2>{};
+    h.add(1);
+    for (uint32_t i = 0; i < UINT16_MAX; ++i) {
+      h.add(0);
+    }
+    h.add(0);
+    h.add(5);
+    return h.counts()[0] == UINT16_MAX / 2 + 1 && h.counts()[1] == 0;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_LINK_QUALITY_H
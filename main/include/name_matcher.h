@@ -0,0 +1,438 @@
+#ifndef BLE_LORA_ADAPTER_NAME_MATCHER_H
+#define BLE_LORA_ADAPTER_NAME_MATCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <etl/optional.h>
+
+/**
+ * @brief match the names of advertisements against a whitelist entry,
+ *        without `std::regex`
+ *
+ * A pattern is compiled once (when the whitelist is written) into a `Matcher`
+ * of fixed size, which never allocates and runs in linear time. The regex
+ * subset is:
+ *
+ * - literal bytes, and `\` to escape a metacharacter
+ * - `.` for any byte, `\d` `\w` `\s` and the bracket classes `[a-z_]` `[^0-9]`
+ * - the quantifiers `?` `*` `+` after a single atom
+ * - the anchors `^` at the start and `$` at the end
+ *
+ * Groups, alternation and counted repetition are rejected. Without `^`, the
+ * pattern could match anywhere in the name (like `std::regex_search`).
+ * `compile_glob` takes a shell-like glob (`*`, `?`, `[...]`) for the whole name instead.
+ *
+ * A pattern of literals only (e.g. `^Polar`, `H10$`) is matched with a plain
+ * comparison instead of stepping through the atoms.
+ */
+namespace name_matcher {
+/**
+ * @brief the max number of atoms in a pattern
+ */
+constexpr size_t MAX_ATOMS = 31;
+
+enum class quantifier : uint8_t {
+  one,
+  optional,
+  star,
+  plus,
+};
+
+/**
+ * @brief a set of bytes
+ */
+class ByteSet {
+  std::array<uint32_t, 8> bits{};
+
+public:
+  constexpr void add(uint8_t c) {
+    bits[c / 32] |= uint32_t{1} << (c % 32);
+  }
+
+  constexpr void add_range(uint8_t lo, uint8_t hi) {
+    for (unsigned c = lo; c <= hi; ++c) {
+      add(static_cast<uint8_t>(c));
+    }
+  }
+
+  constexpr void invert() {
+    for (auto &b : bits) {
+      b = ~b;
+    }
+  }
+
+  [[nodiscard]] constexpr bool contains(uint8_t c) const {
+    return (bits[c / 32] >> (c % 32)) & 1;
+  }
+
+  [[nodiscard]] constexpr size_t count() const {
+    size_t n = 0;
+    for (unsigned c = 0; c < 256; ++c) {
+      n += contains(static_cast<uint8_t>(c));
+    }
+    return n;
+  }
+};
+
+struct atom_t {
+  ByteSet set{};
+  quantifier q = quantifier::one;
+  /**
+   * @brief the byte if `set` has only one, for the literal fast path
+   */
+  uint8_t literal = 0;
+  bool is_literal = false;
+};
+
+enum class kind : uint8_t {
+  /**
+   * @brief literals only; compared as a string
+   */
+  exact,
+  prefix,
+  suffix,
+  contains,
+  /**
+   * @brief stepped through the atoms
+   */
+  program,
+};
+
+class Matcher {
+  std::array<atom_t, MAX_ATOMS> atoms{};
+  size_t size         = 0;
+  bool anchored_begin = false;
+  bool anchored_end   = false;
+  kind _kind          = kind::program;
+  // the bytes of a literal pattern
+  std::array<char, MAX_ATOMS> text{};
+
+  friend constexpr etl::optional<Matcher> compile(std::string_view pattern);
+
+  /**
+   * @brief the states reachable from `states` without consuming a byte
+   */
+  [[nodiscard]] constexpr uint32_t closure(uint32_t states) const {
+    for (size_t i = 0; i < size; ++i) {
+      const auto q = atoms[i].q;
+      if ((states >> i & 1) && (q == quantifier::optional || q == quantifier::star)) {
+        states |= uint32_t{1} << (i + 1);
+      }
+    }
+    return states;
+  }
+
+  [[nodiscard]] constexpr uint32_t step(uint32_t states, uint8_t c) const {
+    uint32_t next = 0;
+    for (size_t i = 0; i < size; ++i) {
+      if (!(states >> i & 1) || !atoms[i].set.contains(c)) {
+        continue;
+      }
+      next |= uint32_t{1} << (i + 1);
+      if (atoms[i].q == quantifier::star || atoms[i].q == quantifier::plus) {
+        next |= uint32_t{1} << i;
+      }
+    }
+    return closure(next);
+  }
+
+  [[nodiscard]] constexpr bool run(std::string_view name) const {
+    const uint32_t start  = closure(1);
+    const uint32_t accept = uint32_t{1} << size;
+    uint32_t states       = start;
+    for (const auto ch : name) {
+      if (!anchored_end && (states & accept)) {
+        return true;
+      }
+      states = step(states, static_cast<uint8_t>(ch));
+      if (!anchored_begin) {
+        // a match could start at every position
+        states |= start;
+      }
+      if (states == 0) {
+        return false;
+      }
+    }
+    return (states & accept) != 0;
+  }
+
+public:
+  [[nodiscard]] constexpr kind get_kind() const {
+    return _kind;
+  }
+
+  [[nodiscard]] constexpr bool matches(std::string_view name) const {
+    const auto lit = std::string_view{text.data(), size};
+    switch (_kind) {
+      case kind::exact:
+        return name == lit;
+      case kind::prefix:
+        return name.starts_with(lit);
+      case kind::suffix:
+        return name.ends_with(lit);
+      case kind::contains:
+        return name.find(lit) != std::string_view::npos;
+      default:
+        return run(name);
+    }
+  }
+};
+
+namespace details {
+  constexpr bool is_quantifier(char c) {
+    return c == '?' || c == '*' || c == '+';
+  }
+
+  /**
+   * @brief the set of `\d`, `\w`, `\s` or an escaped byte
+   */
+  constexpr ByteSet escaped(char c) {
+    auto set = ByteSet{};
+    switch (c) {
+      case 'd':
+        set.add_range('0', '9');
+        break;
+      case 'w':
+        set.add_range('0', '9');
+        set.add_range('a', 'z');
+        set.add_range('A', 'Z');
+        set.add('_');
+        break;
+      case 's':
+        set.add(' ');
+        set.add_range('\t', '\r');
+        break;
+      default:
+        set.add(static_cast<uint8_t>(c));
+        break;
+    }
+    return set;
+  }
+
+  /**
+   * @brief parse a bracket class from `p[i]` (after `[`) to the `]`
+   * @return the index after `]`, 0 if it's not closed
+   */
+  constexpr size_t bracket(std::string_view p, size_t i, ByteSet &out) {
+    bool negate = false;
+    if (i < p.size() && p[i] == '^') {
+      negate = true;
+      i += 1;
+    }
+    bool first = true;
+    while (i < p.size() && (p[i] != ']' || first)) {
+      first   = false;
+      auto lo = static_cast<uint8_t>(p[i]);
+      if (p[i] == '\\' && i + 1 < p.size()) {
+        const auto set = escaped(p[i + 1]);
+        for (unsigned c = 0; c < 256; ++c) {
+          if (set.contains(static_cast<uint8_t>(c))) {
+            out.add(static_cast<uint8_t>(c));
+          }
+        }
+        i += 2;
+        continue;
+      }
+      if (i + 2 < p.size() && p[i + 1] == '-' && p[i + 2] != ']') {
+        const auto hi = static_cast<uint8_t>(p[i + 2]);
+        if (hi < lo) {
+          return 0;
+        }
+        out.add_range(lo, hi);
+        i += 3;
+        continue;
+      }
+      out.add(lo);
+      i += 1;
+    }
+    if (i >= p.size()) {
+      return 0;
+    }
+    if (negate) {
+      out.invert();
+    }
+    return i + 1;
+  }
+}
+
+/**
+ * @brief compile a pattern of the regex subset
+ * @return nullopt if the pattern is not supported or too long
+ */
+constexpr etl::optional<Matcher> compile(std::string_view pattern) {
+  auto m   = Matcher{};
+  size_t i = 0;
+  if (i < pattern.size() && pattern[i] == '^') {
+    m.anchored_begin = true;
+    i += 1;
+  }
+  while (i < pattern.size()) {
+    const auto c = pattern[i];
+    if (c == '$' && i + 1 == pattern.size()) {
+      m.anchored_end = true;
+      break;
+    }
+    if (m.size >= MAX_ATOMS) {
+      return etl::nullopt;
+    }
+    auto &atom = m.atoms[m.size];
+    switch (c) {
+      case '(':
+      case ')':
+      case '|':
+      case '{':
+      case '}':
+      case '^':
+      case '$':
+      case '?':
+      case '*':
+      case '+':
+        return etl::nullopt;
+      case '.':
+        atom.set.add_range(0, 255);
+        i += 1;
+        break;
+      case '[': {
+        const auto end = details::bracket(pattern, i + 1, atom.set);
+        if (end == 0) {
+          return etl::nullopt;
+        }
+        i = end;
+        break;
+      }
+      case '\\':
+        if (i + 1 >= pattern.size()) {
+          return etl::nullopt;
+        }
+        atom.set = details::escaped(pattern[i + 1]);
+        i += 2;
+        break;
+      default:
+        atom.set.add(static_cast<uint8_t>(c));
+        i += 1;
+        break;
+    }
+    if (i < pattern.size() && details::is_quantifier(pattern[i])) {
+      atom.q = pattern[i] == '?'   ? quantifier::optional
+               : pattern[i] == '*' ? quantifier::star
+                                   : quantifier::plus;
+      i += 1;
+    }
+    if (atom.q == quantifier::one && atom.set.count() == 1) {
+      for (unsigned b = 0; b < 256; ++b) {
+        if (atom.set.contains(static_cast<uint8_t>(b))) {
+          atom.literal = static_cast<uint8_t>(b);
+        }
+      }
+      atom.is_literal = true;
+    }
+    m.size += 1;
+  }
+  bool literal = true;
+  for (size_t k = 0; k < m.size; ++k) {
+    literal   = literal && m.atoms[k].is_literal;
+    m.text[k] = static_cast<char>(m.atoms[k].literal);
+  }
+  if (literal) {
+    m._kind = m.anchored_begin && m.anchored_end ? kind::exact
+              : m.anchored_begin                 ? kind::prefix
+              : m.anchored_end                   ? kind::suffix
+                                                 : kind::contains;
+  }
+  return m;
+}
+
+/**
+ * @brief compile a glob that matches the whole name, i.e. `*` for any bytes,
+ *        `?` for a byte and `[...]` for a class
+ * @return nullopt if the glob is too long
+ */
+constexpr etl::optional<Matcher> compile_glob(std::string_view glob) {
+  // translated to the regex subset, whose length is checked by `compile`
+  std::array<char, 4 * MAX_ATOMS + 2> buf{};
+  size_t n    = 0;
+  auto append = [&](char c) {
+    if (n < buf.size()) {
+      buf[n] = c;
+    }
+    n += 1;
+  };
+  append('^');
+  size_t i = 0;
+  while (i < glob.size()) {
+    const auto c = glob[i];
+    if (c == '*') {
+      append('.');
+      append('*');
+    } else if (c == '?') {
+      append('.');
+    } else if (c == '[') {
+      // copied as is, `!` negates as in the shell
+      const auto end = glob.find(']', i + 2);
+      if (end == std::string_view::npos) {
+        return etl::nullopt;
+      }
+      append('[');
+      for (size_t k = i + 1; k < end; ++k) {
+        append(k == i + 1 && glob[k] == '!' ? '^' : glob[k]);
+      }
+      append(']');
+      i = end;
+    } else {
+      const bool meta = c == '.' || c == '\\' || c == '+' || c == '(' || c == ')' ||
+                        c == '|' || c == '{' || c == '}' || c == '^' || c == '$' || c == ']';
+      if (meta) {
+        append('\\');
+      }
+      append(c);
+    }
+    i += 1;
+  }
+  append('$');
+  if (n > buf.size()) {
+    return etl::nullopt;
+  }
+  return compile(std::string_view{buf.data(), n});
+}
+
+namespace static_tests {
+  constexpr bool match(std::string_view pattern, std::string_view name) {
+    const auto m = compile(pattern);
+    return m.has_value() && m->matches(name);
+  }
+
+  static_assert(compile("^Polar")->get_kind() == kind::prefix);
+  static_assert(compile("H10$")->get_kind() == kind::suffix);
+  static_assert(compile("^HW706-0012345$")->get_kind() == kind::exact);
+  static_assert(compile("Polar H10 [0-9A-F]+$")->get_kind() == kind::program);
+
+  static_assert(match("^Polar", "Polar H10 8A2B3C4D"));
+  static_assert(!match("^Polar", "My Polar"));
+  static_assert(match("Polar", "My Polar"));
+  static_assert(match("H10$", "Polar H10"));
+  static_assert(!match("H10$", "Polar H10 1"));
+  static_assert(match("^Polar H10 [0-9A-F]+$", "Polar H10 8A2B3C4D"));
+  static_assert(!match("^Polar H10 [0-9A-F]+$", "Polar H10 8a2b3c4d"));
+  static_assert(!match("^Polar H10 [0-9A-F]+$", "Polar H10 "));
+  static_assert(match("^HW\\d+-\\d*$", "HW706-"));
+  static_assert(match("a.c", "xxabcxx"));
+  static_assert(match("^colou?r$", "color") && match("^colou?r$", "colour"));
+  static_assert(match("^a*b", "b") && match("^a*b", "aaab") && !match("^a+b", "b"));
+  static_assert(match("[^0-9]$", "H10x") && !match("[^0-9]$", "H10"));
+  static_assert(match("\\.", "a.b") && !match("\\.", "ab"));
+  static_assert(match("", "anything"));
+
+  static_assert(!compile("(a|b)").has_value());
+  static_assert(!compile("a{2}").has_value());
+  static_assert(!compile("*a").has_value());
+  static_assert(!compile("[a-").has_value());
+
+  static_assert(compile_glob("Polar*")->matches("Polar H10") && !compile_glob("Polar*")->matches("My Polar"));
+  static_assert(compile_glob("HW?06*")->matches("HW706-123"));
+  static_assert(compile_glob("[!X]*.1")->matches("a.1") && !compile_glob("[!X]*.1")->matches("X.1"));
+}
+}
+
+#endif // BLE_LORA_ADAPTER_NAME_MATCHER_H
@@ -0,0 +1,80 @@
+#ifndef BLE_LORA_ADAPTER_PATTERN_BLOB_H
+#define BLE_LORA_ADAPTER_PATTERN_BLOB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/**
+ * @brief the name patterns of the whitelist as an NVS blob, i.e. a byte of
+ *        length followed by the pattern, one after another
+ * @note the patterns are kept as written (not compiled) so that they could be
+ *       returned to the phone and compiled again by a newer firmware
+ */
+namespace pattern_blob {
+/**
+ * @brief the longest pattern that could be stored
+ */
+constexpr size_t MAX_PATTERN_SIZE = 64;
+
+constexpr size_t size_needed(std::string_view pattern) {
+  return 1 + pattern.size();
+}
+
+/**
+ * @brief append `pattern` at `offset`
+ * @return the offset after it, 0 if it's too long or `buffer` is too small
+ */
+constexpr size_t append(std::span<uint8_t> buffer, size_t offset, std::string_view pattern) {
+  if (pattern.size() > MAX_PATTERN_SIZE || offset + size_needed(pattern) > buffer.size()) {
+    return 0;
+  }
+  buffer[offset++] = static_cast<uint8_t>(pattern.size());
+  for (const auto c : pattern) {
+    buffer[offset++] = static_cast<uint8_t>(c);
+  }
+  return offset;
+}
+
+/**
+ * @brief call `f` with each pattern (a `std::string_view`) in `blob`
+ * @return false if `blob` is malformed, in which case `f` is not called at all
+ */
+template <typename F>
+constexpr bool for_each(std::span<const uint8_t> blob, F &&f) {
+  const auto valid = [&] {
+    size_t offset = 0;
+    while (offset < blob.size()) {
+      const size_t len = blob[offset];
+      if (len > MAX_PATTERN_SIZE || offset + 1 + len > blob.size()) {
+        return false;
+      }
+      offset += 1 + len;
+    }
+    return true;
+  }();
+  if (!valid) {
+    return false;
+  }
+  size_t offset = 0;
+  while (offset < blob.size()) {
+    const size_t len = blob[offset];
+    f(std::string_view{reinterpret_cast<const char *>(blob.data() + offset + 1), len});
+    offset += 1 + len;
+  }
+  return true;
+}
+
+namespace static_tests {
+  static_assert([] {
+    uint8_t buf[16] = {0};
+    auto offset     = append(buf, 0, "^Polar");
+    offset          = append(buf, offset, "");
+    return offset == 8 && buf[0] == 6 && buf[1] == '^' && buf[7] == 0 &&
+           append(buf, offset, "too long for the rest") == 0;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_PATTERN_BLOB_H
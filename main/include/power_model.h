@@ -0,0 +1,132 @@
+#ifndef BLE_LORA_ADAPTER_POWER_MODEL_H
+#define BLE_LORA_ADAPTER_POWER_MODEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include "radio_profile.h"
+
+/**
+ * @brief estimate of the charge the radio draws a day, to size the battery
+ *        of a repeater
+ * @note the transitions between modes (~1 ms each) and the MCU are not
+ *       modeled, except a constant `currents_t::mcu_ma`
+ * @sa Table 3-5 and 13.1.7 SetRxDutyCycle of SX1261/2 datasheet
+ */
+namespace power_model {
+enum class rx_mode : uint8_t {
+  /**
+   * @brief always in RX, i.e. `startReceive`
+   */
+  continuous,
+  /**
+   * @brief RX and sleep in turn, and stay in RX once a preamble is detected,
+   *        i.e. `startReceiveDutyCycleAuto`
+   */
+  duty_cycled,
+};
+
+struct currents_t {
+  /**
+   * @brief with DC-DC, at 125 kHz; a bit more at 500 kHz
+   */
+  float rx_ma = 4.6f;
+  /**
+   * @brief sleep with warm start and the RC64k timer running, which wakes it up
+   */
+  float sleep_ma = 0.0012f;
+  /**
+   * @brief anything else that is always on
+   */
+  float mcu_ma = 0;
+};
+
+struct sniff_t {
+  uint32_t rx_us;
+  uint32_t sleep_us;
+
+  [[nodiscard]] constexpr float duty() const {
+    return rx_us + sleep_us == 0 ? 1.0f : static_cast<float>(rx_us) / static_cast<float>(rx_us + sleep_us);
+  }
+};
+
+/**
+ * @brief the RX and sleep periods that RadioLib's `startReceiveDutyCycleAuto` picks
+ * @param sender_preamble_len the preamble of the frames to catch, in symbols
+ * @param min_symbols the symbols of preamble needed to detect it
+ * @return `sleep_us` is 0 if the preamble is too short to sleep at all
+ */
+constexpr sniff_t sniff_timing(const radio_profile::profile_t &p, uint16_t sender_preamble_len, uint16_t min_symbols) {
+  if (2 * min_symbols > sender_preamble_len) {
+    return sniff_t{.rx_us = 1, .sleep_us = 0};
+  }
+  const auto t_sym    = radio_profile::symbol_time_us(p);
+  const auto sleep_us = t_sym * (sender_preamble_len - 2 * min_symbols);
+  // stay awake long enough that a preamble started right before sleeping is still caught
+  const auto rx_us = std::max((t_sym * (sender_preamble_len + 1) - (sleep_us - 1000)) / 2,
+                              t_sym * (min_symbols + 1));
+  return sniff_t{.rx_us = rx_us, .sleep_us = sleep_us};
+}
+
+struct traffic_t {
+  uint32_t tx_frames_per_day = 0;
+  size_t tx_size             = 0;
+  uint32_t rx_frames_per_day = 0;
+  size_t rx_size             = 0;
+};
+
+struct config_t {
+  /**
+   * @brief what is transmitted with
+   */
+  radio_profile::profile_t tx_profile;
+  /**
+   * @brief what is received with; its `preamble_len` is the one of the sender,
+   *        i.e. the wake-up preamble in `rx_mode::duty_cycled`
+   */
+  radio_profile::profile_t rx_profile;
+  uint16_t min_symbols = 8;
+  currents_t currents{};
+};
+
+/**
+ * @return in milliampere-hours a day
+ */
+constexpr float mah_per_day(rx_mode mode, const config_t &config, const traffic_t &traffic) {
+  constexpr float day_s = 86'400.0f;
+  const auto &c         = config.currents;
+  const auto tx_toa_s   = static_cast<float>(radio_profile::time_on_air_us(config.tx_profile, traffic.tx_size)) / 1e6f;
+  const auto rx_toa_s   = static_cast<float>(radio_profile::time_on_air_us(config.rx_profile, traffic.rx_size)) / 1e6f;
+  const auto tx_s       = static_cast<float>(traffic.tx_frames_per_day) * tx_toa_s;
+  const auto rx_s       = static_cast<float>(traffic.rx_frames_per_day) * rx_toa_s;
+  const auto idle_s     = std::max(day_s - tx_s - rx_s, 0.0f);
+  const auto tx_ma      = static_cast<float>(radio_profile::tx_current_ma(config.tx_profile.power_dbm));
+  float idle_ma         = c.rx_ma;
+  if (mode == rx_mode::duty_cycled) {
+    const auto d = sniff_timing(config.rx_profile, config.rx_profile.preamble_len, config.min_symbols).duty();
+    idle_ma      = d * c.rx_ma + (1 - d) * c.sleep_ma;
+  }
+  const auto mas = tx_s * tx_ma + rx_s * c.rx_ma + idle_s * idle_ma + day_s * c.mcu_ma;
+  return mas / 3600.0f;
+}
+
+namespace static_tests {
+  constexpr auto wake = [] {
+    auto p         = radio_profile::DEFAULT_PROFILE;
+    p.preamble_len = 64;
+    return p;
+  }();
+  // SF10/500 kHz: 2.048 ms a symbol
+  static_assert(sniff_timing(wake, 64, 8).sleep_us == 98'304);
+  static_assert(sniff_timing(wake, 64, 8).rx_us == 18'432);
+  static_assert(sniff_timing(radio_profile::DEFAULT_PROFILE, 8, 8).sleep_us == 0);
+
+  constexpr auto config  = config_t{.tx_profile = radio_profile::DEFAULT_PROFILE, .rx_profile = wake};
+  constexpr auto traffic = traffic_t{.tx_frames_per_day = 16'200, .tx_size = 24, .rx_frames_per_day = 5'400, .rx_size = 8};
+  // a superframe of 16 s with 3 frames each; continuous RX alone is 110 mAh a day
+  static_assert(mah_per_day(rx_mode::continuous, config, traffic) > 110);
+  static_assert(mah_per_day(rx_mode::duty_cycled, config, traffic) < mah_per_day(rx_mode::continuous, config, traffic) / 2);
+}
+}
+
+#endif // BLE_LORA_ADAPTER_POWER_MODEL_H
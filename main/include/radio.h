@@ -0,0 +1,377 @@
+#ifndef BLE_LORA_ADAPTER_RADIO_H
+#define BLE_LORA_ADAPTER_RADIO_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <RadioLib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "radio_profile.h"
+#include "airtime.h"
+#include "rx_ring.h"
+#include "link_quality.h"
+#include "lbt.h"
+#include "esp_hal.h"
+
+namespace radio {
+/**
+ * @brief what the radio task does over SPI
+ */
+enum class spi_op : uint8_t {
+  /**
+   * @brief switch the profile and start transmitting
+   */
+  transmit,
+  /**
+   * @brief read a received frame out
+   */
+  receive,
+  /**
+   * @brief (re)start receiving
+   */
+  listen,
+  cad,
+};
+
+constexpr size_t SPI_OP_COUNT = 4;
+
+struct spi_op_stats_t {
+  uint32_t ops          = 0;
+  uint32_t transactions = 0;
+  /**
+   * @brief time spent in SPI transfers
+   */
+  uint32_t spi_us = 0;
+  /**
+   * @brief time of the whole operation, including waiting for the busy pin
+   */
+  uint32_t wall_us = 0;
+};
+
+struct stats_t {
+  /**
+   * @brief number of frames waiting in the queue
+   */
+  size_t queue_depth = 0;
+  /**
+   * @brief frames dropped because the queue is full or the frame is too large
+   */
+  uint32_t dropped   = 0;
+  uint32_t tx_done   = 0;
+  /**
+   * @brief frames failed to start transmitting
+   */
+  uint32_t tx_failed = 0;
+  /**
+   * @brief no TX done in `RadioTask::TX_TIMEOUT_MS`
+   */
+  uint32_t tx_timeout = 0;
+  uint32_t rx_done    = 0;
+  uint32_t rx_failed  = 0;
+  /**
+   * @brief frames received with a bad payload CRC
+   */
+  uint32_t crc_err = 0;
+  /**
+   * @brief frames whose header is corrupted, which never reach RX done
+   */
+  uint32_t header_err = 0;
+  /**
+   * @brief frames dropped because the consumer doesn't release the RX slots in time
+   */
+  uint32_t rx_overrun = 0;
+  /**
+   * @brief from being queued to TX done, in milliseconds
+   */
+  uint32_t last_tx_latency_ms = 0;
+  uint32_t max_tx_latency_ms  = 0;
+  /**
+   * @brief CAD found the channel busy before a transmission
+   */
+  uint32_t channel_busy = 0;
+  /**
+   * @brief frames dropped because the channel is still busy after all retries
+   */
+  uint32_t lbt_dropped = 0;
+  /**
+   * @brief airtime used in the duty cycle window, in microseconds
+   */
+  uint32_t airtime_used_us   = 0;
+  uint32_t airtime_budget_us = 0;
+  /**
+   * @brief airtime used since boot, in milliseconds
+   */
+  uint32_t airtime_total_ms = 0;
+  /**
+   * @brief frames dropped to stay in the duty cycle, indexed by `airtime::traffic_class`
+   */
+  std::array<uint32_t, airtime::TRAFFIC_CLASS_COUNT> duty_dropped{};
+  /**
+   * @brief indexed by `spi_op`
+   * @note an operation nested in another (e.g. `listen` after a failed
+   *       `transmit`) is counted in both
+   */
+  std::array<spi_op_stats_t, SPI_OP_COUNT> spi{};
+  /**
+   * @brief from the DIO1 edge (in the ISR) to the radio task handling it,
+   *        in microseconds
+   */
+  uint32_t dio1_wakeups         = 0;
+  uint32_t last_dio1_latency_us = 0;
+  uint32_t max_dio1_latency_us  = 0;
+  uint32_t avg_dio1_latency_us  = 0;
+};
+
+/**
+ * @brief listen before talk with channel activity detection (CAD)
+ */
+using lbt_config_t = lbt::config_t;
+
+/**
+ * @brief receive in duty cycle (RX and sleep in turn) instead of continuously
+ * @sa power_model::sniff_timing
+ */
+struct sniff_config_t {
+  bool enabled = false;
+  /**
+   * @brief the preamble of the frames from the gateway, in symbols
+   * @note the gateway should send with a preamble at least this long, or the
+   *       frame might be missed while sleeping
+   */
+  uint16_t wake_preamble_len = 64;
+  /**
+   * @brief the symbols of preamble needed to detect it
+   */
+  uint16_t min_symbols = 8;
+};
+
+/**
+ * @brief a task that owns the radio
+ *
+ * Other tasks never touch the radio directly. Frames are put into a bounded
+ * queue with `send`, which never blocks; the task starts transmitting with
+ * `startTransmit` and waits for the TX done interrupt on DIO1, then returns
+ * to receiving. Received frames are put into a ring of RX slots, which the
+ * consumer reads in place with `wait_receive` and `release_receive`.
+ *
+ * With `lbt` enabled, CAD is run before each transmission. If the channel is
+ * busy, the frame waits a random number of CAD periods (receiving in the
+ * meantime) and tries again.
+ *
+ * The radio always receives with `rx_profile`. A different TX profile could be
+ * set with `set_tx_profile`; the modulation is switched before transmitting and
+ * switched back after that.
+ *
+ * The time on air of every transmission is recorded in a sliding window.
+ * A frame is dropped instead of transmitted if it would exceed the budget
+ * of its `airtime::traffic_class`.
+ *
+ * With `sniff` enabled, the radio sleeps most of the time between
+ * transmissions and only wakes up to look for a (long) preamble.
+ */
+class RadioTask {
+public:
+  static constexpr size_t MAX_FRAME_SIZE = 128;
+  static constexpr size_t QUEUE_LENGTH   = 8;
+  /**
+   * @brief the max time to wait for TX done before giving up
+   */
+  static constexpr uint32_t TX_TIMEOUT_MS = 2000;
+
+  /**
+   * @brief the duty cycle window is divided into this many buckets
+   */
+  static constexpr size_t AIRTIME_BUCKETS = 60;
+
+  static constexpr size_t RX_SLOTS    = 4;
+  static constexpr size_t MAX_RX_SIZE = 255;
+  using rx_ring_t                     = RxRing<RX_SLOTS, MAX_RX_SIZE>;
+  using rx_slot_t                     = rx_ring_t::slot_t;
+
+  struct frame_t {
+    airtime::traffic_class cls;
+    /**
+     * @brief 0 for the frequency of the TX profile
+     */
+    float freq_mhz;
+    uint8_t size;
+    uint32_t queued_ms;
+    uint8_t data[MAX_FRAME_SIZE];
+  };
+
+  /**
+   * @note should be set before `start`
+   */
+  lbt_config_t lbt{};
+  /**
+   * @note should be set before `start`
+   */
+  sniff_config_t sniff{};
+
+private:
+  // bits of the task notification value
+  static constexpr uint32_t Dio1Evt = BIT0;
+  static constexpr uint32_t TxEvt   = BIT1;
+
+  LLCC68 &rf;
+  ESPHal &hal;
+  uint32_t dio1_pin;
+  QueueHandle_t queue = nullptr;
+  StaticQueue_t queue_buf{};
+  uint8_t queue_storage[QUEUE_LENGTH * sizeof(frame_t)]{};
+  TaskHandle_t task_handle = nullptr;
+  // only touched by the task
+  stats_t _stats{};
+  // a copy of `_stats` for the other tasks, made by the task after each event
+  stats_t published{};
+  mutable portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+  const radio_profile::profile_t &rx_profile;
+  std::atomic<const radio_profile::profile_t *> tx_profile;
+  // what the radio is configured with
+  radio_profile::profile_t applied;
+  rx_ring_t rx{};
+  // counts the committed slots
+  SemaphoreHandle_t rx_sem = nullptr;
+  StaticSemaphore_t rx_sem_buf{};
+  // where a frame goes when the ring is full, so that the radio is cleared
+  rx_slot_t rx_scratch{};
+  airtime::Ledger<AIRTIME_BUCKETS> ledger;
+  // increased by the caller of `send`
+  std::atomic<uint32_t> _dropped = 0;
+  link_quality::Monitor quality{};
+  // written by the ISR, when DIO1 rises; the low word of `esp_timer_get_time`,
+  // since a 64-bit store isn't atomic on RV32 and the task could read half of it
+  volatile uint32_t dio1_at_us   = 0;
+  uint64_t total_dio1_latency_us = 0;
+
+  /**
+   * @brief account the SPI transactions and the time in its scope to `op`
+   */
+  class SpiProbe {
+    RadioTask &self;
+    spi_op op;
+    ESPHal::spi_stats_t start{};
+    int64_t start_us;
+
+  public:
+    SpiProbe(RadioTask &self, spi_op op);
+    ~SpiProbe();
+  };
+
+  /**
+   * @param arg the `RadioTask`
+   */
+  static void on_dio1(void *arg);
+  /**
+   * @brief record the time from the DIO1 edge to now
+   */
+  void record_dio1_latency();
+
+  static void run(void *pvParameter);
+  void loop();
+  /**
+   * @brief copy `_stats` to `published`
+   */
+  void publish_stats();
+  /**
+   * @param irq_flags what has been read in the loop, to save an SPI transaction
+   */
+  void receive(uint16_t irq_flags);
+  /**
+   * @brief the TX profile with the frequency of `frame`
+   */
+  [[nodiscard]] radio_profile::profile_t profile_of(const frame_t &frame) const;
+  bool start_transmit(const frame_t &frame);
+  /**
+   * @brief switch back to `rx_profile` if needed and start receiving,
+   *        continuously or in duty cycle
+   */
+  void start_receive();
+  /**
+   * @brief configure the radio with `profile` if it's not yet
+   */
+  void apply(const radio_profile::profile_t &profile);
+  /**
+   * @return whether the channel is free
+   */
+  bool is_channel_free();
+
+public:
+  /**
+   * @param rf should be began with `rx_profile`
+   * @param duty_cycle the airtime budget
+   * @param hal the HAL of `rf`; the DIO1 interrupt is attached with it, and the
+   *        SPI transactions of each operation are counted in `stats_t::spi`
+   * @param dio1_pin the same as the one of the `Module` of `rf`
+   */
+  RadioTask(LLCC68 &rf, const radio_profile::profile_t &rx_profile, airtime::config_t duty_cycle, ESPHal &hal, uint32_t dio1_pin)
+      : rf(rf), hal(hal), dio1_pin(dio1_pin), rx_profile(rx_profile), tx_profile(&rx_profile), applied(rx_profile), ledger(duty_cycle) {}
+
+  /**
+   * @brief attach the DIO1 interrupt, start receiving and start the task
+   * @note `rf` should be began before this; should be called only once
+   */
+  void start(uint32_t stack_size = 4096, UBaseType_t priority = 2);
+
+  /**
+   * @brief queue a frame to be transmitted
+   * @param cls decides which frames are dropped first when the airtime budget runs low
+   * @param freq_mhz the channel to transmit on (see `channel_plan`), 0 for the
+   *        frequency of the TX profile; the radio returns to `rx_profile` after that
+   * @return false if the frame is dropped
+   * @note never blocks; could be called from any task
+   */
+  bool send(std::span<const uint8_t> data, airtime::traffic_class cls = airtime::traffic_class::control, float freq_mhz = 0);
+  bool send(const uint8_t *data, size_t size, airtime::traffic_class cls = airtime::traffic_class::control, float freq_mhz = 0) {
+    return send(std::span<const uint8_t>{data, size}, cls, freq_mhz);
+  }
+
+  /**
+   * @brief the counters as of the last event handled by the task
+   * @note could be called from any task
+   */
+  [[nodiscard]] stats_t stats() const;
+
+  /**
+   * @brief RSSI/SNR of the received frames and the error counters
+   * @note the counters are consistent with each other (see `stats`), while
+   *       RSSI/SNR are read without a lock and might be a frame behind them
+   */
+  [[nodiscard]] HrLoRa::link_stats::t link_stats() const;
+
+  /**
+   * @brief the profile used for the following transmissions
+   * @note `profile` should outlive the task (e.g. an entry of `radio_profile::PROFILES`)
+   */
+  void set_tx_profile(const radio_profile::profile_t &profile) {
+    tx_profile = &profile;
+  }
+
+  [[nodiscard]] const radio_profile::profile_t &current_tx_profile() const {
+    return *tx_profile.load();
+  }
+
+  /**
+   * @brief wait for a received frame
+   * @return the oldest received frame, nullptr if timeout; it's valid until
+   *         `release_receive` is called
+   * @note single consumer
+   */
+  const rx_slot_t *wait_receive(TickType_t timeout);
+
+  /**
+   * @brief give the slot from `wait_receive` back
+   */
+  void release_receive() {
+    rx.release();
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_RADIO_H
@@ -0,0 +1,303 @@
+#ifndef BLE_LORA_ADAPTER_RADIO_PROFILE_H
+#define BLE_LORA_ADAPTER_RADIO_PROFILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @brief named LoRa modulation and power settings, and the selection of them
+ *        by the quality of the link to the gateway
+ * @sa https://www.semtech.com/design-support/lora-calculator
+ * @sa AN1200.13 LoRa Modem Designer's Guide
+ */
+namespace radio_profile {
+struct profile_t {
+  const char *name;
+  float freq_mhz;
+  float bw_khz;
+  uint8_t sf;
+  /**
+   * @brief denominator of the coding rate, i.e. 5 to 8 for 4/5 to 4/8
+   */
+  uint8_t cr;
+  int8_t power_dbm;
+  uint16_t preamble_len;
+};
+
+constexpr bool operator==(const profile_t &a, const profile_t &b) {
+  return a.freq_mhz == b.freq_mhz && a.bw_khz == b.bw_khz && a.sf == b.sf &&
+         a.cr == b.cr && a.power_dbm == b.power_dbm && a.preamble_len == b.preamble_len;
+}
+
+/**
+ * @brief whether `a` and `b` could hear each other, i.e. the power is not considered
+ */
+constexpr bool is_same_modulation(const profile_t &a, const profile_t &b) {
+  return a.freq_mhz == b.freq_mhz && a.bw_khz == b.bw_khz && a.sf == b.sf &&
+         a.cr == b.cr && a.preamble_len == b.preamble_len;
+}
+
+constexpr uint32_t symbol_time_us(const profile_t &p) {
+  return static_cast<uint32_t>((uint32_t{1} << p.sf) * 1000.0f / p.bw_khz);
+}
+
+/**
+ * @brief time on air of a frame with explicit header and CRC, in microseconds
+ * @param payload_len the size of the payload in bytes
+ * @note low data rate optimization is assumed when the symbol time is 16 ms or longer,
+ *       which is what RadioLib does
+ */
+constexpr uint32_t time_on_air_us(const profile_t &p, size_t payload_len) {
+  const auto t_sym   = symbol_time_us(p);
+  const int de       = t_sym >= 16000 ? 1 : 0;
+  const int sf       = p.sf;
+  const int cr       = p.cr - 4;
+  const int num      = 8 * static_cast<int>(payload_len) - 4 * sf + 28 + 16;
+  const int den      = 4 * (sf - 2 * de);
+  const int ceil_div = num <= 0 ? 0 : (num + den - 1) / den;
+  const auto n_sym   = 8 + ceil_div * (cr + 4);
+  // preamble + 4.25 symbols of sync word
+  const auto t_preamble = (p.preamble_len * 4 + 17) * t_sym / 4;
+  return t_preamble + n_sym * t_sym;
+}
+
+/**
+ * @return in bits per second
+ */
+constexpr uint32_t throughput_bps(const profile_t &p, size_t payload_len) {
+  return static_cast<uint32_t>(payload_len * 8 * 1000000ull / time_on_air_us(p, payload_len));
+}
+
+/**
+ * @brief approximate TX current of LLCC68 with the high power PA
+ * @return in milliamperes
+ * @sa Table 3-6 of LLCC68 datasheet
+ */
+constexpr uint32_t tx_current_ma(int8_t power_dbm) {
+  if (power_dbm >= 22) {
+    return 118;
+  } else if (power_dbm >= 20) {
+    return 102;
+  } else if (power_dbm >= 17) {
+    return 95;
+  } else if (power_dbm >= 14) {
+    return 90;
+  } else {
+    return 45;
+  }
+}
+
+/**
+ * @brief energy of transmitting a frame at 3.3 V, in microjoules
+ */
+constexpr uint32_t energy_per_frame_uj(const profile_t &p, size_t payload_len) {
+  return static_cast<uint32_t>(uint64_t{time_on_air_us(p, payload_len)} * tx_current_ma(p.power_dbm) * 33 / 10 / 1000);
+}
+
+/**
+ * @brief the SNR below which the frame could not be demodulated
+ * @sa Table 6-1 of SX1261/2 datasheet
+ */
+constexpr float required_snr_db(uint8_t sf) {
+  switch (sf) {
+    case 5: return -2.5f;
+    case 6: return -5.0f;
+    case 7: return -7.5f;
+    case 8: return -10.0f;
+    case 9: return -12.5f;
+    case 10: return -15.0f;
+    case 11: return -17.5f;
+    default: return -20.0f;
+  }
+}
+
+/**
+ * @brief from the most robust to the fastest (and the most power saving)
+ * @note the first one is what the gateway uses, and it's always used for receiving.
+ *       Profiles with a different modulation would only be heard by a gateway
+ *       that listens on them; see `adapter_config_t::max_index`.
+ */
+constexpr auto PROFILES = std::array<profile_t, 6>{{
+    {.name = "sf10_22dbm", .freq_mhz = 433.2f, .bw_khz = 500.0f, .sf = 10, .cr = 7, .power_dbm = 22, .preamble_len = 8},
+    {.name = "sf10_17dbm", .freq_mhz = 433.2f, .bw_khz = 500.0f, .sf = 10, .cr = 7, .power_dbm = 17, .preamble_len = 8},
+    {.name = "sf10_14dbm", .freq_mhz = 433.2f, .bw_khz = 500.0f, .sf = 10, .cr = 7, .power_dbm = 14, .preamble_len = 8},
+    {.name = "sf9_14dbm", .freq_mhz = 433.2f, .bw_khz = 500.0f, .sf = 9, .cr = 7, .power_dbm = 14, .preamble_len = 8},
+    {.name = "sf8_14dbm", .freq_mhz = 433.2f, .bw_khz = 500.0f, .sf = 8, .cr = 7, .power_dbm = 14, .preamble_len = 8},
+    {.name = "sf7_10dbm", .freq_mhz = 433.2f, .bw_khz = 500.0f, .sf = 7, .cr = 5, .power_dbm = 10, .preamble_len = 8},
+}};
+
+// inline, since a reference at namespace scope is not internal like a const object
+inline constexpr const profile_t &DEFAULT_PROFILE = PROFILES[0];
+
+/**
+ * @return the index of the last profile that shares the modulation of `DEFAULT_PROFILE`
+ */
+consteval size_t last_power_only_index() {
+  size_t i = 0;
+  while (i + 1 < PROFILES.size() && is_same_modulation(PROFILES[i + 1], DEFAULT_PROFILE)) {
+    i += 1;
+  }
+  return i;
+}
+
+struct adapter_config_t {
+  /**
+   * @brief the highest profile index the adapter could step up to
+   */
+  size_t max_index = last_power_only_index();
+  /**
+   * @brief step up when the margin of the next profile is above this
+   */
+  float up_margin_db = 10.0f;
+  /**
+   * @brief step down when the margin of the current profile is below this
+   */
+  float down_margin_db = 5.0f;
+  /**
+   * @brief number of consecutive good samples before stepping up
+   */
+  uint8_t up_count = 4;
+  /**
+   * @brief fall back to the first profile if nothing is heard from the gateway for this long
+   */
+  uint32_t silence_ms = 120'000;
+  /**
+   * @brief weight of the new sample in the moving average, in (0, 1]
+   */
+  float alpha = 0.25f;
+  /**
+   * @brief the noise floor of the receiver, used when SNR saturates
+   * @note -174 dBm/Hz + 10 log10(500 kHz) + 6 dB noise figure
+   */
+  float noise_floor_dbm = -111.0f;
+};
+
+/**
+ * @brief select the TX profile by SNR and RSSI of the frames heard from the gateway
+ *
+ * The link is assumed to be symmetric, i.e. what we hear from the gateway (sent
+ * with `PROFILES[0]`) is what the gateway would hear from us. The margin of a
+ * profile is the estimated SNR, less the power we save, less the SNR that its SF
+ * requires. Stepping down takes one bad sample, while stepping up takes
+ * `up_count` good ones in a row, so it won't flap around a threshold.
+ */
+class Adapter {
+  adapter_config_t config;
+  size_t _index      = 0;
+  float snr_avg      = 0;
+  bool has_sample    = false;
+  uint8_t good_count = 0;
+  uint32_t last_ms   = 0;
+
+  [[nodiscard]] constexpr float margin_db(size_t i) const {
+    const auto &p   = PROFILES[i];
+    const auto loss = static_cast<float>(DEFAULT_PROFILE.power_dbm - p.power_dbm);
+    return snr_avg - loss - required_snr_db(p.sf);
+  }
+
+public:
+  constexpr explicit Adapter(adapter_config_t config = {})
+      : config(config) {
+    this->config.max_index = std::min(config.max_index, PROFILES.size() - 1);
+  }
+
+  [[nodiscard]] constexpr size_t index() const {
+    return _index;
+  }
+
+  [[nodiscard]] constexpr const profile_t &profile() const {
+    return PROFILES[_index];
+  }
+
+  /**
+   * @brief SNR is saturated around +10 dB for strong signals, where RSSI tells more
+   */
+  [[nodiscard]] constexpr float estimate_snr(float snr_db, float rssi_dbm) const {
+    if (snr_db < 5.0f) {
+      return snr_db;
+    }
+    return std::max(snr_db, rssi_dbm - config.noise_floor_dbm);
+  }
+
+  /**
+   * @brief feed a frame heard from the gateway
+   * @return whether the profile is changed
+   */
+  constexpr bool update(float snr_db, float rssi_dbm, uint32_t now_ms) {
+    const auto snr = estimate_snr(snr_db, rssi_dbm);
+    snr_avg        = has_sample ? snr_avg + config.alpha * (snr - snr_avg) : snr;
+    has_sample     = true;
+    last_ms        = now_ms;
+    const auto old = _index;
+    if (margin_db(_index) < config.down_margin_db) {
+      good_count = 0;
+      // drop to the first profile that works, or the most robust one
+      while (_index > 0 && margin_db(_index) < config.down_margin_db) {
+        _index -= 1;
+      }
+    } else if (_index < config.max_index && margin_db(_index + 1) >= config.up_margin_db) {
+      good_count += 1;
+      if (good_count >= config.up_count) {
+        good_count = 0;
+        _index += 1;
+      }
+    } else {
+      good_count = 0;
+    }
+    return old != _index;
+  }
+
+  /**
+   * @brief fall back to the most robust profile if the gateway is silent
+   * @return whether the profile is changed
+   */
+  constexpr bool check_silence(uint32_t now_ms) {
+    if (_index == 0 || now_ms - last_ms < config.silence_ms) {
+      return false;
+    }
+    _index     = 0;
+    has_sample = false;
+    good_count = 0;
+    return true;
+  }
+};
+
+namespace static_tests {
+  constexpr auto sf7_125  = profile_t{.name = "", .freq_mhz = 433.2f, .bw_khz = 125.0f, .sf = 7, .cr = 5, .power_dbm = 14, .preamble_len = 8};
+  constexpr auto sf12_125 = profile_t{.name = "", .freq_mhz = 433.2f, .bw_khz = 125.0f, .sf = 12, .cr = 5, .power_dbm = 14, .preamble_len = 8};
+  // Semtech LoRa calculator: 41.22 ms and 991.23 ms
+  static_assert(time_on_air_us(sf7_125, 10) == 41216);
+  static_assert(time_on_air_us(sf12_125, 10) == 991232);
+  static_assert(time_on_air_us(PROFILES[5], 16) < time_on_air_us(PROFILES[0], 16) / 5);
+  static_assert(last_power_only_index() == 2);
+
+  // steps up slowly and down at once
+  static_assert([] {
+    auto a = Adapter{adapter_config_t{.max_index = PROFILES.size() - 1, .up_count = 2, .alpha = 1.0f}};
+    a.update(8, -60, 0);
+    const auto one = a.index();
+    a.update(8, -60, 1);
+    const auto two = a.index();
+    a.update(-10, -105, 2);
+    return one == 0 && two == 1 && a.index() == 0;
+  }());
+  // never beyond `max_index`
+  static_assert([] {
+    auto a = Adapter{};
+    for (uint32_t i = 0; i < 64; ++i) {
+      a.update(10, -40, i);
+    }
+    return a.index() == last_power_only_index();
+  }());
+  // falls back when the gateway is silent
+  static_assert([] {
+    auto a = Adapter{adapter_config_t{.up_count = 1}};
+    a.update(10, -40, 0);
+    return a.index() == 1 && a.check_silence(200'000) && a.index() == 0;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_RADIO_PROFILE_H
@@ -0,0 +1,153 @@
+#ifndef BLE_LORA_ADAPTER_RX_RING_H
+#define BLE_LORA_ADAPTER_RX_RING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace radio {
+namespace irq {
+  // the same bits as `RADIOLIB_SX126X_IRQ_*`
+  constexpr uint16_t TX_DONE    = 1 << 0;
+  constexpr uint16_t RX_DONE    = 1 << 1;
+  constexpr uint16_t HEADER_ERR = 1 << 5;
+  constexpr uint16_t CRC_ERR    = 1 << 6;
+  constexpr uint16_t TIMEOUT    = 1 << 9;
+
+  /**
+   * @brief format the flags like "rc" (RX done, CRC error)
+   * @param out at least 6 bytes, NUL terminated
+   */
+  constexpr void to_chars(uint16_t flags, char *out) {
+    size_t i = 0;
+    if (flags & TIMEOUT) {
+      out[i++] = 't';
+    }
+    if (flags & RX_DONE) {
+      out[i++] = 'r';
+    }
+    if (flags & CRC_ERR) {
+      out[i++] = 'c';
+    }
+    if (flags & HEADER_ERR) {
+      out[i++] = 'h';
+    }
+    if (flags & TX_DONE) {
+      out[i++] = 'x';
+    }
+    out[i] = '\0';
+  }
+}
+
+/**
+ * @brief a received frame and what the radio knows about it
+ */
+template <size_t MaxSize>
+struct rx_slot_t {
+  uint32_t timestamp_ms = 0;
+  float rssi_dbm        = 0;
+  float snr_db          = 0;
+  uint16_t irq_flags    = 0;
+  uint16_t size         = 0;
+  std::array<uint8_t, MaxSize> data{};
+
+  [[nodiscard]] constexpr std::span<const uint8_t> frame() const {
+    return std::span<const uint8_t>{data.data(), size};
+  }
+};
+
+/**
+ * @brief a single producer, single consumer ring of RX slots
+ *
+ * The producer (the radio task) reads the frame right into the slot from
+ * `acquire` and publishes it with `commit`. The consumer reads it in place
+ * through `front` and gives it back with `release`. Nothing is copied and
+ * nothing is locked.
+ *
+ * @tparam N number of slots, a power of 2
+ */
+template <size_t N, size_t MaxSize>
+class RxRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N should be a power of 2");
+
+public:
+  using slot_t = rx_slot_t<MaxSize>;
+
+private:
+  std::array<slot_t, N> slots{};
+  // written by the producer only
+  std::atomic<uint32_t> head     = 0;
+  // written by the consumer only
+  std::atomic<uint32_t> tail     = 0;
+  std::atomic<uint32_t> _overrun = 0;
+
+public:
+  /**
+   * @brief the slot to be filled, nullptr if the consumer is too slow
+   * @note producer only; the overrun counter is increased if full
+   */
+  slot_t *acquire() {
+    const auto h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) {
+      _overrun.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slots[h % N];
+  }
+
+  /**
+   * @brief publish the slot from `acquire`
+   * @note producer only
+   */
+  void commit() {
+    head.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   * @brief the oldest published slot, nullptr if empty
+   * @note consumer only; the slot is valid until `release`
+   */
+  const slot_t *front() const {
+    const auto t = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == t) {
+      return nullptr;
+    }
+    return &slots[t % N];
+  }
+
+  /**
+   * @brief give the slot from `front` back to the producer
+   * @note consumer only
+   */
+  void release() {
+    tail.fetch_add(1, std::memory_order_release);
+  }
+
+  [[nodiscard]] size_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief frames dropped because the ring is full
+   */
+  [[nodiscard]] uint32_t overrun() const {
+    return _overrun.load(std::memory_order_relaxed);
+  }
+
+  static constexpr size_t capacity() {
+    return N;
+  }
+};
+
+namespace static_tests {
+  static_assert([] {
+    char buf[6] = {};
+    irq::to_chars(irq::RX_DONE | irq::CRC_ERR, buf);
+    return buf[0] == 'r' && buf[1] == 'c' && buf[2] == '\0';
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_RX_RING_H
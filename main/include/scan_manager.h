@@ -9,6 +9,8 @@
 #include <etl/map.h>
 #include <etl/algorithm.h>
 #include <etl/flat_map.h>
+#include <atomic>
+#include <span>
 #include <NimBLEDevice.h>
 #include "wifi_entity.h"
 #include "heart_monitor.h"
@@ -16,11 +18,34 @@
 #include "utils.h"
 #include "common.h"
 #include "app_nvs.h"
+#include "hr_lora.h"
+#include "name_matcher.h"
+#include "addr_set.h"
+#include "pattern_blob.h"
+#include "seen_cache.h"
 
 namespace blue {
-const int MAX_DEVICE_NUM  = 12;
-const int MAX_SERVICE_NUM = 4;
-const int MAX_CHAR_NUM    = 4;
+/**
+ * @brief the max number of target devices
+ */
+const int MAX_DEVICE_NUM = 12;
+/**
+ * @brief the max number of name patterns in the whitelist
+ */
+const int MAX_NAME_PATTERN_NUM = 4;
+/**
+ * @brief the size of the name patterns in NVS, at most
+ * @sa pattern_blob
+ */
+const size_t NAME_PATTERN_BLOB_SIZE = MAX_NAME_PATTERN_NUM * (1 + pattern_blob::MAX_PATTERN_SIZE);
+/**
+ * @brief the size of the name map keys of the devices in NVS, at most; the
+ *        address and then the key of each
+ * @sa ScanManager::export_keys
+ */
+const size_t DEVICE_KEY_BLOB_SIZE = MAX_DEVICE_NUM * (HeartMonitor::ADDR_SIZE + sizeof(HrLoRa::name_map_key_t));
+const int MAX_SERVICE_NUM         = 4;
+const int MAX_CHAR_NUM            = 4;
 
 /**
  * @brief print all services and characteristics of a device
@@ -62,99 +87,552 @@ void print_services_chars(NimBLEClient &client) {
   }
 }
 
+/**
+ * @brief scan for the target devices and keep them connected, up to
+ *        `MAX_DEVICE_NUM` targets
+ *
+ * Each target has its own connection state, name map key and reconnect
+ * backoff. Only one connection is attempted at a time (NimBLE could only
+ * initiate one), and at most `MAX_CONNECTED` are connected at the same time;
+ * the rest wait until one of them disconnects. Scanning runs as long as any
+ * target is not connected.
+ *
+ * The addresses of the targets and the name patterns are mirrored into a
+ * snapshot (`targets_t`), double buffered and swapped atomically whenever
+ * they change, so that `onResult` could filter the advertisements of
+ * everyone else with a hash lookup and without taking the lock.
+ */
 class ScanManager : public NimBLEScanCallbacks {
 public:
   using addr_t       = HeartMonitor::addr_t;
   using device_ptr_t = std::unique_ptr<HeartMonitor>;
   using addr_ptr_t   = std::unique_ptr<white_list::Addr>;
+  using seen_cache_t = seen_cache::SeenCache<common::MAX_SEEN_DEVICE_NUM, common::SEEN_NAME_SIZE>;
+  /**
+   * @brief one of the connections is the phone (as a server), and no more
+   *        than LoRa could carry within the duty cycle, which is fewer than
+   *        NimBLE allows; the other targets wait for one to disconnect
+   * @sa common::MAX_BRIDGED_DEVICES
+   */
+  static constexpr size_t MAX_CONNECTED = std::min<size_t>(CONFIG_BT_NIMBLE_MAX_CONNECTIONS - 1,
+                                                           common::MAX_BRIDGED_DEVICES);
+  /**
+   * @brief the wait before reconnecting, doubled after each failure
+   */
+  static constexpr uint32_t RECONNECT_BASE_MS = 1'000;
+  static constexpr uint32_t RECONNECT_MAX_MS  = 60'000;
+
+  enum class conn_state : uint8_t {
+    /**
+     * @brief waiting for an advertisement (and the backoff to be over)
+     */
+    waiting,
+    connecting,
+    connected,
+  };
 
   /**
-   * @brief callback when we have scan result
-   * @param device name
+   * @brief callback when a device is new or has changed, within the budget of `seen`
+   * @param device name, the last known one
    * @param 6 bytes (48 bits) of mac address
    */
-  std::function<void(std::string, const uint8_t *)> on_result = nullptr;
+  std::function<void(std::string_view, const uint8_t *)> on_result = nullptr;
+  /**
+   * @brief a notification of heart rate measurement from the device at `addr`
+   */
+  std::function<void(const addr_t &addr, uint8_t *data, size_t size)> on_data = nullptr;
+  /**
+   * @brief the devices seen recently, which decides what reaches `on_result`
+   * @note only touched in `onResult`
+   */
+  seen_cache_t seen{seen_cache::config_t{
+      .per_second = common::SCAN_RESULT_PER_SECOND,
+      .burst      = common::SCAN_RESULT_BURST,
+  }};
 
 private:
   static constexpr auto TAG = "ScanManager";
-  addr_ptr_t target_addr    = nullptr;
-  device_ptr_t device       = nullptr;
+  struct entry_t {
+    conn_state state = conn_state::waiting;
+    /**
+     * @brief created on the first connection and reused after that
+     */
+    device_ptr_t device = nullptr;
+    /**
+     * @brief the name map key assigned to this device, if any
+     */
+    etl::optional<HrLoRa::name_map_key_t> key = etl::nullopt;
+    uint8_t failures     = 0;
+    uint32_t retry_at_ms = 0;
+  };
+  using table_t    = etl::flat_map<addr_t, entry_t, MAX_DEVICE_NUM>;
+  using addr_set_t = addr_set::AddrSet<32>;
+  using patterns_t = etl::vector<name_matcher::Matcher, MAX_NAME_PATTERN_NUM>;
+  static_assert(addr_set_t::max_size >= MAX_DEVICE_NUM);
+  static_assert(addr_set::ADDR_SIZE == HeartMonitor::ADDR_SIZE);
+  table_t table{};
+  /**
+   * @brief a device whose name matches any of them becomes a target
+   */
+  patterns_t patterns{};
+  /**
+   * @brief `patterns` as written, in the same order
+   */
+  etl::vector<std::string, MAX_NAME_PATTERN_NUM> pattern_sources{};
+  /**
+   * @brief what `onResult` checks without the lock
+   */
+  struct targets_t {
+    addr_set_t addrs{};
+    patterns_t patterns{};
+  };
+  std::array<targets_t, 2> target_buf{};
+  std::atomic<const targets_t *> targets{&target_buf[0]};
+  /**
+   * @brief the number of `onResult` reading `targets`
+   */
+  std::atomic<uint32_t> readers{0};
+  StaticSemaphore_t lock_buf{};
+  SemaphoreHandle_t lock = xSemaphoreCreateMutexStatic(&lock_buf);
   /**
    * @note could be nullptr if the scanning task is not running
-   *  (either haven't kick-started or the device already connected)
+   *  (either haven't kick-started or all the devices already connected)
    */
   TaskHandle_t scan_task_handle = nullptr;
 
+  static uint32_t now_ms() {
+    return esp_timer_get_time() / 1000;
+  }
+
+  /**
+   * @brief compile a name pattern, which should also fit in `pattern_blob`
+   */
+  static etl::optional<name_matcher::Matcher> compile_pattern(std::string_view pattern) {
+    if (pattern.size() > pattern_blob::MAX_PATTERN_SIZE) {
+      ESP_LOGE(TAG, "name pattern too long (%zu > %zu)", pattern.size(), pattern_blob::MAX_PATTERN_SIZE);
+      return etl::nullopt;
+    }
+    auto matcher = name_matcher::compile(pattern);
+    if (!matcher) {
+      ESP_LOGE(TAG, "unsupported name pattern: %.*s", static_cast<int>(pattern.size()), pattern.data());
+    }
+    return matcher;
+  }
+
+  static uint32_t backoff_ms(uint8_t failures) {
+    const auto shift = std::min<uint8_t>(failures, 16);
+    return std::min<uint32_t>(RECONNECT_BASE_MS << shift, RECONNECT_MAX_MS);
+  }
+
   class ClientCallback : public NimBLEClientCallbacks {
     ScanManager *scan_manager_ptr;
+    addr_t addr;
 
   public:
-    explicit ClientCallback(ScanManager *scan_manager) : scan_manager_ptr(scan_manager) {}
+    ClientCallback(ScanManager *scan_manager, const addr_t &addr) : scan_manager_ptr(scan_manager), addr(addr) {}
     void onDisconnect(NimBLEClient *pClient, int reason) override {
       const auto TAG = "ClientCallback::onDisconnect";
       ESP_LOGI(TAG, "Disconnected from %s", pClient->getPeerAddress().toString().c_str());
       [[likely]] if (scan_manager_ptr != nullptr) {
-        bool ok = scan_manager_ptr->start_scanning_task();
-        if (!ok) {
-          ESP_LOGW(TAG, "scanning task already running");
-        }
+        scan_manager_ptr->on_disconnected(addr);
       } else {
         ESP_LOGE(TAG, "scan_manager_ptr is nullptr");
       }
     }
   };
 
+  void on_disconnected(const addr_t &addr) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it != table.end() && it->second.state == conn_state::connected) {
+      // reconnect soon; it's likely out of range for a moment
+      it->second.state       = conn_state::waiting;
+      it->second.retry_at_ms = now_ms();
+    }
+    xSemaphoreGive(lock);
+    start_scanning_task();
+  }
+
+  /**
+   * @brief rebuild the snapshot of `table` and `patterns` in the spare buffer
+   *        and swap it in
+   * @note should be called with `lock` held
+   */
+  void publish_targets() {
+    const auto *current = targets.load();
+    auto &next          = current == &target_buf[0] ? target_buf[1] : target_buf[0];
+    next.addrs.clear();
+    for (const auto &[addr, _] : table) {
+      next.addrs.insert(addr.data());
+    }
+    next.patterns = patterns;
+    targets.store(&next);
+    // wait until no one could be reading `current`, which would be the spare next time
+    while (readers.load() != 0) {
+      vTaskDelay(1);
+    }
+  }
+
+  /**
+   * @note should be called with `lock` held
+   */
+  [[nodiscard]] size_t count_of(conn_state state) const {
+    return std::count_if(table.begin(), table.end(), [state](const auto &kv) { return kv.second.state == state; });
+  }
+
+  /**
+   * @brief release the client of the device
+   * @note should be called with `lock` held
+   */
+  static void drop(entry_t &entry) {
+    if (entry.device == nullptr) {
+      return;
+    }
+    auto *client = entry.device->client;
+    if (client != nullptr) {
+      // prevent the disconnection from rescheduling it
+      client->setClientCallbacks(nullptr, false);
+      client->disconnect();
+      NimBLEDevice::deleteClient(client);
+    }
+    delete entry.device->callbacks;
+    entry.device = nullptr;
+  }
+
 public:
   /**
-   * @brief get the target device
+   * @brief the first connected device
    */
   std::unique_ptr<HeartMonitor> get_device() {
-    if (device != nullptr) {
-      auto dev = *device;
-      return std::make_unique<HeartMonitor>(std::move(dev));
-    } else {
-      return nullptr;
+    device_ptr_t dev = nullptr;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (const auto &[addr, entry] : table) {
+      if (entry.state == conn_state::connected && entry.device != nullptr) {
+        dev = std::make_unique<HeartMonitor>(*entry.device);
+        break;
+      }
     }
+    xSemaphoreGive(lock);
+    return dev;
   }
 
-  [[nodiscard]] etl::optional<white_list::Addr> get_target_addr() const {
-    if (target_addr == nullptr) {
-      return etl::nullopt;
+  /**
+   * @return the device at `addr`, if it's a target and connected
+   */
+  std::unique_ptr<HeartMonitor> get_device(const addr_t &addr) {
+    device_ptr_t dev = nullptr;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it != table.end() && it->second.state == conn_state::connected && it->second.device != nullptr) {
+      dev = std::make_unique<HeartMonitor>(*it->second.device);
     }
-    return etl::make_optional(*target_addr);
+    xSemaphoreGive(lock);
+    return dev;
   }
-  std::function<void(HeartMonitor &device, uint8_t *data, size_t size)> on_data = nullptr;
 
   /**
-   * @brief set the target address to scan
-   * @param addr the target address
-   * @effect disconnect the current device if connected
-   *  and start the scanning task (should be started in the disconnection callback though...)
+   * @brief the addresses of the targets, including the ones found by name,
+   *        and then the name patterns
    */
-  void set_target_addr(etl::optional<addr_t> addr) {
-    if (device != nullptr) {
-      device->client->disconnect();
-      NimBLEDevice::deleteClient(device->client);
-      device = nullptr;
-    }
-    if (addr.has_value()) {
-      white_list::Addr addr_ = {std::move(*addr)};
-      target_addr            = std::make_unique<white_list::Addr>(std::move(addr_));
-    } else {
-      ESP_LOGW(TAG, "target address is null");
-      target_addr = nullptr;
+  [[nodiscard]] white_list::list_t get_targets() {
+    auto res = white_list::list_t{};
+    xSemaphoreTake(lock, portMAX_DELAY);
+    res.reserve(table.size() + pattern_sources.size());
+    for (const auto &[addr, _] : table) {
+      res.emplace_back(white_list::Addr{addr});
+    }
+    for (const auto &source : pattern_sources) {
+      res.emplace_back(white_list::Name{source});
+    }
+    xSemaphoreGive(lock);
+    return res;
+  }
+
+  /**
+   * @brief the addresses of the targets, one after another
+   * @return the size written, 0 if `buffer` is too small
+   * @sa restore_targets
+   */
+  size_t export_targets(std::span<uint8_t> buffer) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const auto sz = targets.load()->addrs.to_blob(buffer);
+    xSemaphoreGive(lock);
+    return sz;
+  }
+
+  /**
+   * @brief the name patterns as written
+   * @return the size written, 0 if `buffer` is too small
+   * @sa pattern_blob
+   */
+  size_t export_name_patterns(std::span<uint8_t> buffer) {
+    size_t offset = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (const auto &source : pattern_sources) {
+      offset = pattern_blob::append(buffer, offset, source);
+      if (offset == 0) {
+        break;
+      }
+    }
+    xSemaphoreGive(lock);
+    return offset;
+  }
+
+  /**
+   * @brief the address and then the name map key of each target that has one
+   * @return the size written, 0 if `buffer` is too small or there's none
+   * @sa restore_keys
+   */
+  size_t export_keys(std::span<uint8_t> buffer) {
+    constexpr auto entry_size = HeartMonitor::ADDR_SIZE + sizeof(HrLoRa::name_map_key_t);
+    size_t offset             = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (const auto &[addr, entry] : table) {
+      if (!entry.key) {
+        continue;
+      }
+      if (offset + entry_size > buffer.size()) {
+        offset = 0;
+        break;
+      }
+      std::ranges::copy(addr, buffer.begin() + offset);
+      buffer[offset + HeartMonitor::ADDR_SIZE] = *entry.key;
+      offset += entry_size;
+    }
+    xSemaphoreGive(lock);
+    return offset;
+  }
+
+  /**
+   * @brief assign the keys in `blob` to the targets; the ones that are not
+   *        targets any more are ignored
+   * @sa export_keys
+   */
+  bool restore_keys(std::span<const uint8_t> blob) {
+    constexpr auto entry_size = HeartMonitor::ADDR_SIZE + sizeof(HrLoRa::name_map_key_t);
+    if (blob.size() % entry_size != 0) {
+      ESP_LOGE(TAG, "bad device key blob (%zu bytes)", blob.size());
+      return false;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (size_t offset = 0; offset < blob.size(); offset += entry_size) {
+      auto addr = addr_t{};
+      std::copy_n(blob.begin() + offset, addr.size(), addr.begin());
+      auto it = table.find(addr);
+      if (it != table.end()) {
+        it->second.key = blob[offset + HeartMonitor::ADDR_SIZE];
+      }
+    }
+    xSemaphoreGive(lock);
+    return true;
+  }
+
+  [[nodiscard]] etl::optional<conn_state> state_of(const addr_t &addr) {
+    etl::optional<conn_state> res = etl::nullopt;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it != table.end()) {
+      res = it->second.state;
+    }
+    xSemaphoreGive(lock);
+    return res;
+  }
+
+  [[nodiscard]] size_t connected_count() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const auto n = count_of(conn_state::connected);
+    xSemaphoreGive(lock);
+    return n;
+  }
+
+  /**
+   * @return the name map key assigned to the target `addr`
+   */
+  [[nodiscard]] etl::optional<HrLoRa::name_map_key_t> get_key(const addr_t &addr) {
+    etl::optional<HrLoRa::name_map_key_t> res = etl::nullopt;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it != table.end()) {
+      res = it->second.key;
+    }
+    xSemaphoreGive(lock);
+    return res;
+  }
+
+  /**
+   * @return false if `addr` is not a target
+   */
+  bool set_key(const addr_t &addr, HrLoRa::name_map_key_t key) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it        = table.find(addr);
+    const auto has = it != table.end();
+    if (has) {
+      it->second.key = key;
     }
-    bool ok = start_scanning_task();
+    xSemaphoreGive(lock);
+    return has;
+  }
+
+  /**
+   * @brief add a target to scan and connect to
+   * @return false if the table is full
+   */
+  bool add_target(const addr_t &addr) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto ok = true;
+    if (table.find(addr) == table.end()) {
+      ok = !table.full();
+      if (ok) {
+        table.insert(std::make_pair(addr, entry_t{}));
+        publish_targets();
+      }
+    }
+    xSemaphoreGive(lock);
     if (!ok) {
-      ESP_LOGW(TAG, "scanning task already running");
+      ESP_LOGW(TAG, "device table is full (%d)", MAX_DEVICE_NUM);
+      return false;
+    }
+    if (!start_scanning_task()) {
+      ESP_LOGD(TAG, "scanning task already running");
+    }
+    return true;
+  }
+
+  /**
+   * @brief forget the target and disconnect it if connected
+   */
+  void remove_target(const addr_t &addr) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it != table.end()) {
+      drop(it->second);
+      table.erase(it);
+      publish_targets();
+    }
+    xSemaphoreGive(lock);
+  }
+
+  /**
+   * @brief connect to the devices whose name matches `pattern` as well
+   * @return false if there are too many patterns or `pattern` is not supported
+   * @sa name_matcher::compile
+   */
+  bool add_name_pattern(std::string_view pattern) {
+    const auto matcher = compile_pattern(pattern);
+    if (!matcher) {
+      return false;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const auto ok = !patterns.full();
+    if (ok) {
+      patterns.push_back(*matcher);
+      pattern_sources.emplace_back(pattern);
+      publish_targets();
+    }
+    xSemaphoreGive(lock);
+    if (!ok) {
+      ESP_LOGW(TAG, "too many name patterns (%d)", MAX_NAME_PATTERN_NUM);
+      return false;
+    }
+    if (!start_scanning_task()) {
+      ESP_LOGD(TAG, "scanning task already running");
+    }
+    return true;
+  }
+
+  /**
+   * @brief replace all the targets with `list`; the names are compiled into
+   *        patterns
+   * @return false if some of them are not accepted, i.e. too many or a bad pattern
+   * @effect disconnect the current devices if connected; the devices still in
+   *         `list` keep their name map keys
+   */
+  bool set_targets(const white_list::list_t &list) {
+    auto ok   = true;
+    auto keys = etl::flat_map<addr_t, HrLoRa::name_map_key_t, MAX_DEVICE_NUM>{};
+    xSemaphoreTake(lock, portMAX_DELAY);
+    for (auto &[addr, entry] : table) {
+      drop(entry);
+      if (entry.key) {
+        keys.insert(std::make_pair(addr, *entry.key));
+      }
+    }
+    table.clear();
+    patterns.clear();
+    pattern_sources.clear();
+    for (const auto &item : list) {
+      if (std::holds_alternative<white_list::Addr>(item)) {
+        const auto &addr = std::get<white_list::Addr>(item).addr;
+        if (table.find(addr) != table.end()) {
+          continue;
+        }
+        if (table.full()) {
+          ESP_LOGW(TAG, "device table is full (%d)", MAX_DEVICE_NUM);
+          ok = false;
+          continue;
+        }
+        auto entry = entry_t{};
+        if (auto k = keys.find(addr); k != keys.end()) {
+          entry.key = k->second;
+        }
+        table.insert(std::make_pair(addr, std::move(entry)));
+      } else {
+        const auto &name   = std::get<white_list::Name>(item).name;
+        const auto matcher = compile_pattern(name);
+        if (!matcher) {
+          ok = false;
+        } else if (patterns.full()) {
+          ESP_LOGW(TAG, "too many name patterns (%d)", MAX_NAME_PATTERN_NUM);
+          ok = false;
+        } else {
+          patterns.push_back(*matcher);
+          pattern_sources.emplace_back(name);
+        }
+      }
+    }
+    publish_targets();
+    const auto empty = table.empty() && patterns.empty();
+    xSemaphoreGive(lock);
+    if (empty) {
+      ESP_LOGW(TAG, "no target");
+    } else if (!start_scanning_task()) {
+      ESP_LOGD(TAG, "scanning task already running");
+    }
+    return ok;
+  }
+
+  /**
+   * @brief replace all the targets with the addresses in `blob` and the name
+   *        patterns in `name_blob`
+   * @sa export_targets
+   * @sa export_name_patterns
+   */
+  bool restore_targets(std::span<const uint8_t> blob, std::span<const uint8_t> name_blob = {}) {
+    auto set = addr_set_t{};
+    if (!set.from_blob(blob)) {
+      ESP_LOGE(TAG, "bad target blob (%zu bytes)", blob.size());
+      return false;
     }
+    auto list = white_list::list_t{};
+    set.for_each([&list](const uint8_t *addr) {
+      auto item = white_list::Addr{};
+      std::copy_n(addr, item.addr.size(), item.addr.begin());
+      list.emplace_back(item);
+    });
+    const auto patterns_ok = pattern_blob::for_each(name_blob, [&list](std::string_view pattern) {
+      list.emplace_back(white_list::Name{std::string{pattern}});
+    });
+    if (!patterns_ok) {
+      ESP_LOGE(TAG, "bad name pattern blob (%zu bytes)", name_blob.size());
+    }
+    return set_targets(list) && patterns_ok;
   }
 
   /**
    * @brief start the scanning task
    * @note should be kicked off in the main thread.
-   *  When the device is connected successfully, the scanning task will be deleted.
-   *  When the device is disconnected, the scanning task will be restarted.
+   *  When all the targets are connected, the scanning task will be deleted.
+   *  When a device is disconnected, the scanning task will be restarted.
    */
   bool start_scanning_task() {
     if (scan_task_handle != nullptr) {
@@ -185,98 +663,93 @@ public:
 private:
   void onResult(NimBLEAdvertisedDevice *advertisedDevice) override {
     const auto TAG = "ScanCallback::onResult";
-    auto name      = advertisedDevice->getName();
-    if (on_result != nullptr) {
-      on_result(advertisedDevice->getName(), advertisedDevice->getAddress().getNative());
-    }
-    if (!name.empty()) {
-      ESP_LOGI(TAG, "name=%s; addr=%s; rssi=%d", name.c_str(),
-               advertisedDevice->getAddress().toString().c_str(),
-               advertisedDevice->getRSSI());
+    // `getName` parses the payload every time; only once here
+    auto name           = advertisedDevice->getName();
+    auto nimble_address = advertisedDevice->getAddress();
+    auto addr_native    = nimble_address.getNative();
+    auto seen_addr      = seen_cache::addr_t{};
+    std::copy_n(addr_native, seen_addr.size(), seen_addr.begin());
+    const auto rssi = static_cast<int8_t>(advertisedDevice->getRSSI());
+    if (const auto *e = seen.observe(seen_addr, name, rssi, now_ms()); e != nullptr) {
+      const auto seen_name = e->name();
+      ESP_LOGI(TAG, "name=%.*s; addr=%s; rssi=%d", static_cast<int>(seen_name.size()), seen_name.data(),
+               nimble_address.toString().c_str(), e->rssi());
+      if (on_result != nullptr) {
+        on_result(seen_name, addr_native);
+      }
     }
     struct ConnectTaskParam {
       TaskHandle_t task_handle;
       std::function<void()> task;
     };
-    if (target_addr == nullptr) {
-      return;
+
+    // most of the advertisements are from someone else; don't bother the lock
+    auto listed  = false;
+    auto matched = false;
+    readers.fetch_add(1);
+    {
+      const auto &t = *targets.load();
+      listed        = t.addrs.contains(addr_native);
+      if (!listed && !name.empty()) {
+        matched = std::any_of(t.patterns.begin(), t.patterns.end(),
+                              [&name](const auto &p) { return p.matches(name); });
+      }
     }
-    auto native_addr = advertisedDevice->getAddress().getNative();
-    bool eq          = std::equal(target_addr->addr.begin(), target_addr->addr.end(), native_addr);
-    if (!eq) {
+    readers.fetch_sub(1);
+    if (!listed && !matched) {
       return;
     }
-    auto &self          = *this;
-    auto nimble_address = advertisedDevice->getAddress();
-    auto addr_native    = nimble_address.getNative();
-    auto addr           = addr_t{};
+
+    auto addr = addr_t{};
     std::copy(addr_native, addr_native + HeartMonitor::ADDR_SIZE, addr.begin());
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it == table.end() && matched && !table.full()) {
+      ESP_LOGI(TAG, "%s matches the whitelist", name.c_str());
+      it = table.insert(std::make_pair(addr, entry_t{})).first;
+      publish_targets();
+    }
+    const auto now   = now_ms();
+    const bool start = it != table.end() &&
+                       it->second.state == conn_state::waiting &&
+                       static_cast<int32_t>(now - it->second.retry_at_ms) >= 0 &&
+                       count_of(conn_state::connecting) == 0 &&
+                       count_of(conn_state::connected) < MAX_CONNECTED;
+    if (start) {
+      it->second.state = conn_state::connecting;
+    }
+    xSemaphoreGive(lock);
+    if (!start) {
+      return;
+    }
+    auto &self = *this;
     ESP_LOGI(TAG, "try to connect to %s (%s)", name.c_str(), nimble_address.toString().c_str());
     // for some reason the connection would block the scan callback for a long time
     // I have to create a new thread to do the connection
     auto connect_task = [name, addr, nimble_address, &self]() {
-      const auto TAG        = "connect";
-      NimBLEClient *pClient = nullptr;
-      if (self.device != nullptr) {
-        pClient = self.device->client;
-        assert(pClient != nullptr);
-      } else {
-        pClient = NimBLEDevice::createClient(nimble_address);
-        if (pClient == nullptr) {
-          ESP_LOGE(TAG, "bad client");
+      const auto TAG = "connect";
+      const auto ok  = self.connect(name, addr, nimble_address);
+      xSemaphoreTake(self.lock, portMAX_DELAY);
+      auto it = self.table.find(addr);
+      // might be removed in the meantime
+      if (it != self.table.end()) {
+        auto &entry = it->second;
+        if (ok) {
+          entry.state    = conn_state::connected;
+          entry.failures = 0;
+        } else {
+          entry.state       = conn_state::waiting;
+          entry.retry_at_ms = now_ms() + backoff_ms(entry.failures);
+          entry.failures += 1;
+          ESP_LOGW(TAG, "retry %s in %lums", name.c_str(), entry.retry_at_ms - now_ms());
         }
-        auto pClientCallback = new ClientCallback{&self};
-        auto dev             = HeartMonitor{
-                        .name      = name,
-                        .addr      = addr,
-                        .client    = pClient,
-                        .callbacks = pClientCallback,
-        };
-        pClient->setClientCallbacks(pClientCallback);
-        self.device = std::make_unique<HeartMonitor>(std::move(dev));
       }
-      auto &client = *pClient;
-      if (!client.isConnected()) {
-        auto ok = client.connect();
-        ESP_LOGI(TAG, "connected to %s", name.c_str());
-        if (!ok) {
-          ESP_LOGE(TAG, "Failed to connect to %s", name.c_str());
-          return;
-        }
-      } else {
-        ESP_LOGI(TAG, "already connected to %s", name.c_str());
-      }
-      ESP_LOGI(TAG, "connected to %s", name.c_str());
-      print_services_chars(client);
-      auto pService = client.getService(common::BLE_STANDARD_HR_SERVICE_UUID);
-      if (pService == nullptr) {
-        ESP_LOGE(TAG, "failed to get standard hr service");
-        client.disconnect();
-        return;
+      // keep looking for the devices that match the patterns
+      const auto all_connected = self.count_of(conn_state::connected) == self.table.size() && self.patterns.empty();
+      xSemaphoreGive(self.lock);
+      if (all_connected) {
+        self.stop_scanning_task();
       }
-      auto pChar = pService->getCharacteristic(common::BLE_STANDARD_HR_CHAR_UUID);
-      if (pChar == nullptr) {
-        ESP_LOGE(TAG, "failed to get standard hr char");
-        client.disconnect();
-        return;
-      }
-      auto notify = [&self](NimBLERemoteCharacteristic *pBLERemoteCharacteristic,
-                            uint8_t *pData, size_t length, bool isNotify) {
-        const auto TAG = "notify";
-        if (self.on_data != nullptr) {
-          // I'm thinking create a new thread to avoid blocking the callback
-          // not sure if it's necessary
-          self.on_data(*self.device, pData, length);
-        }
-      };
-      auto ok = pChar->subscribe(true, notify);
-      if (!ok) {
-        ESP_LOGE(TAG, "failed to subscribe to standard hr char");
-        client.disconnect();
-        return;
-      }
-      app_nvs::set_addr(addr);
-      self.stop_scanning_task();
     };
     auto param = new ConnectTaskParam{
         .task_handle = nullptr,
@@ -298,9 +771,85 @@ private:
                 param, 5, &param->task_handle);
   };
 
+  /**
+   * @brief connect to the device and subscribe to its heart rate measurement
+   * @return whether it's subscribed
+   * @note runs in the connecting task; only one at a time
+   */
+  bool connect(const std::string &name, const addr_t &addr, const NimBLEAddress &nimble_address) {
+    const auto TAG        = "connect";
+    NimBLEClient *pClient = nullptr;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    auto it = table.find(addr);
+    if (it == table.end()) {
+      xSemaphoreGive(lock);
+      return false;
+    }
+    auto &entry = it->second;
+    if (entry.device != nullptr) {
+      pClient = entry.device->client;
+      assert(pClient != nullptr);
+    } else {
+      pClient = NimBLEDevice::createClient(nimble_address);
+      if (pClient == nullptr) {
+        ESP_LOGE(TAG, "bad client");
+        xSemaphoreGive(lock);
+        return false;
+      }
+      auto pClientCallback = new ClientCallback{this, addr};
+      auto dev             = HeartMonitor{
+                      .name      = name,
+                      .addr      = addr,
+                      .client    = pClient,
+                      .callbacks = pClientCallback,
+      };
+      pClient->setClientCallbacks(pClientCallback, false);
+      entry.device = std::make_unique<HeartMonitor>(std::move(dev));
+    }
+    xSemaphoreGive(lock);
+    // `remove_target` from other tasks is not expected while connecting
+    auto &client = *pClient;
+    if (!client.isConnected()) {
+      auto ok = client.connect();
+      if (!ok) {
+        ESP_LOGE(TAG, "Failed to connect to %s", name.c_str());
+        return false;
+      }
+    } else {
+      ESP_LOGI(TAG, "already connected to %s", name.c_str());
+    }
+    ESP_LOGI(TAG, "connected to %s", name.c_str());
+    print_services_chars(client);
+    auto pService = client.getService(common::BLE_STANDARD_HR_SERVICE_UUID);
+    if (pService == nullptr) {
+      ESP_LOGE(TAG, "failed to get standard hr service");
+      client.disconnect();
+      return false;
+    }
+    auto pChar = pService->getCharacteristic(common::BLE_STANDARD_HR_CHAR_UUID);
+    if (pChar == nullptr) {
+      ESP_LOGE(TAG, "failed to get standard hr char");
+      client.disconnect();
+      return false;
+    }
+    auto notify = [this, addr](NimBLERemoteCharacteristic *pBLERemoteCharacteristic,
+                               uint8_t *pData, size_t length, bool isNotify) {
+      if (on_data != nullptr) {
+        on_data(addr, pData, length);
+      }
+    };
+    auto ok = pChar->subscribe(true, notify);
+    if (!ok) {
+      ESP_LOGE(TAG, "failed to subscribe to standard hr char");
+      client.disconnect();
+      return false;
+    }
+    return true;
+  }
+
   /**
    * @brief stop the scanning task
-   * @note should be called when the device is connected successfully.
+   * @note should be called when all the devices are connected.
    */
   bool stop_scanning_task() {
     if (scan_task_handle == nullptr) {
@@ -0,0 +1,128 @@
+#ifndef BLE_LORA_ADAPTER_SCAN_RESULT_BATCH_H
+#define BLE_LORA_ADAPTER_SCAN_RESULT_BATCH_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+/**
+ * @brief pack the scan results into a `scan_result_pb` as large as a
+ *        notification could carry, without the lock, the timer and the
+ *        encoder, which are the caller's
+ * @note `scan_result_pb` is nothing but the repeated `devices`, so each
+ *       device is encoded right after the previous one in the buffer
+ */
+namespace scan_result_batch {
+/**
+ * @brief `BLE_ATT_MTU_DFLT`, the ATT MTU before it's exchanged
+ */
+constexpr uint16_t ATT_MTU_DFLT = 23;
+/**
+ * @brief the opcode and the handle in front of the value of a notification
+ */
+constexpr size_t NOTIFY_HEADER_SIZE = 3;
+
+/**
+ * @return the most a notification could carry with `mtu`
+ * @note `mtu` is never taken below the default, or `mtu - 3` would wrap around
+ */
+constexpr size_t payload_limit(uint16_t mtu, size_t max_size) {
+  return std::min(std::max(mtu, ATT_MTU_DFLT) - NOTIFY_HEADER_SIZE, max_size);
+}
+
+enum class add_result : uint8_t {
+  /**
+   * @brief the first one in the buffer, i.e. the flush timer should be started
+   */
+  first,
+  appended,
+  /**
+   * @brief doesn't fit in a notification by itself, and nothing is appended
+   */
+  too_large,
+};
+
+/**
+ * @tparam MaxSize the largest value of a characteristic
+ * @note not thread safe
+ */
+template <size_t MaxSize>
+class Packer {
+public:
+  /**
+   * @brief write a `devices` field of `scan_result_pb` into `out`
+   * @return the bytes written; 0 if it doesn't fit
+   */
+  using encode_fn = size_t (*)(std::span<uint8_t> out, std::string_view name, const uint8_t *addr);
+
+private:
+  encode_fn encode;
+  std::array<uint8_t, MaxSize> buf{};
+  size_t _size  = 0;
+  size_t _count = 0;
+
+  constexpr bool append(std::string_view name, const uint8_t *addr, size_t limit) {
+    if (_size >= limit) {
+      return false;
+    }
+    const auto n = encode(std::span<uint8_t>{buf.data() + _size, limit - _size}, name, addr);
+    if (n == 0) {
+      return false;
+    }
+    _size += n;
+    _count += 1;
+    return true;
+  }
+
+public:
+  constexpr explicit Packer(encode_fn encode) : encode(encode) {}
+
+  /**
+   * @brief append a device; what's packed is flushed first if it doesn't fit
+   * @param mtu the ATT MTU of the clients
+   * @param flush called with what's packed, see `flush`
+   */
+  template <typename Flush>
+  constexpr add_result add(std::string_view name, const uint8_t *addr, uint16_t mtu, Flush &&flush) {
+    const auto limit = payload_limit(mtu, MaxSize);
+    if (append(name, addr, limit)) {
+      return _count == 1 ? add_result::first : add_result::appended;
+    }
+    this->flush(flush);
+    return append(name, addr, limit) ? add_result::first : add_result::too_large;
+  }
+
+  /**
+   * @brief call `fn` with what's packed, if anything, and empty the buffer
+   */
+  template <typename Flush>
+  constexpr void flush(Flush &&fn) {
+    if (_size == 0) {
+      return;
+    }
+    fn(std::span<const uint8_t>{buf.data(), _size});
+    _size  = 0;
+    _count = 0;
+  }
+
+  [[nodiscard]] constexpr size_t size() const {
+    return _size;
+  }
+
+  [[nodiscard]] constexpr size_t count() const {
+    return _count;
+  }
+};
+
+namespace static_tests {
+  static_assert(payload_limit(0, 512) == 20);
+  static_assert(payload_limit(ATT_MTU_DFLT, 512) == 20);
+  static_assert(payload_limit(247, 512) == 244);
+  static_assert(payload_limit(UINT16_MAX, 512) == 512);
+}
+}
+
+#endif // BLE_LORA_ADAPTER_SCAN_RESULT_BATCH_H
@@ -0,0 +1,250 @@
+#ifndef BLE_LORA_ADAPTER_SEEN_CACHE_H
+#define BLE_LORA_ADAPTER_SEEN_CACHE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief the devices seen recently while scanning, to tell which
+ *        advertisements are worth reporting to the phone
+ *
+ * A device is reported when it's new, when its name shows up or changes,
+ * when its (smoothed) RSSI moves by `config_t::rssi_delta_dbm`, or every
+ * `config_t::refresh_ms` while it keeps advertising. Reports are limited
+ * by a token bucket; one that isn't allowed is retried on the next
+ * advertisement of the device.
+ */
+namespace seen_cache {
+using addr_t = std::array<uint8_t, 6>;
+
+struct config_t {
+  /**
+   * @brief the weight of a new sample in the EWMA of RSSI is `1 / 2^rssi_shift`
+   */
+  uint8_t rssi_shift     = 2;
+  uint8_t rssi_delta_dbm = 8;
+  uint32_t refresh_ms    = 30'000;
+  /**
+   * @brief the budget of reports
+   */
+  uint16_t per_second = 4;
+  uint16_t burst      = 8;
+};
+
+/**
+ * @brief allows `rate_per_s` events a second on average, and `burst` at once
+ */
+class TokenBucket {
+  uint32_t rate_per_s;
+  uint32_t burst;
+  /**
+   * @brief in 1/1000 of a token
+   */
+  uint32_t tokens;
+  uint32_t last_ms = 0;
+
+public:
+  constexpr TokenBucket(uint32_t rate_per_s, uint32_t burst)
+      : rate_per_s(rate_per_s), burst(burst), tokens(burst * 1000) {}
+
+  /**
+   * @return whether a token is taken
+   */
+  constexpr bool take(uint32_t now_ms) {
+    // no more than enough to fill it up, and no overflow
+    const auto elapsed = std::min<uint32_t>(now_ms - last_ms, 1'000'000);
+    last_ms            = now_ms;
+    tokens             = std::min(tokens + elapsed * rate_per_s, burst * 1000);
+    if (tokens < 1000) {
+      return false;
+    }
+    tokens -= 1000;
+    return true;
+  }
+};
+
+/**
+ * @tparam Entries the number of devices to remember; the least recently seen one is forgotten
+ * @tparam NameSize the longest name kept; longer ones are truncated
+ * @note not thread safe
+ */
+template <size_t Entries, size_t NameSize>
+class SeenCache {
+public:
+  struct entry_t {
+    bool in_use      = false;
+    addr_t addr      = {};
+    uint8_t name_len = 0;
+    std::array<char, NameSize> name_buf{};
+    /**
+     * @brief in 1/16 dBm
+     */
+    int16_t rssi_x16      = 0;
+    uint32_t last_seen_ms = 0;
+    /**
+     * @brief whether it has been reported, with `reported_rssi` and `reported_ms`
+     */
+    bool reported        = false;
+    int8_t reported_rssi = 0;
+    uint32_t reported_ms = 0;
+
+    [[nodiscard]] constexpr std::string_view name() const {
+      return std::string_view{name_buf.data(), name_len};
+    }
+
+    [[nodiscard]] constexpr int8_t rssi() const {
+      return static_cast<int8_t>(rssi_x16 / 16);
+    }
+  };
+
+  struct stats_t {
+    uint32_t seen     = 0;
+    uint32_t reported = 0;
+    /**
+     * @brief worth reporting but out of budget
+     */
+    uint32_t throttled = 0;
+    uint32_t evicted   = 0;
+  };
+
+private:
+  config_t config;
+  TokenBucket bucket;
+  std::array<entry_t, Entries> entries{};
+  stats_t _stats{};
+
+  constexpr entry_t &entry_of(const addr_t &addr, bool &is_new) {
+    entry_t *victim = &entries[0];
+    for (auto &e : entries) {
+      if (e.in_use && e.addr == addr) {
+        is_new = false;
+        return e;
+      }
+      if (!e.in_use) {
+        victim = &e;
+      } else if (victim->in_use && e.last_seen_ms < victim->last_seen_ms) {
+        victim = &e;
+      }
+    }
+    if (victim->in_use) {
+      _stats.evicted += 1;
+    }
+    is_new  = true;
+    *victim = entry_t{.in_use = true, .addr = addr};
+    return *victim;
+  }
+
+public:
+  constexpr explicit SeenCache(config_t config)
+      : config(config), bucket(config.per_second, config.burst) {}
+
+  /**
+   * @brief an advertisement of `addr`
+   * @param name empty if the advertisement doesn't have one; the last known
+   *             name is kept in that case
+   * @return the entry if it should be reported now, otherwise nullptr
+   */
+  constexpr const entry_t *observe(const addr_t &addr, std::string_view name, int8_t rssi, uint32_t now_ms) {
+    _stats.seen += 1;
+    bool is_new = false;
+    auto &e     = entry_of(addr, is_new);
+    if (is_new) {
+      e.rssi_x16 = static_cast<int16_t>(rssi * 16);
+    } else {
+      e.rssi_x16 = static_cast<int16_t>(e.rssi_x16 + (rssi * 16 - e.rssi_x16) / (1 << config.rssi_shift));
+    }
+    e.last_seen_ms = now_ms;
+
+    bool changed = !e.reported;
+    if (!name.empty()) {
+      name = name.substr(0, NameSize);
+      if (name != e.name()) {
+        std::copy(name.begin(), name.end(), e.name_buf.begin());
+        e.name_len = static_cast<uint8_t>(name.size());
+        changed    = true;
+      }
+    }
+    if (!changed) {
+      const auto delta = e.rssi() - e.reported_rssi;
+      changed          = delta >= config.rssi_delta_dbm || -delta >= config.rssi_delta_dbm ||
+                         now_ms - e.reported_ms >= config.refresh_ms;
+    }
+    if (!changed) {
+      return nullptr;
+    }
+    if (!bucket.take(now_ms)) {
+      _stats.throttled += 1;
+      // not marked as reported, so it's tried again next time
+      e.reported = false;
+      return nullptr;
+    }
+    e.reported      = true;
+    e.reported_rssi = e.rssi();
+    e.reported_ms   = now_ms;
+    _stats.reported += 1;
+    return &e;
+  }
+
+  [[nodiscard]] constexpr const stats_t &stats() const {
+    return _stats;
+  }
+};
+
+namespace static_tests {
+  constexpr auto a = addr_t{0xc0, 0x11, 0x22, 0x33, 0x44, 0x55};
+  constexpr auto b = addr_t{0xc0, 0x11, 0x22, 0x33, 0x44, 0x56};
+  constexpr auto c = addr_t{0xc0, 0x11, 0x22, 0x33, 0x44, 0x57};
+
+  static_assert([] {
+    auto t = TokenBucket{2, 3};
+    // the burst, then one every 500 ms
+    bool ok = t.take(0) && t.take(0) && t.take(0) && !t.take(0);
+    ok      = ok && !t.take(499) && t.take(500) && !t.take(500);
+    // refilled up to the burst only
+    return ok && t.take(60'000) && t.take(60'000) && t.take(60'000) && !t.take(60'000);
+  }());
+
+  // a device is reported when it's new, named or moved, and not for the same advertisement
+  static_assert([] {
+    auto s  = SeenCache<4, 8>{config_t{.rssi_delta_dbm = 8, .refresh_ms = 30'000, .per_second = 100, .burst = 100}};
+    bool ok = s.observe(a, "", -60, 0) != nullptr;
+    ok      = ok && s.observe(a, "", -60, 100) == nullptr && s.observe(a, "", -61, 200) == nullptr;
+    // the name shows up, and is truncated
+    auto *e = s.observe(a, "Polar H10 1234", -60, 300);
+    ok      = ok && e != nullptr && e->name() == "Polar H1";
+    ok      = ok && s.observe(a, "", -60, 400) == nullptr && e->name() == "Polar H1";
+    // the EWMA gets there after a few samples
+    int n = 0;
+    while (s.observe(a, "", -80, 500) == nullptr && n < 16) {
+      n += 1;
+    }
+    ok = ok && n > 0 && n < 16;
+    // and it's reported again after `refresh_ms`
+    return ok && s.observe(a, "", -80, 31'000) != nullptr && s.stats().reported == 4;
+  }());
+
+  // out of budget, then reported once a token is back
+  static_assert([] {
+    auto s  = SeenCache<4, 8>{config_t{.per_second = 1, .burst = 1}};
+    bool ok = s.observe(a, "", -60, 0) != nullptr && s.observe(b, "", -60, 10) == nullptr;
+    ok      = ok && s.observe(b, "", -60, 500) == nullptr && s.observe(b, "", -60, 1000) != nullptr;
+    return ok && s.stats().throttled == 2;
+  }());
+
+  // the least recently seen one is forgotten
+  static_assert([] {
+    auto s = SeenCache<2, 8>{config_t{.per_second = 100, .burst = 100}};
+    s.observe(a, "", -60, 0);
+    s.observe(b, "", -60, 10);
+    s.observe(a, "", -60, 20);
+    s.observe(c, "", -60, 30);
+    // `a` is remembered, and `b` is new again
+    return s.observe(a, "", -60, 40) == nullptr && s.observe(b, "", -60, 50) != nullptr && s.stats().evicted == 2;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_SEEN_CACHE_H
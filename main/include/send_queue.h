@@ -0,0 +1,268 @@
+#ifndef BLE_LORA_ADAPTER_SEND_QUEUE_H
+#define BLE_LORA_ADAPTER_SEND_QUEUE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "hr_lora.h"
+
+/**
+ * @brief pending frames waiting to be transmitted, without any allocation
+ *
+ * Entries are kept in a min-heap ordered by due time, then priority, then
+ * the order of insertion. Frames of the same message type (i.e. the same
+ * magic byte) are coalesced, since only the latest one is meaningful; but
+ * for `HrLoRa::ack`, of which each acks a different frame.
+ *
+ * The queue knows nothing about the clock; the caller passes the current
+ * time in, so that it could be driven by a fake clock.
+ */
+namespace send_queue {
+enum class priority : uint8_t {
+  high   = 0,
+  normal = 1,
+  low    = 2,
+};
+
+enum class push_result : uint8_t {
+  queued,
+  /**
+   * @brief a pending frame with the same magic is replaced
+   */
+  coalesced,
+  full,
+  too_large,
+};
+
+/**
+ * @brief whether `a` is before `b`, with the wrap around of `uint32_t` taken into account
+ */
+constexpr bool is_before(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+/**
+ * @tparam N max number of pending frames
+ * @tparam MaxFrameSize max size of a frame
+ */
+template <size_t N, size_t MaxFrameSize>
+class SendQueue {
+public:
+  struct entry_t {
+    uint32_t due_ms = 0;
+    priority prio   = priority::normal;
+    uint32_t order  = 0;
+    uint8_t size    = 0;
+    std::array<uint8_t, MaxFrameSize> data{};
+
+    [[nodiscard]] constexpr std::span<const uint8_t> frame() const {
+      return std::span<const uint8_t>{data.data(), size};
+    }
+  };
+
+private:
+  std::array<entry_t, N> entries{};
+  size_t count   = 0;
+  uint32_t order = 0;
+
+  /**
+   * @brief "less" for `std::push_heap`, which builds a max-heap; i.e. `a` is
+   *        after `b`
+   */
+  static constexpr bool later(const entry_t &a, const entry_t &b) {
+    if (a.due_ms != b.due_ms) {
+      return is_before(b.due_ms, a.due_ms);
+    }
+    if (a.prio != b.prio) {
+      return a.prio > b.prio;
+    }
+    return is_before(b.order, a.order);
+  }
+
+  constexpr auto begin() {
+    return entries.begin();
+  }
+
+  constexpr auto end() {
+    return entries.begin() + count;
+  }
+
+  /**
+   * @brief whether `a` and `b` are the same kind of message, of which only the latest matters
+   * @note an ack is of a kind of its own; replacing one would leave its frame
+   *       to be retransmitted (and handled as a duplicate) for nothing
+   */
+  static constexpr bool same_kind(std::span<const uint8_t> a, std::span<const uint8_t> b) {
+    return a[0] == b[0] && a[0] != HrLoRa::ack::magic;
+  }
+
+public:
+  static constexpr size_t capacity() {
+    return N;
+  }
+
+  static constexpr size_t max_frame_size() {
+    return MaxFrameSize;
+  }
+
+  [[nodiscard]] constexpr size_t size() const {
+    return count;
+  }
+
+  [[nodiscard]] constexpr bool empty() const {
+    return count == 0;
+  }
+
+  /**
+   * @brief queue `data` to be sent at `due_ms`
+   * @note if a frame of the same kind (see `same_kind`) is pending, its
+   *       content is replaced and it's sent at the earlier of the two due times
+   */
+  constexpr push_result push(std::span<const uint8_t> data, uint32_t due_ms, priority prio = priority::normal) {
+    if (data.empty() || data.size() > MaxFrameSize) {
+      return push_result::too_large;
+    }
+    auto fill = [&](entry_t &e) {
+      e.prio  = prio;
+      e.order = order++;
+      e.size  = static_cast<uint8_t>(data.size());
+      std::copy(data.begin(), data.end(), e.data.begin());
+    };
+    const auto it = std::find_if(begin(), end(), [&](const entry_t &e) { return same_kind(e.frame(), data); });
+    if (it != end()) {
+      if (is_before(due_ms, it->due_ms)) {
+        it->due_ms = due_ms;
+      }
+      fill(*it);
+      std::make_heap(begin(), end(), later);
+      return push_result::coalesced;
+    }
+    if (count >= N) {
+      return push_result::full;
+    }
+    auto &e  = entries[count++];
+    e.due_ms = due_ms;
+    fill(e);
+    std::push_heap(begin(), end(), later);
+    return push_result::queued;
+  }
+
+  /**
+   * @brief put back a popped frame that couldn't be sent, to be due at `due_ms`
+   * @return false if it's dropped, since a newer one of the same kind has
+   *         been pushed in the meantime or the queue is full
+   */
+  constexpr bool requeue(const entry_t &entry, uint32_t due_ms) {
+    const auto it = std::find_if(begin(), end(), [&](const entry_t &e) { return same_kind(e.frame(), entry.frame()); });
+    if (it != end() || count >= N) {
+      return false;
+    }
+    auto &e  = entries[count++];
+    e        = entry;
+    e.due_ms = due_ms;
+    std::push_heap(begin(), end(), later);
+    return true;
+  }
+
+  /**
+   * @return the earliest pending frame, nullptr if empty
+   */
+  [[nodiscard]] constexpr const entry_t *peek() const {
+    return count == 0 ? nullptr : &entries[0];
+  }
+
+  /**
+   * @brief pop the earliest frame if it's due at `now_ms`
+   * @param[out] out the popped frame
+   * @return whether a frame is popped
+   */
+  constexpr bool pop_due(uint32_t now_ms, entry_t &out) {
+    if (count == 0 || is_before(now_ms, entries[0].due_ms)) {
+      return false;
+    }
+    std::pop_heap(begin(), end(), later);
+    count -= 1;
+    out = entries[count];
+    return true;
+  }
+
+  /**
+   * @return time until the earliest frame is due, 0 if it's already due
+   */
+  [[nodiscard]] constexpr uint32_t delay_until_next(uint32_t now_ms) const {
+    if (count == 0 || !is_before(now_ms, entries[0].due_ms)) {
+      return 0;
+    }
+    return entries[0].due_ms - now_ms;
+  }
+};
+
+namespace static_tests {
+  using queue_t = SendQueue<4, 8>;
+  constexpr auto pop_magic(queue_t &q, uint32_t now_ms) {
+    auto e = queue_t::entry_t{};
+    return q.pop_due(now_ms, e) ? static_cast<int>(e.data[0]) : -1;
+  }
+  // ordered by due time, then priority
+  static_assert([] {
+    auto q                = queue_t{};
+    constexpr uint8_t a[] = {0x01};
+    constexpr uint8_t b[] = {0x02};
+    constexpr uint8_t c[] = {0x03};
+    q.push(a, 200);
+    q.push(b, 100, priority::low);
+    q.push(c, 100, priority::high);
+    return pop_magic(q, 50) == -1 && q.delay_until_next(50) == 50 &&
+           pop_magic(q, 300) == 0x03 && pop_magic(q, 300) == 0x02 &&
+           pop_magic(q, 300) == 0x01 && q.empty();
+  }());
+  // coalesced by magic, keeping the earlier due time and the newer content
+  static_assert([] {
+    auto q                 = queue_t{};
+    constexpr uint8_t a0[] = {0x01, 0x00};
+    constexpr uint8_t a1[] = {0x01, 0x01};
+    auto ok                = q.push(a0, 100) == push_result::queued &&
+              q.push(a1, 300) == push_result::coalesced &&
+              q.size() == 1;
+    auto e = queue_t::entry_t{};
+    return ok && q.pop_due(100, e) && e.data[1] == 0x01;
+  }());
+  // acks are never coalesced
+  static_assert([] {
+    auto q                = queue_t{};
+    constexpr uint8_t a[] = {HrLoRa::ack::magic, 0x00};
+    constexpr uint8_t b[] = {HrLoRa::ack::magic, 0x01};
+    return q.push(a, 100) == push_result::queued && q.push(b, 100) == push_result::queued && q.size() == 2;
+  }());
+  // put back for later, unless a newer one has come
+  static_assert([] {
+    auto q                 = queue_t{};
+    constexpr uint8_t a0[] = {0x01, 0x00};
+    constexpr uint8_t a1[] = {0x01, 0x01};
+    auto e                 = queue_t::entry_t{};
+    q.push(a0, 100);
+    auto ok = q.pop_due(100, e) && q.requeue(e, 600) && pop_magic(q, 599) == -1 && pop_magic(q, 600) == 0x01;
+    q.push(a0, 100);
+    ok = ok && q.pop_due(100, e);
+    q.push(a1, 200);
+    return ok && !q.requeue(e, 600) && q.pop_due(200, e) && e.data[1] == 0x01 && q.empty();
+  }());
+  // fixed capacity
+  static_assert([] {
+    auto q = queue_t{};
+    for (uint8_t m = 0; m < 4; ++m) {
+      const uint8_t f[] = {m};
+      q.push(f, 0);
+    }
+    constexpr uint8_t f[]   = {0x10};
+    constexpr uint8_t big[] = {0x11, 0, 0, 0, 0, 0, 0, 0, 0};
+    return q.push(f, 0) == push_result::full && q.push(big, 0) == push_result::too_large;
+  }());
+  // wrap around of the millisecond counter
+  static_assert(is_before(UINT32_MAX - 10, 5) && !is_before(5, UINT32_MAX - 10));
+}
+}
+
+#endif // BLE_LORA_ADAPTER_SEND_QUEUE_H
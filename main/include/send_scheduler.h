@@ -0,0 +1,145 @@
+#ifndef BLE_LORA_ADAPTER_SEND_SCHEDULER_H
+#define BLE_LORA_ADAPTER_SEND_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/timers.h>
+#include "handle_message.h"
+#include "send_queue.h"
+
+/**
+ * @brief send frames after a delay, with a single static timer
+ * @note nothing would be allocated after `init`
+ * @sa send_queue::SendQueue
+ */
+class SendScheduler {
+public:
+  static constexpr size_t MAX_FRAME_SIZE = HANDLE_MESSAGE_MAX_FRAME_SIZE;
+
+private:
+  static constexpr auto TAG = "SendScheduler";
+  using queue_t             = send_queue::SendQueue<8, MAX_FRAME_SIZE>;
+  queue_t queue{};
+  StaticTimer_t timer_buf{};
+  TimerHandle_t timer = nullptr;
+  StaticSemaphore_t lock_buf{};
+  SemaphoreHandle_t lock = nullptr;
+
+  static uint32_t default_now_ms() {
+    return esp_timer_get_time() / 1000;
+  }
+
+  /**
+   * @note should be called with `lock` held
+   */
+  void rearm(uint32_t now_ms) {
+    if (queue.empty()) {
+      xTimerStop(timer, 0);
+      return;
+    }
+    const auto ticks = pdMS_TO_TICKS(queue.delay_until_next(now_ms));
+    // `xTimerChangePeriod` would also start the timer
+    xTimerChangePeriod(timer, ticks == 0 ? 1 : ticks, 0);
+  }
+
+  void run() {
+    auto entry = queue_t::entry_t{};
+    for (;;) {
+      xSemaphoreTake(lock, portMAX_DELAY);
+      const auto ok = queue.pop_due(now_ms(), entry);
+      if (!ok) {
+        rearm(now_ms());
+      }
+      xSemaphoreGive(lock);
+      if (!ok) {
+        break;
+      }
+      if (send == nullptr) {
+        ESP_LOGW(TAG, "send callback is empty");
+        continue;
+      }
+      if (send(entry.data.data(), entry.size)) {
+        continue;
+      }
+      // no room; try again later
+      const auto retry_ms = retry_delay_ms != nullptr ? retry_delay_ms(now_ms()) : 0;
+      if (retry_ms == 0) {
+        ESP_LOGW(TAG, "no room; drop magic=0x%02x", entry.data[0]);
+        continue;
+      }
+      xSemaphoreTake(lock, portMAX_DELAY);
+      if (!queue.requeue(entry, now_ms() + retry_ms)) {
+        ESP_LOGW(TAG, "no room, and superseded; drop magic=0x%02x", entry.data[0]);
+      }
+      xSemaphoreGive(lock);
+    }
+  }
+
+public:
+  using now_fn_t = uint32_t (*)();
+  /**
+   * @return false if there's no room for it now, e.g. the slot is full
+   */
+  std::function<bool(uint8_t *data, size_t size)> send = nullptr;
+  /**
+   * @brief how long a frame refused by `send` waits before it's tried again
+   *        (i.e. until the next slot); it's dropped if 0 or empty
+   */
+  std::function<uint32_t(uint32_t now_ms)> retry_delay_ms = nullptr;
+  /**
+   * @brief the time source in milliseconds, could be replaced by a fake clock
+   */
+  now_fn_t now_ms = default_now_ms;
+
+  /**
+   * @brief create the timer and the lock
+   * @note should be called once before `schedule`, and `this` should not be moved after that
+   */
+  void init() {
+    lock      = xSemaphoreCreateMutexStatic(&lock_buf);
+    auto task = [](TimerHandle_t handle) {
+      static_cast<SendScheduler *>(pvTimerGetTimerID(handle))->run();
+    };
+    timer = xTimerCreateStatic("send_timer", 1, pdFALSE, this, task, &timer_buf);
+  }
+
+  /**
+   * @brief schedule the data to be sent
+   * @param pdata the data to be sent
+   * @param size the size of the data
+   * @param interval_ms the delay before transmission, in milliseconds
+   * @param prio frames that are due at the same time are sent by priority
+   * @return `coalesced` if a pending frame with the same magic is replaced
+   */
+  send_queue::push_result schedule(const uint8_t *pdata, size_t size, size_t interval_ms,
+                                   send_queue::priority prio = send_queue::priority::normal) {
+    if (timer == nullptr) {
+      ESP_LOGE(TAG, "not initialized");
+      return send_queue::push_result::full;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const auto now = now_ms();
+    const auto res = queue.push(std::span<const uint8_t>{pdata, size}, now + interval_ms, prio);
+    rearm(now);
+    xSemaphoreGive(lock);
+    switch (res) {
+      case send_queue::push_result::full:
+        ESP_LOGW(TAG, "queue is full; drop magic=0x%02x", pdata[0]);
+        break;
+      case send_queue::push_result::too_large:
+        ESP_LOGE(TAG, "bad frame size %d", size);
+        break;
+      default:
+        break;
+    }
+    return res;
+  }
+};
+
+#endif // BLE_LORA_ADAPTER_SEND_SCHEDULER_H
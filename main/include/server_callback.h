@@ -5,14 +5,37 @@
 #ifndef BLE_LORA_ADAPTER_SERVER_CALLBACK_H
 #define BLE_LORA_ADAPTER_SERVER_CALLBACK_H
 
+#include <atomic>
+#include <etl/vector.h>
 #include <NimBLEDevice.h>
 
 class ServerCallbacks : public NimBLEServerCallbacks {
+  struct peer_t {
+    uint16_t conn_handle;
+    uint16_t mtu;
+  };
+  /**
+   * @note only touched in the callbacks, i.e. the NimBLE host task
+   */
+  etl::vector<peer_t, CONFIG_BT_NIMBLE_MAX_CONNECTIONS> peers{};
+  std::atomic<uint16_t> min_mtu{BLE_ATT_MTU_DFLT};
+
+  void update_min_mtu();
+
   void onConnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo) override;
 
   void onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo, int reason) override;
 
   void onMTUChange(uint16_t MTU, NimBLEConnInfo &connInfo) override;
+
+public:
+  /**
+   * @brief the smallest ATT MTU of the connected clients, which a notification
+   *        to all of them should fit in; `BLE_ATT_MTU_DFLT` if none
+   */
+  [[nodiscard]] uint16_t mtu() const {
+    return min_mtu.load();
+  }
 };
 
 #endif // BLE_LORA_ADAPTER_SERVER_CALLBACK_H
@@ -0,0 +1,224 @@
+#ifndef BLE_LORA_ADAPTER_SLOT_PLAN_H
+#define BLE_LORA_ADAPTER_SLOT_PLAN_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief which frames of which devices go out in a slot of this repeater
+ *
+ * A device goes in the slot of its key, usually alone; the devices whose
+ * keys fall in the same slot (and the ones without a key, in the slot of
+ * the repeater) share its frames in rounds, each in round robin from the
+ * cursor:
+ *
+ * 1. one frame per device: its `hr_batch`, or its `named_hr_data` if it has
+ *    no key (which is the only frame it could send);
+ * 2. the `hr_rr` of the devices with a key;
+ * 3. the `named_hr_data` of the devices with a key, i.e. the announcement
+ *    of their names every few superframes.
+ *
+ * A round only starts when the one before it is done, so the heart rates of
+ * every device go before the RR intervals of any. The cursor moves past the
+ * last device served in the first round, and the devices left out go first
+ * in the next slot.
+ */
+namespace slot_plan {
+enum class kind : uint8_t {
+  named,
+  batch,
+  rr,
+};
+
+/**
+ * @brief what a device has to send
+ */
+struct demand_t {
+  bool has_key = false;
+  bool named   = false;
+  bool batch   = false;
+  bool rr      = false;
+};
+
+struct frame_t {
+  size_t device = 0;
+  kind what     = kind::batch;
+};
+
+/**
+ * @tparam N the capacity, at least the frames of a slot
+ */
+template <size_t N>
+struct plan_t {
+  std::array<frame_t, N> frames{};
+  size_t size = 0;
+  /**
+   * @brief the frames of the first round, which come first
+   */
+  size_t first_round = 0;
+  /**
+   * @brief the device to be served first in the next slot
+   */
+  size_t cursor = 0;
+
+  /**
+   * @brief the device to be served first in the next slot, if only the
+   *        frames before `sent` go out
+   */
+  [[nodiscard]] constexpr size_t cursor_after(size_t sent) const {
+    return sent < first_round ? frames[sent].device : cursor;
+  }
+
+  [[nodiscard]] constexpr std::span<const frame_t> get_frames() const {
+    return {frames.data(), size};
+  }
+};
+
+/**
+ * @param devices indexed as `frame_t::device`
+ * @param cursor the device to be served first
+ * @param max_frames the frames of the slot, capped to `N`
+ */
+template <size_t N>
+constexpr plan_t<N> plan(std::span<const demand_t> devices, size_t cursor, size_t max_frames) {
+  auto res         = plan_t<N>{};
+  const auto n     = devices.size();
+  const auto limit = max_frames < N ? max_frames : N;
+  res.cursor       = n == 0 ? 0 : cursor % n;
+  if (n == 0) {
+    return res;
+  }
+  const auto first = res.cursor;
+  auto add         = [&res](size_t device, kind what) {
+    res.frames[res.size++] = frame_t{.device = device, .what = what};
+  };
+  for (size_t i = 0; i < n && res.size < limit; ++i) {
+    const auto d   = (first + i) % n;
+    const auto &dm = devices[d];
+    if (dm.has_key ? dm.batch : dm.named) {
+      add(d, dm.has_key ? kind::batch : kind::named);
+      res.cursor = (d + 1) % n;
+    }
+  }
+  res.first_round = res.size;
+  for (size_t i = 0; i < n && res.size < limit; ++i) {
+    const auto d = (first + i) % n;
+    if (devices[d].has_key && devices[d].rr) {
+      add(d, kind::rr);
+    }
+  }
+  for (size_t i = 0; i < n && res.size < limit; ++i) {
+    const auto d = (first + i) % n;
+    if (devices[d].has_key && devices[d].named) {
+      add(d, kind::named);
+    }
+  }
+  return res;
+}
+
+namespace static_tests {
+  constexpr auto all     = demand_t{.has_key = true, .named = true, .batch = true, .rr = true};
+  constexpr auto keyless = demand_t{.has_key = false, .named = true};
+
+  // a lone device sends all of its frames, its heart rates first
+  static_assert([] {
+    const demand_t d[] = {all};
+    const auto p       = plan<3>(d, 0, 3);
+    return p.size == 3 && p.frames[0].what == kind::batch && p.frames[1].what == kind::rr &&
+           p.frames[2].what == kind::named && p.cursor == 0;
+  }());
+  // four devices in a slot of three: one frame each, and the fourth goes first next time
+  static_assert([] {
+    const demand_t d[] = {all, all, all, all};
+    const auto p       = plan<3>(d, 0, 3);
+    const auto q       = plan<3>(d, p.cursor, 3);
+    return p.size == 3 && p.frames[2].device == 2 && p.frames[2].what == kind::batch &&
+           p.cursor == 3 && q.frames[0].device == 3 && q.cursor == 2;
+  }());
+  // a slot cut short goes on from the first device left out
+  static_assert([] {
+    const demand_t d[] = {all, all};
+    const auto p       = plan<3>(d, 1, 3);
+    return p.first_round == 2 && p.cursor_after(1) == 0 && p.cursor_after(2) == p.cursor && p.cursor == 1;
+  }());
+  // a keyless device sends its named_hr_data in the first round
+  static_assert([] {
+    const demand_t d[] = {all, keyless};
+    const auto p       = plan<3>(d, 1, 3);
+    return p.size == 3 && p.frames[0].device == 1 && p.frames[0].what == kind::named &&
+           p.frames[1].device == 0 && p.frames[1].what == kind::batch && p.frames[2].what == kind::rr;
+  }());
+  // nothing to send leaves the cursor where it is
+  static_assert([] {
+    const demand_t d[] = {demand_t{}, demand_t{}};
+    const auto p       = plan<3>(d, 1, 3);
+    return p.size == 0 && p.cursor == 1;
+  }());
+  static_assert(plan<3>(std::span<const demand_t>{}, 5, 3).size == 0);
+}
+
+/**
+ * @brief the airtime left in the slot of this repeater, shared by whatever
+ *        transmits in it (the frames planned, `arq::Endpoint::poll` and
+ *        `SendScheduler`)
+ *
+ * The frames queued in a slot should be done before it ends, less a guard;
+ * what doesn't fit waits for the next slot instead of running into the slot
+ * of another repeater (or the beacon of the gateway). The first frame of a
+ * slot is always let through, so that a frame longer than the slot is not
+ * held forever.
+ */
+class Budget {
+  uint32_t slot_ms;
+  uint32_t limit_us;
+  uint32_t opened_ms = 0;
+  uint32_t used_us   = 0;
+  bool opened        = false;
+
+public:
+  constexpr Budget(uint32_t slot_ms, uint32_t guard_ms)
+      : slot_ms(slot_ms), limit_us(slot_ms > guard_ms ? (slot_ms - guard_ms) * 1000 : 0) {}
+
+  /**
+   * @brief take the airtime of a frame from the slot that starts at
+   *        `slot_start_ms` (see `tdma::SlotClock::slot_start`); it's refilled
+   *        in the next slot, which might be right after it
+   * @return whether the frame fits
+   * @note a start that moves by less than half a slot (i.e. a sync in the
+   *       slot) is the same slot
+   */
+  constexpr bool take(uint32_t slot_start_ms, uint32_t time_on_air_us) {
+    const auto moved = slot_start_ms - opened_ms < opened_ms - slot_start_ms ? slot_start_ms - opened_ms
+                                                                             : opened_ms - slot_start_ms;
+    if (!opened || moved >= slot_ms / 2) {
+      opened    = true;
+      opened_ms = slot_start_ms;
+      used_us   = 0;
+    }
+    if (used_us != 0 && used_us + time_on_air_us > limit_us) {
+      return false;
+    }
+    used_us += time_on_air_us;
+    return true;
+  }
+};
+
+namespace static_tests {
+  static_assert([] {
+    auto b = Budget{500, 100};
+    // 400 ms of the slot, and the rest in the next one, even right after it
+    return b.take(1'000, 250'000) && b.take(1'000, 150'000) && !b.take(1'000, 1) &&
+           b.take(1'500, 300'000) && !b.take(1'500, 200'000);
+  }());
+  // moved a bit by a sync, it's still the same slot
+  static_assert([] {
+    auto b = Budget{500, 100};
+    return b.take(1'000, 400'000) && !b.take(1'003, 1) && !b.take(997, 1) && b.take(9'000, 1);
+  }());
+  static_assert(Budget{500, 100}.take(0, 450'000));
+}
+}
+
+#endif // BLE_LORA_ADAPTER_SLOT_PLAN_H
@@ -0,0 +1,129 @@
+#ifndef BLE_LORA_ADAPTER_SLOT_TICKER_H
+#define BLE_LORA_ADAPTER_SLOT_TICKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/timers.h>
+#include "tdma.h"
+
+/**
+ * @brief call `on_slot` at the start of every slot of this repeater, once
+ *        the slot clock is synced
+ *
+ * The slots are the ones of the keys this repeater goes by, i.e. its own
+ * and those of the devices it bridges, which could change at any time; they
+ * are asked for whenever the timer is armed.
+ * @sa tdma::SlotClock
+ */
+class SlotTicker {
+  static constexpr auto TAG                   = "SlotTicker";
+  TimerHandle_t timer                         = nullptr;
+  const tdma::SlotClock *clock                = nullptr;
+  std::function<tdma::SlotSet()> get_slots    = nullptr;
+  /**
+   * @brief when `on_slot` ran last; written by the timer task and read by
+   *        whoever calls `on_sync`
+   */
+  std::atomic<uint32_t> last_run_ms{0};
+  std::atomic<bool> ran{false};
+
+  static uint32_t now_ms() {
+    return esp_timer_get_time() / 1000;
+  }
+
+  void arm(uint32_t delay_ms) {
+    // rounded up; the timer still fires up to a tick early, see `run`
+    const auto ticks = (delay_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+    xTimerChangePeriod(timer, ticks == 0 ? 1 : ticks, 0);
+  }
+
+  void rearm() {
+    const auto now   = now_ms();
+    const auto slots = get_slots();
+    auto delay       = clock->delay_until_any(slots, now);
+    if (delay == UINT32_MAX) {
+      // no slot at all; look again a superframe later
+      arm(clock->superframe_ms());
+      return;
+    }
+    // once per slot, even if a sync moves the slot that has just run
+    if (ran.load() && now + delay - last_run_ms.load() < clock->slot_ms() / 2) {
+      delay += 1 + clock->delay_until_any(slots, now + delay + 1);
+    }
+    arm(delay);
+  }
+
+  void run() {
+    const auto now   = now_ms();
+    const auto slots = get_slots();
+    const auto slot  = clock->slot_at(now);
+    // this slot has run, and the timer is for the one after it
+    const bool done = ran.load() && last_run_ms.load() - clock->slot_start(now) < clock->slot_ms();
+    if (!slots.contains(slot) || done) {
+      // a timer expires on a tick, which could be before the slot starts and
+      // while the gateway (or the slot before) is still transmitting; wait
+      // for the rest of it
+      const auto early = clock->delay_until_any(slots, now);
+      if (early < clock->slot_ms()) {
+        arm(early);
+        return;
+      }
+      // fired too late, or the slot is no longer ours
+      ESP_LOGW(TAG, "slot %d is not ours; skip", slot);
+      rearm();
+      return;
+    }
+    last_run_ms.store(now);
+    ran.store(true);
+    if (!clock->synced()) {
+      ESP_LOGD(TAG, "no beacon yet; skip the slot");
+    } else if (on_slot != nullptr) {
+      on_slot(slot);
+    } else {
+      ESP_LOGW(TAG, "on_slot callback is empty");
+    }
+    rearm();
+  }
+
+public:
+  /**
+   * @brief called with the slot that has just started
+   */
+  std::function<void(uint16_t slot)> on_slot = nullptr;
+
+  /**
+   * @param slot_clock should outlive the ticker
+   * @param slots_getter returns the slots of this repeater, see `tdma::SlotClock::slot_of`
+   */
+  void start(const tdma::SlotClock &slot_clock, std::function<tdma::SlotSet()> slots_getter) {
+    if (timer != nullptr) {
+      ESP_LOGW(TAG, "already started");
+      return;
+    }
+    clock     = &slot_clock;
+    get_slots = std::move(slots_getter);
+    auto run  = [](TimerHandle_t handle) {
+      static_cast<SlotTicker *>(pvTimerGetTimerID(handle))->run();
+    };
+    timer = xTimerCreate("slot_timer", 1, pdFALSE, this, run);
+    rearm();
+  }
+
+  /**
+   * @brief the slot clock has just been synced, or the slots changed (e.g.
+   *        a key is given); the timer is armed for the slots as they are now
+   * @note should be called after `tdma::SlotClock::sync`
+   */
+  void on_sync() {
+    if (timer == nullptr) {
+      return;
+    }
+    rearm();
+  }
+};
+
+#endif // BLE_LORA_ADAPTER_SLOT_TICKER_H
@@ -0,0 +1,203 @@
+#ifndef BLE_LORA_ADAPTER_TDMA_H
+#define BLE_LORA_ADAPTER_TDMA_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief time division of the channel among repeaters
+ *
+ * A superframe is divided into `slot_count` slots of `slot_ms` each.
+ * A repeater only transmits in the slots derived from the name map keys it
+ * goes by (its own, and the ones of the devices it bridges), so that
+ * distinct keys (modulo `slot_count`) never collide.
+ *
+ * Repeaters don't share a clock. The superframe is aligned to the moment
+ * a frame from the gateway is received (see `SlotClock::sync`), which is
+ * (almost) the same instant for every repeater that hears the gateway.
+ * Before that, the slots are those of the boot of the repeater, which
+ * has no slot yet (see `SlotClock::synced`).
+ */
+namespace tdma {
+struct config_t {
+  uint16_t slot_count;
+  uint32_t slot_ms;
+};
+
+/**
+ * @brief the slots of a superframe a repeater transmits in
+ * @note up to 256 slots, as many as there are keys
+ */
+class SlotSet {
+  std::array<uint32_t, 8> words{};
+
+public:
+  constexpr void add(uint16_t slot) {
+    if (slot < 256) {
+      words[slot / 32] |= uint32_t{1} << slot % 32;
+    }
+  }
+
+  [[nodiscard]] constexpr bool contains(uint16_t slot) const {
+    return slot < 256 && (words[slot / 32] >> slot % 32 & 1) != 0;
+  }
+};
+
+class SlotClock {
+  config_t config;
+  uint32_t epoch_ms = 0;
+  bool _synced      = false;
+
+public:
+  explicit constexpr SlotClock(config_t config) : config(config) {}
+
+  /**
+   * @brief align the start of the superframe to `now_ms`
+   * @note should be called when a frame from the gateway is received
+   */
+  constexpr void sync(uint32_t now_ms) {
+    epoch_ms = now_ms;
+    _synced  = true;
+  }
+
+  /**
+   * @brief whether a frame from the gateway has been received
+   * @note a repeater that hasn't should not transmit in its slot; where the
+   *       beacon falls is unknown, and it would be received with the beacon
+   *       by every repeater in range for as long as their clocks are alike
+   */
+  [[nodiscard]] constexpr bool synced() const {
+    return _synced;
+  }
+
+  [[nodiscard]] constexpr uint32_t superframe_ms() const {
+    return config.slot_count * config.slot_ms;
+  }
+
+  [[nodiscard]] constexpr uint32_t slot_ms() const {
+    return config.slot_ms;
+  }
+
+  [[nodiscard]] constexpr uint16_t slot_count() const {
+    return config.slot_count;
+  }
+
+  [[nodiscard]] constexpr uint16_t slot_of(uint8_t key) const {
+    return key % config.slot_count;
+  }
+
+  /**
+   * @brief the index of the superframe since the last sync
+   */
+  [[nodiscard]] constexpr uint32_t superframe_index(uint32_t now_ms) const {
+    return (now_ms - epoch_ms) / superframe_ms();
+  }
+
+  /**
+   * @brief the start of the slot that `now_ms` is in
+   */
+  [[nodiscard]] constexpr uint32_t slot_start(uint32_t now_ms) const {
+    return now_ms - (now_ms - epoch_ms) % config.slot_ms;
+  }
+
+  /**
+   * @brief the slot that `now_ms` is in
+   */
+  [[nodiscard]] constexpr uint16_t slot_at(uint32_t now_ms) const {
+    return static_cast<uint16_t>((now_ms - epoch_ms) % superframe_ms() / config.slot_ms);
+  }
+
+  /**
+   * @brief whether `now_ms` is in the slot of `key`
+   */
+  [[nodiscard]] constexpr bool in_slot(uint8_t key, uint32_t now_ms) const {
+    const auto pos   = (now_ms - epoch_ms) % superframe_ms();
+    const auto start = slot_of(key) * config.slot_ms;
+    return pos >= start && pos < start + config.slot_ms;
+  }
+
+  /**
+   * @brief time until the start of the next slot of `key`, in milliseconds
+   * @return 0 if `now_ms` is exactly the start of the slot
+   */
+  [[nodiscard]] constexpr uint32_t delay_until_slot(uint8_t key, uint32_t now_ms) const {
+    return delay_until_index(slot_of(key), now_ms);
+  }
+
+  /**
+   * @brief time until the start of the next `slot`, in milliseconds
+   * @return 0 if `now_ms` is exactly the start of it
+   */
+  [[nodiscard]] constexpr uint32_t delay_until_index(uint16_t slot, uint32_t now_ms) const {
+    const auto sf    = superframe_ms();
+    const auto pos   = (now_ms - epoch_ms) % sf;
+    const auto start = slot * config.slot_ms;
+    return (start + sf - pos) % sf;
+  }
+
+  /**
+   * @brief time until the start of the next slot in `slots`, in milliseconds
+   * @return 0 if `now_ms` is exactly the start of one; `UINT32_MAX` if there's none
+   */
+  [[nodiscard]] constexpr uint32_t delay_until_any(const SlotSet &slots, uint32_t now_ms) const {
+    auto res = UINT32_MAX;
+    for (uint16_t s = 0; s < config.slot_count; ++s) {
+      if (slots.contains(s)) {
+        const auto d = delay_until_index(s, now_ms);
+        res          = d < res ? d : res;
+      }
+    }
+    return res;
+  }
+};
+
+/**
+ * @brief the name map key a repeater goes by until the gateway gives it one
+ *
+ * Derived from its address (FNV-1a, folded into a byte), so that the
+ * repeaters not assigned yet are spread over the slots instead of all
+ * sharing the slot of 0.
+ */
+constexpr uint8_t default_key(std::span<const uint8_t> addr) {
+  uint32_t h = 2'166'136'261u;
+  for (const auto b : addr) {
+    h = (h ^ b) * 16'777'619u;
+  }
+  return static_cast<uint8_t>(h ^ h >> 8 ^ h >> 16 ^ h >> 24);
+}
+
+namespace static_tests {
+  // addresses that differ in the last byte (the usual case) land apart
+  static_assert([] {
+    const uint8_t a[] = {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01};
+    const uint8_t b[] = {0x24, 0x0a, 0xc4, 0x00, 0x00, 0x02};
+    return default_key(a) % 32 != default_key(b) % 32;
+  }());
+
+  static_assert(!SlotClock{config_t{.slot_count = 4, .slot_ms = 100}}.synced());
+  constexpr auto clock = [] {
+    auto c = SlotClock{config_t{.slot_count = 4, .slot_ms = 100}};
+    c.sync(1000);
+    return c;
+  }();
+  static_assert(clock.synced() && clock.superframe_ms() == 400);
+  static_assert(clock.delay_until_slot(2, 1000) == 200);
+  static_assert(clock.delay_until_slot(2, 1250) == 350);
+  static_assert(clock.delay_until_slot(6, 1200) == 0);
+  static_assert(clock.in_slot(2, 1250) && !clock.in_slot(1, 1250));
+  static_assert(clock.slot_start(1250) == 1200 && clock.slot_start(1300) == 1300);
+  static_assert(clock.slot_at(1250) == 2 && clock.slot_at(1399) == 3 && clock.slot_at(1400) == 0);
+  static_assert([] {
+    auto slots = SlotSet{};
+    slots.add(1);
+    slots.add(3);
+    return clock.delay_until_any(slots, 1050) == 50 && clock.delay_until_any(slots, 1100) == 0 &&
+           clock.delay_until_any(slots, 1150) == 150 && clock.delay_until_any(slots, 1350) == 150 &&
+           clock.delay_until_any(SlotSet{}, 1000) == UINT32_MAX;
+  }());
+}
+}
+
+#endif // BLE_LORA_ADAPTER_TDMA_H
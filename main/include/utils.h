@@ -5,7 +5,9 @@
 #ifndef WIT_HUB_UTILS_H
 #define WIT_HUB_UTILS_H
 
-#include "string"
+#include <cstddef>
+#include <cstdint>
+#include <string>
 
 namespace utils {
 
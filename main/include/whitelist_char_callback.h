@@ -12,13 +12,15 @@
 
 class WhiteListCallback : public NimBLECharacteristicCallbacks {
 public:
-  using addr_opt_t                                 = etl::optional<white_list::Addr>;
-  std::function<void(white_list::Addr)> on_address = nullptr;
-  std::function<void()> on_disconnect              = nullptr;
   /**
-   * @return the address that on the current target list, if exists
+   * @brief the whole list is written, which replaces the current one
    */
-  std::function<addr_opt_t()> on_request_address = nullptr;
+  std::function<void(const white_list::list_t &)> on_list = nullptr;
+  std::function<void()> on_disconnect                     = nullptr;
+  /**
+   * @return the addresses on the current target list
+   */
+  std::function<white_list::list_t()> on_request_list = nullptr;
   void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) override {
     constexpr auto TAG         = "WhiteListCallback";
     auto value                 = pCharacteristic->getValue();
@@ -36,42 +38,39 @@ public:
         ESP_LOGW(TAG, "empty list");
         return;
       }
-      if (list.size() > 1) {
-        ESP_LOGW(TAG, "only the first element would be used (list size: %d)", list.size());
-        return;
-      }
-      auto &item = list[0];
-      if (std::holds_alternative<white_list::Name>(item)) {
-        ESP_LOGE(TAG, "name is not supported yet");
-        return;
-      } else {
-        auto &addr = std::get<white_list::Addr>(item);
-        ESP_LOGI(TAG, "addr: %s", utils::toHex(addr.addr.data(), addr.addr.size()).c_str());
-        if (on_address != nullptr) {
-          on_address(std::move(addr));
+      for (const auto &item : list) {
+        if (std::holds_alternative<white_list::Name>(item)) {
+          ESP_LOGI(TAG, "name: %s", std::get<white_list::Name>(item).name.c_str());
         } else {
-          ESP_LOGW(TAG, "on_address is not set");
+          const auto &addr = std::get<white_list::Addr>(item).addr;
+          ESP_LOGI(TAG, "addr: %s", utils::toHex(addr.data(), addr.size()).c_str());
         }
       }
+      if (on_list != nullptr) {
+        on_list(list);
+      } else {
+        ESP_LOGW(TAG, "on_list is not set");
+      }
     } else {
       auto command = std::get<white_list::command_t>(req);
       ESP_LOGI(TAG, "command: %d", command);
       switch (command) {
         case WhiteListCommand_REQUEST: {
-          addr_opt_t addr_opt = etl::nullopt;
-          if (on_request_address != nullptr) {
-            addr_opt = on_request_address();
+          auto list = white_list::list_t{};
+          if (on_request_list != nullptr) {
+            list = on_request_list();
           } else {
-            ESP_LOGW(TAG, "on_request_address is not set");
+            ESP_LOGW(TAG, "on_request_list is not set");
           }
           ::WhiteListResponse response = WhiteListResponse_init_zero;
           white_list::response_t resp;
-          if (addr_opt.has_value()) {
-            resp = white_list::response_t{white_list::list_t{addr_opt.value()}};
+          if (!list.empty()) {
+            resp = white_list::response_t{std::move(list)};
           } else {
             resp = white_list::response_t{WhiteListErrorCode_NULL};
           }
-          auto buf     = etl::array<uint8_t, 64>{};
+          // the addresses and the name patterns, up to the longest attribute value
+          auto buf     = etl::array<uint8_t, 512>{};
           auto ostream = pb_ostream_from_buffer(buf.data(), buf.size());
           auto ok      = white_list::marshal_white_list_response(&ostream, response, resp);
           if (!ok) {
@@ -11,6 +11,11 @@ files = [
     "query_device_by_mac",
     "repeater_status",
     "set_name_map_key",
+    "hr_batch",
+    "hr_rr",
+    "link_stats",
+    "reliable",
+    "ack",
     "common",
 ]
 
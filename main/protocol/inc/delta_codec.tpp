@@ -0,0 +1,274 @@
+#ifndef BLE_LORA_ADAPTER_DELTA_CODEC_H
+#define BLE_LORA_ADAPTER_DELTA_CODEC_H
+
+/**
+ * @brief compressed encoding of slowly changing series (i.e. heart rate)
+ *
+ * The first value is stored as is. Each following value is stored as the
+ * zig-zag encoded difference to the previous one, packed into a nibble
+ * (high nibble first). A difference that doesn't fit in a nibble (|d| > 7)
+ * is escaped with `0xf` followed by the absolute value in the next two nibbles.
+ *
+ * The worst case is 1.5 bytes per value (see `max_size`), and the usual case
+ * (heart rate changing a few bpm per sample) is 0.5 byte per value.
+ *
+ * Also provides unsigned LEB128 varint helpers, and a varint flavour of the
+ * same scheme for 16-bit series (`encode16`/`decode16`), whose differences
+ * are usually too large for a nibble.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HrLoRa::delta_codec {
+constexpr uint8_t escape = 0x0f;
+
+constexpr unsigned zigzag(int d) {
+  return static_cast<unsigned>(d >= 0 ? 2 * d : -2 * d - 1);
+}
+
+constexpr int unzigzag(unsigned z) {
+  return (z & 0x01) ? -static_cast<int>(z >> 1) - 1 : static_cast<int>(z >> 1);
+}
+
+/**
+ * @brief the upper bound of the encoded size of `count` values
+ */
+constexpr size_t max_size(size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  return 1 + (3 * (count - 1) + 1) / 2;
+}
+
+/**
+ * @brief the exact encoded size of `values`
+ */
+constexpr size_t encoded_size(const uint8_t *values, size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  size_t nibbles = 0;
+  for (size_t i = 1; i < count; ++i) {
+    const auto z = zigzag(values[i] - values[i - 1]);
+    nibbles += z < escape ? 1 : 3;
+  }
+  return 1 + (nibbles + 1) / 2;
+}
+
+/**
+ * @brief encode `values` into `out`
+ * @return the number of bytes written, 0 if `count` is 0 or `out_size` is not enough
+ */
+constexpr size_t encode(const uint8_t *values, size_t count, uint8_t *out, size_t out_size) {
+  if (count == 0 || out_size < encoded_size(values, count)) {
+    return 0;
+  }
+  out[0]        = values[0];
+  size_t offset = 1;
+  bool high     = true;
+  auto put      = [&](uint8_t nibble) {
+    if (high) {
+      out[offset] = static_cast<uint8_t>(nibble << 4);
+    } else {
+      out[offset++] |= nibble;
+    }
+    high = !high;
+  };
+  for (size_t i = 1; i < count; ++i) {
+    const auto z = zigzag(values[i] - values[i - 1]);
+    if (z < escape) {
+      put(static_cast<uint8_t>(z));
+    } else {
+      put(escape);
+      put(values[i] >> 4);
+      put(values[i] & 0x0f);
+    }
+  }
+  // the last half filled byte
+  if (!high) {
+    offset += 1;
+  }
+  return offset;
+}
+
+/**
+ * @brief decode exactly `count` values from `in`
+ * @return the number of bytes consumed, 0 if `in` is truncated or malformed
+ * @note never reads past `in + in_size` and never writes past `values + count`
+ */
+constexpr size_t decode(const uint8_t *in, size_t in_size, uint8_t *values, size_t count) {
+  if (count == 0 || in_size < 1) {
+    return 0;
+  }
+  values[0]     = in[0];
+  size_t offset = 1;
+  bool high     = true;
+  bool ok       = true;
+  auto get      = [&]() -> uint8_t {
+    if (offset >= in_size) {
+      ok = false;
+      return 0;
+    }
+    uint8_t nibble;
+    if (high) {
+      nibble = in[offset] >> 4;
+    } else {
+      nibble = in[offset++] & 0x0f;
+    }
+    high = !high;
+    return nibble;
+  };
+  for (size_t i = 1; i < count; ++i) {
+    const auto z = get();
+    if (z < escape) {
+      const auto v = values[i - 1] + unzigzag(z);
+      if (v < 0 || v > UINT8_MAX) {
+        return 0;
+      }
+      values[i] = static_cast<uint8_t>(v);
+    } else {
+      const auto hi = get();
+      const auto lo = get();
+      values[i]     = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    if (!ok) {
+      return 0;
+    }
+  }
+  if (!high) {
+    offset += 1;
+  }
+  return offset;
+}
+
+constexpr size_t varint_size(uint32_t value) {
+  size_t n = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    n += 1;
+  }
+  return n;
+}
+
+/**
+ * @return the number of bytes written, 0 if `size` is not enough
+ */
+constexpr size_t write_varint(uint32_t value, uint8_t *out, size_t size) {
+  if (size < varint_size(value)) {
+    return 0;
+  }
+  size_t offset = 0;
+  while (value >= 0x80) {
+    out[offset++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[offset++] = static_cast<uint8_t>(value);
+  return offset;
+}
+
+/**
+ * @return the number of bytes consumed, 0 if truncated, longer than 5 bytes,
+ *         more than 32 bits, or not the shortest encoding (i.e. what
+ *         `write_varint` would never write)
+ */
+constexpr size_t read_varint(const uint8_t *in, size_t size, uint32_t &value) {
+  constexpr size_t max_varint_size = 5;
+  value                            = 0;
+  for (size_t i = 0; i < size && i < max_varint_size; ++i) {
+    // only 4 bits left for the 5th byte, and it must be the last one
+    if (i == max_varint_size - 1 && in[i] > 0x0f) {
+      return 0;
+    }
+    value |= static_cast<uint32_t>(in[i] & 0x7f) << (7 * i);
+    if ((in[i] & 0x80) == 0) {
+      // a trailing zero byte adds nothing
+      if (i > 0 && in[i] == 0) {
+        return 0;
+      }
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief the upper bound of the encoded size of `count` 16-bit values
+ */
+constexpr size_t max_size16(size_t count) {
+  return 3 * count;
+}
+
+/**
+ * @brief the exact size of `values` encoded by `encode16`
+ */
+constexpr size_t encoded_size16(const uint16_t *values, size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  size_t sz = varint_size(values[0]);
+  for (size_t i = 1; i < count; ++i) {
+    sz += varint_size(zigzag(values[i] - values[i - 1]));
+  }
+  return sz;
+}
+
+/**
+ * @brief encode 16-bit `values` into `out`: the first one as a varint, then
+ *        the zig-zag encoded difference to the previous one as a varint
+ * @return the number of bytes written, 0 if `count` is 0 or `out_size` is not enough
+ */
+constexpr size_t encode16(const uint16_t *values, size_t count, uint8_t *out, size_t out_size) {
+  if (count == 0 || out_size < encoded_size16(values, count)) {
+    return 0;
+  }
+  size_t offset = write_varint(values[0], out, out_size);
+  for (size_t i = 1; i < count; ++i) {
+    offset += write_varint(zigzag(values[i] - values[i - 1]), out + offset, out_size - offset);
+  }
+  return offset;
+}
+
+/**
+ * @brief decode exactly `count` values from `in`
+ * @return the number of bytes consumed, 0 if `in` is truncated or malformed
+ *         (including a value out of 16 bits)
+ * @note never reads past `in + in_size` and never writes past `values + count`
+ */
+constexpr size_t decode16(const uint8_t *in, size_t in_size, uint16_t *values, size_t count) {
+  if (count == 0) {
+    return 0;
+  }
+  size_t offset = 0;
+  int32_t prev  = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t v    = 0;
+    const auto sz = read_varint(in + offset, in_size - offset, v);
+    if (sz == 0) {
+      return 0;
+    }
+    offset += sz;
+    int32_t value = 0;
+    if (i == 0) {
+      if (v > UINT16_MAX) {
+        return 0;
+      }
+      value = static_cast<int32_t>(v);
+    } else {
+      // a difference of two 16-bit values never needs more than 17 bits
+      if (v > 2 * UINT16_MAX) {
+        return 0;
+      }
+      value = prev + unzigzag(v);
+      if (value < 0 || value > UINT16_MAX) {
+        return 0;
+      }
+    }
+    values[i] = static_cast<uint16_t>(value);
+    prev      = value;
+  }
+  return offset;
+}
+}
+
+#endif // BLE_LORA_ADAPTER_DELTA_CODEC_H
@@ -0,0 +1,223 @@
+#ifndef BLE_LORA_ADAPTER_HR_BATCH_H
+#define BLE_LORA_ADAPTER_HR_BATCH_H
+
+#include <string>
+#include <span>
+#include <etl/optional.h>
+#include <etl/vector.h>
+#include "hr_lora_common.tpp"
+#include "delta_codec.tpp"
+
+namespace HrLoRa {
+/**
+ * @brief several heart rate samples of the same device in one frame
+ * @note the preamble and the header of a LoRa packet cost far more airtime
+ *       than the 3 bytes of `hr_data`, so it's better to send them in batch
+ */
+struct hr_batch {
+  static constexpr uint8_t magic       = 0x64;
+  static constexpr size_t max_samples = 32;
+  struct sample_t {
+    /**
+     * @brief how long ago the sample was taken when the frame is marshalled, in milliseconds
+     * @note saturated to `UINT16_MAX`
+     */
+    uint16_t age = 0;
+    uint8_t hr   = 0;
+  };
+  struct t {
+    using module       = hr_batch;
+    name_map_key_t key = 0;
+    /**
+     * @brief from the oldest to the newest
+     */
+    etl::vector<sample_t, max_samples> samples{};
+  };
+  // fixed capacity, nothing to borrow from the buffer
+  using view = t;
+  /**
+   * @brief the resolution of `sample_t::age` on the wire, in milliseconds
+   */
+  static constexpr uint16_t age_unit_ms = 10;
+
+  /**
+   * @note the ages are encoded as varints, the oldest one first and then the
+   *       (non-negative) interval to the previous sample; the heart rates are
+   *       encoded with `delta_codec`.
+   */
+  static size_t size_needed(const t &data) {
+    // magic + key + count
+    size_t sz                = sizeof(magic) + sizeof(t::key) + sizeof(uint8_t);
+    uint8_t hrs[max_samples] = {0};
+    uint16_t prev            = 0;
+    for (size_t i = 0; i < data.samples.size(); ++i) {
+      const auto age = data.samples[i].age / age_unit_ms;
+      sz += delta_codec::varint_size(i == 0 ? age : interval(prev, age));
+      prev   = age;
+      hrs[i] = data.samples[i].hr;
+    }
+    return sz + delta_codec::encoded_size(hrs, data.samples.size());
+  }
+  static size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
+    if (buffer_size < size_needed(data)) {
+      return 0;
+    }
+    size_t offset            = 0;
+    buffer[offset++]         = magic;
+    buffer[offset++]         = data.key;
+    buffer[offset++]         = static_cast<uint8_t>(data.samples.size());
+    uint8_t hrs[max_samples] = {0};
+    uint16_t prev            = 0;
+    for (size_t i = 0; i < data.samples.size(); ++i) {
+      const auto age = data.samples[i].age / age_unit_ms;
+      offset += delta_codec::write_varint(i == 0 ? age : interval(prev, age),
+                                          buffer + offset, buffer_size - offset);
+      prev   = age;
+      hrs[i] = data.samples[i].hr;
+    }
+    offset += delta_codec::encode(hrs, data.samples.size(), buffer + offset, buffer_size - offset);
+    return offset;
+  }
+  static size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(data, buffer.data(), buffer.size());
+  }
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+    // magic + key + count
+    constexpr size_t header_size = 3;
+    if (size < header_size) {
+      return etl::nullopt;
+    }
+
+    t data;
+    if (buffer[0] != magic) {
+      return etl::nullopt;
+    }
+    data.key         = buffer[1];
+    const auto count = buffer[2];
+    if (count > max_samples) {
+      return etl::nullopt;
+    }
+    size_t offset = header_size;
+    uint32_t age  = 0;
+    for (int i = 0; i < count; ++i) {
+      uint32_t v    = 0;
+      const auto sz = delta_codec::read_varint(buffer + offset, size - offset, v);
+      if (sz == 0) {
+        return etl::nullopt;
+      }
+      offset += sz;
+      age = i == 0 ? v : (v > age ? 0 : age - v);
+      // clamped before multiplied, which would overflow for a hostile varint
+      data.samples.push_back(sample_t{
+          .age = static_cast<uint16_t>(age > UINT16_MAX / age_unit_ms ? UINT16_MAX : age * age_unit_ms),
+          .hr  = 0,
+      });
+    }
+    if (count > 0) {
+      uint8_t hrs[max_samples] = {0};
+      if (delta_codec::decode(buffer + offset, size - offset, hrs, count) == 0) {
+        return etl::nullopt;
+      }
+      for (int i = 0; i < count; ++i) {
+        data.samples[i].hr = hrs[i];
+      }
+    }
+    return data;
+  }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    return unmarshal(buffer.data(), buffer.size());
+  }
+
+private:
+  static constexpr uint16_t interval(uint16_t prev_age, uint16_t age) {
+    return prev_age > age ? prev_age - age : 0;
+  }
+
+public:
+  /**
+   * @brief collect samples on the sender side until the batch should be sent
+   * @note the age deadline is only checked when `push` or `should_flush` is called,
+   *       i.e. the caller is responsible for polling it.
+   */
+  class accumulator {
+    struct entry_t {
+      uint32_t timestamp_ms;
+      uint8_t hr;
+    };
+    etl::vector<entry_t, max_samples> entries{};
+    size_t max_count;
+    uint32_t max_age_ms;
+    uint32_t _dropped = 0;
+
+  public:
+    /**
+     * @param max_count flush when this many samples are collected (capped to `max_samples`)
+     * @param max_age_ms flush when the oldest sample is older than this, in milliseconds
+     */
+    accumulator(size_t max_count, uint32_t max_age_ms)
+        : max_count(max_count > max_samples ? max_samples : max_count),
+          max_age_ms(max_age_ms) {}
+
+    /**
+     * @brief add a sample
+     * @param hr heart rate
+     * @param now_ms current time in milliseconds
+     * @return whether the batch should be flushed (see `should_flush`)
+     * @note the oldest sample would be dropped (and counted in `dropped`) if
+     *       the accumulator is full, which should not happen if the caller
+     *       always flushes when told to
+     */
+    bool push(uint8_t hr, uint32_t now_ms) {
+      if (entries.full()) {
+        entries.erase(entries.begin());
+        _dropped += 1;
+      }
+      entries.push_back(entry_t{.timestamp_ms = now_ms, .hr = hr});
+      return should_flush(now_ms);
+    }
+
+    [[nodiscard]] bool should_flush(uint32_t now_ms) const {
+      if (entries.empty()) {
+        return false;
+      }
+      return entries.size() >= max_count ||
+             now_ms - entries.front().timestamp_ms >= max_age_ms;
+    }
+
+    [[nodiscard]] size_t size() const {
+      return entries.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+      return entries.empty();
+    }
+
+    /**
+     * @brief the number of samples dropped since created, because it was full
+     */
+    [[nodiscard]] uint32_t dropped() const {
+      return _dropped;
+    }
+
+    /**
+     * @brief build a batch from the collected samples and reset the accumulator
+     * @param key the name map key of the device
+     * @param now_ms current time in milliseconds, used to calculate the age of samples
+     */
+    t take(name_map_key_t key, uint32_t now_ms) {
+      auto data = t{.key = key};
+      for (const auto &entry : entries) {
+        const auto age = now_ms - entry.timestamp_ms;
+        data.samples.push_back(sample_t{
+            .age = static_cast<uint16_t>(age > UINT16_MAX ? UINT16_MAX : age),
+            .hr  = entry.hr,
+        });
+      }
+      entries.clear();
+      return data;
+    }
+  };
+};
+}
+
+#endif // BLE_LORA_ADAPTER_HR_BATCH_H
@@ -6,6 +6,8 @@
 #define BLE_LORA_ADAPTER_HR_DATA_H
 
 #include <string>
+#include "hr_lora_common.tpp"
+#include <span>
 #include <etl/optional.h>
 
 namespace HrLoRa {
@@ -16,11 +18,13 @@ struct hr_data {
     uint8_t key  = 0;
     uint8_t hr   = 0;
   };
+  // trivially copyable, nothing to borrow from the buffer
+  using view = t;
   static consteval size_t size_needed() {
     // key + hr + magic
     return sizeof(magic) + sizeof(t::key) + sizeof(t::hr);
   }
-  static size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
+  static constexpr size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
     if (buffer_size < size_needed()) {
       return 0;
     }
@@ -29,6 +33,9 @@ struct hr_data {
     buffer[2] = data.hr;
     return size_needed();
   }
+  static constexpr size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(data, buffer.data(), buffer.size());
+  }
   static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
     if (size < size_needed()) {
       return etl::nullopt;
@@ -44,6 +51,9 @@ struct hr_data {
 
     return data;
   }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    return unmarshal(buffer.data(), buffer.size());
+  }
 };
 }
 
@@ -15,15 +15,107 @@
 #include "query_device_by_mac.tpp"
 #include "set_name_map_key.tpp"
 #include "named_hr_data.tpp"
+#include "link_stats.tpp"
 #include "repeater_status.tpp"
+#include "hr_batch.tpp"
+#include "hr_rr.tpp"
+#include "reliable.tpp"
+#include "registry.tpp"
+
+#if __cplusplus >= 202002L
+namespace HrLoRa::static_tests {
+static_assert(marshallable<hr_data> && unmarshallable<hr_data>);
+static_assert(span_marshallable<hr_data> && view_unmarshallable<hr_data>);
+static_assert(span_marshallable<named_hr_data> && view_unmarshallable<named_hr_data>);
+static_assert(span_marshallable<query_device_by_mac> && view_unmarshallable<query_device_by_mac>);
+static_assert(span_marshallable<set_name_map_key> && view_unmarshallable<set_name_map_key>);
+static_assert(span_marshallable<repeater_status> && view_unmarshallable<repeater_status>);
+static_assert(span_marshallable<hr_device> && view_unmarshallable<hr_device>);
+static_assert(span_marshallable<link_stats> && view_unmarshallable<link_stats>);
+static_assert(span_marshallable<reliable> && view_unmarshallable<reliable>);
+static_assert(span_marshallable<ack> && view_unmarshallable<ack>);
+static_assert(span_marshallable<hr_batch> && view_unmarshallable<hr_batch>);
+static_assert(span_marshallable<hr_rr> && view_unmarshallable<hr_rr>);
+static_assert(hr_rr::to_ms(1024) == 1000 && hr_rr::to_ms(3000) == 2930);
+
+// encoders are usable at compile time
+static_assert([] {
+  auto buf = std::array<uint8_t, hr_data::size_needed()>{};
+  auto sz  = hr_data::marshal(hr_data::t{.key = 0x12, .hr = 0x34}, buf);
+  return sz == 3 && buf[0] == hr_data::magic && buf[1] == 0x12 && buf[2] == 0x34;
+}());
+static_assert([] {
+  auto buf = std::array<uint8_t, set_name_map_key::size_needed()>{};
+  auto sz  = set_name_map_key::marshal(set_name_map_key::t{.addr = broadcast_addr, .key = 0x05}, buf);
+  return sz == set_name_map_key::size_needed() && buf[0] == set_name_map_key::magic && buf[7] == 0x05;
+}());
+static_assert([] {
+  using namespace std::string_view_literals;
+  constexpr auto dev = hr_device::view{.addr = broadcast_addr, .name = "HR"sv};
+  auto buf           = std::array<uint8_t, hr_device::size_needed(dev)>{};
+  auto sz            = hr_device::marshal(dev, buf);
+  return sz == buf.size() && buf[0] == 0xff && buf[6] == 'H' && buf[8] == 0;
+}());
+static_assert(link_stats::rssi_bucket(-121) == 0 && link_stats::rssi_bucket(-120) == 1 &&
+              link_stats::rssi_bucket(-61) == 6 && link_stats::rssi_bucket(-20) == 7);
+static_assert(link_stats::snr_bucket(-20) == 0 && link_stats::snr_bucket(0) == 4 && link_stats::snr_bucket(15) == 7);
+static_assert(link_stats::quantize_rssi(-140) == INT8_MIN && link_stats::quantize_snr(-2.25f) == -9);
+// a fresh one takes a byte per field
+static_assert(link_stats::size_needed(link_stats::t{}) == 3 + 7 + 2 * link_stats::buckets + 2);
+static_assert([] {
+  auto data        = link_stats::t{.rssi_avg_dbm = -97, .snr_avg_db = 6.5f, .crc_err = 300};
+  data.snr_hist[3] = 2;
+  auto buf         = std::array<uint8_t, 64>{};
+  const auto sz    = link_stats::marshal(data, buf);
+  // a newer version with a trailing field
+  buf[0]         = link_stats::version + 1;
+  const auto res = link_stats::unmarshal_view(std::span<const uint8_t>{buf.data(), sz + 1});
+  return sz == link_stats::size_needed(data) && res && res->rssi_avg_dbm == -97 &&
+         res->snr_avg_db == 6.5f && res->crc_err == 300 && res->snr_hist[3] == 2;
+}());
+static_assert([] {
+  constexpr uint8_t inner[] = {set_name_map_key::magic, 1, 2, 3, 4, 5, 6, 7};
+  auto buf                  = std::array<uint8_t, 32>{};
+  const auto sz             = reliable::marshal(reliable::view{.src = broadcast_addr, .seq = 9, .payload = inner}, buf);
+  const auto res            = reliable::unmarshal_view(std::span<const uint8_t>{buf.data(), sz});
+  return sz == reliable::header_size + sizeof(inner) && res && res->seq == 9 &&
+         res->payload.size() == sizeof(inner) && res->payload[0] == set_name_map_key::magic;
+}());
+// varints that `write_varint` never writes are rejected
+static_assert([] {
+  uint32_t v                 = 0;
+  constexpr uint8_t max[]    = {0xff, 0xff, 0xff, 0xff, 0x0f};
+  constexpr uint8_t over[]   = {0xff, 0xff, 0xff, 0xff, 0x1f};
+  constexpr uint8_t padded[] = {0x81, 0x00};
+  return delta_codec::read_varint(max, sizeof(max), v) == 5 && v == UINT32_MAX &&
+         delta_codec::read_varint(over, sizeof(over), v) == 0 &&
+         delta_codec::read_varint(padded, sizeof(padded), v) == 0;
+}());
+// not enough space
+static_assert([] {
+  auto buf = std::array<uint8_t, named_hr_data::size_needed() - 1>{};
+  return named_hr_data::marshal(named_hr_data::t{}, buf) == 0;
+}());
+}
+#endif
 
 namespace HrLoRa::hr_lora_msg {
-using t = std::variant<
-    named_hr_data::t,
-    hr_data::t,
-    query_device_by_mac::t,
-    repeater_status::t,
-    set_name_map_key::t>;
+/**
+ * @brief all the messages that could be sent over LoRa
+ * @note add new message type here
+ */
+using modules = registry<
+    named_hr_data,
+    hr_data,
+    query_device_by_mac,
+    repeater_status,
+    set_name_map_key,
+    hr_batch,
+    hr_rr,
+    reliable,
+    ack>;
+
+using t = modules::variant_t;
 
 // https://en.cppreference.com/w/cpp/utility/variant/visit
 // helper constant for the visitor #3
@@ -38,68 +130,16 @@ struct overloaded : Ts... {
 template <class... Ts>
 overloaded(Ts...) -> overloaded<Ts...>;
 
-size_t marshal(t &data, uint8_t *buffer, size_t size) {
-  return std::visit(overloaded{
-                        [buffer, size](named_hr_data::t &data) {
-                          return named_hr_data::marshal(data, buffer, size);
-                        },
-                        [buffer, size](hr_data::t &data) {
-                          return hr_data::marshal(data, buffer, size);
-                        },
-                        [buffer, size](query_device_by_mac::t &data) {
-                          return query_device_by_mac::marshal(data, buffer, size);
-                        },
-                        [buffer, size](repeater_status::t &data) {
-                          return repeater_status::marshal(data, buffer, size);
-                        },
-                        [buffer, size](set_name_map_key::t &data) {
-                          return set_name_map_key::marshal(data, buffer, size);
-                        },
-                    },
+inline size_t marshal(t &data, uint8_t *buffer, size_t size) {
+  return std::visit([buffer, size](auto &msg) {
+    using module = typename std::remove_cvref_t<decltype(msg)>::module;
+    return module::marshal(msg, buffer, size);
+  },
                     data);
 }
 
-// https://stackoverflow.com/questions/55612759/alternative-to-using-namespace-as-template-parameter
-// https://caml.inria.fr/pub/docs/oreilly-book/html/book-ora132.html
-// However, namespace could be treated as a struct
-#if __cplusplus >= 202002L
-template <unmarshallable T>
-#else
-template <typename T>
-#endif
-etl::optional<t> unmarshal_helper(const uint8_t *buffer, size_t size) {
-  auto res = T::unmarshal(buffer, size);
-  if (res) {
-    return t{res.value()};
-  } else {
-    return etl::nullopt;
-  }
-}
-
-etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
-  if (size < 1) {
-    return etl::nullopt;
-  }
-  auto magic = buffer[0];
-  switch (magic) {
-    case named_hr_data::magic: {
-      return unmarshal_helper<named_hr_data>(buffer, size);
-    }
-    case hr_data::magic: {
-      return unmarshal_helper<hr_data>(buffer, size);
-    }
-    case query_device_by_mac::magic: {
-      return unmarshal_helper<query_device_by_mac>(buffer, size);
-    }
-    case repeater_status::magic: {
-      return unmarshal_helper<repeater_status>(buffer, size);
-    }
-    case set_name_map_key::magic: {
-      return unmarshal_helper<set_name_map_key>(buffer, size);
-    }
-    default:
-      return etl::nullopt;
-  }
+inline etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+  return modules::unmarshal(buffer, size);
 }
 }
 
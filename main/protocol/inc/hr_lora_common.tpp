@@ -9,7 +9,13 @@
  * @brief some common *constant* definitions for HRLoRA
  */
 
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <span>
+#include <type_traits>
 #include <etl/optional.h>
 
 namespace HrLoRa {
@@ -59,6 +65,32 @@ concept _unmarshallable = requires(const uint8_t *buffer, size_t size) {
  */
 template <typename T>
 concept unmarshallable = module_struct<T> && _unmarshallable<T>;
+
+template <typename T>
+concept _span_marshallable = requires(const T::t &t, std::span<uint8_t> buffer) {
+  { T::marshal(t, buffer) } -> std::convertible_to<size_t>;
+};
+
+/**
+ * @brief a concept to check if a module struct could be marshalled into a `std::span`
+ */
+template <typename T>
+concept span_marshallable = module_struct<T> && _span_marshallable<T>;
+
+template <typename T>
+concept _view_unmarshallable = requires(std::span<const uint8_t> buffer) {
+  // a type that might borrow from the buffer, could be `t` itself if `t` owns nothing on heap
+  typename T::view;
+  { T::unmarshal_view(buffer) } -> std::convertible_to<etl::optional<typename T::view>>;
+};
+
+/**
+ * @brief a concept to check if a module struct could be unmarshalled from a `std::span`
+ *        without allocation
+ * @note the `view` should not outlive the buffer
+ */
+template <typename T>
+concept view_unmarshallable = module_struct<T> && _view_unmarshallable<T>;
 #endif
 }
 
@@ -0,0 +1,187 @@
+#ifndef BLE_LORA_ADAPTER_HR_RR_H
+#define BLE_LORA_ADAPTER_HR_RR_H
+
+#include <string>
+#include <span>
+#include <etl/optional.h>
+#include <etl/vector.h>
+#include "hr_lora_common.tpp"
+#include "delta_codec.tpp"
+
+namespace HrLoRa {
+/**
+ * @brief RR intervals (the time between two beats) of the same device,
+ *        collected from several Heart Rate Measurement notifications
+ * @note the intervals are kept in 1/1024 seconds as reported by the monitor,
+ *       and encoded by `delta_codec::encode16`; a beat to beat difference
+ *       usually takes a byte, and a pause longer than 2 s (below 30 bpm) is
+ *       carried as is instead of being clamped
+ */
+struct hr_rr {
+  static constexpr uint8_t magic = 0x66;
+  /**
+   * @brief the beats of a superframe (16 s) at 220 bpm, so that a frame per
+   *        superframe carries all of them
+   */
+  static constexpr size_t max_rr = 60;
+  /**
+   * @brief magic + key + seq + count
+   */
+  static constexpr size_t header_size = 4;
+  /**
+   * @brief `max_rr` intervals of two bytes each, which is what `accumulator`
+   *        keeps a frame within; the intervals of a steady beat take a byte
+   */
+  static constexpr size_t max_size = header_size + 2 * max_rr;
+  struct t {
+    using module       = hr_rr;
+    name_map_key_t key = 0;
+    /**
+     * @brief increased by one for each frame, so that the receiver could tell
+     *        if there's gap in the series
+     */
+    uint8_t seq = 0;
+    /**
+     * @brief in 1/1024 seconds, from the oldest to the newest
+     */
+    etl::vector<uint16_t, max_rr> rr{};
+  };
+  // fixed capacity, nothing to borrow from the buffer
+  using view = t;
+
+  /**
+   * @return in milliseconds
+   */
+  static constexpr uint16_t to_ms(uint16_t rr_1024) {
+    return static_cast<uint16_t>((rr_1024 * 1000u + 512) / 1024);
+  }
+
+  static size_t size_needed(const t &data) {
+    return header_size + delta_codec::encoded_size16(data.rr.data(), data.rr.size());
+  }
+  static size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
+    if (buffer_size < size_needed(data)) {
+      return 0;
+    }
+    size_t offset    = 0;
+    buffer[offset++] = magic;
+    buffer[offset++] = data.key;
+    buffer[offset++] = data.seq;
+    buffer[offset++] = static_cast<uint8_t>(data.rr.size());
+    offset += delta_codec::encode16(data.rr.data(), data.rr.size(), buffer + offset, buffer_size - offset);
+    return offset;
+  }
+  static size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(data, buffer.data(), buffer.size());
+  }
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+    if (size < header_size) {
+      return etl::nullopt;
+    }
+
+    t data;
+    if (buffer[0] != magic) {
+      return etl::nullopt;
+    }
+    data.key         = buffer[1];
+    data.seq         = buffer[2];
+    const auto count = buffer[3];
+    if (count > max_rr) {
+      return etl::nullopt;
+    }
+    if (count > 0) {
+      data.rr.resize(count);
+      if (delta_codec::decode16(buffer + header_size, size - header_size, data.rr.data(), count) == 0) {
+        return etl::nullopt;
+      }
+    }
+    return data;
+  }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    return unmarshal(buffer.data(), buffer.size());
+  }
+
+  /**
+   * @brief collect RR intervals on the sender side until the frame should be sent
+   */
+  class accumulator {
+    etl::vector<uint16_t, max_rr> rr{};
+    // `delta_codec::encoded_size16` of `rr`
+    size_t encoded    = 0;
+    uint32_t first_ms = 0;
+    size_t max_count;
+    uint32_t max_age_ms;
+    uint8_t seq       = 0;
+    uint32_t _dropped = 0;
+
+  public:
+    /**
+     * @param max_count flush when this many intervals are collected (capped to `max_rr`)
+     * @param max_age_ms flush when the oldest interval is older than this, in milliseconds
+     */
+    accumulator(size_t max_count, uint32_t max_age_ms)
+        : max_count(max_count > max_rr ? max_rr : max_count),
+          max_age_ms(max_age_ms) {}
+
+    /**
+     * @brief add RR intervals from one notification
+     * @param rr_1024 RR intervals in 1/1024 seconds
+     * @param now_ms current time in milliseconds
+     * @return whether the frame should be flushed
+     * @note intervals that don't fit (in `max_rr`, or in `max_size` when the
+     *       beat is far from steady) are dropped and counted in `dropped`,
+     *       which should not happen if the caller always flushes when told to
+     */
+    bool push(std::span<const uint16_t> rr_1024, uint32_t now_ms) {
+      for (const auto v : rr_1024) {
+        const auto sz = rr.empty() ? delta_codec::varint_size(v)
+                                   : delta_codec::varint_size(delta_codec::zigzag(v - rr.back()));
+        if (rr.full() || header_size + encoded + sz > max_size) {
+          _dropped += 1;
+          continue;
+        }
+        if (rr.empty()) {
+          first_ms = now_ms;
+        }
+        rr.push_back(v);
+        encoded += sz;
+      }
+      return should_flush(now_ms);
+    }
+
+    [[nodiscard]] bool should_flush(uint32_t now_ms) const {
+      if (rr.empty()) {
+        return false;
+      }
+      return rr.size() >= max_count || now_ms - first_ms >= max_age_ms;
+    }
+
+    [[nodiscard]] size_t size() const {
+      return rr.size();
+    }
+
+    [[nodiscard]] bool empty() const {
+      return rr.empty();
+    }
+
+    /**
+     * @brief the number of intervals dropped since created, because the frame was full
+     */
+    [[nodiscard]] uint32_t dropped() const {
+      return _dropped;
+    }
+
+    /**
+     * @brief build a frame from the collected intervals and reset the accumulator
+     */
+    t take(name_map_key_t key) {
+      auto data = t{.key = key, .seq = seq++, .rr = rr};
+      rr.clear();
+      encoded = 0;
+      return data;
+    }
+  };
+};
+}
+
+#endif // BLE_LORA_ADAPTER_HR_RR_H
@@ -0,0 +1,216 @@
+#ifndef BLE_LORA_ADAPTER_LINK_STATS_H
+#define BLE_LORA_ADAPTER_LINK_STATS_H
+
+#include <array>
+#include <sstream>
+#include <span>
+#include <etl/optional.h>
+#include "hr_lora_common.tpp"
+#include "delta_codec.tpp"
+
+namespace HrLoRa {
+/**
+ * @brief the health of the radio link of a repeater, i.e. RSSI/SNR of the
+ *        frames heard and the error counters
+ * @note not a message by itself; it's carried by `repeater_status` and the
+ *       link statistics characteristic of Bluetooth LE.
+ *       The first byte is the version. A newer version only appends fields,
+ *       so a decoder reads what it knows and ignores the rest.
+ */
+struct link_stats {
+  /**
+   * @brief 2 appends the dropped samples
+   */
+  static constexpr uint8_t version = 2;
+  static constexpr size_t buckets  = 8;
+  /**
+   * @brief bucket 0 is below `rssi_first_edge`, and the last bucket is at or
+   *        above `rssi_first_edge + (buckets - 2) * rssi_step`, i.e. -60 dBm
+   */
+  static constexpr int rssi_first_edge = -120;
+  static constexpr int rssi_step       = 10;
+  /**
+   * @brief from below -15 dB to at or above +15 dB
+   */
+  static constexpr int snr_first_edge = -15;
+  static constexpr int snr_step       = 5;
+  using histogram_t                   = std::array<uint32_t, buckets>;
+  struct t {
+    using module = link_stats;
+    /**
+     * @brief moving average, saturated to [-128, 127] dBm on the wire
+     */
+    float rssi_avg_dbm = 0;
+    /**
+     * @brief moving average, in 1/4 dB on the wire
+     */
+    float snr_avg_db    = 0;
+    uint32_t rx_ok      = 0;
+    uint32_t crc_err    = 0;
+    uint32_t header_err = 0;
+    /**
+     * @brief received but dropped because the receiver is too slow
+     */
+    uint32_t rx_overrun = 0;
+    uint32_t tx_ok      = 0;
+    uint32_t tx_timeout = 0;
+    /**
+     * @brief failed to start transmitting (timeouts not included)
+     */
+    uint32_t tx_failed = 0;
+    histogram_t rssi_hist{};
+    histogram_t snr_hist{};
+    /**
+     * @brief heart rate samples and RR intervals of the devices dropped before
+     *        they could be sent, since version 2
+     */
+    uint32_t hr_dropped = 0;
+    uint32_t rr_dropped = 0;
+  };
+  // fixed size, nothing to borrow from the buffer
+  using view = t;
+
+  static constexpr size_t bucket_of(float value, int first_edge, int step) {
+    if (value < static_cast<float>(first_edge)) {
+      return 0;
+    }
+    const auto idx = static_cast<size_t>((value - static_cast<float>(first_edge)) / static_cast<float>(step)) + 1;
+    return idx >= buckets ? buckets - 1 : idx;
+  }
+  static constexpr size_t rssi_bucket(float rssi_dbm) {
+    return bucket_of(rssi_dbm, rssi_first_edge, rssi_step);
+  }
+  static constexpr size_t snr_bucket(float snr_db) {
+    return bucket_of(snr_db, snr_first_edge, snr_step);
+  }
+
+  static constexpr int8_t quantize_rssi(float rssi_dbm) {
+    return saturate(rssi_dbm >= 0 ? rssi_dbm + 0.5f : rssi_dbm - 0.5f);
+  }
+  static constexpr int8_t quantize_snr(float snr_db) {
+    const auto q = snr_db * 4;
+    return saturate(q >= 0 ? q + 0.5f : q - 0.5f);
+  }
+
+  static constexpr size_t size_needed(const t &data) {
+    // version + rssi + snr
+    size_t sz = sizeof(version) + 2 * sizeof(int8_t);
+    for (const auto c : counters(data)) {
+      sz += delta_codec::varint_size(c);
+    }
+    for (const auto c : data.rssi_hist) {
+      sz += delta_codec::varint_size(c);
+    }
+    for (const auto c : data.snr_hist) {
+      sz += delta_codec::varint_size(c);
+    }
+    return sz + delta_codec::varint_size(data.hr_dropped) + delta_codec::varint_size(data.rr_dropped);
+  }
+  static constexpr size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    if (buffer.size() < size_needed(data)) {
+      return 0;
+    }
+    size_t offset    = 0;
+    buffer[offset++] = version;
+    buffer[offset++] = static_cast<uint8_t>(quantize_rssi(data.rssi_avg_dbm));
+    buffer[offset++] = static_cast<uint8_t>(quantize_snr(data.snr_avg_db));
+    auto write       = [&](uint32_t value) {
+      offset += delta_codec::write_varint(value, buffer.data() + offset, buffer.size() - offset);
+    };
+    for (const auto c : counters(data)) {
+      write(c);
+    }
+    for (const auto c : data.rssi_hist) {
+      write(c);
+    }
+    for (const auto c : data.snr_hist) {
+      write(c);
+    }
+    write(data.hr_dropped);
+    write(data.rr_dropped);
+    return offset;
+  }
+  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
+    return marshal(data, std::span<uint8_t>{buffer, size});
+  }
+  /**
+   * @note bytes after the fields of `version` are ignored
+   */
+  static constexpr etl::optional<t> unmarshal_view(std::span<const uint8_t> buffer) {
+    // version + rssi + snr
+    constexpr size_t header_size = 3;
+    if (buffer.size() < header_size || buffer[0] < 1) {
+      return etl::nullopt;
+    }
+    t data;
+    data.rssi_avg_dbm = static_cast<int8_t>(buffer[1]);
+    data.snr_avg_db   = static_cast<float>(static_cast<int8_t>(buffer[2])) / 4;
+    size_t offset     = header_size;
+    bool ok           = true;
+    auto read         = [&](uint32_t &value) {
+      const auto sz = delta_codec::read_varint(buffer.data() + offset, buffer.size() - offset, value);
+      ok            = ok && sz != 0;
+      offset += sz;
+    };
+    read(data.rx_ok);
+    read(data.crc_err);
+    read(data.header_err);
+    read(data.rx_overrun);
+    read(data.tx_ok);
+    read(data.tx_timeout);
+    read(data.tx_failed);
+    for (auto &c : data.rssi_hist) {
+      read(c);
+    }
+    for (auto &c : data.snr_hist) {
+      read(c);
+    }
+    if (buffer[0] >= 2) {
+      read(data.hr_dropped);
+      read(data.rr_dropped);
+    }
+    if (!ok) {
+      return etl::nullopt;
+    }
+    return data;
+  }
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+    return unmarshal_view(std::span<const uint8_t>{buffer, size});
+  }
+  static std::string to_string(const t &data) {
+    auto ss = std::stringstream();
+    ss << "rssi=" << data.rssi_avg_dbm
+       << ", snr=" << data.snr_avg_db
+       << ", rx=" << data.rx_ok
+       << ", crc_err=" << data.crc_err
+       << ", header_err=" << data.header_err
+       << ", rx_overrun=" << data.rx_overrun
+       << ", tx=" << data.tx_ok
+       << ", tx_timeout=" << data.tx_timeout
+       << ", tx_failed=" << data.tx_failed
+       << ", hr_dropped=" << data.hr_dropped
+       << ", rr_dropped=" << data.rr_dropped;
+    return ss.str();
+  }
+
+private:
+  static constexpr int8_t saturate(float v) {
+    if (v > INT8_MAX) {
+      return INT8_MAX;
+    }
+    if (v < INT8_MIN) {
+      return INT8_MIN;
+    }
+    return static_cast<int8_t>(v);
+  }
+  /**
+   * @brief in the order on the wire
+   */
+  static constexpr std::array<uint32_t, 7> counters(const t &data) {
+    return {data.rx_ok, data.crc_err, data.header_err, data.rx_overrun,
+            data.tx_ok, data.tx_timeout, data.tx_failed};
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_LINK_STATS_H
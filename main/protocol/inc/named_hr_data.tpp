@@ -5,6 +5,11 @@
 #ifndef TRACK_SHORT_HR_DATA_WITH_NAME_H
 #define TRACK_SHORT_HR_DATA_WITH_NAME_H
 
+#include <algorithm>
+#include <span>
+#include <etl/optional.h>
+#include "hr_lora_common.tpp"
+
 namespace HrLoRa {
 struct named_hr_data {
   static constexpr uint8_t magic = 0x60;
@@ -14,11 +19,13 @@ struct named_hr_data {
     uint8_t hr   = 0;
     addr_t addr{};
   };
+  // trivially copyable, nothing to borrow from the buffer
+  using view = t;
   consteval static size_t size_needed() {
     // key + hr + magic
     return sizeof(magic) + sizeof(t::key) + sizeof(t::hr) + BLE_ADDR_SIZE;
   }
-  static size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
+  static constexpr size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
     if (buffer_size < size_needed()) {
       return 0;
     }
@@ -30,6 +37,9 @@ struct named_hr_data {
     offset += BLE_ADDR_SIZE;
     return offset;
   }
+  static constexpr size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(data, buffer.data(), buffer.size());
+  }
   static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
     if (size < size_needed()) {
       return etl::nullopt;
@@ -46,6 +56,9 @@ struct named_hr_data {
 
     return data;
   }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    return unmarshal(buffer.data(), buffer.size());
+  }
 };
 }
 
@@ -6,6 +6,7 @@
 #define BLE_LORA_ADAPTER_QUERY_DEVICE_BY_MAC_H
 
 #include <string>
+#include <span>
 #include <etl/optional.h>
 #include "hr_lora_common.tpp"
 
@@ -15,11 +16,13 @@ struct query_device_by_mac {
     using module = query_device_by_mac;
     addr_t addr{};
   };
+  // trivially copyable, nothing to borrow from the buffer
+  using view = t;
   static consteval size_t size_needed() {
     return BLE_ADDR_SIZE + 1;
   }
   static constexpr uint8_t magic = 0x37;
-  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
+  static constexpr size_t marshal(const t &data, uint8_t *buffer, size_t size) {
     if (size < size_needed()) {
       return 0;
     }
@@ -29,6 +32,9 @@ struct query_device_by_mac {
     }
     return size_needed();
   }
+  static constexpr size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(data, buffer.data(), buffer.size());
+  }
   static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
     if (size < size_needed()) {
       return etl::nullopt;
@@ -45,6 +51,9 @@ struct query_device_by_mac {
 
     return data;
   }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    return unmarshal(buffer.data(), buffer.size());
+  }
 };
 }
 
@@ -0,0 +1,136 @@
+#ifndef BLE_LORA_ADAPTER_REGISTRY_H
+#define BLE_LORA_ADAPTER_REGISTRY_H
+
+#include <array>
+#include <span>
+#include <variant>
+#include <etl/optional.h>
+#include "hr_lora_common.tpp"
+
+namespace HrLoRa {
+#if __cplusplus >= 202002L
+/**
+ * @brief a module struct that could be identified by the first byte of a frame
+ */
+template <typename T>
+concept has_magic = requires {
+  { T::magic } -> std::convertible_to<uint8_t>;
+};
+
+enum class dispatch_result {
+  ok,
+  unknown_magic,
+  /**
+   * @brief the magic is known but the frame could not be unmarshalled
+   */
+  bad_frame,
+};
+
+/**
+ * @brief a list of module structs, which generates the variant and the
+ *        magic byte dispatch tables at compile time
+ * @tparam Ms module structs with distinct `magic`
+ * @note adding a new message type should only need adding it to the list
+ */
+template <typename... Ms>
+  requires(view_unmarshallable<Ms> && ...) && (has_magic<Ms> && ...)
+struct registry {
+  using variant_t = std::variant<typename Ms::t...>;
+
+  static consteval bool is_magic_unique() {
+    constexpr auto magics = std::array<uint8_t, sizeof...(Ms)>{Ms::magic...};
+    for (size_t i = 0; i < magics.size(); ++i) {
+      for (size_t j = i + 1; j < magics.size(); ++j) {
+        if (magics[i] == magics[j]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  static_assert(is_magic_unique(), "duplicated magic in registry");
+
+  static constexpr bool contains(uint8_t magic) {
+    return ((Ms::magic == magic) || ...);
+  }
+
+private:
+  using unmarshal_fn_t = etl::optional<variant_t> (*)(const uint8_t *, size_t);
+  template <typename Handler>
+  using dispatch_fn_t = bool (*)(std::span<const uint8_t>, Handler &);
+
+  template <typename M>
+  static etl::optional<variant_t> unmarshal_one(const uint8_t *buffer, size_t size) {
+    auto res = M::unmarshal(buffer, size);
+    if (res) {
+      return variant_t{std::in_place_type<typename M::t>, std::move(res.value())};
+    } else {
+      return etl::nullopt;
+    }
+  }
+
+  template <typename M, typename Handler>
+  static bool dispatch_one(std::span<const uint8_t> frame, Handler &handler) {
+    auto res = M::unmarshal_view(frame);
+    if (!res) {
+      return false;
+    }
+    handler(res.value());
+    return true;
+  }
+
+  static consteval std::array<unmarshal_fn_t, 256> make_unmarshal_table() {
+    auto table = std::array<unmarshal_fn_t, 256>{};
+    ((table[Ms::magic] = &unmarshal_one<Ms>), ...);
+    return table;
+  }
+
+  template <typename Handler>
+  static consteval std::array<dispatch_fn_t<Handler>, 256> make_dispatch_table() {
+    auto table = std::array<dispatch_fn_t<Handler>, 256>{};
+    ((table[Ms::magic] = &dispatch_one<Ms, Handler>), ...);
+    return table;
+  }
+
+  static constexpr auto unmarshal_table = make_unmarshal_table();
+
+  template <typename Handler>
+  static constexpr auto dispatch_table = make_dispatch_table<Handler>();
+
+public:
+  /**
+   * @brief unmarshal a frame into the variant by its magic
+   */
+  static etl::optional<variant_t> unmarshal(const uint8_t *buffer, size_t size) {
+    if (size < 1) {
+      return etl::nullopt;
+    }
+    const auto fn = unmarshal_table[buffer[0]];
+    if (fn == nullptr) {
+      return etl::nullopt;
+    }
+    return fn(buffer, size);
+  }
+
+  /**
+   * @brief unmarshal a frame into the `view` of its module and pass it to `handler`
+   * @param handler a callable that accepts `const Ms::view &` for every module
+   *        (usually an `overloaded` set of lambdas)
+   * @note nothing would be allocated by the dispatching itself
+   */
+  template <typename Handler>
+  static dispatch_result dispatch(std::span<const uint8_t> frame, Handler &handler) {
+    if (frame.empty()) {
+      return dispatch_result::bad_frame;
+    }
+    const auto fn = dispatch_table<Handler>[frame[0]];
+    if (fn == nullptr) {
+      return dispatch_result::unknown_magic;
+    }
+    return fn(frame, handler) ? dispatch_result::ok : dispatch_result::bad_frame;
+  }
+};
+#endif
+}
+
+#endif // BLE_LORA_ADAPTER_REGISTRY_H
@@ -0,0 +1,156 @@
+#ifndef BLE_LORA_ADAPTER_RELIABLE_H
+#define BLE_LORA_ADAPTER_RELIABLE_H
+
+#include <algorithm>
+#include <span>
+#include <etl/optional.h>
+#include <etl/vector.h>
+#include "hr_lora_common.tpp"
+
+namespace HrLoRa {
+/**
+ * @brief an envelope of another frame (usually a control message like
+ *        `set_name_map_key` or `repeater_status`), which should be answered
+ *        with `ack` by `dst`
+ * @note `seq` is counted per (src, dst) pair; the sender retransmits until
+ *       the `ack` with the same `seq` is received
+ */
+struct reliable {
+  static constexpr uint8_t magic      = 0x52;
+  static constexpr size_t header_size = sizeof(magic) + 2 * BLE_ADDR_SIZE + sizeof(uint8_t);
+  static constexpr size_t max_payload = 96;
+  struct t {
+    using module = reliable;
+    addr_t src{};
+    /**
+     * @brief could be `broadcast_addr`, then every receiver answers
+     */
+    addr_t dst{};
+    uint8_t seq = 0;
+    etl::vector<uint8_t, max_payload> payload{};
+  };
+  /**
+   * @brief `t` that borrows the payload from the RX buffer
+   */
+  struct view {
+    addr_t src{};
+    addr_t dst{};
+    uint8_t seq = 0;
+    std::span<const uint8_t> payload{};
+  };
+  static view to_view(const t &data) {
+    return view{.src = data.src, .dst = data.dst, .seq = data.seq, .payload = {data.payload.data(), data.payload.size()}};
+  }
+  static constexpr size_t size_needed(const view &data) {
+    return header_size + data.payload.size();
+  }
+  static constexpr size_t marshal(const view &data, std::span<uint8_t> buffer) {
+    if (buffer.size() < size_needed(data) || data.payload.size() > max_payload) {
+      return 0;
+    }
+    size_t offset    = 0;
+    buffer[offset++] = magic;
+    for (const auto b : data.src) {
+      buffer[offset++] = b;
+    }
+    for (const auto b : data.dst) {
+      buffer[offset++] = b;
+    }
+    buffer[offset++] = data.seq;
+    for (const auto b : data.payload) {
+      buffer[offset++] = b;
+    }
+    return offset;
+  }
+  static size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(to_view(data), buffer);
+  }
+  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
+    return marshal(to_view(data), std::span<uint8_t>{buffer, size});
+  }
+  static constexpr etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    if (buffer.size() < header_size || buffer[0] != magic ||
+        buffer.size() - header_size > max_payload) {
+      return etl::nullopt;
+    }
+    view data;
+    size_t offset = 1;
+    for (auto &b : data.src) {
+      b = buffer[offset++];
+    }
+    for (auto &b : data.dst) {
+      b = buffer[offset++];
+    }
+    data.seq     = buffer[offset++];
+    data.payload = buffer.subspan(offset);
+    return data;
+  }
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+    auto v = unmarshal_view(std::span<const uint8_t>{buffer, size});
+    if (!v) {
+      return etl::nullopt;
+    }
+    auto data = t{.src = v->src, .dst = v->dst, .seq = v->seq};
+    for (const auto b : v->payload) {
+      data.payload.push_back(b);
+    }
+    return data;
+  }
+};
+
+/**
+ * @brief `src` has received the `reliable` frame with `seq` from `dst`
+ */
+struct ack {
+  static constexpr uint8_t magic = 0x4b;
+  struct t {
+    using module = ack;
+    addr_t src{};
+    addr_t dst{};
+    uint8_t seq = 0;
+  };
+  // trivially copyable, nothing to borrow from the buffer
+  using view = t;
+  static consteval size_t size_needed() {
+    return sizeof(magic) + 2 * BLE_ADDR_SIZE + sizeof(t::seq);
+  }
+  static constexpr size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    if (buffer.size() < size_needed()) {
+      return 0;
+    }
+    size_t offset    = 0;
+    buffer[offset++] = magic;
+    for (const auto b : data.src) {
+      buffer[offset++] = b;
+    }
+    for (const auto b : data.dst) {
+      buffer[offset++] = b;
+    }
+    buffer[offset++] = data.seq;
+    return offset;
+  }
+  static constexpr size_t marshal(const t &data, uint8_t *buffer, size_t size) {
+    return marshal(data, std::span<uint8_t>{buffer, size});
+  }
+  static constexpr etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    if (buffer.size() < size_needed() || buffer[0] != magic) {
+      return etl::nullopt;
+    }
+    t data;
+    size_t offset = 1;
+    for (auto &b : data.src) {
+      b = buffer[offset++];
+    }
+    for (auto &b : data.dst) {
+      b = buffer[offset++];
+    }
+    data.seq = buffer[offset++];
+    return data;
+  }
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+    return unmarshal_view(std::span<const uint8_t>{buffer, size});
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_RELIABLE_H
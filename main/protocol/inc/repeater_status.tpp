@@ -5,6 +5,15 @@
 #ifndef BLE_LORA_ADAPTER_REPEATER_STATUS_H
 #define BLE_LORA_ADAPTER_REPEATER_STATUS_H
 
+#include <algorithm>
+#include <sstream>
+#include <span>
+#include <string_view>
+#include <etl/optional.h>
+#include "hr_lora_common.tpp"
+#include "link_stats.tpp"
+#include "utils.h"
+
 namespace HrLoRa {
 struct hr_device {
   struct t {
@@ -13,11 +22,25 @@ struct hr_device {
     // zero terminated string
     std::string name{};
   };
-  static size_t size_needed(const t &data) {
+  /**
+   * @brief `t` that borrows the name from somewhere else (i.e. the RX buffer)
+   * @note should not outlive what it borrows from
+   */
+  struct view {
+    addr_t addr{};
+    std::string_view name{};
+  };
+  static view to_view(const t &data) {
+    return view{.addr = data.addr, .name = data.name};
+  }
+  static constexpr size_t size_needed(const view &data) {
     return BLE_ADDR_SIZE + data.name.size() + 1;
   }
-  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
-    if (size < size_needed(data)) {
+  static size_t size_needed(const t &data) {
+    return size_needed(to_view(data));
+  }
+  static constexpr size_t marshal(const view &data, std::span<uint8_t> buffer) {
+    if (buffer.size() < size_needed(data)) {
       return 0;
     }
     size_t offset = 0;
@@ -30,37 +53,88 @@ struct hr_device {
     buffer[offset++] = 0;
     return offset;
   }
-  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t buffer_size) {
-    if (buffer_size < BLE_ADDR_SIZE) {
+  static size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(to_view(data), buffer);
+  }
+  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
+    return marshal(to_view(data), std::span<uint8_t>{buffer, size});
+  }
+  /**
+   * @note the name ends at the zero terminator or at the end of the buffer, whichever comes first
+   */
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    if (buffer.size() < BLE_ADDR_SIZE) {
       return etl::nullopt;
     }
 
-    t data;
+    view data;
     for (int i = 0; i < BLE_ADDR_SIZE; ++i) {
       data.addr[i] = buffer[i];
     }
-    size_t offset = BLE_ADDR_SIZE;
-    data.name     = std::string(reinterpret_cast<const char *>(buffer + offset));
+    const auto rest = buffer.subspan(BLE_ADDR_SIZE);
+    const auto end  = std::find(rest.begin(), rest.end(), 0);
+    data.name       = std::string_view(reinterpret_cast<const char *>(rest.data()), end - rest.begin());
     return data;
   }
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t buffer_size) {
+    auto v = unmarshal_view(std::span<const uint8_t>{buffer, buffer_size});
+    if (!v) {
+      return etl::nullopt;
+    }
+    return t{.addr = v->addr, .name = std::string{v->name}};
+  }
 };
 
+/**
+ * @note the flag byte tells what follows: bit 0 for the device, and bit 1 for
+ *       the link statistics, which is prefixed with its length so that a
+ *       receiver could skip it
+ */
 struct repeater_status {
-  static constexpr uint8_t magic = 0x47;
+  static constexpr uint8_t magic           = 0x47;
+  static constexpr uint8_t flag_device     = 0x01;
+  static constexpr uint8_t flag_link_stats = 0x02;
+  /**
+   * @brief magic + addr + key + flag
+   */
+  static constexpr size_t header_size = sizeof(magic) + BLE_ADDR_SIZE + sizeof(name_map_key_t) + sizeof(uint8_t);
   struct t {
     using module = repeater_status;
     addr_t repeater_addr{};
     name_map_key_t key                 = 0;
     etl::optional<hr_device::t> device = etl::nullopt;
+    etl::optional<link_stats::t> link  = etl::nullopt;
+  };
+  /**
+   * @brief `t` that borrows the device name
+   * @sa hr_device::view
+   */
+  struct view {
+    addr_t repeater_addr{};
+    name_map_key_t key                    = 0;
+    etl::optional<hr_device::view> device = etl::nullopt;
+    etl::optional<link_stats::t> link     = etl::nullopt;
   };
+  static view to_view(const t &data) {
+    auto v = view{.repeater_addr = data.repeater_addr, .key = data.key, .link = data.link};
+    if (data.device) {
+      v.device = hr_device::to_view(*data.device);
+    }
+    return v;
+  }
+  static constexpr size_t size_needed(const view &data) {
+    // header + device + (length + link stats)
+    return header_size +
+           (data.device ? hr_device::size_needed(*data.device) : 0) +
+           (data.link ? sizeof(uint8_t) + link_stats::size_needed(*data.link) : 0);
+  }
   static size_t size_needed(const t &data) {
-    return sizeof(magic) +
-           BLE_ADDR_SIZE +
-           sizeof(t::key) +
-           (data.device ? hr_device::size_needed(*data.device) : 0);
+    return size_needed(to_view(data));
   }
-  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
-    if (size < size_needed(data)) {
+  static constexpr size_t marshal(const view &data, std::span<uint8_t> buffer) {
+    // the header on its own as well, which GCC can't tell from `size_needed`
+    // and would warn of the writes below as out of bounds
+    if (buffer.size() < header_size || buffer.size() < size_needed(data)) {
       return 0;
     }
     size_t offset    = 0;
@@ -69,23 +143,36 @@ struct repeater_status {
       buffer[offset++] = data.repeater_addr[i];
     }
     buffer[offset++] = data.key;
-    // last bit indicates whether there is a device
     uint8_t flag = 0x00;
     if (data.device) {
-      flag |= 0x01;
+      flag |= flag_device;
+    }
+    if (data.link) {
+      flag |= flag_link_stats;
     }
     buffer[offset++] = flag;
     if (data.device) {
-      offset += hr_device::marshal(*data.device, buffer + offset, size - offset);
+      offset += hr_device::marshal(*data.device, buffer.subspan(offset));
+    }
+    if (data.link) {
+      const auto sz    = link_stats::marshal(*data.link, buffer.subspan(offset + 1));
+      buffer[offset++] = static_cast<uint8_t>(sz);
+      offset += sz;
     }
     return offset;
   }
-  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
-    if (size < BLE_ADDR_SIZE + sizeof(name_map_key_t)) {
+  static size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(to_view(data), buffer);
+  }
+  static size_t marshal(const t &data, uint8_t *buffer, size_t size) {
+    return marshal(to_view(data), std::span<uint8_t>{buffer, size});
+  }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    if (buffer.size() < header_size) {
       return etl::nullopt;
     }
 
-    t data;
+    view data;
     if (buffer[0] != magic) {
       return etl::nullopt;
     }
@@ -95,14 +182,37 @@ struct repeater_status {
     }
     data.key     = buffer[offset++];
     uint8_t flag = buffer[offset++];
-    if (flag & 0x01) {
-      data.device = hr_device::unmarshal(buffer + offset, size - offset);
+    if (flag & flag_device) {
+      data.device = hr_device::unmarshal_view(buffer.subspan(offset));
+      if (!data.device) {
+        return etl::nullopt;
+      }
+      offset += hr_device::size_needed(*data.device);
     } else {
       data.device = etl::nullopt;
     }
+    if (flag & flag_link_stats) {
+      if (offset >= buffer.size() || buffer.size() - offset - 1 < buffer[offset]) {
+        return etl::nullopt;
+      }
+      const auto len = buffer[offset++];
+      // a version this decoder doesn't know is not an error of the frame
+      data.link = link_stats::unmarshal_view(buffer.subspan(offset, len));
+    }
     return data;
   }
-  static std::string to_string(const t &data) {
+  static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
+    auto v = unmarshal_view(std::span<const uint8_t>{buffer, size});
+    if (!v) {
+      return etl::nullopt;
+    }
+    auto data = t{.repeater_addr = v->repeater_addr, .key = v->key, .link = v->link};
+    if (v->device) {
+      data.device = hr_device::t{.addr = v->device->addr, .name = std::string{v->device->name}};
+    }
+    return data;
+  }
+  static std::string to_string(const view &data) {
     auto ss = std::stringstream();
     ss << "repeater_addr="
        << utils::toHex(data.repeater_addr.data(), data.repeater_addr.size());
@@ -112,8 +222,14 @@ struct repeater_status {
       ss << ", device_name=" << data.device->name;
       ss << ", device_addr=" << utils::toHex(data.device->addr.data(), data.device->addr.size());
     }
+    if (data.link) {
+      ss << ", " << link_stats::to_string(*data.link);
+    }
     return ss.str();
   }
+  static std::string to_string(const t &data) {
+    return to_string(to_view(data));
+  }
 };
 }
 
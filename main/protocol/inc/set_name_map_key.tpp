@@ -6,6 +6,7 @@
 #define BLE_LORA_ADAPTER_SET_NAME_MAP_KEY_H
 
 #include <string>
+#include <span>
 #include <etl/optional.h>
 #include "hr_lora_common.tpp"
 
@@ -17,11 +18,13 @@ struct set_name_map_key {
     addr_t addr{};
     name_map_key_t key = 0;
   };
+  // trivially copyable, nothing to borrow from the buffer
+  using view = t;
   static consteval size_t size_needed() {
     // addr + key + magic
     return BLE_ADDR_SIZE + sizeof(t::key) + sizeof(magic);
   }
-  static size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
+  static constexpr size_t marshal(const t &data, uint8_t *buffer, size_t buffer_size) {
     if (buffer_size < size_needed()) {
       return 0;
     }
@@ -32,6 +35,9 @@ struct set_name_map_key {
     buffer[BLE_ADDR_SIZE + 1] = data.key;
     return size_needed();
   }
+  static constexpr size_t marshal(const t &data, std::span<uint8_t> buffer) {
+    return marshal(data, buffer.data(), buffer.size());
+  }
   static etl::optional<t> unmarshal(const uint8_t *buffer, size_t size) {
     if (size < size_needed()) {
       return etl::nullopt;
@@ -49,6 +55,9 @@ struct set_name_map_key {
 
     return data;
   }
+  static etl::optional<view> unmarshal_view(std::span<const uint8_t> buffer) {
+    return unmarshal(buffer.data(), buffer.size());
+  }
 };
 }
 
@@ -1,270 +1,148 @@
-#include <esp_random.h>
 #include <esp_log.h>
-#include <etl/random.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
-#include <freertos/event_groups.h>
-#include <endian.h>
 #include <cstring>
+#include <span>
 #include "scan_manager.h"
 #include "server_callback.h"
 #include "whitelist_char_callback.h"
 #include "esp_hal.h"
 #include "common.h"
 #include "hr_lora.h"
+#include "hr_measurement.h"
+#include "tdma.h"
+#include "send_queue.h"
+#include "radio.h"
+#include "radio_profile.h"
+#include "airtime.h"
+#include "arq.h"
+#include "channel_plan.h"
+#include "power_model.h"
 #include "app_nvs.h"
+#include "handle_message.h"
+#include "send_scheduler.h"
+#include "slot_ticker.h"
+#include "slot_plan.h"
+#include "scan_result_batch.h"
 
 extern "C" void app_main();
 
-constexpr auto RecvEvt = BIT0;
-
-constexpr auto send_lk_timeout_tick = 100;
-
 // https://docs.espressif.com/projects/esp-idf/en/v5.0/esp32c3/api-reference/system/power_management.html
 // https://github.com/espressif/esp-idf/tree/b4268c874a4/examples/wifi/power_save
-class SendScheduler {
-  static constexpr auto TAG = "SendScheduler";
-  std::vector<uint8_t> data{};
-  TimerHandle_t timer = nullptr;
-  struct send_timer_param_t {
-    std::function<void()> fn;
-  };
-  send_timer_param_t timer_param{[]() {}};
+static_assert(SendScheduler::MAX_FRAME_SIZE == radio::RadioTask::MAX_FRAME_SIZE);
+static_assert(HrLoRa::hr_rr::max_rr * 60'000 >= common::MAX_HEART_RATE_BPM * common::TDMA_SLOT_COUNT * common::TDMA_SLOT_TIME.count());
+static_assert(HrLoRa::hr_rr::max_size <= SendScheduler::MAX_FRAME_SIZE);
+static_assert(scan_result_batch::ATT_MTU_DFLT == BLE_ATT_MTU_DFLT);
 
+/**
+ * @brief `scan_result_batch::Packer` behind a lock, which sends the packed
+ *        scan results when the next one doesn't fit, or `flush_ms` after the
+ *        first one
+ * @note the timer only wakes a task of its own to flush; a notification could
+ *       block on the BLE stack, which would hold up the other timers of the
+ *       timer task (e.g. `SlotTicker`, whose slots can't wait)
+ */
+class ScanResultBatch {
 public:
-  std::function<void(uint8_t *data, size_t size)>
-      send = nullptr;
-
-  void clear_timer() {
-    if (this->timer != nullptr) {
-      xTimerStop(this->timer, portMAX_DELAY);
-      xTimerDelete(this->timer, portMAX_DELAY);
-      this->timer = nullptr;
-    }
-  }
-
   /**
-   * @brief schedule the data to be sent
-   * @param pdata the data to be sent
-   * @param size the size of the data
-   * @param interval_ms the interval between transmission, in milliseconds
-   * @return if the previous timer is replaced
+   * @brief the largest value of a characteristic
    */
-  bool schedule(uint8_t *pdata, uint8_t size, size_t interval_ms) {
-    this->data       = std::vector<uint8_t>(pdata, pdata + size);
-    bool is_replaced = false;
-    if (this->timer != nullptr) {
-      clear_timer();
-      is_replaced = true;
+  static constexpr size_t MAX_SIZE = BLE_ATT_ATTR_MAX_LEN;
+
+private:
+  static constexpr auto TAG = "ScanResultBatch";
+  scan_result_batch::Packer<MAX_SIZE> packer{encode_device};
+  StaticSemaphore_t lock_buf{};
+  SemaphoreHandle_t lock  = nullptr;
+  StaticTimer_t timer_buf{};
+  TimerHandle_t timer     = nullptr;
+  TaskHandle_t flush_task = nullptr;
+
+  static void run_flush_task(void *arg) {
+    auto &self = *static_cast<ScanResultBatch *>(arg);
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      self.flush();
     }
-
-    auto send_task = [this]() {
-      if (this->send != nullptr) {
-        send(data.data(), data.size());
-      } else {
-        ESP_LOGW(TAG, "send callback is empty");
-      }
-      clear_timer();
-    };
-
-    this->timer_param.fn = send_task;
-    auto run_send_task   = [](TimerHandle_t handle) {
-      auto *param = static_cast<send_timer_param_t *>(pvTimerGetTimerID(handle));
-      param->fn();
-    };
-    this->timer = xTimerCreate("send_timer",
-                               pdMS_TO_TICKS(interval_ms),
-                               pdFALSE,
-                               &this->timer_param,
-                               run_send_task);
-    xTimerStart(this->timer, portMAX_DELAY);
-    return is_replaced;
   }
-};
 
-/**
- * @brief try to transmit the data
- * @note would block until the transmission is done and will start receiving after that
- */
-void try_transmit(uint8_t *data, size_t size,
-                  SemaphoreHandle_t lk, TickType_t timeout_tick,
-                  LLCC68 &rf) {
-  const auto TAG = "try_transmit";
-  if (xSemaphoreTake(lk, timeout_tick) != pdTRUE) {
-    ESP_LOGE(TAG, "failed to take rf_lock; no transmission happens;");
-    return;
-  }
-  auto err = rf.transmit(data, size);
-  if (err == RADIOLIB_ERR_NONE) {
-    // ok
-  } else if (err == RADIOLIB_ERR_TX_TIMEOUT) {
-    ESP_LOGW(TAG, "tx timeout; please check the busy pin;");
-  } else {
-    ESP_LOGE(TAG, "failed to transmit, code %d", err);
+  static bool encode_mac(pb_ostream_t *stream, const pb_field_t *field, void *const *arg) {
+    const auto addr_ptr = reinterpret_cast<const uint8_t *>(*arg);
+    if (!pb_encode_tag_for_field(stream, field)) {
+      return false;
+    }
+    return pb_encode_string(stream, addr_ptr, white_list::BLE_MAC_ADDR_SIZE);
   }
-  rf.standby();
-  rf.startReceive();
-  xSemaphoreGive(lk);
-}
 
-size_t try_receive(uint8_t *buf, const size_t max_size,
-                   SemaphoreHandle_t lk, TickType_t timeout_tick,
-                   LLCC68 &rf) {
-  const auto TAG = "try_receive";
-  // https://www.freertos.org/a00122.html
-  if (xSemaphoreTake(lk, timeout_tick) != pdTRUE) {
-    ESP_LOGE(TAG, "failed to take rf_lock");
-    return 0;
-  }
-  const auto length = rf.getPacketLength(true);
-  if (length > max_size) {
-    ESP_LOGE(TAG, "packet length %d > %d max buffer size", length, max_size);
-    xSemaphoreGive(lk);
-    return 0;
-  }
-  const auto err = rf.readData(buf, length);
-  std::string irq_status_str;
-  const auto status = rf.getIrqStatus();
-  if (status & RADIOLIB_SX126X_IRQ_TIMEOUT) {
-    irq_status_str += "t";
-  }
-  if (status & RADIOLIB_SX126X_IRQ_RX_DONE) {
-    irq_status_str += "r";
-  }
-  if (status & RADIOLIB_SX126X_IRQ_CRC_ERR) {
-    irq_status_str += "c";
-  }
-  if (status & RADIOLIB_SX126X_IRQ_HEADER_ERR) {
-    irq_status_str += "h";
-  }
-  if (status & RADIOLIB_SX126X_IRQ_TX_DONE) {
-    irq_status_str += "x";
-  }
-  if (!irq_status_str.empty()) {
-    ESP_LOGI(TAG, "flag=%s", irq_status_str.c_str());
+  /**
+   * @brief a `devices` field, see `scan_result_batch::Packer::encode_fn`
+   */
+  static size_t encode_device(std::span<uint8_t> out, std::string_view name, const uint8_t *addr) {
+    auto ostream                    = pb_ostream_from_buffer(out.data(), out.size());
+    ::bluetooth_device_pb device_pb = bluetooth_device_pb_init_zero;
+    device_pb.mac.funcs.encode      = encode_mac;
+    device_pb.mac.arg               = const_cast<uint8_t *>(addr);
+    std::memcpy(device_pb.name, name.data(), std::min(name.size(), sizeof(device_pb.name) - 1));
+    const auto ok = pb_encode_tag(&ostream, PB_WT_STRING, scan_result_pb_devices_tag) &&
+                    pb_encode_submessage(&ostream, bluetooth_device_pb_fields, &device_pb);
+    return ok ? ostream.bytes_written : 0;
   }
-  if (err != RADIOLIB_ERR_NONE) {
-    ESP_LOGE(TAG, "failed to read data, code %d", err);
-    xSemaphoreGive(lk);
-    return 0;
+
+  /**
+   * @note should be called with `lock` held
+   */
+  void send_packed(std::span<const uint8_t> data) {
+    ESP_LOGD(TAG, "flush %zu devices in %zu bytes", packer.count(), data.size());
+    if (send != nullptr) {
+      send(data);
+    } else {
+      ESP_LOGW(TAG, "send callback is empty");
+    }
   }
-  xSemaphoreGive(lk);
-  return length;
-}
 
-struct handle_message_callbacks_t {
-  std::function<void(uint8_t *data, size_t size, size_t interval_ms)> schedule = nullptr;
-  std::function<void(uint8_t *data, size_t size)> send                         = nullptr;
-  std::function<std::unique_ptr<blue::HeartMonitor>()> get_device              = nullptr;
-  std::function<void(HrLoRa::name_map_key_t)> set_name_map_key                 = nullptr;
-  std::function<HrLoRa::name_map_key_t()> get_name_map_key                     = nullptr;
-};
+public:
+  std::function<void(std::span<const uint8_t>)> send = nullptr;
+  /**
+   * @brief the ATT MTU of the clients; a notification carries 3 bytes less
+   */
+  std::function<uint16_t()> get_mtu = nullptr;
 
-/**
- * @brief handle the message received from LoRa
- * @param data the data received
- * @param size the size of the data
- * @param callbacks the callbacks to handle the message. This function would do nothing if any of the callback is empty.
- */
-void handle_message(uint8_t *data, size_t size, const handle_message_callbacks_t &callbacks) {
-  const auto TAG         = "recv";
-  const bool is_cb_empty = callbacks.send == nullptr ||
-                           callbacks.schedule == nullptr ||
-                           callbacks.get_device == nullptr ||
-                           callbacks.set_name_map_key == nullptr ||
-                           callbacks.get_name_map_key == nullptr;
-  if (is_cb_empty) {
-    ESP_LOGE(TAG, "at least one callback is empty");
-    return;
-  }
-  auto is_my_address = [](const HrLoRa::addr_t &req_addr) {
-    const auto my_addr        = NimBLEDevice::getAddress();
-    const auto my_addr_native = my_addr.getNative();
-    const bool is_broadcast   = std::equal(req_addr.begin(), req_addr.end(), HrLoRa::broadcast_addr.data());
-    const bool eq             = is_broadcast || std::equal(req_addr.begin(), req_addr.end(), my_addr_native);
-    return eq;
-  };
-  auto get_device_status = [&callbacks]() {
-    constexpr auto TAG        = "device status";
-    const auto my_addr        = NimBLEDevice::getAddress();
-    const auto my_addr_native = my_addr.getNative();
-    auto status               = HrLoRa::repeater_status::t{
-                      .repeater_addr = HrLoRa::addr_t{},
-                      .key           = callbacks.get_name_map_key(),
+  /**
+   * @brief create the timer, the lock and the task that flushes
+   * @note should be called once before `add`, and `this` should not be moved after that
+   */
+  void init(uint32_t flush_ms) {
+    lock = xSemaphoreCreateMutexStatic(&lock_buf);
+    xTaskCreate(run_flush_task, "scan_flush", 4096, this, 1, &flush_task);
+    auto run = [](TimerHandle_t handle) {
+      xTaskNotifyGive(static_cast<ScanResultBatch *>(pvTimerGetTimerID(handle))->flush_task);
     };
-    std::copy_n(my_addr_native, status.repeater_addr.size(), status.repeater_addr.data());
-    const auto device = callbacks.get_device();
-    if (device) {
-      auto dev = HrLoRa::hr_device::t{};
-      std::copy(device->addr.begin(), device->addr.end(), dev.addr.data());
-      dev.name      = device->name;
-      status.device = dev;
-    } else {
-      status.device = etl::nullopt;
-    }
-    ESP_LOGI(TAG, "status=%s", HrLoRa::repeater_status::to_string(status).c_str());
-    return status;
-  };
+    const auto ticks = pdMS_TO_TICKS(flush_ms);
+    timer            = xTimerCreateStatic("scan_timer", ticks == 0 ? 1 : ticks, pdFALSE, this, run, &timer_buf);
+  }
 
-  static auto rng  = etl::random_xorshift(esp_random());
-  const auto magic = data[0];
-  switch (magic) {
-    case HrLoRa::query_device_by_mac::magic: {
-      auto r = HrLoRa::query_device_by_mac::unmarshal(data, size);
-      if (!r) {
-        ESP_LOGE(TAG, "failed to unmarshal query_device_by_mac");
-        break;
-      }
-      auto &req = r.value();
-      if (!is_my_address(req.addr)) {
-        ESP_LOGI(TAG, "%s is not for me", utils::toHex(req.addr.data(), req.addr.size()).c_str());
-        break;
-      }
-      auto status     = get_device_status();
-      uint8_t buf[64] = {0};
-      auto sz         = HrLoRa::repeater_status::marshal(status, buf, sizeof(buf));
-      if (sz == 0) {
-        ESP_LOGE(TAG, "failed to marshal query_device_by_mac_response");
-        break;
-      }
-      const auto interval = rng.range(0, common::MAX_RF_MSG_SCHEDULE_DELAY_MS);
-      constexpr auto TAG  = "schedule";
-      ESP_LOGI(TAG, "schedule time=%lums", interval);
-      callbacks.schedule(buf, sz, interval);
-      break;
-    }
-    case HrLoRa::set_name_map_key::magic: {
-      auto r = HrLoRa::set_name_map_key::unmarshal(data, size);
-      if (!r) {
-        ESP_LOGE(TAG, "failed to unmarshal set_name_map_key");
-        break;
-      }
-      auto &req = r.value();
-      callbacks.set_name_map_key(req.key);
-      app_nvs::set_name_map_key(req.key);
-      ESP_LOGI(TAG, "set name map key to %d", req.key);
-      // send the new status back after setting the name map key
-      uint8_t buf[64] = {0};
-      auto status     = get_device_status();
-      auto sz         = HrLoRa::repeater_status::size_needed(status);
-      if (sz == 0) {
-        ESP_LOGE(TAG, "failed to marshal repeater_status");
-        break;
-      }
-      callbacks.send(buf, sz);
-      break;
-    }
-    case HrLoRa::hr_data::magic:
-    case HrLoRa::named_hr_data::magic:
-    case HrLoRa::repeater_status::magic: {
-      // from other repeater. do nothing.
+  void add(std::string_view name, const uint8_t *addr) {
+    if (timer == nullptr) {
+      ESP_LOGE(TAG, "not initialized");
       return;
     }
-    default: {
-      ESP_LOGW("recv", "unknown magic: 0x%02x", magic);
+    const uint16_t mtu = get_mtu != nullptr ? get_mtu() : BLE_ATT_MTU_DFLT;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    const auto res = packer.add(name, addr, mtu, [this](std::span<const uint8_t> data) { send_packed(data); });
+    if (res == scan_result_batch::add_result::too_large) {
+      ESP_LOGE(TAG, "a device doesn't fit in %zu bytes", scan_result_batch::payload_limit(mtu, MAX_SIZE));
+    } else if (res == scan_result_batch::add_result::first) {
+      xTimerReset(timer, 0);
     }
+    xSemaphoreGive(lock);
   }
-}
+
+  void flush() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    packer.flush([this](std::span<const uint8_t> data) { send_packed(data); });
+    xSemaphoreGive(lock);
+  }
+};
 
 void app_main() {
   using namespace common;
@@ -275,14 +153,25 @@ void app_main() {
   // https://github.com/h2zero/esp-nimble-cpp/blob/4e65ce5d32a458b285c536f680edc550c60aeb92/examples/Bluetooth_5/NimBLE_extended_server/main/main.cpp
   auto err = app_nvs::nvs_init();
   ESP_ERROR_CHECK(err);
-  app_nvs::addr_t addr{0};
-  bool has_addr = false;
-  err           = app_nvs::get_addr(&addr);
+  auto whitelist_blob  = std::array<uint8_t, blue::MAX_DEVICE_NUM * app_nvs::ADDR_SIZE>{};
+  size_t whitelist_len = 0;
+  err                  = app_nvs::get_whitelist(whitelist_blob, &whitelist_len);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "no device addr, fallback back to nullptr; reason %s (%d);", esp_err_to_name(err), err);
-  } else {
-    ESP_LOGI(TAG, "addr=%s", utils::toHex(addr.data(), addr.size()).c_str());
-    has_addr = true;
+    // the single address saved by the older firmware
+    app_nvs::addr_t addr{0};
+    err = app_nvs::get_addr(&addr);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "no device addr, fallback back to nullptr; reason %s (%d);", esp_err_to_name(err), err);
+    } else {
+      std::copy(addr.begin(), addr.end(), whitelist_blob.begin());
+      whitelist_len = addr.size();
+    }
+  }
+  ESP_LOGI(TAG, "whitelist=%s", utils::toHex(whitelist_blob.data(), whitelist_len).c_str());
+  auto name_pattern_blob  = std::array<uint8_t, blue::NAME_PATTERN_BLOB_SIZE>{};
+  size_t name_pattern_len = 0;
+  if (app_nvs::get_name_patterns(name_pattern_blob, &name_pattern_len) != ESP_OK) {
+    name_pattern_len = 0;
   }
 
   /**
@@ -291,21 +180,25 @@ void app_main() {
   static auto name_map_key = HrLoRa::name_map_key_t{0};
   auto name_map_key_ptr    = &name_map_key;
   err                      = app_nvs::get_name_map_key(name_map_key_ptr);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "no name map key, fallback back to 0; reason %s (%d);", esp_err_to_name(err), err);
+  // derived from the address once it's known, see `tdma::default_key`
+  const bool has_name_map_key = err == ESP_OK;
+  if (!has_name_map_key) {
+    ESP_LOGE(TAG, "no name map key; reason %s (%d);", esp_err_to_name(err), err);
   } else {
     ESP_LOGI(TAG, "name map key=%d", *name_map_key_ptr);
   }
 
 #ifndef DISABLE_LORA
-  static auto hal = ESPHal(pin::SCK, pin::MISO, pin::MOSI);
+  static auto hal = ESPHal(pin::SCK, pin::MISO, pin::MOSI,
+                           ESPHal::config_t{.clock_hz = RADIO_SPI_CLOCK_HZ});
   hal.init();
   ESP_LOGI(TAG, "hal init success!");
   static auto module = Module(&hal, pin::CS, pin::DIO1, pin::RST, pin::BUSY);
   static auto rf     = LLCC68(&module);
-  auto st            = rf.begin(433.2, 500.0, 10, 7,
-                                RADIOLIB_SX126X_SYNC_WORD_PRIVATE,
-                                22, 8, 1.6);
+  constexpr auto &rx_profile = radio_profile::DEFAULT_PROFILE;
+  auto st                    = rf.begin(rx_profile.freq_mhz, rx_profile.bw_khz, rx_profile.sf, rx_profile.cr,
+                                        RADIOLIB_SX126X_SYNC_WORD_PRIVATE,
+                                        rx_profile.power_dbm, rx_profile.preamble_len, 1.6);
   if (st != RADIOLIB_ERR_NONE) {
     ESP_LOGE(TAG, "RF begin failed, code %d", st);
     vTaskDelay(1000 / portTICK_PERIOD_MS);
@@ -313,38 +206,59 @@ void app_main() {
   }
   ESP_LOGI(TAG, "RF began!");
 
-  /** Radio receive interruption */
-  struct rf_recv_interrupt_data_t {
-    EventGroupHandle_t evt_grp;
+  /**
+   * @brief owns `rf` after `start`; nobody else should touch `rf` since then
+   */
+  static auto radio_task = radio::RadioTask(rf, rx_profile,
+                                            airtime::config_t{
+                                                .window_ms     = static_cast<uint32_t>(DUTY_CYCLE_WINDOW.count()),
+                                                .duty_permille = DUTY_CYCLE_PERMILLE,
+                                            },
+                                            hal, pin::DIO1);
+  radio_task.lbt.enabled = LBT_ENABLED;
+  radio_task.sniff       = radio::sniff_config_t{
+      .enabled           = RX_DUTY_CYCLED,
+      .wake_preamble_len = WAKE_PREAMBLE_LEN,
   };
-  auto evt_grp = xEventGroupCreate();
 
   /**
-   * used in `rf.setPacketReceivedAction`
-   * a workaround to pass an argument to ISR.
-   * Actually ESP IDF has a API to pass an argument to ISR (`gpio_isr_handler_add`),
-   * but RadioLib doesn't use it and I don't want to break the API (though I can).
+   * @brief select the TX profile by the frames heard from the gateway
+   * @note accessed from both the radio task and the slot ticker
    */
-  static auto rf_recv_interrupt_data = rf_recv_interrupt_data_t{evt_grp};
-  rf.setPacketReceivedAction([]() {
-    // https://www.freertos.org/xEventGroupSetBitsFromISR.html
-    BaseType_t task_woken = pdFALSE;
-    auto xResult          = xEventGroupSetBitsFromISR(rf_recv_interrupt_data.evt_grp, RecvEvt, &task_woken);
-    if (xResult != pdFAIL) {
-      portYIELD_FROM_ISR(task_woken);
-    }
-  });
-
-  rf.standby();
-  rf.startReceive();
+  struct link_adapter_t {
+    SemaphoreHandle_t lock;
+    radio_profile::Adapter adapter;
+  };
+  static auto link_adapter = link_adapter_t{
+      .lock    = xSemaphoreCreateMutex(),
+      .adapter = radio_profile::Adapter{radio_profile::adapter_config_t{
+          .max_index = GATEWAY_MULTI_SF ? radio_profile::PROFILES.size() - 1 : radio_profile::last_power_only_index(),
+      }},
+  };
 #endif
-  auto *rf_lock = xSemaphoreCreateMutex();
 
   NimBLEDevice::init(BLE_NAME);
   auto &server          = *NimBLEDevice::createServer();
   static auto server_cb = ServerCallbacks();
   server.setCallbacks(&server_cb);
 
+  /**
+   * @brief the BLE address, which is also the address of this repeater in HrLoRa
+   */
+  const auto get_self_addr = []() {
+    auto addr = HrLoRa::addr_t{};
+    std::copy_n(NimBLEDevice::getAddress().getNative(), addr.size(), addr.data());
+    return addr;
+  };
+  if (!has_name_map_key) {
+    *name_map_key_ptr = tdma::default_key(get_self_addr());
+    ESP_LOGW(TAG, "************************************************************");
+    ESP_LOGW(TAG, "* NO NAME MAP KEY FROM THE GATEWAY; GOING BY %3d (slot %2d) *",
+             *name_map_key_ptr, *name_map_key_ptr % TDMA_SLOT_COUNT);
+    ESP_LOGW(TAG, "* derived from the address, and might share a slot         *");
+    ESP_LOGW(TAG, "************************************************************");
+  }
+
   static auto scan_manager = ScanManager();
   auto &hr_service         = *server.createService(BLE_CHAR_HR_SERVICE_UUID);
   // repeat the data from the connected device
@@ -354,198 +268,567 @@ void app_main() {
                                                                  NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY);
   auto &device_char           = *hr_service.createCharacteristic(BLE_CHAR_DEVICE_UUID,
                                                                  NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
+  auto &link_stats_char       = *hr_service.createCharacteristic(BLE_CHAR_LINK_STATS_UUID,
+                                                                 NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
   static auto white_cb        = WhiteListCallback();
-  white_cb.on_request_address = []() {
-    return scan_manager.get_target_addr();
+  white_cb.on_request_list    = []() {
+    return scan_manager.get_targets();
   };
-  white_cb.on_disconnect = []() {
-    scan_manager.set_target_addr(etl::nullopt);
+  // the keys given by the gateway, which outlive a reboot as the targets do
+  static auto save_device_keys = []() {
+    auto blob     = std::array<uint8_t, blue::DEVICE_KEY_BLOB_SIZE>{};
+    const auto sz = scan_manager.export_keys(blob);
+    app_nvs::set_device_keys(std::span<const uint8_t>{blob.data(), sz});
   };
-  white_cb.on_address = [](WhiteListCallback::addr_opt_t addr) {
-    if (addr.has_value()) {
-      scan_manager.set_target_addr(etl::make_optional(addr.value().addr));
-    } else {
-      scan_manager.set_target_addr(etl::nullopt);
-    }
+  // the list written replaces the targets and is saved; `DISCONNECT` clears them all
+  const auto save_targets = []() {
+    auto blob     = std::array<uint8_t, blue::MAX_DEVICE_NUM * app_nvs::ADDR_SIZE>{};
+    const auto sz = scan_manager.export_targets(blob);
+    app_nvs::set_whitelist(std::span<const uint8_t>{blob.data(), sz});
+    auto name_blob     = std::array<uint8_t, blue::NAME_PATTERN_BLOB_SIZE>{};
+    const auto name_sz = scan_manager.export_name_patterns(name_blob);
+    app_nvs::set_name_patterns(std::span<const uint8_t>{name_blob.data(), name_sz});
+    // the ones removed take their keys with them
+    save_device_keys();
+  };
+  white_cb.on_disconnect = [save_targets]() {
+    scan_manager.set_targets(white_list::list_t{});
+    save_targets();
+  };
+  white_cb.on_list = [save_targets](const white_list::list_t &list) {
+    scan_manager.set_targets(list);
+    save_targets();
   };
   white_char.setCallbacks(&white_cb);
 
   /**
-   * @brief should always allocate on heap when using `run_recv_task`
+   * @brief aligned to the frames from the gateway
+   */
+  static auto slot_clock = tdma::SlotClock{tdma::config_t{
+      .slot_count = common::TDMA_SLOT_COUNT,
+      .slot_ms    = static_cast<uint32_t>(common::TDMA_SLOT_TIME.count()),
+  }};
+  /**
+   * @brief samples of a device, collected from BLE notifications
+   */
+  struct device_hr_t {
+    HrLoRa::addr_t addr;
+    HrLoRa::hr_batch::accumulator hr_accumulator;
+    HrLoRa::hr_rr::accumulator rr_accumulator;
+    // the latest sample, for `named_hr_data`
+    etl::optional<uint8_t> latest;
+    uint32_t updated_ms;
+  };
+  /**
+   * @brief flushed in the slots of this repeater, see `key_of`
+   */
+  struct hr_state_t {
+    SemaphoreHandle_t lock;
+    etl::vector<device_hr_t, common::MAX_BRIDGED_DEVICES> devices;
+    /**
+     * @brief the device to be served first in the next slot
+     */
+    size_t cursor;
+
+    /**
+     * @brief the samples dropped by the devices replaced, which were never
+     *        sent, and the RR intervals `hr_measurement::parse` had no room for
+     */
+    uint32_t hr_dropped;
+    uint32_t rr_dropped;
+
+    /**
+     * @brief the samples of `addr`; the least recently updated device is
+     *        replaced if full, and what it had is counted as dropped
+     */
+    device_hr_t &of(const HrLoRa::addr_t &addr, uint32_t now_ms) {
+      auto it = std::ranges::find_if(devices, [&addr](const auto &d) { return d.addr == addr; });
+      if (it != devices.end()) {
+        return *it;
+      }
+      auto fresh = device_hr_t{
+          .addr           = addr,
+          .hr_accumulator = HrLoRa::hr_batch::accumulator(HrLoRa::hr_batch::max_samples, slot_clock.superframe_ms()),
+          .rr_accumulator = HrLoRa::hr_rr::accumulator(HrLoRa::hr_rr::max_rr, slot_clock.superframe_ms()),
+          .latest         = etl::nullopt,
+          .updated_ms     = now_ms,
+      };
+      if (!devices.full()) {
+        devices.push_back(std::move(fresh));
+        return devices.back();
+      }
+      auto &victim = *std::ranges::max_element(devices, {}, [now_ms](const auto &d) { return now_ms - d.updated_ms; });
+      hr_dropped += victim.hr_accumulator.dropped() + victim.hr_accumulator.size();
+      rr_dropped += victim.rr_accumulator.dropped() + victim.rr_accumulator.size();
+      victim = std::move(fresh);
+      return victim;
+    }
+
+    /**
+     * @brief the samples dropped so far, including the ones of the devices
+     *        still here
+     * @note should be called with `lock` held
+     */
+    void count_dropped(HrLoRa::link_stats::t &stats) const {
+      stats.hr_dropped = hr_dropped;
+      stats.rr_dropped = rr_dropped;
+      for (const auto &d : devices) {
+        stats.hr_dropped += d.hr_accumulator.dropped();
+        stats.rr_dropped += d.rr_accumulator.dropped();
+      }
+    }
+  };
+  static auto hr_state = hr_state_t{
+      .lock       = xSemaphoreCreateMutex(),
+      .devices    = {},
+      .cursor     = 0,
+      .hr_dropped = 0,
+      .rr_dropped = 0,
+  };
+  /**
+   * @brief the key a device sends with, and whose slot it goes in
+   * @return its own; the one of this repeater if it's the only device (as it
+   *         always was); none for the others, which send `named_hr_data` only
+   *         (which has the address) in the slot of this repeater until they have one
+   * @note should be called with `hr_state.lock` held
    */
-  struct recv_task_param_t {
-    std::function<void(LLCC68 &)> task;
-    LLCC68 *rf;
-    TaskHandle_t handle;
-    EventGroupHandle_t evt_grp;
+  static auto key_of = [](const device_hr_t &dev) -> etl::optional<HrLoRa::name_map_key_t> {
+    auto dev_addr = ScanManager::addr_t{};
+    std::ranges::copy(dev.addr, dev_addr.begin());
+    if (const auto key = scan_manager.get_key(dev_addr)) {
+      return key;
+    }
+    if (hr_state.devices.size() == 1) {
+      return name_map_key;
+    }
+    return etl::nullopt;
   };
 
+#ifndef DISABLE_LORA
+  /**
+   * @brief the frame being handled by `recv_task`
+   */
+  static const radio::RadioTask::rx_slot_t *current_rx = nullptr;
+#endif
   static auto send_scheduler = SendScheduler();
+  send_scheduler.init();
 #ifndef DISABLE_LORA
-  send_scheduler.send = [rf_lock](uint8_t *data, size_t size) {
-    try_transmit(data, size, rf_lock, send_lk_timeout_tick, rf);
+  static auto channels = channel_plan::Plan{channel_plan::config_t{
+      .base_freq_mhz = rx_profile.freq_mhz,
+      .spacing_mhz   = CHANNEL_SPACING_MHZ,
+      .channel_count = CHANNEL_COUNT,
+      .slot_count    = TDMA_SLOT_COUNT,
+  }};
+  /**
+   * @brief the uplink frequency of `key` in the current superframe
+   * @note should be called in the slot of `key`
+   */
+  static auto uplink_freq_mhz = [](HrLoRa::name_map_key_t key) {
+    const uint32_t now_ms = esp_timer_get_time() / 1000;
+    // the middle of the slot, in case the timer fires a bit early
+    const auto superframe = slot_clock.superframe_index(now_ms + slot_clock.slot_ms() / 2);
+    return channels.freq_mhz(key, superframe);
+  };
+  /**
+   * @brief the airtime left in the slot of this repeater
+   * @note only used in the timer task, by `slot_ticker` and `send_scheduler`
+   */
+  static auto slot_budget  = slot_plan::Budget{slot_clock.slot_ms(), static_cast<uint32_t>(TDMA_SLOT_GUARD_TIME.count())};
+  static auto fits_in_slot = [](size_t size) {
+    const uint32_t now_ms = esp_timer_get_time() / 1000;
+    return slot_budget.take(slot_clock.slot_start(now_ms), radio_profile::time_on_air_us(radio_task.current_tx_profile(), size));
   };
+  static auto slot_ticker = SlotTicker();
+  send_scheduler.send     = [](uint8_t *data, size_t size) {
+    if (!fits_in_slot(size)) {
+      return false;
+    }
+    radio_task.send(data, size, airtime::traffic_class::control, uplink_freq_mhz(name_map_key));
+    return true;
+  };
+  send_scheduler.retry_delay_ms = [](uint32_t now_ms) {
+    // refused at the start of the slot, the slot is full; 0 would drop it
+    const auto delay = slot_clock.delay_until_slot(name_map_key, now_ms);
+    return delay == 0 ? slot_clock.superframe_ms() : delay;
+  };
+  /**
+   * @brief control frames in flight, and the sequence numbers of the gateways
+   * @note accessed from both `recv_task` and the slot ticker
+   */
+  struct arq_state_t {
+    using endpoint_t = arq::Endpoint<4, 4, SendScheduler::MAX_FRAME_SIZE>;
+    SemaphoreHandle_t lock;
+    endpoint_t endpoint;
+  };
+  static auto arq_state = arq_state_t{
+      .lock     = xSemaphoreCreateMutex(),
+      .endpoint = arq_state_t::endpoint_t{get_self_addr(), arq::config_t{
+                                                               .max_attempts = RELIABLE_MAX_ATTEMPTS,
+                                                               // it's polled once per superframe
+                                                               .base_backoff_ms = slot_clock.superframe_ms() - slot_clock.slot_ms(),
+                                                               .max_backoff_ms  = 8 * slot_clock.superframe_ms(),
+                                                           }},
+  };
+  {
+    // 3 frames in each superframe, and a frame from the gateway
+    constexpr uint32_t day_ms = 86'400'000;
+    const auto superframes    = day_ms / slot_clock.superframe_ms();
+    const auto traffic        = power_model::traffic_t{
+        .tx_frames_per_day = 3 * superframes,
+        .tx_size           = 24,
+        .rx_frames_per_day = superframes,
+        .rx_size           = HrLoRa::query_device_by_mac::size_needed(),
+    };
+    auto wake         = rx_profile;
+    wake.preamble_len = WAKE_PREAMBLE_LEN;
+    const auto config = power_model::config_t{.tx_profile = rx_profile, .rx_profile = wake};
+    ESP_LOGI(TAG, "estimated radio charge: continuous rx %.1f mAh/day, duty cycled rx %.1f mAh/day; using %s",
+             power_model::mah_per_day(power_model::rx_mode::continuous, config, traffic),
+             power_model::mah_per_day(power_model::rx_mode::duty_cycled, config, traffic),
+             RX_DUTY_CYCLED ? "duty cycled" : "continuous");
+  }
   static auto handle_message_callbacks = handle_message_callbacks_t{
-      .schedule         = [](uint8_t *data, const size_t size, const size_t interval_ms) { send_scheduler.schedule(data, size, interval_ms); },
-      .send             = [rf_lock](uint8_t *data, const size_t size) { try_transmit(data, size, rf_lock, send_lk_timeout_tick, rf); },
-      .get_device       = []() {
+      .schedule = [name_map_key_ptr](uint8_t *data, const size_t size, const size_t interval_ms) {
+        constexpr auto TAG    = "schedule";
+        const uint32_t now_ms = esp_timer_get_time() / 1000;
+        const auto delay      = interval_ms + slot_clock.delay_until_slot(*name_map_key_ptr, now_ms + interval_ms);
+        ESP_LOGI(TAG, "schedule time=%lums", delay);
+        send_scheduler.schedule(data, size, delay); },
+      .get_device = []() -> etl::optional<HrLoRa::hr_device::t> {
         const auto TAG = "get_device";
         auto dev = scan_manager.get_device();
-        if (dev) {
-          ESP_LOGI(TAG, "name=%s; addr=%s",
-                   dev->name.c_str(),
-                   utils::toHex(dev->addr.data(), dev->addr.size()).c_str());
-        } else {
+        if (!dev) {
           ESP_LOGW(TAG, "no device");
+          return etl::nullopt;
+        }
+        ESP_LOGI(TAG, "name=%s; addr=%s",
+                 dev->name.c_str(),
+                 utils::toHex(dev->addr.data(), dev->addr.size()).c_str());
+        auto data = HrLoRa::hr_device::t{.name = dev->name};
+        std::copy(dev->addr.begin(), dev->addr.end(), data.addr.begin());
+        return data; },
+      .find_device = [](const HrLoRa::addr_t &addr) -> etl::optional<bridged_device_t> {
+        auto dev_addr = ScanManager::addr_t{};
+        std::ranges::copy(addr, dev_addr.begin());
+        auto dev = scan_manager.get_device(dev_addr);
+        if (!dev) {
+          return etl::nullopt;
         }
-        return dev; },
-      .set_name_map_key = [name_map_key_ptr](HrLoRa::name_map_key_t key) { *name_map_key_ptr = key; },
+        return bridged_device_t{
+            .device = HrLoRa::hr_device::t{.addr = addr, .name = dev->name},
+            .key    = scan_manager.get_key(dev_addr),
+        }; },
+      .get_self_addr    = get_self_addr,
+      .set_name_map_key = [name_map_key_ptr](HrLoRa::name_map_key_t key) {
+        *name_map_key_ptr = key;
+        app_nvs::set_name_map_key(key);
+        // the slot moves with the key
+        slot_ticker.on_sync(); },
       .get_name_map_key = [name_map_key_ptr]() { return *name_map_key_ptr; },
+      .set_device_key   = [](const HrLoRa::addr_t &addr, HrLoRa::name_map_key_t key) {
+        auto dev_addr = ScanManager::addr_t{};
+        std::ranges::copy(addr, dev_addr.begin());
+        if (!scan_manager.set_key(dev_addr, key)) {
+          return false;
+        }
+        save_device_keys();
+        // the device goes in the slot of its key
+        slot_ticker.on_sync();
+        return true; },
+      .get_link_stats = []() {
+        auto stats = radio_task.link_stats();
+        xSemaphoreTake(hr_state.lock, portMAX_DELAY);
+        hr_state.count_dropped(stats);
+        xSemaphoreGive(hr_state.lock);
+        return stats; },
+      .on_gateway_frame = []() {
+        constexpr auto TAG    = "link";
+        const uint32_t now_ms = esp_timer_get_time() / 1000;
+        slot_clock.sync(now_ms);
+        slot_ticker.on_sync();
+        // called in `recv_task`, which has set `current_rx`
+        const auto &q = *current_rx;
+        xSemaphoreTake(link_adapter.lock, portMAX_DELAY);
+        if (link_adapter.adapter.update(q.snr_db, q.rssi_dbm, now_ms)) {
+          const auto &profile = link_adapter.adapter.profile();
+          ESP_LOGI(TAG, "snr=%.1f rssi=%.1f; switch to %s", q.snr_db, q.rssi_dbm, profile.name);
+          radio_task.set_tx_profile(profile);
+        }
+        xSemaphoreGive(link_adapter.lock); },
+      .send_reliable = [](const HrLoRa::addr_t &peer, std::span<const uint8_t> data) {
+        constexpr auto TAG    = "reliable";
+        const uint32_t now_ms = esp_timer_get_time() / 1000;
+        xSemaphoreTake(arq_state.lock, portMAX_DELAY);
+        const auto ok = arq_state.endpoint.submit(peer, data, now_ms);
+        xSemaphoreGive(arq_state.lock);
+        if (!ok) {
+          ESP_LOGW(TAG, "in-flight table is full; drop magic=0x%02x", data[0]);
+        } },
+      .accept_reliable = [](const HrLoRa::addr_t &peer, uint8_t seq) {
+        const uint32_t now_ms = esp_timer_get_time() / 1000;
+        xSemaphoreTake(arq_state.lock, portMAX_DELAY);
+        const auto ok = arq_state.endpoint.accept(peer, seq, now_ms);
+        xSemaphoreGive(arq_state.lock);
+        return ok; },
+      .on_ack = [](const HrLoRa::addr_t &peer, uint8_t seq) {
+        constexpr auto TAG = "reliable";
+        xSemaphoreTake(arq_state.lock, portMAX_DELAY);
+        const auto ok = arq_state.endpoint.on_ack(peer, seq);
+        xSemaphoreGive(arq_state.lock);
+        if (!ok) {
+          ESP_LOGW(TAG, "unexpected ack seq=%d", seq);
+        } },
   };
 #else
-  send_scheduler.send                  = [](uint8_t *data, size_t size) {};
+  send_scheduler.send                  = [](uint8_t *data, size_t size) { return true; };
   static auto handle_message_callbacks = handle_message_callbacks_t{
       .schedule         = [](uint8_t *data, size_t size, std::chrono::milliseconds interval) {},
-      .send             = [](uint8_t *data, size_t size) {},
-      .get_device       = []() { return nullptr; },
-      .set_name_map_key = [name_map_key_ptr](HrLoRa::name_map_key_t key) { *name_map_key_ptr = key; },
+      .get_device       = []() -> etl::optional<HrLoRa::hr_device::t> { return etl::nullopt; },
+      .find_device      = [](const HrLoRa::addr_t &addr) -> etl::optional<bridged_device_t> { return etl::nullopt; },
+      .get_self_addr    = get_self_addr,
+      .set_name_map_key = [name_map_key_ptr](HrLoRa::name_map_key_t key) {
+        *name_map_key_ptr = key;
+        app_nvs::set_name_map_key(key); },
       .get_name_map_key = [name_map_key_ptr]() { return *name_map_key_ptr; },
+      .set_device_key   = [](const HrLoRa::addr_t &addr, HrLoRa::name_map_key_t key) { return false; },
+      .get_link_stats   = []() { return HrLoRa::link_stats::t{}; },
+      .on_gateway_frame = []() { slot_clock.sync(esp_timer_get_time() / 1000); },
+      .send_reliable    = [](const HrLoRa::addr_t &peer, std::span<const uint8_t> data) {},
+      .accept_reliable  = [](const HrLoRa::addr_t &peer, uint8_t seq) { return true; },
+      .on_ack           = [](const HrLoRa::addr_t &peer, uint8_t seq) {},
   };
 #endif
 
 #ifndef DISABLE_LORA
-  auto recv_task = [evt_grp, rf_lock](LLCC68 &rf) {
+  auto recv_task = [](void *) {
     constexpr auto TAG = "recv";
     for (;;) {
-      xEventGroupWaitBits(evt_grp, RecvEvt, pdTRUE, pdFALSE, portMAX_DELAY);
-      uint8_t data[255];
-      const auto size = try_receive(data, std::size(data), rf_lock, send_lk_timeout_tick, rf);
-      if (size == 0) {
+      const auto *slot = radio_task.wait_receive(portMAX_DELAY);
+      if (slot == nullptr) {
         continue;
-      } else {
-        ESP_LOGI(TAG, "data=%s(%d)", utils::toHex(data, size).c_str(), size);
       }
-      handle_message(data, size, handle_message_callbacks);
+      ESP_LOGI(TAG, "data=%s(%d) rssi=%.1f snr=%.1f",
+               utils::toHex(slot->data.data(), slot->size).c_str(), slot->size,
+               slot->rssi_dbm, slot->snr_db);
+      current_rx = slot;
+      handle_message(slot->data.data(), slot->size, handle_message_callbacks);
+      current_rx = nullptr;
+      radio_task.release_receive();
     }
   };
 
-  /**
-   * a helper function to run a function on a new FreeRTOS task
-   */
-  auto run_recv_task = [](void *pvParameter) {
-    const auto param = reinterpret_cast<recv_task_param_t *>(pvParameter);
-    [[likely]] if (param->task != nullptr && param->rf != nullptr) {
-      param->task(*param->rf);
-    } else {
-      ESP_LOGW("recv task", "bad precondition");
-    }
-    auto handle = param->handle;
-    delete param;
-    vTaskDelete(handle);
-  };
-  static auto recv_param = recv_task_param_t{recv_task, &rf, nullptr, evt_grp};
-
-  scan_manager.on_result = [&device_char](std::string device_name, const uint8_t *addr) {
-    uint8_t buf[32]                 = {0};
-    constexpr auto TAG              = "on_result";
-    auto ostream                    = pb_ostream_from_buffer(buf, sizeof(buf));
-    ::bluetooth_device_pb device_pb = bluetooth_device_pb_init_zero;
-    device_pb.mac.funcs.encode      = [](pb_ostream_t *stream, const pb_field_t *field, void *const *arg) {
-      const auto addr_ptr = reinterpret_cast<const uint8_t *>(*arg);
-      if (!pb_encode_tag_for_field(stream, field)) {
-        return false;
-      }
-      return pb_encode_string(stream, addr_ptr, white_list::BLE_MAC_ADDR_SIZE);
-    };
-    device_pb.mac.arg           = const_cast<uint8_t *>(addr);
-    const auto target_name_size = sizeof(device_pb.name) - 1;
-    if (device_name.size() > target_name_size) {
-      device_name.resize(target_name_size);
-      ESP_LOGW(TAG, "Truncated device name to %s", device_name.c_str());
-    }
-    std::memcpy(device_pb.name, device_name.c_str(), device_name.size());
-    auto ok = pb_encode(&ostream, bluetooth_device_pb_fields, &device_pb);
-    if (!ok) {
-      ESP_LOGE(TAG, "Failed to encode the device");
-      return;
-    }
-    auto sz = ostream.bytes_written;
-    device_char.setValue(buf, sz);
+  static_assert(sizeof(bluetooth_device_pb::name) - 1 >= common::SEEN_NAME_SIZE);
+  // a `scan_result_pb` of the devices which are new or have changed, see `ScanManager::seen`
+  static auto scan_result_batch = ScanResultBatch{};
+  scan_result_batch.get_mtu     = []() { return server_cb.mtu(); };
+  scan_result_batch.send        = [&device_char](std::span<const uint8_t> data) {
+    device_char.setValue(data.data(), data.size());
     device_char.notify();
   };
+  scan_result_batch.init(SCAN_RESULT_FLUSH_INTERVAL.count());
+  scan_manager.on_result = [](std::string_view device_name, const uint8_t *addr) {
+    scan_result_batch.add(device_name, addr);
+  };
 #endif
 
-  static uint32_t on_data_counter = 0;
-  scan_manager.on_data            = [&hr_char, name_map_key_ptr, rf_lock](HeartMonitor &device, uint8_t *data, size_t size) {
-    const auto TAG = "scan_manager";
+  scan_manager.on_data = [&hr_char](const ScanManager::addr_t &dev_addr, uint8_t *data, size_t size) {
+    const auto TAG   = "scan_manager";
+    auto measurement = hr_measurement::t{};
     // ESP_LOGI(TAG, "data: %s", utils::toHex(data, size).c_str());
-    // https://community.home-assistant.io/t/ble-heartrate-monitor/300354/43
-    // 3.103 Heart Rate Measurement of GATT Specification Supplement
-    // first byte is a struct of some flags
-    // if bit 0 of the first byte is 0, it's uint8
-    if (size < 2) {
+    if (!hr_measurement::parse(std::span<const uint8_t>{data, size}, measurement)) {
       ESP_LOGW(TAG, "bad data size: %d", size);
       return;
     }
-    int hr;
-    if ((data[0] & 0b1) == 0) {
-      hr = data[1];
-    } else {
-      // if bit 0 of the first byte is 1, it's uint16 and it's little endian
-      hr = ::le16dec(data + 1);
+    if (measurement.contact == hr_measurement::sensor_contact::not_detected) {
+      ESP_LOGW(TAG, "no sensor contact; skip;");
+      return;
     }
+    int hr = measurement.hr;
     if (hr > 255) {
       ESP_LOGW(TAG, "hr overflow; cap to 255;");
       hr = 255;
     }
 
-    uint8_t buf[48] = {0};
-
-    size_t sz;
     if (hr <= 0) {
       ESP_LOGW(TAG, "hr=%d; skip;", hr);
       return;
     } else {
-      ESP_LOGI(TAG, "hr=%d", hr);
+      ESP_LOGI(TAG, "hr=%d; rr=%d", hr, measurement.rr_count);
     }
 
-    if (on_data_counter % common::INTERVAL_SEND_NAMED_HR_COUNT == 0) {
-      auto named_hr_data = HrLoRa::named_hr_data::t{
-                     .key = *name_map_key_ptr,
-                     .hr  = static_cast<uint8_t>(hr),
-      };
-      std::ranges::copy(device.addr, named_hr_data.addr.begin());
-      sz = HrLoRa::named_hr_data::marshal(named_hr_data, buf, sizeof(buf));
-      if (sz == 0) {
-        ESP_LOGE(TAG, "failed to marshal named_hr_data");
-        return;
-      }
-    } else {
-      const auto hr_data = HrLoRa::hr_data::t{
-                     .key = *name_map_key_ptr,
-                     .hr  = static_cast<uint8_t>(hr),
-      };
-      sz = HrLoRa::hr_data::marshal(hr_data, buf, sizeof(buf));
-      if (sz == 0) {
-        ESP_LOGE(TAG, "failed to marshal hr_data");
-        return;
-      }
+    // for LoRa the samples are sent in the slot of its key (see `on_slot`)
+    const uint32_t now_ms = esp_timer_get_time() / 1000;
+    auto addr = HrLoRa::addr_t{};
+    std::ranges::copy(dev_addr, addr.begin());
+    if (xSemaphoreTake(hr_state.lock, portMAX_DELAY) == pdTRUE) {
+      auto &dev = hr_state.of(addr, now_ms);
+      dev.hr_accumulator.push(static_cast<uint8_t>(hr), now_ms);
+      dev.rr_accumulator.push(measurement.rr_intervals(), now_ms);
+      // beyond `hr_measurement::MAX_RR_COUNT` of a notification
+      hr_state.rr_dropped += measurement.rr_dropped;
+      dev.latest     = static_cast<uint8_t>(hr);
+      dev.updated_ms = now_ms;
+      xSemaphoreGive(hr_state.lock);
     }
 
-    on_data_counter += 1;
-
-#ifndef DISABLE_LORA
-    rf.standby();
-    // for LoRa we encode the data as `HrLoRa::hr_data`
-    try_transmit(buf, sz, rf_lock, send_lk_timeout_tick, rf);
-#else
-    auto a = rf_lock;
-#endif
     // for Bluetooth LE character we just repeat the data
     hr_char.setValue(data, size);
     hr_char.notify();
   };
 
+#ifndef DISABLE_LORA
+  slot_ticker.on_slot = [name_map_key_ptr, &link_stats_char](uint16_t slot) {
+    constexpr auto TAG    = "on_slot";
+    const uint32_t now_ms = esp_timer_get_time() / 1000;
+    const auto key        = *name_map_key_ptr;
+    const auto superframe = slot_clock.superframe_index(now_ms + slot_clock.slot_ms() / 2);
+    const bool named_turn = superframe % common::INTERVAL_SEND_NAMED_HR_SUPERFRAMES == 0;
+    // control frames go first in the slot of this repeater, as many as it has
+    // room for; the rest stay due for the next one
+    xSemaphoreTake(arq_state.lock, portMAX_DELAY);
+    if (slot_clock.slot_of(key) == slot) {
+      const auto freq_mhz = uplink_freq_mhz(key);
+      arq_state.endpoint.poll(now_ms, [freq_mhz](std::span<const uint8_t> frame) {
+        if (!fits_in_slot(frame.size())) {
+          return false;
+        }
+        radio_task.send(frame, airtime::traffic_class::control, freq_mhz);
+        return true;
+      });
+    }
+    const auto arq_st = arq_state.endpoint.stats();
+    xSemaphoreGive(arq_state.lock);
+
+    // named_hr_data, hr_batch and hr_rr of the devices, as planned
+    uint8_t bufs[common::LORA_FRAMES_PER_SLOT][128]          = {{0}};
+    size_t sizes[common::LORA_FRAMES_PER_SLOT]               = {0};
+    airtime::traffic_class cls[common::LORA_FRAMES_PER_SLOT] = {};
+    float freqs[common::LORA_FRAMES_PER_SLOT]                = {0};
+    size_t n_frames                                          = 0;
+    if (xSemaphoreTake(hr_state.lock, portMAX_DELAY) != pdTRUE) {
+      return;
+    }
+    // each device goes in the slot of its key, and the devices of a slot share
+    // its frames (see `slot_plan`); the ones left out keep accumulating and go
+    // first in the next slot
+    auto &devices = hr_state.devices;
+    const auto n  = devices.size();
+    etl::optional<HrLoRa::name_map_key_t> keys[common::MAX_BRIDGED_DEVICES] = {};
+    slot_plan::demand_t demands[common::MAX_BRIDGED_DEVICES]               = {};
+    for (size_t i = 0; i < n; ++i) {
+      const auto &dev = devices[i];
+      keys[i]         = key_of(dev);
+      // without a key, in the slot of this repeater
+      if (slot_clock.slot_of(keys[i].value_or(key)) != slot) {
+        continue;
+      }
+      demands[i] = slot_plan::demand_t{
+          .has_key = keys[i].has_value(),
+          .named   = dev.latest && (named_turn || !keys[i]),
+          .batch   = !dev.hr_accumulator.empty(),
+          .rr      = !dev.rr_accumulator.empty(),
+      };
+    }
+    const auto plan = slot_plan::plan<common::LORA_FRAMES_PER_SLOT>(std::span<const slot_plan::demand_t>{demands, n},
+                                                                    hr_state.cursor, common::LORA_FRAMES_PER_SLOT);
+    // a frame is built from a copy of what it takes, which is only given up
+    // if the frame fits in the airtime left
+    for (; n_frames < plan.size; ++n_frames) {
+      const auto &f = plan.frames[n_frames];
+      auto &dev     = devices[f.device];
+      auto &buf     = bufs[n_frames];
+      auto hr_acc   = dev.hr_accumulator;
+      auto rr_acc   = dev.rr_accumulator;
+      auto latest   = dev.latest;
+      // on the channel of its key, like a repeater of its own
+      const auto dev_key = keys[f.device].value_or(key);
+      freqs[n_frames]    = uplink_freq_mhz(dev_key);
+      switch (f.what) {
+        case slot_plan::kind::named: {
+          auto named_hr_data = HrLoRa::named_hr_data::t{
+              .key  = dev_key,
+              .hr   = *latest,
+              .addr = dev.addr,
+          };
+          sizes[n_frames] = HrLoRa::named_hr_data::marshal(named_hr_data, buf, sizeof(buf));
+          cls[n_frames]   = airtime::traffic_class::named;
+          latest          = etl::nullopt;
+          break;
+        }
+        case slot_plan::kind::batch: {
+          const auto batch = hr_acc.take(dev_key, now_ms);
+          sizes[n_frames]  = HrLoRa::hr_batch::marshal(batch, buf, sizeof(buf));
+          cls[n_frames]    = airtime::traffic_class::bulk;
+          break;
+        }
+        case slot_plan::kind::rr: {
+          const auto rr   = rr_acc.take(dev_key);
+          sizes[n_frames] = HrLoRa::hr_rr::marshal(rr, buf, sizeof(buf));
+          cls[n_frames]   = airtime::traffic_class::bulk;
+          break;
+        }
+      }
+      if (!fits_in_slot(sizes[n_frames])) {
+        break;
+      }
+      dev.hr_accumulator = std::move(hr_acc);
+      dev.rr_accumulator = std::move(rr_acc);
+      dev.latest         = latest;
+    }
+    hr_state.cursor = plan.cursor_after(n_frames);
+    xSemaphoreGive(hr_state.lock);
+
+    for (size_t i = 0; i < n_frames; ++i) {
+      if (sizes[i] != 0) {
+        radio_task.send(bufs[i], sizes[i], cls[i], freqs[i]);
+      } else {
+        ESP_LOGE(TAG, "failed to marshal frame %zu", i);
+      }
+    }
+    xSemaphoreTake(link_adapter.lock, portMAX_DELAY);
+    if (link_adapter.adapter.check_silence(now_ms)) {
+      ESP_LOGW(TAG, "gateway is silent; fall back to %s", link_adapter.adapter.profile().name);
+      radio_task.set_tx_profile(link_adapter.adapter.profile());
+    }
+    xSemaphoreGive(link_adapter.lock);
+    const auto st = radio_task.stats();
+    ESP_LOGI(TAG, "radio depth=%d dropped=%lu tx=%lu/%lu rx=%lu/%lu latency=%lu/%lums busy=%lu/%lu",
+             st.queue_depth, st.dropped,
+             st.tx_done, st.tx_failed, st.rx_done, st.rx_failed,
+             st.last_tx_latency_ms, st.max_tx_latency_ms,
+             st.channel_busy, st.lbt_dropped);
+    ESP_LOGI(TAG, "airtime %lu/%luus total=%lums duty dropped=%lu/%lu/%lu",
+             st.airtime_used_us, st.airtime_budget_us, st.airtime_total_ms,
+             st.duty_dropped[0], st.duty_dropped[1], st.duty_dropped[2]);
+    ESP_LOGI(TAG, "crc_err=%lu header_err=%lu tx_timeout=%lu",
+             st.crc_err, st.header_err, st.tx_timeout);
+    ESP_LOGI(TAG, "dio1 wakeups=%lu latency=%lu/%lu/%luus (last/avg/max)",
+             st.dio1_wakeups, st.last_dio1_latency_us, st.avg_dio1_latency_us, st.max_dio1_latency_us);
+    constexpr const char *spi_op_names[radio::SPI_OP_COUNT] = {"transmit", "receive", "listen", "cad"};
+    for (size_t i = 0; i < radio::SPI_OP_COUNT; ++i) {
+      const auto &op = st.spi[i];
+      if (op.ops == 0) {
+        continue;
+      }
+      ESP_LOGI(TAG, "spi %s ops=%lu transactions=%lu spi=%luus wall=%luus (avg %lu/%luus)",
+               spi_op_names[i], op.ops, op.transactions, op.spi_us, op.wall_us,
+               op.spi_us / op.ops, op.wall_us / op.ops);
+    }
+    ESP_LOGI(TAG, "reliable submitted=%lu acked=%lu retransmitted=%lu given_up=%lu",
+             arq_st.submitted, arq_st.acked, arq_st.retransmitted, arq_st.given_up);
+    // with the samples dropped, as in `repeater_status`
+    const auto link  = handle_message_callbacks.get_link_stats();
+    uint8_t buf[128] = {0};
+    const auto sz    = HrLoRa::link_stats::marshal(link, buf);
+    if (sz == 0) {
+      ESP_LOGE(TAG, "failed to marshal link_stats");
+      return;
+    }
+    link_stats_char.setValue(buf, sz);
+    link_stats_char.notify();
+  };
+#endif
+
   /**
    * the server should be started before scanning and advertising
    */
@@ -553,13 +836,32 @@ void app_main() {
   server.start();
   NimBLEDevice::startAdvertising();
 
-  if (has_addr) {
-    scan_manager.set_target_addr(etl::make_optional(addr));
+  if (whitelist_len != 0 || name_pattern_len != 0) {
+    scan_manager.restore_targets(std::span<const uint8_t>{whitelist_blob.data(), whitelist_len},
+                                 std::span<const uint8_t>{name_pattern_blob.data(), name_pattern_len});
+    auto key_blob  = std::array<uint8_t, blue::DEVICE_KEY_BLOB_SIZE>{};
+    size_t key_len = 0;
+    if (app_nvs::get_device_keys(key_blob, &key_len) == ESP_OK) {
+      scan_manager.restore_keys(std::span<const uint8_t>{key_blob.data(), key_len});
+    }
   }
 
   scan_manager.start_scanning_task();
 #ifndef DISABLE_LORA
-  xTaskCreate(run_recv_task, "recv_task", 4096, &recv_param, 0, &recv_param.handle);
+  radio_task.start();
+  xTaskCreate(recv_task, "recv_task", 4096, nullptr, 1, nullptr);
+  slot_ticker.start(slot_clock, []() {
+    auto slots = tdma::SlotSet{};
+    slots.add(slot_clock.slot_of(name_map_key));
+    xSemaphoreTake(hr_state.lock, portMAX_DELAY);
+    for (const auto &dev : hr_state.devices) {
+      if (const auto key = key_of(dev)) {
+        slots.add(slot_clock.slot_of(*key));
+      }
+    }
+    xSemaphoreGive(hr_state.lock);
+    return slots;
+  });
 #endif
   vTaskDelete(nullptr);
 }
@@ -38,6 +38,117 @@ esp_err_t set_addr(const addr_t &addr) {
   }
   return ESP_OK;
 }
+
+namespace {
+  /**
+   * @brief read the blob of `key` into `buffer`
+   */
+  esp_err_t get_blob(const char *TAG, const char *key, std::span<uint8_t> buffer, size_t *size_ptr) {
+    esp_err_t err = ESP_OK;
+    auto handle   = nvs::open_nvs_handle(common::PREF_PARTITION_LABEL, NVS_READONLY, &err);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "failed to open nvs handle, reason %s (%d)", esp_err_to_name(err), err);
+      return err;
+    }
+    size_t size = 0;
+    err         = handle->get_item_size(nvs::ItemType::BLOB, key, size);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "failed to get blob size from nvs, reason %s (%d)", esp_err_to_name(err), err);
+      return err;
+    }
+    if (size > buffer.size()) {
+      ESP_LOGE(TAG, "blob too large (%zu > %zu)", size, buffer.size());
+      return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    err = handle->get_blob(key, buffer.data(), size);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "failed to get blob from nvs, reason %s (%d)", esp_err_to_name(err), err);
+      return err;
+    }
+    *size_ptr = size;
+    return ESP_OK;
+  }
+
+  /**
+   * @brief write `blob` to `key`, or erase `key` if `blob` is empty
+   * @note `handle` is committed by the caller
+   */
+  esp_err_t set_blob(const char *TAG, nvs::NVSHandle &handle, const char *key, std::span<const uint8_t> blob) {
+    esp_err_t err = ESP_OK;
+    if (blob.empty()) {
+      err = handle.erase_item(key);
+      if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+      }
+    } else {
+      err = handle.set_blob(key, blob.data(), blob.size());
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "failed to set blob from nvs, reason %s (%d)", esp_err_to_name(err), err);
+    }
+    return err;
+  }
+}
+
+esp_err_t get_whitelist(std::span<uint8_t> buffer, size_t *size_ptr) {
+  return get_blob("whitelist::get", common::PREF_WHITELIST_BLOB_KEY, buffer, size_ptr);
+}
+
+esp_err_t set_whitelist(std::span<const uint8_t> blob) {
+  const auto TAG = "whitelist::set";
+  esp_err_t err  = ESP_OK;
+  auto handle    = nvs::open_nvs_handle(common::PREF_PARTITION_LABEL, NVS_READWRITE, &err);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "failed to open nvs handle, reason %s (%d)", esp_err_to_name(err), err);
+    return err;
+  }
+  err = set_blob(TAG, *handle, common::PREF_WHITELIST_BLOB_KEY, blob);
+  if (err != ESP_OK) {
+    return err;
+  }
+  // supersedes the single address, which shouldn't come back after the whitelist is cleared
+  handle->erase_item(common::PREF_ADDR_BLOB_KEY);
+  return handle->commit();
+}
+
+esp_err_t get_name_patterns(std::span<uint8_t> buffer, size_t *size_ptr) {
+  return get_blob("name_patterns::get", common::PREF_NAME_PATTERN_BLOB_KEY, buffer, size_ptr);
+}
+
+esp_err_t set_name_patterns(std::span<const uint8_t> blob) {
+  const auto TAG = "name_patterns::set";
+  esp_err_t err  = ESP_OK;
+  auto handle    = nvs::open_nvs_handle(common::PREF_PARTITION_LABEL, NVS_READWRITE, &err);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "failed to open nvs handle, reason %s (%d)", esp_err_to_name(err), err);
+    return err;
+  }
+  err = set_blob(TAG, *handle, common::PREF_NAME_PATTERN_BLOB_KEY, blob);
+  if (err != ESP_OK) {
+    return err;
+  }
+  return handle->commit();
+}
+
+esp_err_t get_device_keys(std::span<uint8_t> buffer, size_t *size_ptr) {
+  return get_blob("device_keys::get", common::PREF_DEVICE_KEY_BLOB_KEY, buffer, size_ptr);
+}
+
+esp_err_t set_device_keys(std::span<const uint8_t> blob) {
+  const auto TAG = "device_keys::set";
+  esp_err_t err  = ESP_OK;
+  auto handle    = nvs::open_nvs_handle(common::PREF_PARTITION_LABEL, NVS_READWRITE, &err);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "failed to open nvs handle, reason %s (%d)", esp_err_to_name(err), err);
+    return err;
+  }
+  err = set_blob(TAG, *handle, common::PREF_DEVICE_KEY_BLOB_KEY, blob);
+  if (err != ESP_OK) {
+    return err;
+  }
+  return handle->commit();
+}
+
 esp_err_t nvs_init() {
   auto TAG = "nvs init";
   if (is_nvs_init) {
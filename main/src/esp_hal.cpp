@@ -2,6 +2,27 @@
 // Created by Kurosu Chan on 2023/10/19.
 //
 #include "esp_hal.h"
+
+void IRAM_ATTR ESPHal::call_without_arg(void *arg) {
+  reinterpret_cast<void (*)()>(arg)();
+}
+
+esp_err_t ESPHal::install_isr_service() {
+  constexpr auto TAG    = "ESPHal::install_isr_service";
+  static bool installed = false;
+  if (installed) {
+    return ESP_OK;
+  }
+  auto ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+  // ESP_ERR_INVALID_STATE: installed by someone else
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "%s", esp_err_to_name(ret));
+    return ret;
+  }
+  installed = true;
+  return ESP_OK;
+}
+
 uint32_t spiFrequencyToClockDiv(uint32_t freq) {
   uint32_t apb_freq = getApbFrequency();
   if (freq >= apb_freq) {
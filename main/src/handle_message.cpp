@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <esp_log.h>
+#include "handle_message.h"
+#include "utils.h"
+
+void handle_message(const uint8_t *data, size_t size, const handle_message_callbacks_t &callbacks,
+                    const HrLoRa::addr_t *reply_to) {
+  const auto TAG         = "recv";
+  const bool is_cb_empty = callbacks.schedule == nullptr ||
+                           callbacks.get_device == nullptr ||
+                           callbacks.find_device == nullptr ||
+                           callbacks.get_self_addr == nullptr ||
+                           callbacks.set_name_map_key == nullptr ||
+                           callbacks.get_name_map_key == nullptr ||
+                           callbacks.set_device_key == nullptr ||
+                           callbacks.get_link_stats == nullptr ||
+                           callbacks.on_gateway_frame == nullptr ||
+                           callbacks.send_reliable == nullptr ||
+                           callbacks.accept_reliable == nullptr ||
+                           callbacks.on_ack == nullptr;
+  if (is_cb_empty) {
+    ESP_LOGE(TAG, "at least one callback is empty");
+    return;
+  }
+  const auto my_addr = callbacks.get_self_addr();
+  auto is_my_address = [&my_addr](const HrLoRa::addr_t &req_addr) {
+    return req_addr == HrLoRa::broadcast_addr || req_addr == my_addr;
+  };
+  /**
+   * @brief marshal the status of this repeater into `buf`, or of one of its
+   *        devices with the key of that device if `bridged` is given
+   * @return the size of the marshalled data, 0 if failed
+   */
+  auto marshal_device_status = [&callbacks, &my_addr](std::span<uint8_t> buf,
+                                                      const etl::optional<bridged_device_t> &bridged = etl::nullopt) -> size_t {
+    constexpr auto TAG = "device status";
+    auto status        = HrLoRa::repeater_status::view{
+               .repeater_addr = my_addr,
+               .key           = callbacks.get_name_map_key(),
+    };
+    // the view borrows the name from `device`, which should outlive the marshalling
+    const auto device = bridged ? etl::optional<HrLoRa::hr_device::t>{bridged->device} : callbacks.get_device();
+    if (device) {
+      status.device = HrLoRa::hr_device::to_view(*device);
+    } else {
+      status.device = etl::nullopt;
+    }
+    if (bridged && bridged->key) {
+      status.key = *bridged->key;
+    }
+    status.link = callbacks.get_link_stats();
+    ESP_LOGI(TAG, "status=%s", HrLoRa::repeater_status::to_string(status).c_str());
+    if (HrLoRa::repeater_status::size_needed(status) > buf.size()) {
+      // the statistics are nice to have; the device is not
+      ESP_LOGW(TAG, "no room for link stats");
+      status.link = etl::nullopt;
+    }
+    return HrLoRa::repeater_status::marshal(status, buf);
+  };
+  /**
+   * @brief the response goes out in the slot of this repeater, reliably if the request is
+   */
+  auto respond = [&callbacks, reply_to](uint8_t *buf, size_t sz) {
+    if (reply_to != nullptr) {
+      callbacks.send_reliable(*reply_to, std::span<const uint8_t>{buf, sz});
+    } else {
+      callbacks.schedule(buf, sz, 0);
+    }
+  };
+  // leaves room for the envelope of `HrLoRa::reliable`
+  constexpr size_t max_response_size = HANDLE_MESSAGE_MAX_FRAME_SIZE - HrLoRa::reliable::header_size;
+
+  if (size < 1) {
+    ESP_LOGW(TAG, "empty message");
+    return;
+  }
+  const auto frame = std::span<const uint8_t>{data, size};
+  auto handler     = HrLoRa::hr_lora_msg::overloaded{
+      [&](const HrLoRa::query_device_by_mac::view &req) {
+        callbacks.on_gateway_frame();
+        // a device of this repeater answers for itself
+        const auto bridged = is_my_address(req.addr) ? etl::nullopt : callbacks.find_device(req.addr);
+        if (!is_my_address(req.addr) && !bridged) {
+          ESP_LOGI(TAG, "%s is not for me", utils::toHex(req.addr.data(), req.addr.size()).c_str());
+          return;
+        }
+        uint8_t buf[max_response_size] = {0};
+        auto sz                        = marshal_device_status(buf, bridged);
+        if (sz == 0) {
+          ESP_LOGE(TAG, "failed to marshal query_device_by_mac_response");
+          return;
+        }
+        respond(buf, sz);
+      },
+      [&](const HrLoRa::set_name_map_key::view &req) {
+        callbacks.on_gateway_frame();
+        auto bridged = etl::optional<bridged_device_t>{};
+        if (callbacks.set_device_key(req.addr, req.key)) {
+          ESP_LOGI(TAG, "set name map key of %s to %d", utils::toHex(req.addr.data(), req.addr.size()).c_str(), req.key);
+          // the device might have just disconnected; its key is set all the same
+          bridged = callbacks.find_device(req.addr);
+          if (!bridged) {
+            bridged = bridged_device_t{.device = HrLoRa::hr_device::t{.addr = req.addr}, .key = req.key};
+          }
+        } else if (is_my_address(req.addr)) {
+          callbacks.set_name_map_key(req.key);
+          ESP_LOGI(TAG, "set name map key to %d", req.key);
+        } else {
+          // the key of another repeater, which would move this one into its slot
+          ESP_LOGI(TAG, "%s is not for me", utils::toHex(req.addr.data(), req.addr.size()).c_str());
+          return;
+        }
+        // send the new status back after setting the name map key
+        uint8_t buf[max_response_size] = {0};
+        auto sz                        = marshal_device_status(buf, bridged);
+        if (sz == 0) {
+          ESP_LOGE(TAG, "failed to marshal repeater_status");
+          return;
+        }
+        respond(buf, sz);
+      },
+      [&](const HrLoRa::reliable::view &req) {
+        if (!is_my_address(req.dst)) {
+          return;
+        }
+        auto ack = HrLoRa::ack::t{.src = my_addr, .dst = req.src, .seq = req.seq};
+        uint8_t buf[HrLoRa::ack::size_needed()] = {0};
+        const auto sz                           = HrLoRa::ack::marshal(ack, buf);
+        // acked even if it's a duplicate, since the last ack might be lost.
+        // Acks are never coalesced in the send queue, so the ones of frames
+        // received back to back all go out
+        callbacks.schedule(buf, sz, 0);
+        if (!callbacks.accept_reliable(req.src, req.seq)) {
+          ESP_LOGI(TAG, "duplicated seq=%d", req.seq);
+          return;
+        }
+        if (!req.payload.empty() && req.payload[0] == HrLoRa::reliable::magic) {
+          ESP_LOGW(TAG, "nested reliable frame");
+          return;
+        }
+        handle_message(req.payload.data(), req.payload.size(), callbacks, &req.src);
+      },
+      [&](const HrLoRa::ack::view &req) {
+        if (!is_my_address(req.dst)) {
+          return;
+        }
+        callbacks.on_ack(req.src, req.seq);
+      },
+      [](const auto &) {
+        // from other repeater. do nothing.
+      },
+  };
+
+  const auto res = HrLoRa::hr_lora_msg::modules::dispatch(frame, handler);
+  switch (res) {
+    case HrLoRa::dispatch_result::ok:
+      break;
+    case HrLoRa::dispatch_result::unknown_magic:
+      ESP_LOGW(TAG, "unknown magic: 0x%02x", frame[0]);
+      break;
+    case HrLoRa::dispatch_result::bad_frame:
+      ESP_LOGE(TAG, "failed to unmarshal message with magic 0x%02x", frame[0]);
+      break;
+  }
+}
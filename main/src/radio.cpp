@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_random.h>
+#include "radio.h"
+
+namespace radio {
+static uint32_t now_ms() {
+  return esp_timer_get_time() / 1000;
+}
+
+RadioTask::SpiProbe::SpiProbe(RadioTask &self, spi_op op)
+    : self(self), op(op), start(self.hal.spi_stats()), start_us(esp_timer_get_time()) {}
+
+RadioTask::SpiProbe::~SpiProbe() {
+  const auto end = self.hal.spi_stats();
+  auto &s        = self._stats.spi[static_cast<size_t>(op)];
+  s.ops += 1;
+  s.transactions += end.transactions - start.transactions;
+  s.spi_us += end.busy_us - start.busy_us;
+  s.wall_us += static_cast<uint32_t>(esp_timer_get_time() - start_us);
+}
+
+void IRAM_ATTR RadioTask::on_dio1(void *arg) {
+  auto &self      = *static_cast<RadioTask *>(arg);
+  self.dio1_at_us = static_cast<uint32_t>(esp_timer_get_time());
+  if (self.task_handle == nullptr) {
+    return;
+  }
+  // https://www.freertos.org/xTaskNotifyFromISR.html
+  BaseType_t task_woken = pdFALSE;
+  xTaskNotifyFromISR(self.task_handle, Dio1Evt, eSetBits, &task_woken);
+  portYIELD_FROM_ISR(task_woken);
+}
+
+void RadioTask::record_dio1_latency() {
+  // modular, so it holds across the wrap of the low word (every ~71 minutes)
+  const auto latency = static_cast<uint32_t>(esp_timer_get_time()) - dio1_at_us;
+  _stats.dio1_wakeups += 1;
+  _stats.last_dio1_latency_us = latency;
+  _stats.max_dio1_latency_us  = std::max(_stats.max_dio1_latency_us, latency);
+  total_dio1_latency_us += latency;
+  _stats.avg_dio1_latency_us = static_cast<uint32_t>(total_dio1_latency_us / _stats.dio1_wakeups);
+}
+
+void RadioTask::start(uint32_t stack_size, UBaseType_t priority) {
+  constexpr auto TAG = "RadioTask";
+  if (task_handle != nullptr) {
+    ESP_LOGW(TAG, "already started");
+    return;
+  }
+  queue  = xQueueCreateStatic(QUEUE_LENGTH, sizeof(frame_t), queue_storage, &queue_buf);
+  rx_sem = xSemaphoreCreateCountingStatic(RX_SLOTS, 0, &rx_sem_buf);
+  // DIO1 is raised on both RX done and TX done; the task is notified
+  // directly from the ISR, with this as the context
+  hal.attach_interrupt(dio1_pin, on_dio1, this, RISING);
+  rf.standby();
+  xTaskCreate(run, "radio", stack_size, this, priority, &task_handle);
+}
+
+bool RadioTask::send(std::span<const uint8_t> data, airtime::traffic_class cls, float freq_mhz) {
+  constexpr auto TAG = "RadioTask::send";
+  if (task_handle == nullptr) {
+    ESP_LOGE(TAG, "not started");
+    return false;
+  }
+  if (data.empty() || data.size() > MAX_FRAME_SIZE) {
+    ESP_LOGE(TAG, "bad frame size %d", data.size());
+    _dropped += 1;
+    return false;
+  }
+  frame_t frame;
+  frame.cls       = cls;
+  frame.freq_mhz  = freq_mhz;
+  frame.size      = static_cast<uint8_t>(data.size());
+  frame.queued_ms = now_ms();
+  std::copy(data.begin(), data.end(), frame.data);
+  if (xQueueSend(queue, &frame, 0) != pdTRUE) {
+    ESP_LOGW(TAG, "queue is full; drop magic=0x%02x", data[0]);
+    _dropped += 1;
+    return false;
+  }
+  xTaskNotify(task_handle, TxEvt, eSetBits);
+  return true;
+}
+
+void RadioTask::publish_stats() {
+  portENTER_CRITICAL(&stats_lock);
+  published = _stats;
+  portEXIT_CRITICAL(&stats_lock);
+}
+
+stats_t RadioTask::stats() const {
+  portENTER_CRITICAL(&stats_lock);
+  auto s = published;
+  portEXIT_CRITICAL(&stats_lock);
+  s.queue_depth = queue == nullptr ? 0 : uxQueueMessagesWaiting(queue);
+  s.dropped     = _dropped;
+  s.rx_overrun  = rx.overrun();
+  return s;
+}
+
+HrLoRa::link_stats::t RadioTask::link_stats() const {
+  portENTER_CRITICAL(&stats_lock);
+  const auto s = published;
+  portEXIT_CRITICAL(&stats_lock);
+  auto data = HrLoRa::link_stats::t{
+      .rx_ok      = s.rx_done,
+      .crc_err    = s.crc_err,
+      .header_err = s.header_err,
+      .rx_overrun = rx.overrun(),
+      .tx_ok      = s.tx_done,
+      .tx_timeout = s.tx_timeout,
+      .tx_failed  = s.tx_failed,
+  };
+  quality.fill(data);
+  return data;
+}
+
+void RadioTask::run(void *pvParameter) {
+  auto &self = *static_cast<RadioTask *>(pvParameter);
+  // `xTaskCreate` might not have returned yet, when the task runs at a higher priority
+  self.task_handle = xTaskGetCurrentTaskHandle();
+  self.loop();
+}
+
+void RadioTask::receive(uint16_t irq_flags) {
+  constexpr auto TAG = "RadioTask::receive";
+  const auto probe   = SpiProbe{*this, spi_op::receive};
+  auto *slot         = rx.acquire();
+  const bool overrun = slot == nullptr;
+  if (overrun) {
+    // still read it out, or the radio won't be cleared
+    slot = &rx_scratch;
+  }
+  const auto length = rf.getPacketLength(true);
+  if (length > slot->data.size()) {
+    ESP_LOGE(TAG, "packet length %d > %d max buffer size", length, slot->data.size());
+    _stats.rx_failed += 1;
+    return;
+  }
+  const auto err = rf.readData(slot->data.data(), length);
+  if (LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG && esp_log_level_get(TAG) >= ESP_LOG_DEBUG) {
+    char flags[6];
+    irq::to_chars(irq_flags, flags);
+    ESP_LOGD(TAG, "flag=%s", flags);
+  }
+  if (err == RADIOLIB_ERR_CRC_MISMATCH) {
+    ESP_LOGW(TAG, "crc error");
+    _stats.crc_err += 1;
+    return;
+  }
+  if (err != RADIOLIB_ERR_NONE) {
+    ESP_LOGE(TAG, "failed to read data, code %d", err);
+    _stats.rx_failed += 1;
+    return;
+  }
+  if (overrun) {
+    ESP_LOGW(TAG, "rx ring is full; drop");
+    return;
+  }
+  slot->timestamp_ms = now_ms();
+  slot->irq_flags    = irq_flags;
+  slot->size         = length;
+  slot->rssi_dbm     = rf.getRSSI();
+  slot->snr_db       = rf.getSNR();
+  quality.add(slot->rssi_dbm, slot->snr_db);
+  _stats.rx_done += 1;
+  rx.commit();
+  xSemaphoreGive(rx_sem);
+}
+
+const RadioTask::rx_slot_t *RadioTask::wait_receive(TickType_t timeout) {
+  if (rx_sem == nullptr || xSemaphoreTake(rx_sem, timeout) != pdTRUE) {
+    return nullptr;
+  }
+  return rx.front();
+}
+
+void RadioTask::apply(const radio_profile::profile_t &profile) {
+  constexpr auto TAG = "RadioTask::apply";
+  if (profile == applied) {
+    return;
+  }
+  // only touch what differs; each setter is a few SPI transactions
+  if (profile.sf != applied.sf) {
+    rf.setSpreadingFactor(profile.sf);
+  }
+  if (profile.bw_khz != applied.bw_khz) {
+    rf.setBandwidth(profile.bw_khz);
+  }
+  if (profile.cr != applied.cr) {
+    rf.setCodingRate(profile.cr);
+  }
+  if (profile.power_dbm != applied.power_dbm) {
+    rf.setOutputPower(profile.power_dbm);
+  }
+  if (profile.preamble_len != applied.preamble_len) {
+    rf.setPreambleLength(profile.preamble_len);
+  }
+  if (profile.freq_mhz != applied.freq_mhz) {
+    rf.setFrequency(profile.freq_mhz);
+  }
+  ESP_LOGD(TAG, "%s", profile.name);
+  applied = profile;
+}
+
+radio_profile::profile_t RadioTask::profile_of(const frame_t &frame) const {
+  auto profile = *tx_profile.load();
+  if (frame.freq_mhz != 0) {
+    profile.freq_mhz = frame.freq_mhz;
+  }
+  return profile;
+}
+
+bool RadioTask::start_transmit(const frame_t &frame) {
+  constexpr auto TAG = "RadioTask::transmit";
+  const auto profile = profile_of(frame);
+  const auto toa     = radio_profile::time_on_air_us(profile, frame.size);
+  const auto now     = now_ms();
+  if (!ledger.admit(frame.cls, toa, now)) {
+    ESP_LOGW(TAG, "airtime budget exceeded; drop magic=0x%02x", frame.data[0]);
+    _stats.duty_dropped[static_cast<size_t>(frame.cls)] += 1;
+    // CAD might have left the radio in standby
+    start_receive();
+    return false;
+  }
+  const auto probe = SpiProbe{*this, spi_op::transmit};
+  rf.standby();
+  apply(profile);
+  const auto err = rf.startTransmit(frame.data, frame.size);
+  if (err != RADIOLIB_ERR_NONE) {
+    ESP_LOGE(TAG, "failed to start transmitting, code %d", err);
+    _stats.tx_failed += 1;
+    start_receive();
+    return false;
+  }
+  // recorded at start; a frame that times out still occupied the channel
+  ledger.record(toa, now);
+  _stats.airtime_used_us   = ledger.used_us(now);
+  _stats.airtime_budget_us = ledger.budget_us();
+  _stats.airtime_total_ms  = static_cast<uint32_t>(ledger.total() / 1000);
+  return true;
+}
+
+void RadioTask::start_receive() {
+  constexpr auto TAG = "RadioTask::receive";
+  const auto probe   = SpiProbe{*this, spi_op::listen};
+  if (!radio_profile::is_same_modulation(applied, rx_profile)) {
+    rf.standby();
+    // keep the power of the TX profile; it doesn't matter for receiving
+    auto profile      = rx_profile;
+    profile.power_dbm = applied.power_dbm;
+    apply(profile);
+  }
+  // DIO1 is only raised for RX done by default; a header error (which no RX
+  // done follows) would leave the radio stuck until the next frame
+  constexpr uint16_t irq_mask = RADIOLIB_SX126X_IRQ_RX_DONE | RADIOLIB_SX126X_IRQ_HEADER_ERR;
+  if (!sniff.enabled) {
+    rf.startReceive(RADIOLIB_SX126X_RX_TIMEOUT_INF, RADIOLIB_SX126X_IRQ_RX_DEFAULT, irq_mask);
+    return;
+  }
+  const auto err = rf.startReceiveDutyCycleAuto(sniff.wake_preamble_len, sniff.min_symbols,
+                                                RADIOLIB_SX126X_IRQ_RX_DEFAULT, irq_mask);
+  if (err != RADIOLIB_ERR_NONE) {
+    ESP_LOGE(TAG, "failed to start duty cycled receiving, code %d", err);
+    rf.startReceive(RADIOLIB_SX126X_RX_TIMEOUT_INF, RADIOLIB_SX126X_IRQ_RX_DEFAULT, irq_mask);
+  }
+}
+
+bool RadioTask::is_channel_free() {
+  constexpr auto TAG = "RadioTask::cad";
+  const auto probe   = SpiProbe{*this, spi_op::cad};
+  const auto res     = rf.scanChannel();
+  // CAD done is signaled on DIO1 as well, which is not what the loop is waiting for
+  ulTaskNotifyValueClear(nullptr, Dio1Evt);
+  if (res == RADIOLIB_CHANNEL_FREE) {
+    return true;
+  }
+  if (res != RADIOLIB_LORA_DETECTED) {
+    // treat it as free; LBT should never be the reason a frame is lost
+    ESP_LOGW(TAG, "failed to scan channel, code %d", res);
+    return true;
+  }
+  _stats.channel_busy += 1;
+  return false;
+}
+
+void RadioTask::loop() {
+  constexpr auto TAG = "RadioTask";
+  // in the task, so that the DIO1 raised by it is never missed
+  start_receive();
+  enum class state_t {
+    idle,
+    /**
+     * @brief the channel is busy; waiting to run CAD again
+     */
+    backoff,
+    transmitting,
+  };
+  // the frame being transmitted (or waiting for the channel)
+  frame_t frame;
+  auto state             = state_t::idle;
+  uint32_t tx_started_ms = 0;
+  uint32_t backoff_until = 0;
+  auto backoff           = ::lbt::Backoff{lbt};
+  auto remaining         = [](uint32_t deadline_ms) -> TickType_t {
+    const auto now = now_ms();
+    if (static_cast<int32_t>(deadline_ms - now) <= 0) {
+      return 0;
+    }
+    // at least one tick, or it would spin until the deadline
+    return std::max<TickType_t>(pdMS_TO_TICKS(deadline_ms - now), 1);
+  };
+  /**
+   * @brief run CAD if enabled and start transmitting `frame`
+   * @return the next state
+   */
+  auto try_transmit = [&]() {
+    if (lbt.enabled) {
+      // listen on the channel to transmit on
+      rf.standby();
+      apply(profile_of(frame));
+    }
+    if (lbt.enabled && !is_channel_free()) {
+      const auto delay_ms = backoff.on_busy(esp_random());
+      if (!delay_ms) {
+        ESP_LOGW(TAG, "channel busy; drop magic=0x%02x", frame.data[0]);
+        _stats.lbt_dropped += 1;
+        start_receive();
+        return state_t::idle;
+      }
+      backoff_until = now_ms() + *delay_ms;
+      start_receive();
+      return state_t::backoff;
+    }
+    if (!start_transmit(frame)) {
+      return state_t::idle;
+    }
+    tx_started_ms = now_ms();
+    return state_t::transmitting;
+  };
+  for (;;) {
+    TickType_t wait = portMAX_DELAY;
+    if (state == state_t::transmitting) {
+      wait = remaining(tx_started_ms + TX_TIMEOUT_MS);
+    } else if (state == state_t::backoff) {
+      wait = remaining(backoff_until);
+    }
+    const auto is_transmitting = state == state_t::transmitting;
+    // `TxEvt` is only a wake up hint, the queue is always checked below
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, Dio1Evt | TxEvt, &bits, wait);
+    if (bits & Dio1Evt) {
+      record_dio1_latency();
+      const auto status = rf.getIrqStatus();
+      if (is_transmitting && (status & RADIOLIB_SX126X_IRQ_TX_DONE)) {
+        rf.finishTransmit();
+        const auto latency        = now_ms() - frame.queued_ms;
+        _stats.last_tx_latency_ms = latency;
+        _stats.max_tx_latency_ms  = std::max(_stats.max_tx_latency_ms, latency);
+        _stats.tx_done += 1;
+        state = state_t::idle;
+        start_receive();
+      } else if (status & RADIOLIB_SX126X_IRQ_RX_DONE) {
+        receive(status);
+        if (sniff.enabled) {
+          // the radio stays in standby after RX done in duty cycle
+          start_receive();
+        }
+      } else if (!is_transmitting && (status & RADIOLIB_SX126X_IRQ_HEADER_ERR)) {
+        // no RX done would follow; restarting clears the flags
+        _stats.header_err += 1;
+        start_receive();
+      } else {
+        ESP_LOGW(TAG, "unexpected irq status 0x%04x", status);
+      }
+    } else if (is_transmitting && now_ms() - tx_started_ms >= TX_TIMEOUT_MS) {
+      ESP_LOGW(TAG, "tx timeout; please check the busy pin;");
+      _stats.tx_timeout += 1;
+      state = state_t::idle;
+      rf.standby();
+      start_receive();
+    }
+    if (state == state_t::backoff && remaining(backoff_until) == 0) {
+      state = try_transmit();
+    }
+    while (state == state_t::idle && xQueueReceive(queue, &frame, 0) == pdTRUE) {
+      backoff.reset();
+      state = try_transmit();
+    }
+    publish_stats();
+  }
+}
+}
@@ -1,8 +1,19 @@
 //
 // Created by Kurosu Chan on 2023/11/1.
 //
+#include <algorithm>
 #include "server_callback.h"
 
+void ServerCallbacks::update_min_mtu() {
+  uint16_t mtu = BLE_ATT_MTU_DFLT;
+  if (!peers.empty()) {
+    mtu = std::min_element(peers.begin(), peers.end(),
+                           [](const auto &a, const auto &b) { return a.mtu < b.mtu; })
+              ->mtu;
+  }
+  min_mtu.store(mtu);
+}
+
 /** Alternative onConnect() method to extract details of the connection.
  *  See: src/ble_gap.h for the details of the ble_gap_conn_desc struct.
  */
@@ -10,14 +21,29 @@ void ServerCallbacks::onConnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo)
   ESP_LOGI("onConnect", "Client connected.");
   ESP_LOGI("onConnect", "Multi-connect support: start advertising");
   pServer->updateConnParams(connInfo.getConnHandle(), 24, 48, 0, 60);
+  if (!peers.full()) {
+    peers.push_back(peer_t{.conn_handle = connInfo.getConnHandle(), .mtu = connInfo.getMTU()});
+    update_min_mtu();
+  }
   NimBLEDevice::startAdvertising();
 }
 
 void ServerCallbacks::onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo, int reason) {
   ESP_LOGI("onDisconnect", "Client disconnected - start advertising");
+  const auto handle = connInfo.getConnHandle();
+  peers.erase(std::remove_if(peers.begin(), peers.end(),
+                             [handle](const auto &p) { return p.conn_handle == handle; }),
+              peers.end());
+  update_min_mtu();
   NimBLEDevice::startAdvertising();
 }
 
 void ServerCallbacks::onMTUChange(uint16_t MTU, NimBLEConnInfo &connInfo) {
   ESP_LOGI("onMTUChange", "MTU updated: %u for connection ID: %s", MTU, connInfo.getIdAddress().toString().c_str());
+  for (auto &p : peers) {
+    if (p.conn_handle == connInfo.getConnHandle()) {
+      p.mtu = MTU;
+    }
+  }
+  update_min_mtu();
 }
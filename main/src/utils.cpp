@@ -24,7 +24,7 @@ size_t sprintHex(char *out, size_t outSize, const uint8_t *bytes, size_t size) {
 std::string toHex(const uint8_t *bytes, size_t size) {
   auto sizeNeeded = size * 2;
   auto res        = std::string(sizeNeeded, '\0');
-  auto _len       = sprintHex(const_cast<char *>(res.data()), sizeNeeded, bytes, size);
+  sprintHex(res.data(), sizeNeeded, bytes, size);
   return res;
 }
 }
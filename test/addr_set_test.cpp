@@ -0,0 +1,132 @@
+/**
+ * @brief `addr_set::AddrSet` against `std::unordered_set`, and its NVS blob
+ */
+
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "check.h"
+#include "addr_set.h"
+
+namespace {
+using namespace addr_set;
+using set_t = AddrSet<32>;
+
+struct addr_t {
+  uint8_t bytes[ADDR_SIZE];
+};
+
+addr_t random_addr(std::mt19937 &rng) {
+  auto a = addr_t{};
+  for (auto &b : a.bytes) {
+    b = static_cast<uint8_t>(rng());
+  }
+  return a;
+}
+
+TEST(same_as_unordered_set) {
+  auto rng = std::mt19937{23};
+  for (int round = 0; round < 500; ++round) {
+    auto s   = set_t{};
+    auto ref = std::unordered_set<uint64_t>{};
+    // draw from a small pool so that duplicates and misses both happen
+    auto pool = std::vector<addr_t>{};
+    for (int i = 0; i < 40; ++i) {
+      pool.push_back(random_addr(rng));
+    }
+    for (int i = 0; i < 60; ++i) {
+      const auto &a  = pool[rng() % pool.size()];
+      const auto ok  = s.insert(a.bytes);
+      const auto has = ref.contains(pack(a.bytes));
+      if (has || ref.size() < set_t::max_size) {
+        REQUIRE(ok);
+        ref.insert(pack(a.bytes));
+      } else {
+        REQUIRE(!ok);
+      }
+      REQUIRE(s.size() == ref.size());
+    }
+    for (const auto &a : pool) {
+      REQUIRE(s.contains(a.bytes) == ref.contains(pack(a.bytes)));
+    }
+    size_t n = 0;
+    s.for_each([&](const uint8_t *addr) {
+      n += 1;
+      CHECK(ref.contains(pack(addr)));
+    });
+    CHECK(n == ref.size());
+  }
+}
+
+TEST(colliding_addresses) {
+  // the same hash bucket for many addresses, i.e. long probes with wrap around
+  auto s     = set_t{};
+  auto rng   = std::mt19937{7};
+  auto found = std::vector<addr_t>{};
+  while (found.size() < set_t::max_size) {
+    const auto a = random_addr(rng);
+    if ((mix64(pack(a.bytes)) & 31) == 31) {
+      found.push_back(a);
+    }
+  }
+  for (const auto &a : found) {
+    REQUIRE(s.insert(a.bytes));
+  }
+  for (const auto &a : found) {
+    CHECK(s.contains(a.bytes));
+  }
+  const auto other = addr_t{{0xc0, 0x11, 0x22, 0x33, 0x44, 0x55}};
+  CHECK(!s.contains(other.bytes));
+  CHECK(!s.insert(other.bytes));
+}
+
+TEST(extreme_addresses) {
+  auto s                     = set_t{};
+  constexpr uint8_t zero[]   = {0, 0, 0, 0, 0, 0};
+  constexpr uint8_t ones[]   = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+  constexpr uint8_t almost[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xfe};
+  CHECK(!s.contains(ones) && !s.contains(zero));
+  CHECK(s.insert(zero) && s.insert(ones));
+  CHECK(s.contains(zero) && s.contains(ones) && !s.contains(almost));
+}
+
+TEST(blob_round_trip) {
+  auto rng = std::mt19937{5};
+  auto s   = set_t{};
+  for (size_t i = 0; i < 12; ++i) {
+    const auto a = random_addr(rng);
+    s.insert(a.bytes);
+  }
+  auto blob = std::vector<uint8_t>(s.blob_size());
+  REQUIRE(s.to_blob(blob) == blob.size());
+  auto t = set_t{};
+  REQUIRE(t.from_blob(blob));
+  CHECK(t.size() == s.size());
+  s.for_each([&](const uint8_t *addr) { CHECK(t.contains(addr)); });
+  // too small a buffer
+  auto small = std::vector<uint8_t>(s.blob_size() - 1);
+  CHECK(s.to_blob(small) == 0);
+}
+
+TEST(bad_blobs) {
+  auto s = set_t{};
+  // not a multiple of an address
+  CHECK(!s.from_blob(std::vector<uint8_t>(ADDR_SIZE + 1)));
+  // more addresses than it holds
+  auto big = std::vector<uint8_t>{};
+  for (uint8_t i = 0; i <= set_t::max_size; ++i) {
+    const uint8_t a[] = {0xc0, 0, 0, 0, 0, i};
+    big.insert(big.end(), a, a + ADDR_SIZE);
+  }
+  CHECK(!s.from_blob(big));
+  // empty is fine, and clears
+  const uint8_t a[] = {1, 2, 3, 4, 5, 6};
+  s.insert(a);
+  CHECK(s.from_blob({}) && s.empty() && !s.contains(a));
+  // duplicates are taken once
+  auto dup = std::vector<uint8_t>{a, a + ADDR_SIZE};
+  dup.insert(dup.end(), a, a + ADDR_SIZE);
+  CHECK(s.from_blob(dup) && s.size() == 1);
+}
+}
@@ -0,0 +1,172 @@
+/**
+ * @brief the time-on-air model and the airtime ledger with its degrading policy
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include "check.h"
+#include "airtime.h"
+#include "common.h"
+#include "radio_profile.h"
+
+namespace {
+using namespace airtime;
+using radio_profile::profile_t;
+
+/**
+ * @brief the formula of AN1200.13 in floating point, in microseconds
+ */
+double reference_toa_us(const profile_t &p, size_t payload_len) {
+  const auto t_sym = std::ldexp(1.0, p.sf) / (p.bw_khz * 1e3) * 1e6;
+  const auto de    = t_sym >= 16'000 ? 1 : 0;
+  const auto num   = 8.0 * static_cast<double>(payload_len) - 4.0 * p.sf + 28 + 16;
+  const auto n     = 8 + std::max(std::ceil(num / (4.0 * (p.sf - 2 * de))) * p.cr, 0.0);
+  return (p.preamble_len + 4.25 + n) * t_sym;
+}
+
+TEST(time_on_air_matches_the_reference) {
+  for (const auto bw : {62.5f, 125.0f, 250.0f, 500.0f}) {
+    for (uint8_t sf = 6; sf <= 12; ++sf) {
+      for (uint8_t cr = 5; cr <= 8; ++cr) {
+        const auto p = profile_t{.name = "", .freq_mhz = 433.2f, .bw_khz = bw, .sf = sf, .cr = cr, .power_dbm = 14, .preamble_len = 8};
+        for (size_t len = 1; len <= 255; len += 7) {
+          const auto ref = reference_toa_us(p, len);
+          const auto toa = static_cast<double>(radio_profile::time_on_air_us(p, len));
+          // the symbol time is truncated to a microsecond; at most a microsecond a symbol
+          const auto symbols = ref / (std::ldexp(1.0, sf) / (bw * 1e3) * 1e6);
+          CHECK(toa <= ref + 1 && toa >= ref - symbols - 1);
+        }
+      }
+    }
+  }
+}
+
+TEST(time_on_air_of_the_profiles) {
+  // SF10/500kHz CR4/7: 12.25 symbols of preamble, 8 + 3 * 7 of header and payload, 2.048 ms each
+  CHECK(radio_profile::time_on_air_us(radio_profile::DEFAULT_PROFILE, 10) == 84'480);
+  // longer frames never take less
+  for (const auto &p : radio_profile::PROFILES) {
+    for (size_t len = 1; len < 255; ++len) {
+      CHECK(radio_profile::time_on_air_us(p, len) <= radio_profile::time_on_air_us(p, len + 1));
+    }
+  }
+}
+
+constexpr auto config = config_t{
+    .window_ms     = static_cast<uint32_t>(common::DUTY_CYCLE_WINDOW.count()),
+    .duty_permille = common::DUTY_CYCLE_PERMILLE,
+};
+// as `radio::RadioTask`
+using ledger_t = Ledger<60>;
+
+TEST(budget_is_split_by_class) {
+  const auto l = ledger_t{config};
+  // 10% of an hour
+  CHECK(l.budget_us() == 360'000'000);
+  CHECK(l.budget_us(traffic_class::control) == l.budget_us());
+  CHECK(l.budget_us(traffic_class::named) == 324'000'000);
+  CHECK(l.budget_us(traffic_class::bulk) == 270'000'000);
+}
+
+TEST(bulk_gives_up_first) {
+  auto l         = ledger_t{config};
+  const auto toa = 100'000u;
+  uint32_t now   = 0;
+  // fill the bulk share
+  while (l.admit(traffic_class::bulk, toa, now)) {
+    l.record(toa, now);
+    now += 10;
+  }
+  CHECK(l.used_us(now) <= l.budget_us(traffic_class::bulk));
+  CHECK(l.used_us(now) + toa > l.budget_us(traffic_class::bulk));
+  CHECK(l.admit(traffic_class::named, toa, now));
+  // then the named share
+  while (l.admit(traffic_class::named, toa, now)) {
+    l.record(toa, now);
+    now += 10;
+  }
+  CHECK(!l.admit(traffic_class::bulk, toa, now));
+  CHECK(l.admit(traffic_class::control, toa, now));
+}
+
+TEST(airtime_is_forgotten_a_bucket_at_a_time) {
+  auto l              = ledger_t{config};
+  const auto bucket   = config.window_ms / 60;
+  const auto early_ms = bucket / 2;
+  l.record(1'000, early_ms);
+  l.record(2'000, config.window_ms / 2);
+  CHECK(l.used_us(config.window_ms - 1) == 3'000);
+  // the first bucket is dropped as a whole
+  CHECK(l.used_us(config.window_ms) == 2'000);
+  CHECK(l.used_us(config.window_ms + config.window_ms / 2 - 1) == 2'000);
+  CHECK(l.used_us(config.window_ms + config.window_ms / 2) == 0);
+  CHECK(l.total() == 3'000);
+}
+
+TEST(idle_longer_than_the_window) {
+  auto l = ledger_t{config};
+  l.record(5'000, 0);
+  CHECK(l.used_us(10 * config.window_ms) == 0);
+  l.record(7'000, 10 * config.window_ms + 1);
+  CHECK(l.used_us(10 * config.window_ms + 2) == 7'000);
+}
+
+/**
+ * @brief a repeater that wants to send far more than it may, for hours: the
+ *        long-run duty cycle stays at the limit, and control frames are
+ *        never refused while bulk is throttled
+ */
+TEST(saturated_repeater_keeps_the_duty_cycle) {
+  auto l              = ledger_t{config};
+  const auto &profile = radio_profile::DEFAULT_PROFILE;
+  const auto bulk_toa = radio_profile::time_on_air_us(profile, 64);
+  const auto ctrl_toa = radio_profile::time_on_air_us(profile, 16);
+  const auto hours    = 6u;
+  uint64_t sent_us    = 0;
+  uint32_t bulk_drop   = 0;
+  uint32_t ctrl_drop   = 0;
+  uint32_t ctrl_sent   = 0;
+  // the airtime sent in the last window, to check the sliding window by the record
+  auto recent        = std::deque<std::pair<uint32_t, uint32_t>>{};
+  uint64_t recent_us = 0;
+  uint64_t worst_us  = 0;
+  auto send          = [&](traffic_class cls, uint32_t toa, uint32_t now) {
+    if (!l.admit(cls, toa, now)) {
+      return false;
+    }
+    l.record(toa, now);
+    sent_us += toa;
+    recent.emplace_back(now, toa);
+    recent_us += toa;
+    return true;
+  };
+  // back to back, as fast as the radio could
+  const auto step_ms = bulk_toa / 1000 + 1;
+  for (uint32_t now = 0; now < hours * config.window_ms; now += step_ms) {
+    while (!recent.empty() && now - recent.front().first >= config.window_ms) {
+      recent_us -= recent.front().second;
+      recent.pop_front();
+    }
+    if (!send(traffic_class::bulk, bulk_toa, now)) {
+      bulk_drop += 1;
+    }
+    // a status response every 10 s
+    if (now / 10'000 != (now - step_ms) / 10'000) {
+      if (send(traffic_class::control, ctrl_toa, now)) {
+        ctrl_sent += 1;
+      } else {
+        ctrl_drop += 1;
+      }
+    }
+    worst_us = std::max(worst_us, recent_us);
+  }
+  CHECK(bulk_drop > 0);
+  CHECK(ctrl_drop == 0 && ctrl_sent > 0);
+  // on average, within the limit
+  CHECK(sent_us <= uint64_t{l.budget_us()} * hours + l.budget_us());
+  // and in any window, but for the bucket that's forgotten at once, which
+  // holds at most a bucket of airtime
+  CHECK(worst_us <= uint64_t{l.budget_us()} + config.window_ms / 60 * 1000);
+}
+}
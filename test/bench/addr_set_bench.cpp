@@ -0,0 +1,66 @@
+/**
+ * @brief the address lookup of `ScanManager::onResult`: `AddrSet` against the
+ *        linear `std::equal` scan and `std::unordered_set`, for the advertisements
+ *        of the targets (hit) and of everyone else (miss)
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "bench.h"
+#include "addr_set.h"
+
+namespace {
+using addr_t = std::array<uint8_t, addr_set::ADDR_SIZE>;
+
+std::vector<addr_t> random_addrs(size_t n, std::mt19937 &rng) {
+  auto res = std::vector<addr_t>(n);
+  for (auto &a : res) {
+    for (auto &b : a) {
+      b = static_cast<uint8_t>(rng());
+    }
+  }
+  return res;
+}
+}
+
+int main(int argc, char **argv) {
+  auto s   = bench::session{argc, argv};
+  auto rng = std::mt19937{23};
+  // `MAX_DEVICE_NUM` targets in the set of `ScanManager`, and at its capacity
+  for (const size_t n_targets : {size_t{1}, size_t{12}, size_t{16}}) {
+    const auto targets = random_addrs(n_targets, rng);
+    const auto crowd   = random_addrs(1'024, rng);
+    auto set           = addr_set::AddrSet<32>{};
+    auto hashed        = std::unordered_set<uint64_t>{};
+    for (const auto &a : targets) {
+      set.insert(a.data());
+      hashed.insert(addr_set::pack(a.data()));
+    }
+    size_t i    = 0;
+    size_t hits = 0;
+    auto linear = [&](const addr_t &a) {
+      return std::any_of(targets.begin(), targets.end(), [&](const auto &t) { return std::equal(t.begin(), t.end(), a.begin()); });
+    };
+    const auto limit = bench::limit_t{.max_ns = 200, .max_bytes = 0};
+    char name[64]    = {0};
+    std::snprintf(name, sizeof(name), "%zu targets, miss: linear", n_targets);
+    const auto lin = s.run(name, limit, [&] { hits += linear(crowd[i++ % crowd.size()]); });
+    std::snprintf(name, sizeof(name), "%zu targets, miss: unordered_set", n_targets);
+    s.run(name, limit, [&] { hits += hashed.contains(addr_set::pack(crowd[i++ % crowd.size()].data())); });
+    std::snprintf(name, sizeof(name), "%zu targets, miss: AddrSet", n_targets);
+    const auto miss = s.run(name, limit, [&] { hits += set.contains(crowd[i++ % crowd.size()].data()); });
+    std::snprintf(name, sizeof(name), "%zu targets, hit: linear", n_targets);
+    s.run(name, limit, [&] { hits += linear(targets[i++ % targets.size()]); });
+    std::snprintf(name, sizeof(name), "%zu targets, hit: AddrSet", n_targets);
+    s.run(name, limit, [&] { hits += set.contains(targets[i++ % targets.size()].data()); });
+    bench::do_not_optimize(hits);
+    std::snprintf(name, sizeof(name), "%zu targets, miss: AddrSet vs linear", n_targets);
+    s.note(name, lin.ns_per_op / miss.ns_per_op, "x faster");
+  }
+  return s.finish();
+}
@@ -0,0 +1,121 @@
+/**
+ * @brief marshal and unmarshal of every message in `hr_lora.h`
+ *
+ * A codec should take well under a microsecond and never allocate, since
+ * it runs for every frame received or sent.
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "bench.h"
+#include "hr_lora.h"
+
+namespace {
+using namespace HrLoRa;
+using bytes_t = std::vector<uint8_t>;
+
+constexpr auto addr_a = addr_t{0xc0, 0x11, 0x22, 0x33, 0x44, 0x55};
+constexpr auto addr_b = addr_t{0xd0, 0x66, 0x77, 0x88, 0x99, 0xaa};
+
+constexpr auto limit_frame  = bench::limit_t{.max_ns = 1'000, .max_bytes = 0};
+// for a frame of 32 samples
+constexpr auto limit_series = bench::limit_t{.max_ns = 5'000, .max_bytes = 0};
+
+template <typename M, typename T>
+bytes_t frame_of(const T &data) {
+  auto buf      = bytes_t(256);
+  const auto sz = M::marshal(data, std::span<uint8_t>{buf});
+  buf.resize(sz);
+  return buf;
+}
+
+/**
+ * @brief `<module>::marshal` and `<module>::unmarshal_view`
+ */
+template <typename M, typename T>
+void codec(bench::session &s, const char *marshal_name, const char *unmarshal_name, const T &data,
+           bench::limit_t limit = limit_frame) {
+  uint8_t buf[256] = {0};
+  s.run(marshal_name, limit, [&] {
+    bench::do_not_optimize(M::marshal(data, std::span<uint8_t>{buf}));
+  });
+  const auto frame = frame_of<M>(data);
+  s.run(unmarshal_name, limit, [&] {
+    auto res = M::unmarshal_view(std::span<const uint8_t>{frame});
+    bench::do_not_optimize(res);
+  });
+}
+
+link_stats::t sample_link_stats() {
+  auto data = link_stats::t{.rssi_avg_dbm = -97, .snr_avg_db = 6.25f, .rx_ok = 12'345, .crc_err = 17};
+  for (size_t i = 0; i < link_stats::buckets; ++i) {
+    data.rssi_hist[i] = 100 * i;
+    data.snr_hist[i]  = 3 * i;
+  }
+  return data;
+}
+
+hr_batch::t sample_batch() {
+  auto data = hr_batch::t{.key = 1};
+  for (uint16_t i = 0; i < hr_batch::max_samples; ++i) {
+    data.samples.push_back(hr_batch::sample_t{
+        .age = static_cast<uint16_t>((hr_batch::max_samples - i) * 1'000),
+        .hr  = static_cast<uint8_t>(70 + i % 5),
+    });
+  }
+  return data;
+}
+
+hr_rr::t sample_rr() {
+  auto data = hr_rr::t{.key = 1, .seq = 9};
+  for (uint16_t i = 0; i < hr_rr::max_rr; ++i) {
+    data.rr.push_back(static_cast<uint16_t>(840 + (i % 7) * 9 - 27));
+  }
+  return data;
+}
+}
+
+int main(int argc, char **argv) {
+  auto s = bench::session{argc, argv};
+
+  codec<hr_data>(s, "hr_data::marshal", "hr_data::unmarshal_view", hr_data::t{.key = 1, .hr = 70});
+  codec<named_hr_data>(s, "named_hr_data::marshal", "named_hr_data::unmarshal_view",
+                       named_hr_data::t{.key = 1, .hr = 70, .addr = addr_a});
+  codec<query_device_by_mac>(s, "query_device_by_mac::marshal", "query_device_by_mac::unmarshal_view",
+                             query_device_by_mac::t{.addr = addr_a});
+  codec<set_name_map_key>(s, "set_name_map_key::marshal", "set_name_map_key::unmarshal_view",
+                          set_name_map_key::t{.addr = addr_a, .key = 3});
+  codec<link_stats>(s, "link_stats::marshal", "link_stats::unmarshal_view", sample_link_stats());
+  codec<repeater_status>(s, "repeater_status::marshal", "repeater_status::unmarshal_view",
+                         repeater_status::t{
+                             .repeater_addr = addr_a,
+                             .key           = 2,
+                             .device        = hr_device::t{.addr = addr_b, .name = "Polar H10 12345678"},
+                             .link          = sample_link_stats(),
+                         });
+  codec<hr_batch>(s, "hr_batch::marshal (32)", "hr_batch::unmarshal_view (32)", sample_batch(), limit_series);
+  codec<hr_rr>(s, "hr_rr::marshal (60)", "hr_rr::unmarshal_view (60)", sample_rr(), limit_series);
+  const uint8_t inner[] = {hr_data::magic, 1, 70};
+  codec<reliable>(s, "reliable::marshal", "reliable::unmarshal_view",
+                  reliable::view{.src = addr_a, .dst = addr_b, .seq = 3, .payload = inner});
+  codec<ack>(s, "ack::marshal", "ack::unmarshal_view", ack::t{.src = addr_a, .dst = addr_b, .seq = 3});
+
+  // a mixed stream of what a gateway receives, through the dispatch table
+  const auto frames = std::vector<bytes_t>{
+      frame_of<hr_batch>(sample_batch()),
+      frame_of<hr_rr>(sample_rr()),
+      frame_of<named_hr_data>(named_hr_data::t{.key = 1, .hr = 70, .addr = addr_a}),
+      frame_of<hr_data>(hr_data::t{.key = 1, .hr = 70}),
+      frame_of<ack>(ack::t{.src = addr_a, .dst = addr_b, .seq = 3}),
+  };
+  size_t i     = 0;
+  size_t n_ok  = 0;
+  auto handler = [&](const auto &) { n_ok += 1; };
+  s.run("hr_lora_msg::modules::dispatch (mixed)", limit_frame, [&] {
+    const auto &f = frames[i++ % frames.size()];
+    bench::do_not_optimize(hr_lora_msg::modules::dispatch(std::span<const uint8_t>{f}, handler));
+  });
+  bench::do_not_optimize(n_ok);
+  return s.finish();
+}
@@ -0,0 +1,95 @@
+/**
+ * @brief `delta_codec` on heart rate traces
+ *
+ *     delta_codec_bench [--scale=x] [--no-gate] [trace.csv]...
+ *
+ * Reports bytes per sample (against a byte per sample as is, and the 3 bytes
+ * of a `hr_data`) and ns per sample to encode and decode, over frames of
+ * `hr_batch::max_samples`. The built-in trace is `hr_trace::synthetic`; a
+ * recording (a heart rate per line) could be given instead.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "hr_lora.h"
+#include "hr_trace.h"
+
+namespace {
+using namespace HrLoRa;
+constexpr size_t frame_samples = hr_batch::max_samples;
+
+struct trace_t {
+  std::string name;
+  std::vector<uint8_t> hr;
+};
+
+void run(bench::session &s, const trace_t &trace, bool gated) {
+  const auto &hr      = trace.hr;
+  const size_t frames = hr.size() / frame_samples;
+  if (frames == 0) {
+    return;
+  }
+  // encoded once for the figures and the decoder
+  auto encoded       = std::vector<std::vector<uint8_t>>{};
+  size_t total_bytes = 0;
+  for (size_t f = 0; f < frames; ++f) {
+    auto out      = std::vector<uint8_t>(delta_codec::max_size(frame_samples));
+    const auto sz = delta_codec::encode(hr.data() + f * frame_samples, frame_samples, out.data(), out.size());
+    out.resize(sz);
+    total_bytes += sz;
+    encoded.push_back(std::move(out));
+  }
+  const auto samples          = static_cast<double>(frames * frame_samples);
+  const auto bytes_per_sample = static_cast<double>(total_bytes) / samples;
+  const auto label            = [&](const char *what) { return trace.name + " " + what; };
+
+  // the nibble codec should stay close to half a byte on a real trace
+  const auto bps_name = label("bytes/sample");
+  if (gated) {
+    s.note(bps_name.c_str(), bytes_per_sample, "bytes", 0.75);
+  } else {
+    s.note(bps_name.c_str(), bytes_per_sample, "bytes");
+  }
+  const auto ratio_name = label("vs hr_data");
+  s.note(ratio_name.c_str(), static_cast<double>(hr_data::size_needed()) / bytes_per_sample, "x smaller");
+
+  size_t f            = 0;
+  uint8_t out[64]     = {0};
+  const auto enc_name = label("encode (32)");
+  const auto enc      = s.run(enc_name.c_str(), {.max_ns = 2'000}, [&] {
+    bench::do_not_optimize(delta_codec::encode(hr.data() + (f++ % frames) * frame_samples, frame_samples, out, sizeof(out)));
+  });
+  uint8_t values[frame_samples] = {0};
+  const auto dec_name           = label("decode (32)");
+  const auto dec                = s.run(dec_name.c_str(), {.max_ns = 2'000}, [&] {
+    const auto &e = encoded[f++ % frames];
+    bench::do_not_optimize(delta_codec::decode(e.data(), e.size(), values, frame_samples));
+    bench::do_not_optimize(values);
+  });
+  const auto enc_sample = label("encode ns/sample");
+  const auto dec_sample = label("decode ns/sample");
+  s.note(enc_sample.c_str(), enc.ns_per_op / frame_samples, "ns");
+  s.note(dec_sample.c_str(), dec.ns_per_op / frame_samples, "ns");
+}
+}
+
+int main(int argc, char **argv) {
+  auto s      = bench::session{argc, argv};
+  auto traces = std::vector<trace_t>{};
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--", 2) != 0) {
+      traces.push_back(trace_t{.name = argv[i], .hr = hr_trace::load_csv(argv[i])});
+    }
+  }
+  if (traces.empty()) {
+    run(s, trace_t{.name = "synthetic", .hr = hr_trace::synthetic(2 * 3600)}, true);
+  } else {
+    for (const auto &t : traces) {
+      run(s, t, false);
+    }
+  }
+  return s.finish();
+}
@@ -0,0 +1,69 @@
+/**
+ * @brief the Heart Rate Measurement parser, and `hr_rr` on RR intervals of a trace
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "bench.h"
+#include "hr_lora.h"
+#include "hr_measurement.h"
+#include "hr_trace.h"
+
+int main(int argc, char **argv) {
+  using namespace blue::hr_measurement;
+  auto s = bench::session{argc, argv};
+
+  // what a chest strap usually sends: uint8 hr, contact, one or two RR intervals
+  const uint8_t usual[] = {0x16, 0x46, 0x34, 0x03, 0x40, 0x03};
+  // as long as the default MTU allows, with every field
+  auto longest = std::vector<uint8_t>{0x1f, 0x2c, 0x01, 0x10, 0x00};
+  while (longest.size() + 2 <= 20) {
+    longest.push_back(0x00);
+    longest.push_back(0x04);
+  }
+  auto r = t{};
+  s.run("hr_measurement::parse (usual)", {.max_ns = 200}, [&] {
+    bench::do_not_optimize(parse(usual, r));
+    bench::do_not_optimize(r);
+  });
+  s.run("hr_measurement::parse (20 bytes)", {.max_ns = 500}, [&] {
+    bench::do_not_optimize(parse(longest, r));
+    bench::do_not_optimize(r);
+  });
+
+  // RR intervals of a two hour session, in frames as `app_main` sends them
+  using HrLoRa::hr_rr;
+  const auto rr       = hr_trace::rr_of(hr_trace::synthetic(2 * 3600));
+  auto frames         = std::vector<hr_rr::t>{};
+  size_t total_bytes  = 0;
+  size_t total_values = 0;
+  for (size_t i = 0; i + hr_rr::max_rr <= rr.size(); i += hr_rr::max_rr) {
+    auto f = hr_rr::t{.key = 1};
+    for (size_t j = 0; j < hr_rr::max_rr; ++j) {
+      f.rr.push_back(rr[i + j]);
+    }
+    total_bytes += hr_rr::size_needed(f);
+    total_values += f.rr.size();
+    frames.push_back(f);
+  }
+  // 2 bytes each as they come from the monitor
+  s.note("hr_rr bytes/interval (with header)", static_cast<double>(total_bytes) / total_values, "bytes", 1.5);
+
+  size_t i         = 0;
+  uint8_t buf[128] = {0};
+  s.run("hr_rr::marshal (60, trace)", {.max_ns = 5'000}, [&] {
+    bench::do_not_optimize(hr_rr::marshal(frames[i++ % frames.size()], buf, sizeof(buf)));
+  });
+  auto encoded = std::vector<std::vector<uint8_t>>{};
+  for (const auto &f : frames) {
+    const auto sz = hr_rr::marshal(f, buf, sizeof(buf));
+    encoded.emplace_back(buf, buf + sz);
+  }
+  s.run("hr_rr::unmarshal (60, trace)", {.max_ns = 5'000}, [&] {
+    const auto &e = encoded[i++ % encoded.size()];
+    auto res      = hr_rr::unmarshal(e.data(), e.size());
+    bench::do_not_optimize(res);
+  });
+  return s.finish();
+}
@@ -0,0 +1,102 @@
+/**
+ * @brief the filter of `ScanManager::onResult` on a crowded band, in
+ *        advertisements per second: the `AddrSet` lookup, then the names
+ *        against the compiled patterns, against precompiled `std::regex`
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "addr_set.h"
+#include "name_matcher.h"
+
+namespace {
+using addr_t = std::array<uint8_t, addr_set::ADDR_SIZE>;
+
+struct advert_t {
+  addr_t addr;
+  std::string name;
+};
+
+// what a scan in an office or a gym hears, mostly someone else
+constexpr const char *crowd[] = {
+    "", "", "", "",
+    "Mi Smart Band 7", "[TV] Samsung 7 Series", "JBL Flip 5", "LE-Bose QC35",
+    "iPhone", "Galaxy Watch5 (A1B2)", "Tile", "MX Master 3",
+    "Polar H10 8A2B3C4D", "HW706-0012345", "TICKR 1A2B", "COOSPO H6 0123",
+    "Forerunner 255", "WH-1000XM4", "Amazfit Band 5", "ELK-BLEDOM",
+};
+
+std::vector<advert_t> make_adverts(size_t n, uint32_t seed) {
+  auto rng = std::mt19937{seed};
+  auto res = std::vector<advert_t>{};
+  for (size_t i = 0; i < n; ++i) {
+    auto a = advert_t{};
+    for (auto &b : a.addr) {
+      b = static_cast<uint8_t>(rng());
+    }
+    a.name = crowd[rng() % std::size(crowd)];
+    res.push_back(std::move(a));
+  }
+  return res;
+}
+}
+
+int main(int argc, char **argv) {
+  auto s = bench::session{argc, argv};
+
+  const auto adverts = make_adverts(1'024, 22);
+  // `MAX_DEVICE_NUM` targets, a few of which are heard
+  auto addrs     = addr_set::AddrSet<32>{};
+  auto addr_list = std::vector<addr_t>{};
+  for (size_t i = 0; i < 12; ++i) {
+    const auto &a = i < 4 ? adverts[i * 97].addr : addr_t{0xc0, 0, 0, 0, 0, static_cast<uint8_t>(i)};
+    addrs.insert(a.data());
+    addr_list.push_back(a);
+  }
+  // `MAX_NAME_PATTERN_NUM` patterns, from the fast path to the program
+  const char *patterns[] = {"^Polar H10", "^HW\\d+-\\d+$", "TICKR", "^COOSPO [A-Z]\\d [0-9A-F]+$"};
+  auto matchers          = std::vector<name_matcher::Matcher>{};
+  auto regexes           = std::vector<std::regex>{};
+  for (const auto p : patterns) {
+    matchers.push_back(*name_matcher::compile(p));
+    regexes.emplace_back(p, std::regex::ECMAScript | std::regex::optimize);
+  }
+
+  size_t i     = 0;
+  size_t hits  = 0;
+  auto next    = [&]() -> const advert_t & { return adverts[i++ % adverts.size()]; };
+  const auto a = s.run("std::regex + linear address scan", {.max_ns = 50'000, .max_bytes = 10'000}, [&] {
+    const auto &ad = next();
+    auto listed    = std::find(addr_list.begin(), addr_list.end(), ad.addr) != addr_list.end();
+    if (!listed && !ad.name.empty()) {
+      listed = std::any_of(regexes.begin(), regexes.end(), [&](const auto &re) { return std::regex_search(ad.name, re); });
+    }
+    hits += listed;
+  });
+  const auto b = s.run("name_matcher + AddrSet", {.max_ns = 2'000, .max_bytes = 0}, [&] {
+    const auto &ad = next();
+    auto listed    = addrs.contains(ad.addr.data());
+    if (!listed && !ad.name.empty()) {
+      listed = std::any_of(matchers.begin(), matchers.end(), [&](const auto &m) { return m.matches(ad.name); });
+    }
+    hits += listed;
+  });
+  // a single pattern of each kind, on every name
+  for (const auto p : patterns) {
+    const auto m = *name_matcher::compile(p);
+    s.run(p, {.max_ns = 1'000, .max_bytes = 0}, [&] {
+      hits += m.matches(next().name);
+    });
+  }
+  bench::do_not_optimize(hits);
+  s.note("std::regex", 1e9 / a.ns_per_op, "adverts/s");
+  s.note("name_matcher", 1e9 / b.ns_per_op, "adverts/s");
+  s.note("name_matcher vs std::regex", a.ns_per_op / b.ns_per_op, "x faster");
+  return s.finish();
+}
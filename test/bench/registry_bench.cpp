@@ -0,0 +1,138 @@
+/**
+ * @brief the magic byte dispatch of `registry` against the `switch` over the
+ *        magic and `std::visit` over the variant that it replaced, on a mixed
+ *        stream of frames
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "bench.h"
+#include "hr_lora.h"
+
+namespace {
+using namespace HrLoRa;
+using bytes_t = std::vector<uint8_t>;
+
+constexpr auto addr_a = addr_t{0xc0, 0x11, 0x22, 0x33, 0x44, 0x55};
+constexpr auto addr_b = addr_t{0xd0, 0x66, 0x77, 0x88, 0x99, 0xaa};
+
+template <typename M, typename T>
+bytes_t frame_of(const T &data) {
+  auto buf      = bytes_t(256);
+  const auto sz = M::marshal(data, std::span<uint8_t>{buf});
+  buf.resize(sz);
+  return buf;
+}
+
+/**
+ * @brief how `hr_lora_msg::unmarshal` used to be, with every message of today
+ */
+namespace legacy {
+  template <typename M>
+  etl::optional<hr_lora_msg::t> unmarshal_helper(const uint8_t *buffer, size_t size) {
+    auto res = M::unmarshal(buffer, size);
+    if (res) {
+      return hr_lora_msg::t{res.value()};
+    }
+    return etl::nullopt;
+  }
+
+  etl::optional<hr_lora_msg::t> unmarshal(const uint8_t *buffer, size_t size) {
+    if (size < 1) {
+      return etl::nullopt;
+    }
+    switch (buffer[0]) {
+      case named_hr_data::magic:
+        return unmarshal_helper<named_hr_data>(buffer, size);
+      case hr_data::magic:
+        return unmarshal_helper<hr_data>(buffer, size);
+      case query_device_by_mac::magic:
+        return unmarshal_helper<query_device_by_mac>(buffer, size);
+      case repeater_status::magic:
+        return unmarshal_helper<repeater_status>(buffer, size);
+      case set_name_map_key::magic:
+        return unmarshal_helper<set_name_map_key>(buffer, size);
+      case hr_batch::magic:
+        return unmarshal_helper<hr_batch>(buffer, size);
+      case hr_rr::magic:
+        return unmarshal_helper<hr_rr>(buffer, size);
+      case reliable::magic:
+        return unmarshal_helper<reliable>(buffer, size);
+      case ack::magic:
+        return unmarshal_helper<ack>(buffer, size);
+      default:
+        return etl::nullopt;
+    }
+  }
+}
+
+/**
+ * @brief what a handler does with a message: look at a field or two
+ */
+struct sink_t {
+  uint32_t sum = 0;
+
+  void operator()(const hr_data::t &v) { sum += v.hr; }
+  void operator()(const named_hr_data::t &v) { sum += v.hr + v.addr[0]; }
+  void operator()(const query_device_by_mac::t &v) { sum += v.addr[5]; }
+  void operator()(const set_name_map_key::t &v) { sum += v.key; }
+  void operator()(const hr_batch::t &v) { sum += v.samples.size(); }
+  void operator()(const hr_rr::t &v) { sum += v.rr.size(); }
+  void operator()(const ack::t &v) { sum += v.seq; }
+  void operator()(const repeater_status::t &v) { sum += v.device ? v.device->name.size() : 0; }
+  void operator()(const repeater_status::view &v) { sum += v.device ? v.device->name.size() : 0; }
+  void operator()(const reliable::t &v) { sum += v.payload.size(); }
+  void operator()(const reliable::view &v) { sum += v.payload.size(); }
+};
+}
+
+int main(int argc, char **argv) {
+  auto s = bench::session{argc, argv};
+
+  auto batch = hr_batch::t{.key = 1};
+  auto rr    = hr_rr::t{.key = 1};
+  for (uint16_t i = 0; i < 16; ++i) {
+    batch.samples.push_back(hr_batch::sample_t{.age = static_cast<uint16_t>((16 - i) * 1'000), .hr = 70});
+    rr.rr.push_back(static_cast<uint16_t>(850 + i % 3));
+  }
+  const uint8_t inner[] = {set_name_map_key::magic, 1, 2, 3, 4, 5, 6, 7};
+  // roughly what a gateway hears, plus a frame of a protocol it doesn't know
+  const auto frames = std::vector<bytes_t>{
+      frame_of<hr_batch>(batch),
+      frame_of<hr_rr>(rr),
+      frame_of<hr_data>(hr_data::t{.key = 1, .hr = 70}),
+      frame_of<hr_batch>(batch),
+      frame_of<named_hr_data>(named_hr_data::t{.key = 1, .hr = 70, .addr = addr_a}),
+      frame_of<repeater_status>(repeater_status::t{
+          .repeater_addr = addr_a,
+          .device        = hr_device::t{.addr = addr_b, .name = "Polar H10 ABCDEF12"},
+      }),
+      frame_of<ack>(ack::t{.src = addr_a, .dst = addr_b, .seq = 1}),
+      frame_of<reliable>(reliable::view{.src = addr_a, .dst = addr_b, .seq = 1, .payload = inner}),
+      bytes_t{0x00, 0x01, 0x02},
+  };
+
+  auto sink    = sink_t{};
+  size_t i     = 0;
+  auto next    = [&]() -> const bytes_t & { return frames[i++ % frames.size()]; };
+  const auto a = s.run("switch + std::visit (owned t)", {.max_ns = 2'000, .max_bytes = 1'000}, [&] {
+    const auto &f = next();
+    if (auto msg = legacy::unmarshal(f.data(), f.size())) {
+      std::visit(sink, *msg);
+    }
+  });
+  const auto b = s.run("table + std::visit (owned t)", {.max_ns = 2'000, .max_bytes = 1'000}, [&] {
+    const auto &f = next();
+    if (auto msg = hr_lora_msg::modules::unmarshal(f.data(), f.size())) {
+      std::visit(sink, *msg);
+    }
+  });
+  const auto c = s.run("table dispatch (view)", {.max_ns = 1'000, .max_bytes = 0}, [&] {
+    bench::do_not_optimize(hr_lora_msg::modules::dispatch(std::span<const uint8_t>{next()}, sink));
+  });
+  bench::do_not_optimize(sink.sum);
+  s.note("table + visit vs switch + visit", a.ns_per_op / b.ns_per_op, "x faster");
+  s.note("table dispatch vs switch + visit", a.ns_per_op / c.ns_per_op, "x faster");
+  return s.finish();
+}
@@ -0,0 +1,141 @@
+/**
+ * @brief the channel plan at the size of a fleet, i.e. `common::TDMA_SLOT_COUNT`
+ *        slots and every 8-bit name map key
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "check.h"
+#include "channel_plan.h"
+#include "common.h"
+
+namespace {
+using namespace channel_plan;
+
+constexpr uint8_t MAX_CHANNELS = 8;
+
+Plan plan_of(uint8_t channel_count) {
+  return Plan{config_t{
+      .base_freq_mhz = 433.2f,
+      .spacing_mhz   = common::CHANNEL_SPACING_MHZ,
+      .channel_count = channel_count,
+      .slot_count    = common::TDMA_SLOT_COUNT,
+  }};
+}
+
+TEST(keys_within_capacity_never_collide) {
+  for (uint8_t n = 1; n <= MAX_CHANNELS; ++n) {
+    const auto plan = plan_of(n);
+    for (uint32_t sf = 0; sf < 256; ++sf) {
+      // (slot, channel) is taken at most once
+      auto taken = std::vector<bool>(plan.capacity(), false);
+      for (uint32_t key = 0; key < plan.capacity() && key <= UINT8_MAX; ++key) {
+        const auto at = (key % common::TDMA_SLOT_COUNT) * n + plan.channel_of(key, sf);
+        CHECK(!taken[at]);
+        taken[at] = true;
+      }
+    }
+  }
+}
+
+TEST(keys_beyond_capacity_share_a_lane) {
+  // the first key that wraps around shares the slot and the channel with key 0
+  // in every superframe
+  const auto plan = plan_of(4);
+  const auto key  = static_cast<uint8_t>(plan.capacity());
+  for (uint32_t sf = 0; sf < 64; ++sf) {
+    CHECK(plan.channel_of(key, sf) == plan.channel_of(0, sf));
+  }
+}
+
+TEST(gateway_with_a_receiver_per_channel_hears_everyone) {
+  for (uint8_t n = 1; n <= MAX_CHANNELS; ++n) {
+    const auto plan = plan_of(n);
+    for (uint32_t sf = 0; sf < 64; ++sf) {
+      for (uint32_t key = 0; key <= UINT8_MAX; ++key) {
+        const uint16_t slot = key % common::TDMA_SLOT_COUNT;
+        const auto lane     = plan.lane_of(key);
+        CHECK(plan.listen_channel(lane, slot, sf) == plan.channel_of(key, sf));
+      }
+    }
+  }
+}
+
+TEST(capacity_scales_with_channels) {
+  // keys heard without collision, with a receiver per channel
+  for (uint8_t n = 1; n <= MAX_CHANNELS; ++n) {
+    const auto plan = plan_of(n);
+    CHECK(plan.capacity() == uint32_t{common::TDMA_SLOT_COUNT} * n);
+  }
+  // a gateway with fewer receivers hears its share of the lanes
+  const auto plan = plan_of(4);
+  for (uint8_t receivers = 1; receivers <= 4; ++receivers) {
+    size_t heard = 0;
+    for (uint32_t key = 0; key < plan.capacity(); ++key) {
+      heard += plan.lane_of(key) < receivers;
+    }
+    CHECK(heard == size_t{common::TDMA_SLOT_COUNT} * receivers);
+  }
+}
+
+TEST(hop_spreads_a_key_over_every_channel) {
+  // over a day of 16 s superframes, each channel takes its share, within 10%
+  constexpr uint32_t superframes = 24 * 3600 / 16;
+  for (uint8_t n = 2; n <= MAX_CHANNELS; ++n) {
+    const auto plan = plan_of(n);
+    for (const uint8_t key : {0, 1, 31, 77, 255}) {
+      auto count = std::array<uint32_t, MAX_CHANNELS>{};
+      for (uint32_t sf = 0; sf < superframes; ++sf) {
+        count[plan.channel_of(key, sf)] += 1;
+      }
+      for (uint8_t ch = 0; ch < n; ++ch) {
+        const auto expected = superframes / n;
+        CHECK(count[ch] * 10 >= expected * 9 && count[ch] * 10 <= expected * 11);
+      }
+    }
+  }
+}
+
+TEST(hop_changes_between_superframes) {
+  // a key stays on the same channel in the next superframe about 1/n of the
+  // time, rather than for long runs
+  const auto plan             = plan_of(4);
+  constexpr uint32_t sf_count = 10'000;
+  uint32_t same               = 0;
+  uint32_t longest_run        = 0;
+  uint32_t run                = 0;
+  for (uint32_t sf = 1; sf < sf_count; ++sf) {
+    if (plan.channel_of(9, sf) == plan.channel_of(9, sf - 1)) {
+      same += 1;
+      run += 1;
+      longest_run = std::max(longest_run, run);
+    } else {
+      run = 0;
+    }
+  }
+  CHECK(same * 4 > sf_count * 8 / 10 && same * 4 < sf_count * 12 / 10);
+  CHECK(longest_run < 12);
+}
+
+TEST(superframe_counter_wraps) {
+  // no discontinuity other than a different hop
+  const auto plan = plan_of(3);
+  for (const uint32_t sf : {UINT32_MAX - 1, UINT32_MAX, 0u}) {
+    for (uint32_t key = 0; key < plan.capacity(); ++key) {
+      CHECK(plan.channel_of(key, sf) < 3);
+      CHECK(plan.listen_channel(plan.lane_of(key), key % common::TDMA_SLOT_COUNT, sf) == plan.channel_of(key, sf));
+    }
+  }
+}
+
+TEST(frequencies_of_the_channels) {
+  const auto plan = plan_of(4);
+  CHECK(plan.freq_of(0) == 433.2f);
+  CHECK(plan.freq_of(3) == 433.2f + 3 * common::CHANNEL_SPACING_MHZ);
+  // `channel_count = 0` is taken as a single channel
+  const auto zero = plan_of(0);
+  CHECK(zero.channel_count() == 1 && zero.freq_mhz(200, 1234) == 433.2f);
+}
+}
@@ -0,0 +1,105 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "bench.h"
+
+namespace {
+std::atomic<size_t> n_allocs{0};
+std::atomic<size_t> n_bytes{0};
+}
+
+// counted, so that a benchmark could tell how much an op allocates
+void *operator new(size_t size) {
+  n_allocs.fetch_add(1, std::memory_order_relaxed);
+  n_bytes.fetch_add(size, std::memory_order_relaxed);
+  if (auto *p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace bench {
+size_t alloc_count() {
+  return n_allocs.load(std::memory_order_relaxed);
+}
+
+size_t alloc_bytes() {
+  return n_bytes.load(std::memory_order_relaxed);
+}
+
+session::session(int argc, char **argv) {
+  if (const auto *env = std::getenv("BENCH_SCALE")) {
+    scale = std::atof(env);
+  }
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--scale=", 8) == 0) {
+      scale = std::atof(argv[i] + 8);
+    } else if (std::strcmp(argv[i], "--no-gate") == 0) {
+      gate = false;
+    }
+  }
+  if (scale <= 0) {
+    scale = 1;
+  }
+  std::printf("%-40s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "bytes/op");
+}
+
+void session::record(result_t r, limit_t limit) {
+  const bool too_slow = limit.max_ns > 0 && r.ns_per_op > limit.max_ns * scale;
+  const bool too_fat  = r.bytes_per_op > limit.max_bytes;
+  std::printf("%-40s %12.1f %12.2f %12.1f", r.name, r.ns_per_op, r.allocs_per_op, r.bytes_per_op);
+  if (too_slow) {
+    std::printf("  > %.0f ns", limit.max_ns * scale);
+  }
+  if (too_fat) {
+    std::printf("  > %.0f bytes", limit.max_bytes);
+  }
+  std::printf("\n");
+  if (too_slow || too_fat) {
+    n_failed += 1;
+  }
+}
+
+void session::note(const char *name, double value, const char *unit) {
+  std::printf("%-40s %12.3f %s\n", name, value, unit);
+}
+
+void session::note(const char *name, double value, const char *unit, double max) {
+  std::printf("%-40s %12.3f %s", name, value, unit);
+  if (value > max) {
+    std::printf("  > %.3f", max);
+    n_failed += 1;
+  }
+  std::printf("\n");
+}
+
+int session::finish() const {
+  if (n_failed == 0) {
+    return 0;
+  }
+  std::fprintf(stderr, "%zu figures over the limit%s\n", n_failed, gate ? "" : " (not gated)");
+  return gate ? 1 : 0;
+}
+}
@@ -0,0 +1,134 @@
+#ifndef BLE_LORA_ADAPTER_TEST_BENCH_H
+#define BLE_LORA_ADAPTER_TEST_BENCH_H
+
+/**
+ * @brief micro-benchmarks with a regression gate, for the host build
+ *
+ * @code
+ * int main(int argc, char **argv) {
+ *   auto s = bench::session{argc, argv};
+ *   s.run("hr_data::marshal", {.max_ns = 200}, [&] { ... });
+ *   return s.finish();
+ * }
+ * @endcode
+ *
+ * Each benchmark reports ns/op and heap allocations (count and bytes) per op.
+ * `finish` fails if an op is slower than its `limit_t::max_ns`, or allocates
+ * more than `limit_t::max_bytes`. The time limits are meant to catch an
+ * order of magnitude (an allocation or a quadratic loop sneaking into a hot
+ * path) on any reasonable machine, and could be scaled with `--scale=<x>`
+ * (or `BENCH_SCALE`) for a slow one; `--no-gate` only reports.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace bench {
+/**
+ * @brief the allocations since the program started, counted by the global
+ *        `operator new` in `bench.cpp`
+ */
+size_t alloc_count();
+size_t alloc_bytes();
+
+/**
+ * @brief keep `value` from being optimized away
+ */
+template <typename T>
+inline void do_not_optimize(T const &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber() {
+  asm volatile("" : : : "memory");
+}
+
+struct limit_t {
+  /**
+   * @brief in nanoseconds per op, before scaling; 0 for no limit
+   */
+  double max_ns = 0;
+  /**
+   * @brief heap bytes allocated per op
+   */
+  double max_bytes = 0;
+};
+
+struct result_t {
+  const char *name     = nullptr;
+  double ns_per_op     = 0;
+  double allocs_per_op = 0;
+  double bytes_per_op  = 0;
+};
+
+class session {
+  double scale    = 1;
+  bool gate       = true;
+  size_t n_failed = 0;
+
+  template <typename F>
+  static double time_batch(size_t n, F &fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; ++i) {
+      fn();
+      clobber();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+  }
+
+  void record(result_t r, limit_t limit);
+
+public:
+  session(int argc, char **argv);
+
+  /**
+   * @brief measure `fn`, which does one op per call
+   * @note the best of a few batches of at least 10 ms each, to be robust to noise
+   */
+  template <typename F>
+  result_t run(const char *name, limit_t limit, F &&fn) {
+    constexpr double min_batch_ns = 10e6;
+    constexpr int batches         = 5;
+    size_t n                      = 1;
+    // warm up and calibrate
+    while (time_batch(n, fn) < min_batch_ns && n < (size_t{1} << 30)) {
+      n *= 2;
+    }
+    double best             = 0;
+    const auto allocs_start = alloc_count();
+    const auto bytes_start  = alloc_bytes();
+    for (int b = 0; b < batches; ++b) {
+      const auto ns = time_batch(n, fn) / static_cast<double>(n);
+      best          = b == 0 || ns < best ? ns : best;
+    }
+    const auto ops = static_cast<double>(n) * batches;
+    auto r         = result_t{
+                .name          = name,
+                .ns_per_op     = best,
+                .allocs_per_op = static_cast<double>(alloc_count() - allocs_start) / ops,
+                .bytes_per_op  = static_cast<double>(alloc_bytes() - bytes_start) / ops,
+    };
+    record(r, limit);
+    return r;
+  }
+
+  /**
+   * @brief a figure that is not a timing (e.g. bytes per sample), printed along
+   */
+  void note(const char *name, double value, const char *unit);
+
+  /**
+   * @brief a figure that is not a timing, gated by `max`
+   */
+  void note(const char *name, double value, const char *unit, double max);
+
+  /**
+   * @return the exit code
+   */
+  int finish() const;
+};
+}
+
+#endif // BLE_LORA_ADAPTER_TEST_BENCH_H
@@ -0,0 +1,51 @@
+#ifndef BLE_LORA_ADAPTER_TEST_CHECK_H
+#define BLE_LORA_ADAPTER_TEST_CHECK_H
+
+/**
+ * @brief a minimal test harness for the host build
+ *
+ * @code
+ * TEST(round_trip) {
+ *   REQUIRE(sz > 0);
+ *   CHECK(res->hr == 60);
+ * }
+ * @endcode
+ *
+ * `CHECK` records a failure and goes on; `REQUIRE` records it and leaves the
+ * test. Linked with `check_main.cpp`, which runs every test and exits with
+ * non-zero if any of them failed.
+ */
+
+#include <cstddef>
+
+namespace test {
+using fn_t = void (*)();
+
+struct registrar {
+  registrar(const char *name, fn_t fn);
+};
+
+void fail(const char *file, int line, const char *expr);
+}
+
+#define TEST(name)                                                \
+  static void name();                                             \
+  static const ::test::registrar name##_registrar{#name, &name}; \
+  static void name()
+
+#define CHECK(expr)                                \
+  do {                                             \
+    if (!(expr)) {                                 \
+      ::test::fail(__FILE__, __LINE__, #expr);     \
+    }                                              \
+  } while (0)
+
+#define REQUIRE(expr)                              \
+  do {                                             \
+    if (!(expr)) {                                 \
+      ::test::fail(__FILE__, __LINE__, #expr);     \
+      return;                                      \
+    }                                              \
+  } while (0)
+
+#endif // BLE_LORA_ADAPTER_TEST_CHECK_H
@@ -0,0 +1,54 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "check.h"
+
+namespace test {
+namespace {
+  struct case_t {
+    const char *name;
+    fn_t fn;
+  };
+
+  std::vector<case_t> &cases() {
+    static auto v = std::vector<case_t>{};
+    return v;
+  }
+
+  size_t failures = 0;
+}
+
+registrar::registrar(const char *name, fn_t fn) {
+  cases().push_back(case_t{.name = name, .fn = fn});
+}
+
+void fail(const char *file, int line, const char *expr) {
+  failures += 1;
+  std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+}
+}
+
+/**
+ * @brief run every test, or only those whose name contains `argv[1]`
+ */
+int main(int argc, char **argv) {
+  const char *filter = argc > 1 ? argv[1] : nullptr;
+  size_t n_run       = 0;
+  size_t n_failed    = 0;
+  for (const auto &c : test::cases()) {
+    if (filter != nullptr && std::strstr(c.name, filter) == nullptr) {
+      continue;
+    }
+    const auto before = test::failures;
+    c.fn();
+    n_run += 1;
+    if (test::failures != before) {
+      n_failed += 1;
+      std::fprintf(stderr, "[FAIL] %s\n", c.name);
+    } else {
+      std::printf("[ OK ] %s\n", c.name);
+    }
+  }
+  std::printf("%zu tests, %zu failed\n", n_run, n_failed);
+  return n_failed == 0 && n_run > 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/**
+ * @brief a stand-in for libFuzzer's driver, for compilers without `-fsanitize=fuzzer`
+ *
+ * Takes the same arguments as libFuzzer for what it does:
+ *
+ *     <target> [-runs=N] [-seed=S] [-max_len=L] [corpus dir or file]...
+ *
+ * Every file in the corpus is run once, then `N` inputs mutated from them
+ * (random bytes if there's none). Each input is copied into a buffer of
+ * exactly its size, so that an over-read is caught by AddressSanitizer.
+ * It's a smoke test in CI, not a replacement of a coverage guided fuzzer.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+using bytes_t = std::vector<uint8_t>;
+
+void run_one(const bytes_t &input) {
+  // exactly sized, so that reading past the end is caught
+  auto buf = std::make_unique<uint8_t[]>(input.size());
+  std::copy(input.begin(), input.end(), buf.get());
+  LLVMFuzzerTestOneInput(buf.get(), input.size());
+}
+
+void load(const std::filesystem::path &path, std::vector<bytes_t> &corpus) {
+  if (std::filesystem::is_directory(path)) {
+    for (const auto &entry : std::filesystem::directory_iterator(path)) {
+      if (entry.is_regular_file()) {
+        load(entry.path(), corpus);
+      }
+    }
+    return;
+  }
+  auto f = std::ifstream(path, std::ios::binary);
+  if (!f) {
+    std::fprintf(stderr, "can't read %s\n", path.c_str());
+    std::exit(2);
+  }
+  corpus.emplace_back(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+bytes_t mutate(bytes_t in, std::mt19937 &rng, size_t max_len) {
+  auto pick            = [&](size_t n) { return std::uniform_int_distribution<size_t>(0, n - 1)(rng); };
+  const auto n_mutants = 1 + pick(4);
+  for (size_t m = 0; m < n_mutants; ++m) {
+    switch (pick(7)) {
+    case 0:
+      if (!in.empty()) {
+        in[pick(in.size())] ^= static_cast<uint8_t>(1 << pick(8));
+      }
+      break;
+    case 1:
+      if (!in.empty()) {
+        in[pick(in.size())] = static_cast<uint8_t>(pick(256));
+      }
+      break;
+    case 2:
+      // an "interesting" byte
+      if (!in.empty()) {
+        constexpr uint8_t interesting[] = {0x00, 0x01, 0x0f, 0x10, 0x7f, 0x80, 0xff};
+        in[pick(in.size())]             = interesting[pick(sizeof(interesting))];
+      }
+      break;
+    case 3:
+      in.insert(in.begin() + static_cast<ptrdiff_t>(pick(in.size() + 1)), static_cast<uint8_t>(pick(256)));
+      break;
+    case 4:
+      if (!in.empty()) {
+        in.erase(in.begin() + static_cast<ptrdiff_t>(pick(in.size())));
+      }
+      break;
+    case 5:
+      if (!in.empty()) {
+        in.resize(pick(in.size()));
+      }
+      break;
+    default:
+      // a copy of a chunk somewhere else
+      if (!in.empty()) {
+        const auto from = pick(in.size());
+        const auto len  = 1 + pick(in.size() - from);
+        const auto to   = pick(in.size() + 1);
+        auto chunk      = bytes_t(in.begin() + static_cast<ptrdiff_t>(from),
+                                  in.begin() + static_cast<ptrdiff_t>(from + len));
+        in.insert(in.begin() + static_cast<ptrdiff_t>(to), chunk.begin(), chunk.end());
+      }
+      break;
+    }
+  }
+  if (in.size() > max_len) {
+    in.resize(max_len);
+  }
+  return in;
+}
+}
+
+int main(int argc, char **argv) {
+  size_t runs    = 100'000;
+  uint32_t seed  = 1;
+  size_t max_len = 256;
+  auto corpus    = std::vector<bytes_t>{};
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "-runs=", 6) == 0) {
+      runs = std::strtoull(argv[i] + 6, nullptr, 10);
+    } else if (std::strncmp(argv[i], "-seed=", 6) == 0) {
+      seed = static_cast<uint32_t>(std::strtoul(argv[i] + 6, nullptr, 10));
+    } else if (std::strncmp(argv[i], "-max_len=", 9) == 0) {
+      max_len = std::strtoull(argv[i] + 9, nullptr, 10);
+    } else if (argv[i][0] == '-') {
+      // other libFuzzer flags are accepted and ignored
+      continue;
+    } else {
+      load(argv[i], corpus);
+    }
+  }
+
+  for (const auto &input : corpus) {
+    run_one(input);
+  }
+  auto rng = std::mt19937{seed};
+  for (size_t i = 0; i < runs; ++i) {
+    bytes_t input;
+    if (corpus.empty() || rng() % 8 == 0) {
+      input.resize(rng() % (max_len + 1));
+      for (auto &b : input) {
+        b = static_cast<uint8_t>(rng());
+      }
+    } else {
+      input = mutate(corpus[rng() % corpus.size()], rng, max_len);
+    }
+    run_one(input);
+  }
+  std::printf("%zu corpus inputs and %zu mutations done\n", corpus.size(), runs);
+  return 0;
+}
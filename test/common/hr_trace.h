@@ -0,0 +1,88 @@
+#ifndef BLE_LORA_ADAPTER_TEST_HR_TRACE_H
+#define BLE_LORA_ADAPTER_TEST_HR_TRACE_H
+
+/**
+ * @brief heart rate traces for the benchmarks and the simulation
+ *
+ * A recording could be loaded with `load_csv`; `synthetic` is a stand-in
+ * shaped like what a chest strap reports during a session (rest, a ramp up,
+ * a plateau with intervals, recovery), with beat to beat noise.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace hr_trace {
+/**
+ * @return a heart rate (bpm) per second
+ */
+inline std::vector<uint8_t> synthetic(size_t seconds, uint32_t seed = 1) {
+  auto rng   = std::mt19937{seed};
+  auto noise = std::normal_distribution<double>{0, 0.8};
+  auto out   = std::vector<uint8_t>{};
+  out.reserve(seconds);
+  double hr = 62;
+  for (size_t t = 0; t < seconds; ++t) {
+    const double phase = static_cast<double>(t) / static_cast<double>(seconds);
+    double target      = 62;
+    if (phase < 0.15) {
+      target = 62;
+    } else if (phase < 0.3) {
+      target = 62 + (phase - 0.15) / 0.15 * 88;
+    } else if (phase < 0.75) {
+      // intervals of 2 min hard and 1 min easy
+      target = t % 180 < 120 ? 165 : 135;
+    } else {
+      target = 70 + 80 * std::exp(-(phase - 0.75) * 20);
+    }
+    // the heart follows with a lag of ~20 s
+    hr += (target - hr) / 20 + noise(rng);
+    out.push_back(static_cast<uint8_t>(std::clamp(hr, 30.0, 230.0)));
+  }
+  return out;
+}
+
+/**
+ * @return the RR intervals (in 1/1024 s) of the beats in `hr`, with heart
+ *         rate variability that shrinks as the heart rate goes up
+ */
+inline std::vector<uint16_t> rr_of(const std::vector<uint8_t> &hr, uint32_t seed = 1) {
+  auto rng = std::mt19937{seed};
+  auto out = std::vector<uint16_t>{};
+  for (const auto bpm : hr) {
+    const double mean = 60.0 * 1024 / bpm;
+    auto jitter       = std::normal_distribution<double>{0, 40.0 * 60 / bpm};
+    // the beats in this second
+    const auto n      = std::max<size_t>(1, static_cast<size_t>(std::lround(bpm / 60.0)));
+    for (size_t i = 0; i < n; ++i) {
+      out.push_back(static_cast<uint16_t>(std::clamp(mean + jitter(rng), 200.0, 4000.0)));
+    }
+  }
+  return out;
+}
+
+/**
+ * @brief one heart rate per line (the first column, if there're more);
+ *        lines that don't start with a number are skipped
+ */
+inline std::vector<uint8_t> load_csv(const std::string &path) {
+  auto f   = std::ifstream(path);
+  auto out = std::vector<uint8_t>{};
+  for (std::string line; std::getline(f, line);) {
+    char *end     = nullptr;
+    const auto hr = std::strtol(line.c_str(), &end, 10);
+    if (end != line.c_str() && hr > 0 && hr < 256) {
+      out.push_back(static_cast<uint8_t>(hr));
+    }
+  }
+  return out;
+}
+}
+
+#endif // BLE_LORA_ADAPTER_TEST_HR_TRACE_H
@@ -0,0 +1,61 @@
+/**
+ * @brief `delta_codec::decode` and `delta_codec::decode16`
+ *
+ * The first byte picks the flavour (bit 7) and the count (the rest, plus
+ * one); the others are the encoded series. Whatever decodes should encode
+ * within `max_size` and decode to the same values again.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include "delta_codec.tpp"
+
+namespace {
+using namespace HrLoRa;
+
+template <typename T, auto encoded_size, auto max_size, auto encode, auto decode>
+void check(const uint8_t *in, size_t in_size, size_t count) {
+  // exactly sized, so that writing past `count` is caught
+  auto values   = std::make_unique<T[]>(count);
+  const auto sz = decode(in, in_size, values.get(), count);
+  if (sz > in_size) {
+    std::abort();
+  }
+  if (sz == 0) {
+    return;
+  }
+  const auto need = encoded_size(values.get(), count);
+  if (need > max_size(count)) {
+    std::abort();
+  }
+  auto out = std::make_unique<uint8_t[]>(need);
+  if (encode(values.get(), count, out.get(), need) != need) {
+    std::abort();
+  }
+  auto again = std::make_unique<T[]>(count);
+  if (decode(out.get(), need, again.get(), count) != need) {
+    std::abort();
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (again[i] != values[i]) {
+      std::abort();
+    }
+  }
+}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 1) {
+    return 0;
+  }
+  const auto count = static_cast<size_t>(data[0] & 0x7f) + 1;
+  if (data[0] & 0x80) {
+    check<uint16_t, delta_codec::encoded_size16, delta_codec::max_size16,
+          delta_codec::encode16, delta_codec::decode16>(data + 1, size - 1, count);
+  } else {
+    check<uint8_t, delta_codec::encoded_size, delta_codec::max_size,
+          delta_codec::encode, delta_codec::decode>(data + 1, size - 1, count);
+  }
+  return 0;
+}
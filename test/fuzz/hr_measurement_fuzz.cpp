@@ -0,0 +1,48 @@
+/**
+ * @brief `blue::hr_measurement::parse`
+ *
+ * What's parsed is written back as a notification (without the dropped RR
+ * intervals and a trailing odd byte) and should parse to the same again.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <vector>
+#include "hr_measurement.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  using namespace blue::hr_measurement;
+  auto r = t{};
+  if (!parse(std::span<const uint8_t>{data, size}, r)) {
+    return 0;
+  }
+  if (r.rr_count > MAX_RR_COUNT) {
+    std::abort();
+  }
+  const auto flags = data[0];
+  auto out         = std::vector<uint8_t>{flags};
+  auto le          = [&](uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+  };
+  if (flags & flag::HR_FORMAT_U16) {
+    le(r.hr);
+  } else {
+    out.push_back(static_cast<uint8_t>(r.hr));
+  }
+  if (flags & flag::ENERGY_EXPENDED) {
+    le(r.energy_expended);
+  }
+  for (const auto v : r.rr_intervals()) {
+    le(v);
+  }
+  auto again = t{};
+  if (!parse(out, again) || again.hr != r.hr || again.contact != r.contact ||
+      again.has_energy_expended != r.has_energy_expended ||
+      again.energy_expended != r.energy_expended || again.rr_count != r.rr_count ||
+      again.rr != r.rr || again.rr_dropped != 0) {
+    std::abort();
+  }
+  return 0;
+}
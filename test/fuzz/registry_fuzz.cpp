@@ -0,0 +1,91 @@
+/**
+ * @brief every `unmarshal` of the messages in `HrLoRa::hr_lora_msg::modules`,
+ *        through `registry::dispatch` and `registry::unmarshal`
+ *
+ * What's decoded is touched byte by byte (so that a view borrowing past the
+ * frame is caught by AddressSanitizer), marshalled again and decoded again,
+ * which should always succeed.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include "hr_lora.h"
+
+namespace {
+using namespace HrLoRa;
+
+uint8_t sink = 0;
+
+void touch(std::span<const uint8_t> bytes) {
+  for (const auto b : bytes) {
+    sink ^= b;
+  }
+}
+
+void touch(std::string_view s) {
+  touch(std::span<const uint8_t>{reinterpret_cast<const uint8_t *>(s.data()), s.size()});
+}
+
+template <typename V>
+void touch_view(const V &v) {
+  if constexpr (requires { v.payload; }) {
+    touch(std::span<const uint8_t>{v.payload.data(), v.payload.size()});
+  }
+  if constexpr (requires { v.device; }) {
+    if (v.device) {
+      touch(v.device->name);
+    }
+  }
+}
+
+/**
+ * @brief marshal what's decoded and decode it again
+ */
+template <typename M>
+void round_trip(std::span<const uint8_t> frame) {
+  if (frame[0] != M::magic) {
+    return;
+  }
+  const auto v = M::unmarshal_view(frame);
+  const auto t = M::unmarshal(frame.data(), frame.size());
+  // the owning and the borrowing decoder agree
+  if (v.has_value() != t.has_value()) {
+    std::abort();
+  }
+  if (!v) {
+    return;
+  }
+  touch_view(*v);
+  uint8_t buf[512];
+  const auto sz = M::marshal(*v, std::span<uint8_t>{buf});
+  if (sz == 0 || !M::unmarshal_view(std::span<const uint8_t>{buf, sz})) {
+    std::abort();
+  }
+}
+
+template <typename... Ms>
+void round_trip_all(registry<Ms...> *, std::span<const uint8_t> frame) {
+  (round_trip<Ms>(frame), ...);
+}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  using modules    = hr_lora_msg::modules;
+  const auto frame = std::span<const uint8_t>{data, size};
+
+  auto handler     = [](const auto &v) { touch_view(v); };
+  const auto res   = modules::dispatch(frame, handler);
+  const auto owned = modules::unmarshal(data, size);
+  // the magic byte dispatch and the variant one agree
+  if ((res == dispatch_result::ok) != owned.has_value()) {
+    std::abort();
+  }
+  if (res == dispatch_result::unknown_magic && size > 0 && modules::contains(data[0])) {
+    std::abort();
+  }
+  if (!frame.empty()) {
+    round_trip_all(static_cast<modules *>(nullptr), frame);
+  }
+  return 0;
+}
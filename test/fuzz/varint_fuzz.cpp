@@ -0,0 +1,33 @@
+/**
+ * @brief `delta_codec::read_varint`
+ *
+ * A varint that is read should be exactly what `write_varint` writes for its
+ * value, since the overlong and the padded ones are rejected.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include "delta_codec.tpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  using namespace HrLoRa;
+  uint32_t value = 0;
+  const auto sz  = delta_codec::read_varint(data, size, value);
+  if (sz > size || sz > 5) {
+    std::abort();
+  }
+  if (sz == 0) {
+    return 0;
+  }
+  uint8_t out[5] = {0};
+  if (delta_codec::write_varint(value, out, sizeof(out)) != sz ||
+      delta_codec::varint_size(value) != sz) {
+    std::abort();
+  }
+  for (size_t i = 0; i < sz; ++i) {
+    if (out[i] != data[i]) {
+      std::abort();
+    }
+  }
+  return 0;
+}
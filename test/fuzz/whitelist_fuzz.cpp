@@ -0,0 +1,38 @@
+/**
+ * @brief `white_list::unmarshal_white_list` and `white_list::unmarshal_while_list_request`
+ *
+ * A list that is decoded should be marshalled and decoded again to the same
+ * number of entries.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <pb_decode.h>
+#include <pb_encode.h>
+#include "whitelist.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  auto istream   = pb_istream_from_buffer(data, size);
+  ::WhiteList pb = WhiteList_init_zero;
+  auto list      = white_list::unmarshal_white_list(&istream, pb);
+  if (list) {
+    uint8_t buf[1024];
+    auto ostream       = pb_ostream_from_buffer(buf, sizeof(buf));
+    ::WhiteList pb_out = WhiteList_init_zero;
+    // a list too long for the buffer is fine, a list that can't be decoded again is not
+    if (white_list::marshal_white_list(&ostream, pb_out, *list)) {
+      auto again_stream = pb_istream_from_buffer(buf, ostream.bytes_written);
+      ::WhiteList pb_in = WhiteList_init_zero;
+      const auto again  = white_list::unmarshal_white_list(&again_stream, pb_in);
+      if (!again || again->size() != list->size()) {
+        std::abort();
+      }
+    }
+  }
+
+  auto request_stream       = pb_istream_from_buffer(data, size);
+  ::WhiteListRequest request = WhiteListRequest_init_zero;
+  const auto req             = white_list::unmarshal_while_list_request(&request_stream, request);
+  (void)req;
+  return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * @brief `handle_message` with the callbacks of a repeater bridging two devices
+ */
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "check.h"
+#include "handle_message.h"
+#include "hr_lora.h"
+
+namespace {
+using bytes_t = std::vector<uint8_t>;
+
+constexpr auto SELF   = HrLoRa::addr_t{0x24, 0x0a, 0xc4, 0x00, 0x00, 0x01};
+constexpr auto DEV_A  = HrLoRa::addr_t{0xc0, 0x1d, 0x00, 0x00, 0x01, 0x00};
+constexpr auto DEV_B  = HrLoRa::addr_t{0xc0, 0x1d, 0x00, 0x00, 0x01, 0x01};
+constexpr auto OTHER  = HrLoRa::addr_t{0xc0, 0x1d, 0x00, 0x00, 0x02, 0x00};
+constexpr uint8_t KEY = 7;
+
+struct Repeater {
+  uint8_t key = KEY;
+  std::map<HrLoRa::addr_t, etl::optional<uint8_t>> devices{{DEV_A, etl::nullopt}, {DEV_B, uint8_t{3}}};
+  std::vector<bytes_t> sent;
+  handle_message_callbacks_t callbacks{
+      .schedule   = [this](uint8_t *data, size_t size, size_t) { sent.emplace_back(data, data + size); },
+      .get_device = []() -> etl::optional<HrLoRa::hr_device::t> {
+        return HrLoRa::hr_device::t{.addr = DEV_A, .name = "A"};
+      },
+      .find_device = [this](const HrLoRa::addr_t &addr) -> etl::optional<bridged_device_t> {
+        const auto it = devices.find(addr);
+        if (it == devices.end()) {
+          return etl::nullopt;
+        }
+        return bridged_device_t{.device = HrLoRa::hr_device::t{.addr = addr, .name = "B"}, .key = it->second};
+      },
+      .get_self_addr    = [] { return SELF; },
+      .set_name_map_key = [this](uint8_t k) { key = k; },
+      .get_name_map_key = [this] { return key; },
+      .set_device_key   = [this](const HrLoRa::addr_t &addr, uint8_t k) {
+        const auto it = devices.find(addr);
+        if (it == devices.end()) {
+          return false;
+        }
+        it->second = k;
+        return true;
+      },
+      .get_link_stats   = [] { return HrLoRa::link_stats::t{.rr_dropped = 5}; },
+      .on_gateway_frame = [] {},
+      .send_reliable    = [](const HrLoRa::addr_t &, std::span<const uint8_t>) {},
+      .accept_reliable  = [](const HrLoRa::addr_t &, uint8_t) { return true; },
+      .on_ack           = [](const HrLoRa::addr_t &, uint8_t) {},
+  };
+
+  void receive(bytes_t frame) {
+    handle_message(frame.data(), frame.size(), callbacks);
+  }
+};
+
+bytes_t query(const HrLoRa::addr_t &addr) {
+  auto buf = bytes_t(HrLoRa::query_device_by_mac::size_needed());
+  HrLoRa::query_device_by_mac::marshal(HrLoRa::query_device_by_mac::t{.addr = addr}, buf);
+  return buf;
+}
+
+TEST(the_repeater_answers_for_itself_with_the_first_device) {
+  auto r = Repeater{};
+  r.receive(query(SELF));
+  REQUIRE(r.sent.size() == 1);
+  const auto status = HrLoRa::repeater_status::unmarshal(r.sent[0].data(), r.sent[0].size());
+  REQUIRE(status && status->device);
+  CHECK(status->repeater_addr == SELF && status->key == KEY);
+  CHECK(status->device->addr == DEV_A);
+  REQUIRE(status->link);
+  CHECK(status->link->rr_dropped == 5);
+}
+
+TEST(a_device_answers_with_its_own_key) {
+  auto r = Repeater{};
+  r.receive(query(DEV_B));
+  REQUIRE(r.sent.size() == 1);
+  const auto status = HrLoRa::repeater_status::unmarshal(r.sent[0].data(), r.sent[0].size());
+  REQUIRE(status && status->device);
+  CHECK(status->repeater_addr == SELF && status->key == 3);
+  CHECK(status->device->addr == DEV_B);
+
+  // without a key of its own, it goes by the key of the repeater
+  r.receive(query(DEV_A));
+  REQUIRE(r.sent.size() == 2);
+  const auto keyless = HrLoRa::repeater_status::unmarshal(r.sent[1].data(), r.sent[1].size());
+  REQUIRE(keyless && keyless->device);
+  CHECK(keyless->key == KEY && keyless->device->addr == DEV_A);
+
+  r.receive(query(OTHER));
+  CHECK(r.sent.size() == 2);
+}
+
+TEST(setting_the_key_of_a_device_answers_with_that_device) {
+  auto r   = Repeater{};
+  auto buf = bytes_t(HrLoRa::set_name_map_key::size_needed());
+  HrLoRa::set_name_map_key::marshal(HrLoRa::set_name_map_key::t{.addr = DEV_A, .key = 9}, buf);
+  r.receive(buf);
+  CHECK(r.key == KEY);
+  REQUIRE(r.sent.size() == 1);
+  const auto status = HrLoRa::repeater_status::unmarshal(r.sent[0].data(), r.sent[0].size());
+  REQUIRE(status && status->device);
+  CHECK(status->key == 9 && status->device->addr == DEV_A);
+}
+
+TEST(a_key_for_another_repeater_changes_nothing) {
+  auto r   = Repeater{};
+  auto buf = bytes_t(HrLoRa::set_name_map_key::size_needed());
+  HrLoRa::set_name_map_key::marshal(HrLoRa::set_name_map_key::t{.addr = OTHER, .key = 9}, buf);
+  r.receive(buf);
+  CHECK(r.key == KEY);
+  CHECK(!r.devices.at(DEV_A) && *r.devices.at(DEV_B) == 3);
+  CHECK(r.sent.empty());
+
+  // addressed to the repeater itself, it's applied and answered
+  HrLoRa::set_name_map_key::marshal(HrLoRa::set_name_map_key::t{.addr = SELF, .key = 9}, buf);
+  r.receive(buf);
+  CHECK(r.key == 9);
+  CHECK(r.sent.size() == 1);
+}
+}
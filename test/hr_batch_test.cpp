@@ -0,0 +1,131 @@
+/**
+ * @brief `hr_batch` and its accumulator
+ */
+
+#include <cstdint>
+#include <span>
+#include "check.h"
+#include "hr_lora.h"
+
+namespace {
+using namespace HrLoRa;
+
+etl::optional<hr_batch::t> round_trip(const hr_batch::t &data) {
+  uint8_t buf[256] = {0};
+  const auto sz    = hr_batch::marshal(data, std::span<uint8_t>{buf});
+  if (sz == 0 || sz != hr_batch::size_needed(data)) {
+    return etl::nullopt;
+  }
+  return hr_batch::unmarshal(buf, sz);
+}
+
+TEST(ages_are_kept_to_the_unit) {
+  auto data = hr_batch::t{.key = 7};
+  data.samples.push_back(hr_batch::sample_t{.age = 12'345, .hr = 61});
+  data.samples.push_back(hr_batch::sample_t{.age = 11'339, .hr = 62});
+  data.samples.push_back(hr_batch::sample_t{.age = 9, .hr = 63});
+  const auto res = round_trip(data);
+  REQUIRE(res && res->samples.size() == 3);
+  // truncated to `age_unit_ms`
+  CHECK(res->samples[0].age == 12'340);
+  CHECK(res->samples[1].age == 11'330);
+  CHECK(res->samples[2].age == 0);
+  CHECK(res->samples[2].hr == 63);
+}
+
+TEST(out_of_order_ages_are_clamped) {
+  // a newer sample claiming to be older is sent as the same age as the previous
+  auto data = hr_batch::t{};
+  data.samples.push_back(hr_batch::sample_t{.age = 1'000, .hr = 60});
+  data.samples.push_back(hr_batch::sample_t{.age = 2'000, .hr = 60});
+  const auto res = round_trip(data);
+  REQUIRE(res && res->samples.size() == 2);
+  CHECK(res->samples[0].age == 1'000 && res->samples[1].age == 1'000);
+}
+
+TEST(saturated_age) {
+  auto data = hr_batch::t{};
+  data.samples.push_back(hr_batch::sample_t{.age = UINT16_MAX, .hr = 200});
+  const auto res = round_trip(data);
+  REQUIRE(res && res->samples.size() == 1);
+  CHECK(res->samples[0].age == UINT16_MAX / hr_batch::age_unit_ms * hr_batch::age_unit_ms);
+}
+
+TEST(a_full_batch_fits_a_slot_frame) {
+  // the worst case: the largest ages, every heart rate escaped
+  auto data = hr_batch::t{};
+  for (size_t i = 0; i < hr_batch::max_samples; ++i) {
+    data.samples.push_back(hr_batch::sample_t{.age = UINT16_MAX, .hr = static_cast<uint8_t>(i % 2 == 0 ? 30 : 220)});
+  }
+  CHECK(hr_batch::size_needed(data) <= 128);
+  CHECK(round_trip(data));
+}
+
+TEST(accumulator_flushes_on_count) {
+  auto acc = hr_batch::accumulator(4, 60'000);
+  CHECK(!acc.should_flush(0));
+  CHECK(!acc.push(60, 0));
+  CHECK(!acc.push(61, 1'000));
+  CHECK(!acc.push(62, 2'000));
+  CHECK(acc.push(63, 3'000));
+  const auto data = acc.take(9, 3'500);
+  CHECK(acc.empty() && !acc.should_flush(3'500));
+  REQUIRE(data.samples.size() == 4);
+  CHECK(data.key == 9);
+  CHECK(data.samples[0].age == 3'500 && data.samples[0].hr == 60);
+  CHECK(data.samples[3].age == 500 && data.samples[3].hr == 63);
+}
+
+TEST(accumulator_flushes_on_age) {
+  auto acc = hr_batch::accumulator(hr_batch::max_samples, 5'000);
+  CHECK(!acc.push(60, 10'000));
+  CHECK(!acc.should_flush(14'999));
+  CHECK(acc.should_flush(15'000));
+  // the clock wraps around
+  auto wrap = hr_batch::accumulator(hr_batch::max_samples, 5'000);
+  wrap.push(60, UINT32_MAX - 1'000);
+  CHECK(!wrap.should_flush(1'000));
+  CHECK(wrap.should_flush(4'000));
+}
+
+TEST(accumulator_caps_the_count) {
+  auto acc = hr_batch::accumulator(1'000, UINT32_MAX);
+  for (uint32_t i = 0; i < hr_batch::max_samples - 1; ++i) {
+    CHECK(!acc.push(60, i));
+  }
+  CHECK(acc.push(60, hr_batch::max_samples));
+}
+
+TEST(accumulator_drops_the_oldest_when_full) {
+  auto acc = hr_batch::accumulator(hr_batch::max_samples, UINT32_MAX);
+  for (uint32_t i = 0; i < hr_batch::max_samples + 3; ++i) {
+    acc.push(static_cast<uint8_t>(i), i * 1'000);
+  }
+  CHECK(acc.size() == hr_batch::max_samples);
+  CHECK(acc.dropped() == 3);
+  const auto data = acc.take(0, 100'000);
+  REQUIRE(data.samples.size() == hr_batch::max_samples);
+  CHECK(data.samples.front().hr == 3);
+  CHECK(data.samples.back().hr == hr_batch::max_samples + 2);
+}
+
+TEST(fewer_frames_than_hr_data) {
+  // a monitor notifying once a second, batched the way `app_main` does
+  // (flushed once a 16 s superframe), against a `hr_data` per notification
+  constexpr uint32_t minute_ms = 60'000;
+  auto acc                     = hr_batch::accumulator(hr_batch::max_samples, 16'000);
+  size_t n_frames              = 0;
+  size_t n_bytes               = 0;
+  for (uint32_t now = 0; now < 10 * minute_ms; now += 1'000) {
+    if (acc.push(static_cast<uint8_t>(70 + now / 7'000 % 5), now)) {
+      const auto data = acc.take(1, now);
+      n_frames += 1;
+      n_bytes += hr_batch::size_needed(data);
+    }
+  }
+  const auto hr_data_frames = 10 * minute_ms / 1'000;
+  CHECK(n_frames * 10 <= hr_data_frames);
+  // and not paid for with more bytes
+  CHECK(n_bytes < hr_data_frames * hr_data::size_needed());
+}
+}
@@ -0,0 +1,177 @@
+/**
+ * @brief the Heart Rate Measurement parser and the RR intervals it feeds to `hr_rr`
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "check.h"
+#include "hr_lora.h"
+#include "hr_measurement.h"
+
+namespace {
+using namespace blue;
+using bytes_t = std::vector<uint8_t>;
+
+/**
+ * @brief a notification as a monitor would send it
+ */
+bytes_t notification(uint8_t flags, uint16_t hr, uint16_t energy, const std::vector<uint16_t> &rr) {
+  auto out = bytes_t{flags};
+  auto le  = [&](uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+  };
+  if (flags & hr_measurement::flag::HR_FORMAT_U16) {
+    le(hr);
+  } else {
+    out.push_back(static_cast<uint8_t>(hr));
+  }
+  if (flags & hr_measurement::flag::ENERGY_EXPENDED) {
+    le(energy);
+  }
+  if (flags & hr_measurement::flag::RR_INTERVAL) {
+    for (const auto v : rr) {
+      le(v);
+    }
+  }
+  return out;
+}
+
+TEST(contact_not_detected) {
+  using namespace hr_measurement;
+  const auto d = notification(flag::SENSOR_CONTACT_SUPP, 80, 0, {});
+  auto r       = t{};
+  REQUIRE(parse(d, r));
+  CHECK(r.hr == 80 && r.contact == sensor_contact::not_detected && !r.has_energy_expended);
+}
+
+TEST(every_field) {
+  using namespace hr_measurement;
+  const auto d = notification(flag::HR_FORMAT_U16 | flag::SENSOR_CONTACT | flag::SENSOR_CONTACT_SUPP |
+                                  flag::ENERGY_EXPENDED | flag::RR_INTERVAL,
+                              301, 4'000, {700, 710, 3'000});
+  auto r       = t{};
+  REQUIRE(parse(d, r));
+  CHECK(r.hr == 301 && r.contact == sensor_contact::detected);
+  CHECK(r.has_energy_expended && r.energy_expended == 4'000);
+  REQUIRE(r.rr_count == 3);
+  CHECK(r.rr[0] == 700 && r.rr[1] == 710 && r.rr[2] == 3'000 && r.rr_dropped == 0);
+}
+
+TEST(truncated_mandatory_fields) {
+  using namespace hr_measurement;
+  const auto d = notification(flag::HR_FORMAT_U16 | flag::ENERGY_EXPENDED, 300, 10, {});
+  auto r       = t{};
+  for (size_t n = 0; n < d.size(); ++n) {
+    CHECK(!parse(std::span<const uint8_t>{d.data(), n}, r));
+  }
+  CHECK(parse(d, r));
+}
+
+TEST(rr_odd_byte_and_overflow) {
+  using namespace hr_measurement;
+  auto d = notification(flag::RR_INTERVAL, 60, 0, {1'000, 1'010});
+  d.push_back(0xaa);
+  auto r = t{};
+  REQUIRE(parse(d, r));
+  CHECK(r.rr_count == 2 && r.rr_dropped == 0);
+
+  auto many = std::vector<uint16_t>{};
+  for (size_t i = 0; i < MAX_RR_COUNT + 5; ++i) {
+    many.push_back(static_cast<uint16_t>(500 + i));
+  }
+  REQUIRE(parse(notification(flag::RR_INTERVAL, 120, 0, many), r));
+  CHECK(r.rr_count == MAX_RR_COUNT && r.rr_dropped == 5);
+  CHECK(r.rr[0] == 500 && r.rr[MAX_RR_COUNT - 1] == 500 + MAX_RR_COUNT - 1);
+}
+
+TEST(rr_flag_without_intervals) {
+  using namespace hr_measurement;
+  const auto d = notification(flag::RR_INTERVAL, 60, 0, {});
+  auto r       = t{};
+  CHECK(parse(d, r) && r.rr_count == 0);
+}
+
+TEST(rr_from_notifications_to_frame) {
+  // what `on_data` does with the notifications, and what the gateway gets
+  using namespace hr_measurement;
+  auto acc        = HrLoRa::hr_rr::accumulator(HrLoRa::hr_rr::max_rr, 16'000);
+  const auto sent = std::vector<std::vector<uint16_t>>{{820, 830}, {2'500}, {}, {815, 60'000, 1}};
+  auto expected   = std::vector<uint16_t>{};
+  uint32_t now    = 0;
+  for (const auto &rr : sent) {
+    auto r = t{};
+    REQUIRE(parse(notification(flag::RR_INTERVAL, 70, 0, rr), r));
+    CHECK(!acc.push(r.rr_intervals(), now));
+    expected.insert(expected.end(), rr.begin(), rr.end());
+    now += 1'000;
+  }
+  const auto data  = acc.take(3);
+  uint8_t buf[128] = {0};
+  const auto sz    = HrLoRa::hr_rr::marshal(data, buf, sizeof(buf));
+  const auto res   = HrLoRa::hr_rr::unmarshal(buf, sz);
+  REQUIRE(res);
+  CHECK(res->key == 3 && res->seq == 0);
+  // nothing quantized or clamped
+  CHECK(std::equal(res->rr.begin(), res->rr.end(), expected.begin(), expected.end()));
+}
+
+TEST(rr_accumulator) {
+  auto acc = HrLoRa::hr_rr::accumulator(4, 5'000);
+  CHECK(acc.empty() && !acc.should_flush(0));
+  const uint16_t three[] = {800, 810, 820};
+  CHECK(!acc.push(three, 1'000));
+  CHECK(!acc.should_flush(5'999) && acc.should_flush(6'000));
+  // `max_count` only tells when to flush; what's pushed is kept up to `max_rr`
+  CHECK(acc.push(three, 2'000));
+  CHECK(acc.dropped() == 0);
+  const auto first = acc.take(1);
+  CHECK(first.rr.size() == 6 && first.seq == 0);
+
+  // the frame is full only at `max_rr`
+  auto full = HrLoRa::hr_rr::accumulator(HrLoRa::hr_rr::max_rr, UINT32_MAX);
+  for (size_t i = 0; i < HrLoRa::hr_rr::max_rr / 3 + 2; ++i) {
+    full.push(three, 0);
+  }
+  CHECK(full.dropped() == (HrLoRa::hr_rr::max_rr / 3 + 2) * 3 - HrLoRa::hr_rr::max_rr);
+  CHECK(full.take(1).rr.size() == HrLoRa::hr_rr::max_rr);
+}
+
+TEST(rr_frame_stays_within_max_size) {
+  // a steady beat at 220 bpm fills a frame of a superframe in a byte each
+  auto steady = HrLoRa::hr_rr::accumulator(HrLoRa::hr_rr::max_rr, UINT32_MAX);
+  for (size_t i = 0; i < HrLoRa::hr_rr::max_rr; ++i) {
+    const uint16_t rr[] = {static_cast<uint16_t>(279 + i % 3)};
+    steady.push(rr, 0);
+  }
+  CHECK(steady.dropped() == 0);
+  const auto frame = steady.take(1);
+  CHECK(frame.rr.size() == HrLoRa::hr_rr::max_rr);
+  CHECK(HrLoRa::hr_rr::size_needed(frame) <= HrLoRa::hr_rr::header_size + 2 + HrLoRa::hr_rr::max_rr);
+
+  // differences of three bytes each would overflow it, so the last are dropped
+  auto erratic        = HrLoRa::hr_rr::accumulator(HrLoRa::hr_rr::max_rr, UINT32_MAX);
+  const uint16_t rr[] = {200, 20'000};
+  for (size_t i = 0; i < HrLoRa::hr_rr::max_rr / 2; ++i) {
+    erratic.push(rr, 0);
+  }
+  CHECK(erratic.dropped() > 0);
+  const auto capped = erratic.take(1);
+  CHECK(capped.rr.size() + erratic.dropped() == HrLoRa::hr_rr::max_rr);
+  CHECK(HrLoRa::hr_rr::size_needed(capped) <= HrLoRa::hr_rr::max_size);
+  uint8_t buf[HrLoRa::hr_rr::max_size] = {0};
+  CHECK(HrLoRa::hr_rr::marshal(capped, buf, sizeof(buf)) == HrLoRa::hr_rr::size_needed(capped));
+}
+
+TEST(rr_seq_wraps) {
+  auto acc             = HrLoRa::hr_rr::accumulator(1, 0);
+  const uint16_t one[] = {800};
+  uint8_t last         = 0;
+  for (int i = 0; i < 257; ++i) {
+    acc.push(one, 0);
+    last = acc.take(1).seq;
+  }
+  CHECK(last == 0);
+}
+}
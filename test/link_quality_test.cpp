@@ -0,0 +1,122 @@
+/**
+ * @brief `link_quality::Monitor`: the averages and the histograms of RSSI and
+ *        SNR, and the error counters next to them in `HrLoRa::link_stats`, as
+ *        `sim::Radio` counts them the way `radio::RadioTask` does
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "check.h"
+#include "hr_lora.h"
+#include "link_quality.h"
+#include "medium.h"
+#include "sim/radio.h"
+
+namespace {
+using HrLoRa::link_stats;
+using namespace sim;
+
+bool near(float a, float b) {
+  return std::fabs(a - b) < 1e-3f;
+}
+
+TEST(the_averages_follow_the_samples_by_alpha) {
+  auto m        = link_quality::Monitor{0.25f};
+  auto out      = link_stats::t{};
+  double rssi   = 0;
+  double snr    = 0;
+  bool first    = true;
+  const auto in = std::vector<std::pair<float, float>>{{-80, 9}, {-100, -3}, {-95, 0.5f}, {-70, 12}, {-112, -11}};
+  for (const auto &[r, s] : in) {
+    m.add(r, s);
+    // the first sample is taken as is, instead of being pulled towards 0
+    rssi  = first ? r : rssi + 0.25 * (r - rssi);
+    snr   = first ? s : snr + 0.25 * (s - snr);
+    first = false;
+    m.fill(out);
+    CHECK(near(out.rssi_avg_dbm, static_cast<float>(rssi)));
+    CHECK(near(out.snr_avg_db, static_cast<float>(snr)));
+  }
+}
+
+TEST(the_histograms_count_by_the_bucket_edges) {
+  auto m = link_quality::Monitor{};
+  // RSSI: below -120, [-120, -110), ... [-70, -60), and from -60 up
+  for (const float rssi : {-121.0f, -120.0f, -110.5f, -60.1f, -60.0f, -20.0f}) {
+    m.add(rssi, 0);
+  }
+  // SNR: below -15, [-15, -10), ... [10, 15), and from 15 up
+  for (const float snr : {-20.0f, -15.0f, 14.9f, 15.0f}) {
+    m.add(-90, snr);
+  }
+  auto out = link_stats::t{};
+  m.fill(out);
+  CHECK((out.rssi_hist == link_stats::histogram_t{1, 2, 0, 0, 4, 0, 1, 2}));
+  CHECK((out.snr_hist == link_stats::histogram_t{1, 1, 0, 0, 6, 0, 1, 1}));
+}
+
+TEST(a_full_bucket_halves_them_all) {
+  auto m = link_quality::Monitor{};
+  m.add(-115, -12);
+  m.add(-115, -12);
+  m.add(-115, -12);
+  for (uint32_t i = 0; i < UINT16_MAX; ++i) {
+    m.add(-50, 20);
+  }
+  auto out = link_stats::t{};
+  m.fill(out);
+  CHECK(out.rssi_hist[7] == UINT16_MAX && out.rssi_hist[1] == 3);
+  m.add(-50, 20);
+  m.fill(out);
+  CHECK(out.rssi_hist[7] == UINT16_MAX / 2 + 1);
+  CHECK(out.rssi_hist[1] == 1 && out.snr_hist[1] == 1);
+}
+
+TEST(fill_leaves_the_counters) {
+  auto m = link_quality::Monitor{};
+  m.add(-90, 5);
+  auto out = link_stats::t{.rx_ok = 3, .crc_err = 2, .header_err = 1, .tx_timeout = 4, .rr_dropped = 5};
+  m.fill(out);
+  CHECK(out.rx_ok == 3 && out.crc_err == 2 && out.header_err == 1);
+  CHECK(out.tx_timeout == 4 && out.rr_dropped == 5);
+  CHECK(near(out.rssi_avg_dbm, -90) && near(out.snr_avg_db, 5));
+}
+
+TEST(the_errors_are_counted_apart_from_the_average) {
+  auto world       = World{1};
+  auto medium      = Medium{world, medium_config_t{}};
+  auto clock       = LocalClock{world, 0, 0};
+  auto radio       = Radio{clock, medium, 0, 0, radio_config_t{}};
+  const auto frame = std::vector<uint8_t>{1, 2, 3};
+  auto rx          = [&](float rssi, float snr, rx_result result) {
+    radio.on_rx(rx_t{.src = 1, .data = frame, .rssi_dbm = rssi, .snr_db = snr, .result = result});
+  };
+  // a radio that is off hears nothing
+  rx(-90, 5, rx_result::ok);
+  CHECK(radio.link_stats().rx_ok == 0);
+
+  radio.power(true);
+  rx(-90, 5, rx_result::ok);
+  rx(-30, 20, rx_result::crc_error);
+  rx(-30, 20, rx_result::header_error);
+  rx(-30, 20, rx_result::crc_error);
+  rx(-100, -5, rx_result::ok);
+  const auto stats = radio.link_stats();
+  CHECK(stats.rx_ok == 2 && stats.crc_err == 2 && stats.header_err == 1);
+  // the frames lost don't weigh in the average, nor in the histograms
+  CHECK(near(stats.rssi_avg_dbm, -90 + 0.125f * (-100 + 90)));
+  CHECK(near(stats.snr_avg_db, 5 + 0.125f * (-5 - 5)));
+  CHECK(stats.rssi_hist[link_stats::rssi_bucket(-30)] == 0);
+  CHECK(stats.rssi_hist[link_stats::rssi_bucket(-90)] == 1);
+
+  // and they go over the air as counted
+  auto buf         = std::vector<uint8_t>(link_stats::size_needed(stats));
+  CHECK(link_stats::marshal(stats, buf.data(), buf.size()) == buf.size());
+  const auto wired = link_stats::unmarshal(buf.data(), buf.size());
+  REQUIRE(wired);
+  CHECK(wired->rx_ok == 2 && wired->crc_err == 2 && wired->header_err == 1);
+  CHECK(wired->rssi_hist == stats.rssi_hist && wired->snr_hist == stats.snr_hist);
+}
+}
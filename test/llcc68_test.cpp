@@ -0,0 +1,163 @@
+/**
+ * @brief the simulated LLCC68, driven with the bytes RadioLib would clock
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "llcc68.h"
+#include "medium.h"
+#include "radio_profile.h"
+#include "world.h"
+
+namespace {
+using namespace sim;
+using bytes = std::vector<uint8_t>;
+
+constexpr auto still = medium_config_t{.shadowing_db = 0, .fading_db = 0};
+
+constexpr uint8_t STATUS_BITS = 0x0e;
+
+uint8_t cmd_status_of(uint8_t status) {
+  return (status & STATUS_BITS) >> 1;
+}
+
+uint8_t mode_of(uint8_t status) {
+  return (status >> 4) & 0x07;
+}
+
+/**
+ * @brief a LoRa radio with the modulation of the default profile and a
+ *        `len` bytes long payload, with every IRQ on DIO1
+ */
+void setup(Llcc68 &chip, uint8_t len) {
+  constexpr auto steps = static_cast<uint32_t>(433.2e6 * (1 << 25) / 32e6);
+  chip.transfer(bytes{0x80, 0x00});
+  chip.transfer(bytes{0x8A, 0x01});
+  chip.transfer(bytes{0x86, steps >> 24, (steps >> 16) & 0xff, (steps >> 8) & 0xff, steps & 0xff});
+  // SF10, 500 kHz, 4/7
+  chip.transfer(bytes{0x8B, 0x0A, 0x06, 0x03, 0x00});
+  // 8 symbols of preamble, explicit header, CRC on
+  chip.transfer(bytes{0x8C, 0x00, 0x08, 0x00, len, 0x01, 0x00});
+  chip.transfer(bytes{0x8F, 0x00, 0x80});
+  chip.transfer(bytes{0x08, 0x03, 0xff, 0x03, 0xff, 0x00, 0x00, 0x00, 0x00});
+}
+
+uint16_t irq_status(Llcc68 &chip) {
+  const auto in = chip.transfer(bytes{0x12, 0x00, 0x00, 0x00});
+  return static_cast<uint16_t>(in[2] << 8 | in[3]);
+}
+
+void clear_irq(Llcc68 &chip) {
+  chip.transfer(bytes{0x02, 0x03, 0xff});
+}
+
+TEST(a_frame_is_transmitted_and_received) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto tx = Llcc68{world, medium, 0, 0}, rx = Llcc68{world, medium, 100, 0};
+  const auto payload = bytes{'h', 'e', 'l', 'l', 'o'};
+  setup(tx, static_cast<uint8_t>(payload.size()));
+  setup(rx, static_cast<uint8_t>(payload.size()));
+  int rx_interrupts = 0;
+  rx.on_dio1        = [&] { rx_interrupts += 1; };
+
+  // continuous RX
+  rx.transfer(bytes{0x82, 0xff, 0xff, 0xff});
+  CHECK(rx.get_mode() == Llcc68::mode::rx);
+  auto write = bytes{0x0E, 0x00};
+  write.insert(write.end(), payload.begin(), payload.end());
+  tx.transfer(write);
+  const auto status = tx.transfer(bytes{0x83, 0x00, 0x00, 0x00});
+  CHECK(cmd_status_of(status[0]) == 0);
+  CHECK(tx.get_mode() == Llcc68::mode::tx);
+  CHECK(!tx.dio1());
+
+  world.run_until(radio_profile::time_on_air_us(radio_profile::DEFAULT_PROFILE, payload.size()));
+  CHECK(tx.get_mode() == Llcc68::mode::stby_rc);
+  CHECK(tx.dio1());
+  CHECK(irq_status(tx) == Llcc68::TX_DONE);
+  clear_irq(tx);
+  CHECK(!tx.dio1());
+
+  REQUIRE(rx_interrupts == 1);
+  CHECK((irq_status(rx) & (Llcc68::RX_DONE | Llcc68::CRC_ERR)) == Llcc68::RX_DONE);
+  // still receiving
+  CHECK(rx.get_mode() == Llcc68::mode::rx);
+  const auto buffer_status = rx.transfer(bytes{0x13, 0x00, 0x00, 0x00});
+  REQUIRE(buffer_status[2] == payload.size());
+  CHECK(buffer_status[3] == 0x80);
+  auto read = bytes{0x1E, buffer_status[3], 0x00};
+  read.resize(read.size() + buffer_status[2]);
+  const auto in = rx.transfer(read);
+  CHECK((bytes{in.begin() + 3, in.end()} == payload));
+  const auto packet_status = rx.transfer(bytes{0x14, 0x00, 0x00, 0x00, 0x00});
+  // RSSI is -value/2 dBm
+  CHECK(packet_status[2] > 0);
+}
+
+TEST(the_version_string_is_in_the_registers) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto chip   = Llcc68{world, medium, 0, 0};
+  auto read   = bytes{0x1D, 0x03, 0x20, 0x00};
+  read.resize(read.size() + 16);
+  const auto in = chip.transfer(read);
+  CHECK(std::string(in.begin() + 4, in.begin() + 10) == "LLCC68");
+
+  chip.transfer(bytes{0x0D, 0x07, 0x40, 0x34, 0x44});
+  const auto sync = chip.transfer(bytes{0x1D, 0x07, 0x40, 0x00, 0x00, 0x00});
+  CHECK(sync[4] == 0x34);
+  CHECK(sync[5] == 0x44);
+}
+
+TEST(an_unknown_opcode_is_invalid) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto chip   = Llcc68{world, medium, 0, 0};
+  const auto in = chip.transfer(bytes{0x42, 0x00});
+  CHECK(cmd_status_of(in[0]) == static_cast<uint8_t>(Llcc68::cmd_status::invalid));
+  CHECK(mode_of(in[0]) == static_cast<uint8_t>(Llcc68::mode::stby_rc));
+  // and a TX with the packet type not set to LoRa fails
+  chip.transfer(bytes{0x83, 0x00, 0x00, 0x00});
+  CHECK(mode_of(chip.transfer(bytes{0xC0, 0x00})[1]) == static_cast<uint8_t>(Llcc68::mode::stby_rc));
+}
+
+TEST(cad_detects_a_transmission) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto tx = Llcc68{world, medium, 0, 0}, cad = Llcc68{world, medium, 100, 0};
+  setup(tx, 16);
+  setup(cad, 16);
+  // 2 symbols, exit to standby
+  cad.transfer(bytes{0x88, 0x01, 22, 10, 0x00, 0x00, 0x00, 0x00});
+  const auto t_sym = radio_profile::symbol_time_us(radio_profile::DEFAULT_PROFILE);
+
+  cad.transfer(bytes{0xC5});
+  world.run_until(world.now_us() + 4 * t_sym);
+  CHECK(irq_status(cad) == Llcc68::CAD_DONE);
+  clear_irq(cad);
+
+  tx.transfer(bytes{0x83, 0x00, 0x00, 0x00});
+  world.run_until(world.now_us() + t_sym);
+  cad.transfer(bytes{0xC5});
+  world.run_until(world.now_us() + 4 * t_sym);
+  CHECK(irq_status(cad) == (Llcc68::CAD_DONE | Llcc68::CAD_DETECTED));
+  CHECK(cad.get_mode() == Llcc68::mode::stby_rc);
+}
+
+TEST(a_single_rx_times_out) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto chip   = Llcc68{world, medium, 0, 0};
+  setup(chip, 16);
+  // 64000 steps of 15.625 us
+  chip.transfer(bytes{0x82, 0x00, 0xfa, 0x00});
+  world.run_until(999'000);
+  CHECK(!chip.dio1());
+  world.run_until(1'001'000);
+  CHECK(irq_status(chip) == Llcc68::TIMEOUT);
+  CHECK(chip.get_mode() == Llcc68::mode::stby_rc);
+}
+}
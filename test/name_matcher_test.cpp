@@ -0,0 +1,220 @@
+/**
+ * @brief `name_matcher` against `std::regex` (ECMAScript, `regex_search`) and
+ *        `fnmatch`, which it replaces
+ */
+
+#include <fnmatch.h>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "check.h"
+#include "name_matcher.h"
+#include "pattern_blob.h"
+
+namespace {
+using namespace name_matcher;
+
+bool matches(std::string_view pattern, std::string_view name) {
+  const auto m = compile(pattern);
+  return m.has_value() && m->matches(name);
+}
+
+bool regex_matches(const std::string &pattern, const std::string &name) {
+  return std::regex_search(name, std::regex{pattern, std::regex::ECMAScript});
+}
+
+/**
+ * @brief a random pattern of the subset, over a small alphabet so that it
+ *        matches often enough
+ */
+std::string random_pattern(std::mt19937 &rng) {
+  static constexpr const char *atoms[] = {
+      "a", "b", "0", "1", " ", "-", "\\.", ".", "\\d", "\\w", "\\s",
+      "[a-c]", "[^0-9]", "[ab_]", "[\\d-]", "[^ ]",
+  };
+  static constexpr const char *quantifiers[] = {"", "", "", "?", "*", "+"};
+  auto p = std::string{};
+  if (rng() % 2 == 0) {
+    p += '^';
+  }
+  const auto n = rng() % 8;
+  for (size_t i = 0; i < n; ++i) {
+    p += atoms[rng() % std::size(atoms)];
+    p += quantifiers[rng() % std::size(quantifiers)];
+  }
+  if (rng() % 2 == 0) {
+    p += '$';
+  }
+  return p;
+}
+
+std::string random_name(std::mt19937 &rng) {
+  // no line terminators, which `.` of ECMAScript doesn't match
+  static constexpr char alphabet[] = {'a', 'b', 'c', '0', '1', '9', ' ', '\t', '_', '-', '.', 'Z'};
+  auto s       = std::string{};
+  const auto n = rng() % 12;
+  for (size_t i = 0; i < n; ++i) {
+    s += alphabet[rng() % std::size(alphabet)];
+  }
+  return s;
+}
+
+TEST(same_as_std_regex) {
+  auto rng = std::mt19937{22};
+  for (int i = 0; i < 3'000; ++i) {
+    const auto pattern = random_pattern(rng);
+    const auto m       = compile(pattern);
+    REQUIRE(m.has_value());
+    const auto re = std::regex{pattern, std::regex::ECMAScript};
+    for (int j = 0; j < 20; ++j) {
+      const auto name = random_name(rng);
+      if (m->matches(name) != std::regex_search(name, re)) {
+        CHECK(!"mismatch");
+        std::fprintf(stderr, "pattern \"%s\", name \"%s\"\n", pattern.c_str(), name.c_str());
+        return;
+      }
+    }
+  }
+}
+
+TEST(real_names) {
+  struct case_t {
+    const char *pattern;
+    const char *name;
+  };
+  const case_t cases[] = {
+      {"^Polar H10 [0-9A-F]{8}$", "Polar H10 8A2B3C4D"},
+      {"^Polar", "Polar H10 8A2B3C4D"},
+      {"^Polar", "Polar OH1 12345678"},
+      {"H10", "Polar H10 8A2B3C4D"},
+      {"^HW\\d+", "HW706-0012345"},
+      {"^HW\\d+-\\d+$", "HW706-0012345"},
+      {"^HRM-Pro:\\d+$", "HRM-Pro:123456"},
+      {"^TICKR [0-9A-F]+$", "TICKR 1A2B"},
+      {"^COOSPO", "COOSPO H6 0123"},
+      {"^COOSPO", "coospo h6 0123"},
+      {"Heart\\s*Rate", "My HeartRate"},
+      {"Heart\\s*Rate", "Heart  Rate Band"},
+      {"[^\\w]$", "Wahoo TICKR!"},
+  };
+  for (const auto &c : cases) {
+    const auto m = compile(c.pattern);
+    if (!m) {
+      // counted repetition isn't supported; the rest should be
+      CHECK(std::string_view{c.pattern}.find('{') != std::string_view::npos);
+      continue;
+    }
+    CHECK(m->matches(c.name) == regex_matches(c.pattern, c.name));
+  }
+}
+
+TEST(literal_patterns_take_the_fast_path) {
+  CHECK(compile("^Polar H10")->get_kind() == kind::prefix);
+  CHECK(compile("8A2B$")->get_kind() == kind::suffix);
+  CHECK(compile("^HW706$")->get_kind() == kind::exact);
+  CHECK(compile("H10")->get_kind() == kind::contains);
+  // escaped metacharacters are literals too
+  CHECK(compile("^a\\.b")->get_kind() == kind::prefix);
+  CHECK(compile("^a.b")->get_kind() == kind::program);
+  // the fast path agrees with the program, checked by a pattern that's forced
+  // into the program with `[x]` instead of `x`
+  for (const auto name : {"Polar H10", "My Polar H10", "Polar", "", "H10 Polar"}) {
+    CHECK(matches("^Polar", name) == matches("^[P]olar", name));
+    CHECK(matches("H10$", name) == matches("[H]10$", name));
+    CHECK(matches("^Polar H10$", name) == matches("^[P]olar H10$", name));
+    CHECK(matches("lar", name) == matches("[l]ar", name));
+  }
+}
+
+TEST(longest_pattern) {
+  auto p = std::string(MAX_ATOMS, 'a');
+  CHECK(compile(p).has_value());
+  CHECK(compile("^" + p + "$").has_value());
+  CHECK(!compile(p + "a").has_value());
+  // the program path, at the size of the state bitset
+  auto q = std::string{};
+  for (size_t i = 0; i < MAX_ATOMS; ++i) {
+    q += "a?";
+  }
+  const auto m = compile("^" + q + "$");
+  REQUIRE(m.has_value());
+  CHECK(m->matches(std::string(MAX_ATOMS, 'a')));
+  CHECK(!m->matches(std::string(MAX_ATOMS + 1, 'a')));
+  CHECK(m->matches(""));
+}
+
+TEST(rejected_patterns) {
+  for (const auto p : {"(a)", "a|b", "a{2}", "*a", "+", "?a", "[a-", "[z-a]", "a\\", "a^b", "a$b", "a**"}) {
+    CHECK(!compile(p).has_value());
+  }
+}
+
+TEST(bytes_beyond_ascii) {
+  // UTF-8 names are matched byte by byte
+  CHECK(matches("^心率", "心率带 01"));
+  CHECK(matches("^.+01$", "心率带 01"));
+  CHECK(matches("[^a-z]", "\xff"));
+}
+
+TEST(same_as_fnmatch) {
+  const char *globs[] = {"Polar*", "*H10*", "HW?06*", "[!X]*", "[A-F]?", "*.1", "a[bc]d", "*", "?", ""};
+  const char *names[] = {"Polar H10", "My Polar H10", "HW706-1", "X.1", "a.1", "Bx", "abd", "acd", "aed", "", "a"};
+  for (const auto g : globs) {
+    const auto m = compile_glob(g);
+    REQUIRE(m.has_value());
+    for (const auto n : names) {
+      CHECK(m->matches(n) == (fnmatch(g, n, 0) == 0));
+    }
+  }
+}
+
+TEST(glob_escapes_regex_metacharacters) {
+  CHECK(compile_glob("a.b")->matches("a.b") && !compile_glob("a.b")->matches("axb"));
+  CHECK(compile_glob("a+b")->matches("a+b") && !compile_glob("a+b")->matches("aab"));
+  CHECK(compile_glob("(x)")->matches("(x)"));
+  CHECK(!compile_glob("[ab").has_value());
+}
+
+TEST(patterns_survive_the_blob) {
+  // what `ScanManager` saves to NVS and compiles again on boot
+  const std::string patterns[] = {"^Polar H10", "", "^HW\\d+-\\d+$", std::string(pattern_blob::MAX_PATTERN_SIZE, 'x')};
+  auto blob   = std::vector<uint8_t>(4 * (1 + pattern_blob::MAX_PATTERN_SIZE));
+  size_t size = 0;
+  for (const auto &p : patterns) {
+    size = pattern_blob::append(blob, size, p);
+    REQUIRE(size != 0);
+  }
+  blob.resize(size);
+  auto restored = std::vector<std::string>{};
+  REQUIRE(pattern_blob::for_each(blob, [&](std::string_view p) { restored.emplace_back(p); }));
+  REQUIRE(restored.size() == std::size(patterns));
+  for (size_t i = 0; i < restored.size(); ++i) {
+    CHECK(restored[i] == patterns[i]);
+  }
+  CHECK(matches(restored[2], "HW706-0012345"));
+  // too long to be stored
+  auto buf = std::vector<uint8_t>(128);
+  CHECK(pattern_blob::append(buf, 0, std::string(pattern_blob::MAX_PATTERN_SIZE + 1, 'x')) == 0);
+}
+
+TEST(malformed_pattern_blobs) {
+  size_t calls = 0;
+  auto count   = [&](std::string_view) { calls += 1; };
+  // truncated, in the first and the last pattern
+  const uint8_t truncated[] = {3, 'a', 'b'};
+  const uint8_t last[]      = {1, 'a', 2, 'b'};
+  // a length beyond the limit
+  auto oversized = std::vector<uint8_t>(2 + pattern_blob::MAX_PATTERN_SIZE, 'x');
+  oversized[0]   = pattern_blob::MAX_PATTERN_SIZE + 1;
+  CHECK(!pattern_blob::for_each(truncated, count));
+  CHECK(!pattern_blob::for_each(last, count));
+  CHECK(!pattern_blob::for_each(oversized, count));
+  // nothing is taken from a malformed blob
+  CHECK(calls == 0);
+  CHECK(pattern_blob::for_each(std::span<const uint8_t>{}, count) && calls == 0);
+}
+}
@@ -0,0 +1,98 @@
+/**
+ * @brief `power_model::sniff_timing`: a receiver that sleeps and wakes up by
+ *        it still hears enough of a `WAKE_PREAMBLE_LEN` preamble to detect it,
+ *        wherever in its cycle the preamble starts
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include "check.h"
+#include "common.h"
+#include "power_model.h"
+#include "radio_profile.h"
+
+namespace {
+using namespace power_model;
+
+constexpr auto MIN_SYMBOLS = config_t{}.min_symbols;
+
+/**
+ * @return whether an RX window of `s`, repeated from 0, overlaps a preamble
+ *         of `preamble_len` symbols started at `start_us` by `min_symbols`
+ */
+bool caught(const sniff_t &s, uint32_t t_sym, uint16_t preamble_len, uint16_t min_symbols, uint64_t start_us) {
+  const uint64_t period = s.rx_us + s.sleep_us;
+  const uint64_t end_us = start_us + uint64_t{t_sym} * preamble_len;
+  for (uint64_t w = start_us / period * period; w < end_us; w += period) {
+    const auto from = std::max(w, start_us);
+    const auto to   = std::min(w + s.rx_us, end_us);
+    if (to > from && to - from >= uint64_t{t_sym} * min_symbols) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @return the preambles missed, started every 1/8 symbol over a cycle
+ */
+uint32_t missed(const radio_profile::profile_t &p, uint16_t preamble_len, const sniff_t &s) {
+  const auto t_sym = radio_profile::symbol_time_us(p);
+  uint32_t n       = 0;
+  for (uint64_t start = 0; start < s.rx_us + s.sleep_us; start += std::max(t_sym / 8, uint32_t{1})) {
+    n += !caught(s, t_sym, preamble_len, MIN_SYMBOLS, start);
+  }
+  return n;
+}
+
+TEST(the_wake_preamble_is_caught_at_any_phase) {
+  for (const auto &p : radio_profile::PROFILES) {
+    const auto s = sniff_timing(p, common::WAKE_PREAMBLE_LEN, MIN_SYMBOLS);
+    CHECK(s.sleep_us > 0);
+    CHECK(missed(p, common::WAKE_PREAMBLE_LEN, s) == 0);
+  }
+  // and at the other end of the range, where the 1 ms margin is most of the window
+  auto slow   = radio_profile::DEFAULT_PROFILE;
+  slow.bw_khz = 125;
+  slow.sf     = 12;
+  auto fast   = radio_profile::DEFAULT_PROFILE;
+  fast.sf     = 5;
+  for (const auto &p : {slow, fast}) {
+    CHECK(missed(p, common::WAKE_PREAMBLE_LEN, sniff_timing(p, common::WAKE_PREAMBLE_LEN, MIN_SYMBOLS)) == 0);
+  }
+}
+
+TEST(any_preamble_long_enough_to_sleep_is_caught) {
+  for (uint16_t len = 2 * MIN_SYMBOLS; len <= 128; ++len) {
+    const auto s = sniff_timing(radio_profile::DEFAULT_PROFILE, len, MIN_SYMBOLS);
+    CHECK(missed(radio_profile::DEFAULT_PROFILE, len, s) == 0);
+  }
+}
+
+TEST(a_shorter_preamble_than_the_one_planned_for_is_missed) {
+  // the timing has no slack: the gateway must send the whole `WAKE_PREAMBLE_LEN`
+  const auto &p = radio_profile::DEFAULT_PROFILE;
+  const auto s  = sniff_timing(p, common::WAKE_PREAMBLE_LEN, MIN_SYMBOLS);
+  CHECK(missed(p, common::WAKE_PREAMBLE_LEN - 2, s) > 0);
+  CHECK(missed(p, p.preamble_len, s) > 0);
+}
+
+TEST(a_preamble_too_short_to_sleep_keeps_it_in_rx) {
+  const auto s = sniff_timing(radio_profile::DEFAULT_PROFILE, 2 * MIN_SYMBOLS - 1, MIN_SYMBOLS);
+  CHECK(s.sleep_us == 0);
+  CHECK(s.duty() == 1.0f);
+}
+
+TEST(sleeping_saves_what_the_duty_says) {
+  auto wake         = radio_profile::DEFAULT_PROFILE;
+  wake.preamble_len = common::WAKE_PREAMBLE_LEN;
+  const auto config = config_t{.tx_profile = radio_profile::DEFAULT_PROFILE, .rx_profile = wake};
+  const auto idle   = traffic_t{};
+  const auto d      = sniff_timing(wake, wake.preamble_len, config.min_symbols).duty();
+  CHECK(d > 0.1f && d < 0.2f);
+  const auto continuous = mah_per_day(rx_mode::continuous, config, idle);
+  const auto cycled     = mah_per_day(rx_mode::duty_cycled, config, idle);
+  CHECK(continuous > 110 && continuous < 111);
+  CHECK(cycled > continuous * d && cycled < continuous * d * 1.01f);
+}
+}
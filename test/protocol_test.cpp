@@ -0,0 +1,373 @@
+/**
+ * @brief round trips and hostile frames for every codec in `hr_lora.h`
+ */
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "check.h"
+#include "hr_lora.h"
+
+namespace {
+using namespace HrLoRa;
+using bytes_t = std::vector<uint8_t>;
+
+constexpr auto addr_a = addr_t{0xc0, 0x11, 0x22, 0x33, 0x44, 0x55};
+constexpr auto addr_b = addr_t{0xd0, 0x66, 0x77, 0x88, 0x99, 0xaa};
+
+template <typename M, typename T>
+bytes_t frame_of(const T &data) {
+  auto buf      = bytes_t(256);
+  const auto sz = M::marshal(data, std::span<uint8_t>{buf});
+  buf.resize(sz);
+  return buf;
+}
+
+template <typename M>
+auto view_of(const bytes_t &frame) {
+  return M::unmarshal_view(std::span<const uint8_t>{frame});
+}
+
+/**
+ * @brief every proper prefix of `frame` is rejected
+ */
+template <typename M>
+bool rejects_truncated(const bytes_t &frame) {
+  for (size_t n = 0; n < frame.size(); ++n) {
+    if (M::unmarshal_view(std::span<const uint8_t>{frame.data(), n}) ||
+        M::unmarshal(frame.data(), n)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief the frame with another magic is rejected
+ */
+template <typename M>
+bool rejects_wrong_magic(bytes_t frame) {
+  frame[0] ^= 0xff;
+  return !view_of<M>(frame) && !M::unmarshal(frame.data(), frame.size());
+}
+
+TEST(hr_data_round_trip) {
+  const auto frame = frame_of<hr_data>(hr_data::t{.key = 0x12, .hr = 0xc8});
+  REQUIRE(frame.size() == hr_data::size_needed());
+  const auto res = view_of<hr_data>(frame);
+  REQUIRE(res);
+  CHECK(res->key == 0x12 && res->hr == 0xc8);
+  CHECK(rejects_truncated<hr_data>(frame));
+  CHECK(rejects_wrong_magic<hr_data>(frame));
+}
+
+TEST(named_hr_data_round_trip) {
+  const auto frame = frame_of<named_hr_data>(named_hr_data::t{.key = 3, .hr = 61, .addr = addr_a});
+  REQUIRE(frame.size() == named_hr_data::size_needed());
+  const auto res = view_of<named_hr_data>(frame);
+  REQUIRE(res);
+  CHECK(res->key == 3 && res->hr == 61 && res->addr == addr_a);
+  CHECK(rejects_truncated<named_hr_data>(frame));
+  CHECK(rejects_wrong_magic<named_hr_data>(frame));
+}
+
+TEST(query_device_by_mac_round_trip) {
+  const auto frame = frame_of<query_device_by_mac>(query_device_by_mac::t{.addr = addr_b});
+  REQUIRE(frame.size() == query_device_by_mac::size_needed());
+  const auto res = view_of<query_device_by_mac>(frame);
+  REQUIRE(res);
+  CHECK(res->addr == addr_b);
+  CHECK(rejects_truncated<query_device_by_mac>(frame));
+  CHECK(rejects_wrong_magic<query_device_by_mac>(frame));
+}
+
+TEST(set_name_map_key_round_trip) {
+  const auto frame = frame_of<set_name_map_key>(set_name_map_key::t{.addr = addr_a, .key = 0x7e});
+  REQUIRE(frame.size() == set_name_map_key::size_needed());
+  const auto res = view_of<set_name_map_key>(frame);
+  REQUIRE(res);
+  CHECK(res->addr == addr_a && res->key == 0x7e);
+  CHECK(rejects_truncated<set_name_map_key>(frame));
+  CHECK(rejects_wrong_magic<set_name_map_key>(frame));
+}
+
+TEST(hr_device_round_trip) {
+  const auto frame = frame_of<hr_device>(hr_device::t{.addr = addr_a, .name = "Polar H10"});
+  REQUIRE(frame.size() == BLE_ADDR_SIZE + 9 + 1);
+  const auto res = view_of<hr_device>(frame);
+  REQUIRE(res);
+  CHECK(res->addr == addr_a && res->name == "Polar H10");
+  // the name ends at the end of the buffer when the terminator is missing
+  const auto no_terminator = bytes_t(frame.begin(), frame.end() - 3);
+  const auto cut           = view_of<hr_device>(no_terminator);
+  REQUIRE(cut);
+  CHECK(cut->name == "Polar H");
+  CHECK(!view_of<hr_device>(bytes_t(frame.begin(), frame.begin() + BLE_ADDR_SIZE - 1)));
+}
+
+link_stats::t sample_link_stats() {
+  auto data         = link_stats::t{.rssi_avg_dbm = -97, .snr_avg_db = 6.25f, .rx_ok = 123'456, .crc_err = 7};
+  data.tx_ok        = UINT32_MAX;
+  data.rssi_hist[2] = 300;
+  data.snr_hist[7]  = 1;
+  data.rr_dropped   = 1'000;
+  return data;
+}
+
+TEST(link_stats_round_trip) {
+  const auto data  = sample_link_stats();
+  const auto frame = frame_of<link_stats>(data);
+  REQUIRE(frame.size() == link_stats::size_needed(data));
+  const auto res = view_of<link_stats>(frame);
+  REQUIRE(res);
+  CHECK(res->rssi_avg_dbm == -97 && res->snr_avg_db == 6.25f);
+  CHECK(res->rx_ok == 123'456 && res->crc_err == 7 && res->tx_ok == UINT32_MAX);
+  CHECK(res->rssi_hist[2] == 300 && res->snr_hist[7] == 1);
+  CHECK(res->hr_dropped == 0 && res->rr_dropped == 1'000);
+  CHECK(rejects_truncated<link_stats>(frame));
+  // version 1 ends before the dropped samples
+  auto v1 = bytes_t(frame.begin(), frame.end() - 1 - 2);
+  v1[0]   = 1;
+  const auto old = view_of<link_stats>(v1);
+  REQUIRE(old);
+  CHECK(old->snr_hist[7] == 1 && old->rr_dropped == 0);
+  // version 0 never existed
+  auto v0 = frame;
+  v0[0]   = 0;
+  CHECK(!view_of<link_stats>(v0));
+}
+
+TEST(repeater_status_round_trip) {
+  const auto data = repeater_status::t{
+      .repeater_addr = addr_a,
+      .key           = 9,
+      .device        = hr_device::t{.addr = addr_b, .name = "HRM"},
+      .link          = sample_link_stats(),
+  };
+  const auto frame = frame_of<repeater_status>(data);
+  REQUIRE(frame.size() == repeater_status::size_needed(data));
+  const auto res = view_of<repeater_status>(frame);
+  REQUIRE(res && res->device && res->link);
+  CHECK(res->repeater_addr == addr_a && res->key == 9);
+  CHECK(res->device->addr == addr_b && res->device->name == "HRM");
+  CHECK(res->link->rx_ok == 123'456);
+  const auto owned = repeater_status::unmarshal(frame.data(), frame.size());
+  REQUIRE(owned && owned->device);
+  CHECK(owned->device->name == "HRM");
+  CHECK(rejects_wrong_magic<repeater_status>(frame));
+
+  const auto bare = frame_of<repeater_status>(repeater_status::t{.repeater_addr = addr_b, .key = 1});
+  CHECK(bare.size() == 1 + BLE_ADDR_SIZE + 1 + 1);
+  const auto bare_res = view_of<repeater_status>(bare);
+  REQUIRE(bare_res);
+  CHECK(!bare_res->device && !bare_res->link);
+  CHECK(rejects_truncated<repeater_status>(bare));
+}
+
+TEST(repeater_status_hostile) {
+  auto bare = frame_of<repeater_status>(repeater_status::t{.repeater_addr = addr_b, .key = 1});
+  // the flag claims a device that is not there
+  bare.back() = repeater_status::flag_device;
+  CHECK(!view_of<repeater_status>(bare));
+  // the flag claims link stats without the length
+  bare.back() = repeater_status::flag_link_stats;
+  CHECK(!view_of<repeater_status>(bare));
+  // the length claims more than the frame has
+  bare.push_back(40);
+  bare.push_back(link_stats::version);
+  CHECK(!view_of<repeater_status>(bare));
+  // link stats that can't be decoded are dropped, which is not an error of the frame
+  const auto data = repeater_status::t{.repeater_addr = addr_a, .link = sample_link_stats()};
+  auto frame      = frame_of<repeater_status>(data);
+  // magic + addr + key + flag + length
+  frame[1 + BLE_ADDR_SIZE + 3] = 0;
+  const auto res               = view_of<repeater_status>(frame);
+  REQUIRE(res);
+  CHECK(!res->link);
+}
+
+TEST(hr_batch_round_trip) {
+  auto data = hr_batch::t{.key = 4};
+  for (uint16_t i = 0; i < hr_batch::max_samples; ++i) {
+    data.samples.push_back(hr_batch::sample_t{
+        .age = static_cast<uint16_t>(31'000 - i * 1'000),
+        .hr  = static_cast<uint8_t>(i % 3 == 0 ? 60 + i : 200 - i),
+    });
+  }
+  const auto frame = frame_of<hr_batch>(data);
+  REQUIRE(frame.size() == hr_batch::size_needed(data));
+  const auto res = view_of<hr_batch>(frame);
+  REQUIRE(res);
+  REQUIRE(res->samples.size() == data.samples.size());
+  CHECK(res->key == 4);
+  for (size_t i = 0; i < data.samples.size(); ++i) {
+    CHECK(res->samples[i].hr == data.samples[i].hr);
+    CHECK(res->samples[i].age == data.samples[i].age);
+  }
+  CHECK(rejects_truncated<hr_batch>(frame));
+  CHECK(rejects_wrong_magic<hr_batch>(frame));
+}
+
+TEST(hr_batch_hostile) {
+  // more samples than allowed
+  const bytes_t too_many = {hr_batch::magic, 0, hr_batch::max_samples + 1};
+  CHECK(!view_of<hr_batch>(too_many));
+  // an age too large to be scaled is saturated
+  const bytes_t big_age = {hr_batch::magic, 0, 1, 0xff, 0xff, 0xff, 0xff, 0x0f, 60};
+  const auto res        = view_of<hr_batch>(big_age);
+  REQUIRE(res && res->samples.size() == 1);
+  CHECK(res->samples[0].age == UINT16_MAX && res->samples[0].hr == 60);
+  // an overlong varint
+  const bytes_t overlong = {hr_batch::magic, 0, 1, 0x80, 0x00, 60};
+  CHECK(!view_of<hr_batch>(overlong));
+}
+
+TEST(hr_rr_round_trip) {
+  auto data = hr_rr::t{.key = 2, .seq = 255};
+  // a normal rhythm, an ectopic beat, and a pause longer than 2 s
+  for (const uint16_t v : {820, 830, 815, 600, 1100, 825, 3100, 800, 0, UINT16_MAX}) {
+    data.rr.push_back(v);
+  }
+  const auto frame = frame_of<hr_rr>(data);
+  REQUIRE(frame.size() == hr_rr::size_needed(data));
+  const auto res = view_of<hr_rr>(frame);
+  REQUIRE(res);
+  CHECK(res->key == 2 && res->seq == 255);
+  CHECK(res->rr == data.rr);
+  CHECK(rejects_truncated<hr_rr>(frame));
+  CHECK(rejects_wrong_magic<hr_rr>(frame));
+  const bytes_t too_many = {hr_rr::magic, 0, 0, hr_rr::max_rr + 1};
+  CHECK(!view_of<hr_rr>(too_many));
+  // an empty one is fine
+  const auto empty = frame_of<hr_rr>(hr_rr::t{.key = 1});
+  CHECK(empty.size() == 4 && view_of<hr_rr>(empty));
+}
+
+TEST(reliable_round_trip) {
+  const uint8_t inner[] = {set_name_map_key::magic, 1, 2, 3, 4, 5, 6, 7};
+  const auto frame      = frame_of<reliable>(reliable::view{.src = addr_a, .dst = addr_b, .seq = 200, .payload = inner});
+  REQUIRE(frame.size() == reliable::header_size + sizeof(inner));
+  const auto res = view_of<reliable>(frame);
+  REQUIRE(res);
+  CHECK(res->src == addr_a && res->dst == addr_b && res->seq == 200);
+  CHECK(std::equal(res->payload.begin(), res->payload.end(), std::begin(inner), std::end(inner)));
+  // the payload borrows from the frame
+  CHECK(res->payload.data() == frame.data() + reliable::header_size);
+  CHECK(!view_of<reliable>(bytes_t(frame.begin(), frame.begin() + reliable::header_size - 1)));
+  CHECK(rejects_wrong_magic<reliable>(frame));
+  // a payload longer than allowed
+  auto too_long = frame;
+  too_long.resize(reliable::header_size + reliable::max_payload + 1);
+  CHECK(!view_of<reliable>(too_long) && !reliable::unmarshal(too_long.data(), too_long.size()));
+}
+
+TEST(ack_round_trip) {
+  const auto frame = frame_of<ack>(ack::t{.src = addr_b, .dst = addr_a, .seq = 17});
+  REQUIRE(frame.size() == ack::size_needed());
+  const auto res = view_of<ack>(frame);
+  REQUIRE(res);
+  CHECK(res->src == addr_b && res->dst == addr_a && res->seq == 17);
+  CHECK(rejects_truncated<ack>(frame));
+  CHECK(rejects_wrong_magic<ack>(frame));
+}
+
+TEST(marshal_fails_without_space) {
+  uint8_t buf[4] = {0};
+  CHECK(named_hr_data::marshal(named_hr_data::t{}, buf, sizeof(buf)) == 0);
+  CHECK(ack::marshal(ack::t{}, buf, sizeof(buf)) == 0);
+  auto batch = hr_batch::t{};
+  batch.samples.push_back(hr_batch::sample_t{.age = 100, .hr = 60});
+  batch.samples.push_back(hr_batch::sample_t{.age = 0, .hr = 90});
+  CHECK(hr_batch::marshal(batch, buf, sizeof(buf)) == 0);
+  CHECK(repeater_status::marshal(repeater_status::t{}, buf, sizeof(buf)) == 0);
+}
+
+TEST(delta_codec_bounds) {
+  // the worst case: every difference escaped
+  uint8_t values[33] = {0};
+  for (size_t i = 0; i < sizeof(values); ++i) {
+    values[i] = i % 2 == 0 ? 0 : 255;
+  }
+  const auto need = delta_codec::encoded_size(values, sizeof(values));
+  CHECK(need == delta_codec::max_size(sizeof(values)));
+  uint8_t out[64] = {0};
+  CHECK(delta_codec::encode(values, sizeof(values), out, need - 1) == 0);
+  REQUIRE(delta_codec::encode(values, sizeof(values), out, need) == need);
+  uint8_t back[33] = {0};
+  CHECK(delta_codec::decode(out, need, back, sizeof(back)) == need);
+  CHECK(std::equal(std::begin(values), std::end(values), std::begin(back)));
+  // truncated anywhere
+  for (size_t n = 0; n < need; ++n) {
+    CHECK(delta_codec::decode(out, n, back, sizeof(back)) == 0);
+  }
+  // a difference that leaves the range of a byte
+  const uint8_t under[] = {0x00, 0x10};
+  CHECK(delta_codec::decode(under, sizeof(under), back, 2) == 0);
+}
+
+TEST(delta_codec16_bounds) {
+  const uint16_t values[] = {0, UINT16_MAX, 0, 1, 1, 32768};
+  uint8_t out[32]         = {0};
+  const auto need         = delta_codec::encoded_size16(values, std::size(values));
+  CHECK(need <= delta_codec::max_size16(std::size(values)));
+  REQUIRE(delta_codec::encode16(values, std::size(values), out, sizeof(out)) == need);
+  uint16_t back[std::size(values)] = {0};
+  CHECK(delta_codec::decode16(out, need, back, std::size(back)) == need);
+  CHECK(std::equal(std::begin(values), std::end(values), std::begin(back)));
+  for (size_t n = 0; n < need; ++n) {
+    CHECK(delta_codec::decode16(out, n, back, std::size(back)) == 0);
+  }
+  // the first value or a difference out of range (the padding keeps GCC from
+  // warning about the reads that `size` rules out)
+  const uint8_t first_over[8] = {0x80, 0x80, 0x04};
+  CHECK(delta_codec::decode16(first_over, 3, back, 1) == 0);
+  const uint8_t below_zero[8] = {0x00, 0x01};
+  CHECK(delta_codec::decode16(below_zero, 2, back, 2) == 0);
+}
+
+TEST(varint_round_trip) {
+  for (const uint32_t v : {0u, 1u, 127u, 128u, 16'383u, 16'384u, UINT32_MAX}) {
+    uint8_t buf[5] = {0};
+    const auto sz  = delta_codec::write_varint(v, buf, sizeof(buf));
+    CHECK(sz == delta_codec::varint_size(v));
+    uint32_t back = 0;
+    CHECK(delta_codec::read_varint(buf, sz, back) == sz && back == v);
+    CHECK(delta_codec::read_varint(buf, sz - 1, back) == 0);
+  }
+  // no terminating byte in 5
+  const uint8_t endless[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  uint32_t v              = 0;
+  CHECK(delta_codec::read_varint(endless, sizeof(endless), v) == 0);
+}
+
+TEST(registry_dispatch) {
+  using modules    = hr_lora_msg::modules;
+  const auto hr    = frame_of<hr_data>(hr_data::t{.key = 1, .hr = 70});
+  const auto query = frame_of<query_device_by_mac>(query_device_by_mac::t{.addr = addr_a});
+  int n_hr         = 0;
+  int n_query      = 0;
+  int n_other      = 0;
+  auto handler     = hr_lora_msg::overloaded{
+      [&](const hr_data::view &v) { n_hr += v.hr == 70; },
+      [&](const query_device_by_mac::view &v) { n_query += v.addr == addr_a; },
+      [&](const auto &) { n_other += 1; },
+  };
+  CHECK(modules::dispatch(std::span<const uint8_t>{hr}, handler) == dispatch_result::ok);
+  CHECK(modules::dispatch(std::span<const uint8_t>{query}, handler) == dispatch_result::ok);
+  CHECK(n_hr == 1 && n_query == 1 && n_other == 0);
+
+  const bytes_t unknown = {0x00, 1, 2};
+  CHECK(modules::dispatch(std::span<const uint8_t>{unknown}, handler) == dispatch_result::unknown_magic);
+  CHECK(modules::dispatch(std::span<const uint8_t>{}, handler) == dispatch_result::bad_frame);
+  const auto truncated = bytes_t(hr.begin(), hr.end() - 1);
+  CHECK(modules::dispatch(std::span<const uint8_t>{truncated}, handler) == dispatch_result::bad_frame);
+  CHECK(n_hr == 1 && n_query == 1 && n_other == 0);
+
+  // and the variant path
+  auto msg = hr_lora_msg::unmarshal(query.data(), query.size());
+  REQUIRE(msg && std::holds_alternative<query_device_by_mac::t>(*msg));
+  uint8_t buf[16] = {0};
+  CHECK(hr_lora_msg::marshal(*msg, buf, sizeof(buf)) == query.size());
+  CHECK(!hr_lora_msg::unmarshal(unknown.data(), unknown.size()));
+}
+}
@@ -0,0 +1,124 @@
+/**
+ * @brief `radio_profile::Adapter`: its hysteresis, and how it steps up and down
+ *        through `radio_profile::PROFILES`
+ *
+ * The margins of the profiles at an SNR of `s` (see `Adapter::margin_db`) are
+ * s + 15, s + 10, s + 7, s + 4.5, s + 2 and s - 4.5.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include "check.h"
+#include "radio_profile.h"
+
+namespace {
+using namespace radio_profile;
+
+// SNR below 5 dB is taken as is, see `Adapter::estimate_snr`
+constexpr float WEAK_RSSI = -110.0f;
+
+// without the moving average, so that each sample is what the margin is of
+constexpr auto instant = adapter_config_t{.up_count = 4, .alpha = 1.0f};
+
+TEST(steps_up_after_up_count_good_samples_in_a_row) {
+  auto a = Adapter{instant};
+  for (uint32_t i = 0; i < 3; ++i) {
+    CHECK(!a.update(0, WEAK_RSSI, i));
+  }
+  // not good enough to step up, nor bad enough to step down; the count restarts
+  CHECK(!a.update(-3, WEAK_RSSI, 3));
+  CHECK(a.index() == 0);
+  for (uint32_t i = 4; i < 7; ++i) {
+    CHECK(!a.update(0, WEAK_RSSI, i));
+  }
+  CHECK(a.update(0, WEAK_RSSI, 7));
+  CHECK(a.index() == 1);
+  CHECK(a.profile() == PROFILES[1]);
+}
+
+TEST(stays_between_the_margins_to_step_up_and_down) {
+  auto a = Adapter{adapter_config_t{.up_count = 1, .alpha = 1.0f}};
+  CHECK(a.update(0, WEAK_RSSI, 0));
+  REQUIRE(a.index() == 1);
+  // at index 1 it steps down below -5 dB and up from 3 dB
+  size_t changes = 0;
+  for (uint32_t i = 1; i < 200; ++i) {
+    const float snr = i % 2 == 0 ? -4.9f : 2.9f;
+    changes += a.update(snr, WEAK_RSSI, i);
+  }
+  CHECK(changes == 0);
+  CHECK(a.index() == 1);
+  CHECK(a.update(3, WEAK_RSSI, 200) && a.index() == 2);
+  CHECK(a.update(-2.1f, WEAK_RSSI, 201) && a.index() == 1);
+}
+
+TEST(steps_down_at_once_to_the_first_profile_that_works) {
+  auto a = Adapter{adapter_config_t{.max_index = PROFILES.size() - 1, .up_count = 1, .alpha = 1.0f}};
+  for (uint32_t i = 0; i < PROFILES.size(); ++i) {
+    a.update(10, -40, i);
+  }
+  REQUIRE(a.index() == PROFILES.size() - 1);
+  // -3 dB leaves a margin of 5 dB or more for the second profile only
+  CHECK(a.update(-3, WEAK_RSSI, 10));
+  CHECK(a.index() == 1);
+  // and nothing at all for the first, which is as low as it goes
+  CHECK(a.update(-30, WEAK_RSSI, 11));
+  CHECK(a.index() == 0);
+  CHECK(!a.update(-30, WEAK_RSSI, 12));
+}
+
+TEST(the_average_rides_out_a_single_fade) {
+  auto smooth  = Adapter{adapter_config_t{.up_count = 1, .alpha = 0.25f}};
+  auto sharp   = Adapter{adapter_config_t{.up_count = 1, .alpha = 1.0f}};
+  for (auto *a : {&smooth, &sharp}) {
+    a->update(2, WEAK_RSSI, 0);
+    REQUIRE(a->index() == 1);
+    a->update(-12, WEAK_RSSI, 1);
+  }
+  // 2 + 0.25 * (-12 - 2) = -1.5 dB, which is still above -5 dB
+  CHECK(smooth.index() == 1);
+  CHECK(sharp.index() == 0);
+}
+
+TEST(a_saturated_snr_is_estimated_from_the_rssi) {
+  const auto a = Adapter{};
+  CHECK(a.estimate_snr(4, -60) == 4);
+  // -60 dBm is 51 dB above the noise floor of -111 dBm
+  CHECK(a.estimate_snr(10, -60) == 51);
+  CHECK(a.estimate_snr(10, -115) == 10);
+}
+
+TEST(falls_back_when_the_gateway_is_silent) {
+  const auto silence = adapter_config_t{}.silence_ms;
+  auto a             = Adapter{adapter_config_t{.up_count = 1, .alpha = 1.0f}};
+  a.update(0, WEAK_RSSI, 0);
+  REQUIRE(a.index() == 1);
+  CHECK(!a.check_silence(silence - 1));
+  // a frame heard restarts the wait
+  a.update(0, WEAK_RSSI, 100'000);
+  CHECK(!a.check_silence(100'000 + silence - 1));
+  CHECK(a.check_silence(100'000 + silence));
+  CHECK(a.index() == 0);
+  CHECK(!a.check_silence(UINT32_MAX));
+
+  // the average restarts from the next sample, instead of being carried up
+  // by the ones before the silence (which would make it 1.8 dB)
+  auto smooth = Adapter{adapter_config_t{.up_count = 1, .alpha = 0.25f}};
+  smooth.update(4.9f, WEAK_RSSI, 0);
+  smooth.update(-4, WEAK_RSSI, 1);
+  REQUIRE(smooth.index() == 1);
+  CHECK(smooth.check_silence(silence + 1));
+  CHECK(!smooth.update(-1, WEAK_RSSI, silence + 2));
+  CHECK(smooth.index() == 0);
+}
+
+TEST(never_steps_up_beyond_max_index) {
+  for (const size_t max : {size_t{0}, last_power_only_index(), PROFILES.size() - 1, size_t{100}}) {
+    auto a = Adapter{adapter_config_t{.max_index = max, .up_count = 1}};
+    for (uint32_t i = 0; i < 64; ++i) {
+      a.update(10, -40, i);
+    }
+    CHECK(a.index() == std::min(max, PROFILES.size() - 1));
+  }
+}
+}
@@ -0,0 +1,64 @@
+/**
+ * @brief RadioLib's LLCC68 driver on the simulated chip, begun like `app_main`
+ * @note only built with the RadioLib submodule
+ */
+
+#include <RadioLib.h>
+#include <cstdint>
+#include <string>
+#include "check.h"
+#include "llcc68.h"
+#include "medium.h"
+#include "radio_profile.h"
+#include "sim_hal.h"
+#include "world.h"
+
+namespace {
+using namespace sim;
+
+constexpr auto still = medium_config_t{.shadowing_db = 0, .fading_db = 0};
+
+int16_t begin(LLCC68 &rf) {
+  constexpr auto &p = radio_profile::DEFAULT_PROFILE;
+  return rf.begin(p.freq_mhz, p.bw_khz, p.sf, p.cr, RADIOLIB_SX126X_SYNC_WORD_PRIVATE, p.power_dbm, p.preamble_len, 1.6);
+}
+
+TEST(radiolib_transmits_to_radiolib) {
+  auto world   = World{1};
+  auto medium  = Medium{world, still};
+  auto a       = Llcc68{world, medium, 0, 0};
+  auto b       = Llcc68{world, medium, 100, 0};
+  auto hal_a   = SimHal{world, a};
+  auto hal_b   = SimHal{world, b};
+  const auto p = SimHal::pins_t{};
+  auto mod_a   = Module(&hal_a, p.nss, p.dio1, p.rst, p.busy);
+  auto mod_b   = Module(&hal_b, p.nss, p.dio1, p.rst, p.busy);
+  auto rf_a    = LLCC68(&mod_a);
+  auto rf_b    = LLCC68(&mod_b);
+  REQUIRE(begin(rf_a) == RADIOLIB_ERR_NONE);
+  REQUIRE(begin(rf_b) == RADIOLIB_ERR_NONE);
+
+  REQUIRE(rf_b.startReceive() == RADIOLIB_ERR_NONE);
+  uint8_t out[] = {'h', 'e', 'l', 'l', 'o'};
+  // blocks, running the world until TX_DONE
+  REQUIRE(rf_a.transmit(out, sizeof(out)) == RADIOLIB_ERR_NONE);
+  CHECK(b.dio1());
+  REQUIRE(rf_b.getPacketLength() == sizeof(out));
+  uint8_t in[sizeof(out)] = {};
+  CHECK(rf_b.readData(in, sizeof(in)) == RADIOLIB_ERR_NONE);
+  CHECK(std::string(in, in + sizeof(in)) == "hello");
+}
+
+TEST(radiolib_finds_the_chip) {
+  auto world   = World{1};
+  auto medium  = Medium{world, still};
+  auto chip    = Llcc68{world, medium, 0, 0};
+  auto hal     = SimHal{world, chip};
+  const auto p = SimHal::pins_t{};
+  auto mod     = Module(&hal, p.nss, p.dio1, p.rst, p.busy);
+  auto rf      = LLCC68(&mod);
+  CHECK(begin(rf) == RADIOLIB_ERR_NONE);
+  // CAD on a quiet channel
+  CHECK(rf.scanChannel() == RADIOLIB_CHANNEL_FREE);
+}
+}
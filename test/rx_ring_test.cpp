@@ -0,0 +1,173 @@
+/**
+ * @brief `radio::RxRing`, filled the way `RadioTask::receive` fills it and drained
+ *        the way `RadioTask::wait_receive` and `release_receive` drain it
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "rx_ring.h"
+
+namespace {
+using ring_t = radio::RxRing<4, 16>;
+
+/**
+ * @brief a frame of `size` bytes of `seq`, with `seq` as the timestamp
+ * @return false if the ring is full
+ */
+bool produce(ring_t &ring, uint32_t seq, uint16_t size = 8) {
+  auto *slot = ring.acquire();
+  if (slot == nullptr) {
+    return false;
+  }
+  slot->timestamp_ms = seq;
+  slot->irq_flags    = radio::irq::RX_DONE;
+  slot->size         = size;
+  std::memset(slot->data.data(), static_cast<uint8_t>(seq), size);
+  ring.commit();
+  return true;
+}
+
+/**
+ * @return the timestamp of the oldest frame, after checking its bytes;
+ *         `UINT32_MAX` if there's none
+ */
+uint32_t consume(ring_t &ring) {
+  const auto *slot = ring.front();
+  CHECK(slot != nullptr);
+  if (slot == nullptr) {
+    return UINT32_MAX;
+  }
+  const auto seq = slot->timestamp_ms;
+  for (const auto b : slot->frame()) {
+    CHECK(b == static_cast<uint8_t>(seq));
+  }
+  ring.release();
+  return seq;
+}
+
+TEST(an_empty_ring_has_nothing_in_front) {
+  auto ring = ring_t{};
+  CHECK(ring.front() == nullptr);
+  CHECK(ring.size() == 0 && ring.overrun() == 0);
+  CHECK(ring_t::capacity() == 4);
+}
+
+TEST(a_slot_is_published_by_commit_only) {
+  auto ring  = ring_t{};
+  auto *slot = ring.acquire();
+  REQUIRE(slot != nullptr);
+  slot->size = 3;
+  CHECK(ring.front() == nullptr);
+  // acquired again without a commit, it's the same slot
+  CHECK(ring.acquire() == slot);
+  ring.commit();
+  CHECK(ring.front() == slot);
+  CHECK(ring.front()->frame().size() == 3);
+  CHECK(ring.size() == 1);
+}
+
+TEST(frames_come_out_in_order_across_the_wraparound) {
+  auto ring     = ring_t{};
+  uint32_t next = 0;
+  // in bursts of 1 to `capacity`, so that the head and the tail pass the end
+  // of the array at every offset
+  for (uint32_t round = 0; round < 100; ++round) {
+    const auto burst = round % ring_t::capacity() + 1;
+    for (uint32_t i = 0; i < burst; ++i) {
+      REQUIRE(produce(ring, next + i, static_cast<uint16_t>(1 + (next + i) % 16)));
+    }
+    CHECK(ring.size() == burst);
+    for (uint32_t i = 0; i < burst; ++i) {
+      CHECK(consume(ring) == next + i);
+    }
+    next += burst;
+    CHECK(ring.front() == nullptr);
+  }
+  CHECK(ring.overrun() == 0);
+}
+
+TEST(a_full_ring_counts_the_overruns_and_keeps_what_it_has) {
+  auto ring = ring_t{};
+  for (uint32_t seq = 0; seq < ring_t::capacity(); ++seq) {
+    REQUIRE(produce(ring, seq));
+  }
+  // the frames that don't fit are dropped, not written over the oldest
+  for (uint32_t seq = 100; seq < 103; ++seq) {
+    CHECK(!produce(ring, seq));
+  }
+  CHECK(ring.overrun() == 3);
+  CHECK(ring.size() == ring_t::capacity());
+  CHECK(consume(ring) == 0);
+  // a slot given back is taken by the next frame
+  CHECK(produce(ring, 4));
+  CHECK(!produce(ring, 5));
+  CHECK(ring.overrun() == 4);
+  for (uint32_t seq = 1; seq <= 4; ++seq) {
+    CHECK(consume(ring) == seq);
+  }
+  CHECK(ring.size() == 0);
+}
+
+TEST(the_slot_in_front_stays_until_released) {
+  auto ring = ring_t{};
+  REQUIRE(produce(ring, 7));
+  const auto *slot = ring.front();
+  // the producer fills the others meanwhile, never the one being read
+  for (uint32_t seq = 8; seq < 8 + ring_t::capacity() - 1; ++seq) {
+    REQUIRE(produce(ring, seq));
+    CHECK(ring.front() == slot);
+  }
+  CHECK(ring.acquire() == nullptr);
+  CHECK(slot->timestamp_ms == 7);
+  ring.release();
+  // and the released one is the next to be filled
+  CHECK(ring.acquire() == slot);
+}
+
+TEST(a_producer_and_a_consumer_on_two_threads) {
+  // nothing is lost but what's counted, nothing is duplicated, and a frame is
+  // seen whole, i.e. after everything written to it before the commit
+  constexpr uint32_t FRAMES = 200'000;
+  auto ring                 = ring_t{};
+  auto done                 = std::atomic<bool>{false};
+  uint32_t dropped          = 0;
+  auto producer             = std::thread{[&] {
+    for (uint32_t seq = 0; seq < FRAMES; ++seq) {
+      dropped += !produce(ring, seq, static_cast<uint16_t>(1 + seq % 16));
+    }
+    done.store(true, std::memory_order_release);
+  }};
+  auto received = std::vector<uint32_t>{};
+  bool whole    = true;
+  for (;;) {
+    const auto *slot = ring.front();
+    if (slot == nullptr) {
+      if (done.load(std::memory_order_acquire) && ring.front() == nullptr) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    const auto seq = slot->timestamp_ms;
+    whole          = whole && slot->size == 1 + seq % 16 && slot->irq_flags == radio::irq::RX_DONE;
+    for (const auto b : slot->frame()) {
+      whole = whole && b == static_cast<uint8_t>(seq);
+    }
+    received.push_back(seq);
+    ring.release();
+  }
+  producer.join();
+  CHECK(whole);
+  CHECK(received.size() + dropped == FRAMES);
+  CHECK(ring.overrun() == dropped);
+  bool increasing = true;
+  for (size_t i = 1; i < received.size(); ++i) {
+    increasing = increasing && received[i] > received[i - 1];
+  }
+  CHECK(increasing);
+}
+}
@@ -0,0 +1,160 @@
+/**
+ * @brief `scan_result_batch::Packer` at the boundaries of the ATT MTU, with
+ *        an encoder that writes the bytes nanopb writes for a `devices` field
+ *        of `scan_result_pb`
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "check.h"
+#include "scan_result_batch.h"
+
+namespace {
+using namespace scan_result_batch;
+// `BLE_ATT_ATTR_MAX_LEN`
+constexpr size_t MAX_SIZE = 512;
+using packer_t            = Packer<MAX_SIZE>;
+
+constexpr size_t ADDR_SIZE = 6;
+// `bluetooth_device_pb::name` less the terminator
+constexpr size_t NAME_SIZE = 20;
+
+/**
+ * @brief `{1: {1: mac, 2: name}}`, with the name left out when empty, as
+ *        proto3 does
+ */
+size_t encode_device(std::span<uint8_t> out, std::string_view name, const uint8_t *addr) {
+  name                = name.substr(0, NAME_SIZE);
+  const size_t inner  = 2 + ADDR_SIZE + (name.empty() ? 0 : 2 + name.size());
+  const size_t needed = 2 + inner;
+  if (out.size() < needed) {
+    return 0;
+  }
+  auto it = out.begin();
+  *it++   = 0x0a;
+  *it++   = static_cast<uint8_t>(inner);
+  *it++   = 0x0a;
+  *it++   = ADDR_SIZE;
+  it      = std::copy(addr, addr + ADDR_SIZE, it);
+  if (!name.empty()) {
+    *it++ = 0x12;
+    *it++ = static_cast<uint8_t>(name.size());
+    std::copy(name.begin(), name.end(), it);
+  }
+  return needed;
+}
+
+// a device without a name is 10 bytes; with a name of n, 12 + n
+constexpr uint8_t ADDR[ADDR_SIZE] = {0xc0, 0x11, 0x22, 0x33, 0x44, 0x55};
+constexpr size_t NAMELESS_SIZE    = 10;
+
+std::string name_of(size_t size) {
+  return std::string(size, 'n');
+}
+
+struct sink_t {
+  std::vector<std::vector<uint8_t>> sent;
+
+  auto fn() {
+    return [this](std::span<const uint8_t> data) { sent.emplace_back(data.begin(), data.end()); };
+  }
+};
+
+TEST(the_mtu_is_taken_as_the_default_at_least) {
+  // before the MTU exchange, or from a client that reports less
+  for (const uint16_t mtu : {uint16_t{0}, uint16_t{3}, uint16_t{22}, ATT_MTU_DFLT}) {
+    CHECK(payload_limit(mtu, MAX_SIZE) == ATT_MTU_DFLT - NOTIFY_HEADER_SIZE);
+  }
+  CHECK(payload_limit(ATT_MTU_DFLT + 1, MAX_SIZE) == ATT_MTU_DFLT + 1 - NOTIFY_HEADER_SIZE);
+  // and a notification is never larger than the characteristic
+  CHECK(payload_limit(MAX_SIZE + NOTIFY_HEADER_SIZE - 1, MAX_SIZE) == MAX_SIZE - 1);
+  CHECK(payload_limit(MAX_SIZE + NOTIFY_HEADER_SIZE, MAX_SIZE) == MAX_SIZE);
+  CHECK(payload_limit(UINT16_MAX, MAX_SIZE) == MAX_SIZE);
+
+  // a small MTU packs as the default does, and doesn't wrap around
+  auto p    = packer_t{encode_device};
+  auto sink = sink_t{};
+  CHECK(p.add("", ADDR, 0, sink.fn()) == add_result::first);
+  CHECK(p.add("", ADDR, 0, sink.fn()) == add_result::appended);
+  CHECK(p.add("", ADDR, 0, sink.fn()) == add_result::first);
+  REQUIRE(sink.sent.size() == 1);
+  CHECK(sink.sent[0].size() == 2 * NAMELESS_SIZE);
+}
+
+TEST(packs_up_to_exactly_the_limit) {
+  // the second device ends right at the limit, or a byte past it
+  for (const size_t slack : {size_t{0}, size_t{1}}) {
+    const auto mtu = static_cast<uint16_t>(2 * (12 + 8) - slack + NOTIFY_HEADER_SIZE);
+    auto p         = packer_t{encode_device};
+    auto sink      = sink_t{};
+    CHECK(p.add(name_of(8), ADDR, mtu, sink.fn()) == add_result::first);
+    const auto second = p.add(name_of(8), ADDR, mtu, sink.fn());
+    if (slack == 0) {
+      CHECK(second == add_result::appended);
+      CHECK(sink.sent.empty() && p.size() == payload_limit(mtu, MAX_SIZE));
+    } else {
+      CHECK(second == add_result::first);
+      REQUIRE(sink.sent.size() == 1);
+      CHECK(sink.sent[0].size() == 20 && p.count() == 1);
+    }
+  }
+}
+
+TEST(every_notification_fits_in_the_mtu) {
+  for (const uint16_t mtu : {ATT_MTU_DFLT, uint16_t{24}, uint16_t{64}, uint16_t{185}, uint16_t{247}, uint16_t{517}}) {
+    const auto limit = payload_limit(mtu, MAX_SIZE);
+    auto p           = packer_t{encode_device};
+    auto sink        = sink_t{};
+    size_t added     = 0;
+    for (size_t i = 0; i < 200; ++i) {
+      // names of 0 to 20 bytes, and longer ones that are cut
+      added += p.add(name_of(i % 24), ADDR, mtu, sink.fn()) != add_result::too_large;
+    }
+    p.flush(sink.fn());
+    size_t bytes = 0;
+    for (const auto &n : sink.sent) {
+      CHECK(!n.empty() && n.size() <= limit);
+      bytes += n.size();
+    }
+    // what's sent is every device added, each whole
+    size_t expected = 0;
+    for (size_t i = 0; i < 200; ++i) {
+      const auto sz = i % 24 == 0 ? NAMELESS_SIZE : 12 + std::min(i % 24, NAME_SIZE);
+      expected += sz <= limit ? sz : 0;
+    }
+    CHECK(bytes == expected);
+    CHECK(added > 0);
+  }
+}
+
+TEST(a_device_too_large_for_the_mtu_is_left_out) {
+  // at the default MTU, a name of more than 8 bytes doesn't fit at all
+  auto p    = packer_t{encode_device};
+  auto sink = sink_t{};
+  CHECK(p.add(name_of(8), ADDR, ATT_MTU_DFLT, sink.fn()) == add_result::first);
+  CHECK(p.add(name_of(9), ADDR, ATT_MTU_DFLT, sink.fn()) == add_result::too_large);
+  // what was packed is sent anyway, and nothing is left
+  REQUIRE(sink.sent.size() == 1);
+  CHECK(sink.sent[0].size() == 20);
+  CHECK(p.size() == 0 && p.count() == 0);
+  // and with a larger MTU, it fits
+  CHECK(p.add(name_of(9), ADDR, ATT_MTU_DFLT + 1, sink.fn()) == add_result::first);
+}
+
+TEST(a_flush_with_nothing_sends_nothing) {
+  auto p    = packer_t{encode_device};
+  auto sink = sink_t{};
+  p.flush(sink.fn());
+  CHECK(sink.sent.empty());
+  CHECK(p.add("", ADDR, 247, sink.fn()) == add_result::first);
+  p.flush(sink.fn());
+  p.flush(sink.fn());
+  CHECK(sink.sent.size() == 1);
+  // the next one starts the timer again
+  CHECK(p.add("", ADDR, 247, sink.fn()) == add_result::first);
+}
+}
@@ -0,0 +1,110 @@
+/**
+ * @brief `seen_cache::SeenCache::observe` as `ScanManager` has it: the budget
+ *        of the scan results, what's forgotten and how long a name is kept
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "check.h"
+#include "common.h"
+#include "seen_cache.h"
+
+namespace {
+using namespace seen_cache;
+using cache_t = SeenCache<common::MAX_SEEN_DEVICE_NUM, common::SEEN_NAME_SIZE>;
+
+constexpr auto SCAN = config_t{
+    .per_second = common::SCAN_RESULT_PER_SECOND,
+    .burst      = common::SCAN_RESULT_BURST,
+};
+// for the tests that aren't about the budget
+constexpr auto UNLIMITED = config_t{.per_second = 1000, .burst = 1000};
+
+addr_t addr_of(uint32_t i) {
+  return addr_t{0xc0, 0x11, 0x22, static_cast<uint8_t>(i >> 16), static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+}
+
+TEST(a_burst_then_per_second_on_average) {
+  auto s = cache_t{SCAN};
+  // a crowd shows up at once: as many as the burst are reported
+  uint32_t reported = 0;
+  for (uint32_t i = 0; i < 20; ++i) {
+    reported += s.observe(addr_of(i), "", -60, 0) != nullptr;
+  }
+  CHECK(reported == common::SCAN_RESULT_BURST);
+  CHECK(s.stats().throttled == 20 - common::SCAN_RESULT_BURST);
+
+  // and then keeps advertising every 50 ms, each one new to the cache; over
+  // 10 s the tokens come back at the rate, no faster
+  uint32_t next = 1000;
+  reported      = 0;
+  for (uint32_t t = 50; t <= 10'000; t += 50) {
+    reported += s.observe(addr_of(next++), "", -60, t) != nullptr;
+  }
+  CHECK(reported == 10 * common::SCAN_RESULT_PER_SECOND);
+}
+
+TEST(a_throttled_device_is_reported_once_a_token_is_back) {
+  auto s = cache_t{SCAN};
+  for (uint32_t i = 0; i < common::SCAN_RESULT_BURST; ++i) {
+    REQUIRE(s.observe(addr_of(i), "", -60, 0) != nullptr);
+  }
+  const auto late = addr_of(100);
+  CHECK(s.observe(late, "Polar", -60, 0) == nullptr);
+  // a token is back every 1/`per_second` s
+  const uint32_t token_ms = 1000 / common::SCAN_RESULT_PER_SECOND;
+  CHECK(s.observe(late, "", -60, token_ms - 1) == nullptr);
+  const auto *e = s.observe(late, "", -60, token_ms);
+  REQUIRE(e != nullptr);
+  CHECK(e->name() == "Polar");
+  // and not again for the same advertisement
+  CHECK(s.observe(late, "", -60, 10 * token_ms) == nullptr);
+}
+
+TEST(the_least_recently_seen_is_forgotten_when_full) {
+  auto s = cache_t{UNLIMITED};
+  for (uint32_t i = 0; i < common::MAX_SEEN_DEVICE_NUM; ++i) {
+    REQUIRE(s.observe(addr_of(i), "", -60, i) != nullptr);
+  }
+  // all of them are remembered
+  for (uint32_t i = 0; i < common::MAX_SEEN_DEVICE_NUM; ++i) {
+    CHECK(s.observe(addr_of(i), "", -60, 100 + i) == nullptr);
+  }
+  CHECK(s.stats().evicted == 0);
+  // seen again, so 1 is the oldest now
+  CHECK(s.observe(addr_of(0), "", -60, 200) == nullptr);
+  CHECK(s.observe(addr_of(1000), "", -60, 201) != nullptr);
+  CHECK(s.stats().evicted == 1);
+  CHECK(s.observe(addr_of(0), "", -60, 202) == nullptr);
+  // forgotten, so it's new again, and 2 makes room for it
+  CHECK(s.observe(addr_of(1), "", -60, 203) != nullptr);
+  CHECK(s.stats().evicted == 2);
+  CHECK(s.observe(addr_of(2), "", -60, 204) != nullptr);
+  CHECK(s.observe(addr_of(1000), "", -60, 205) == nullptr);
+}
+
+TEST(a_name_is_kept_up_to_seen_name_size) {
+  auto s          = cache_t{UNLIMITED};
+  const auto full = std::string(common::SEEN_NAME_SIZE, 'n');
+  const auto *e   = s.observe(addr_of(0), full, -60, 0);
+  REQUIRE(e != nullptr);
+  CHECK(e->name() == full);
+
+  const auto longer = std::string("Polar H10 ABCDEF12 chest strap");
+  REQUIRE(longer.size() > common::SEEN_NAME_SIZE);
+  e = s.observe(addr_of(1), longer, -60, 0);
+  REQUIRE(e != nullptr);
+  CHECK(e->name() == std::string_view{longer}.substr(0, common::SEEN_NAME_SIZE));
+  // the same name, told in full again, is no change
+  CHECK(s.observe(addr_of(1), longer, -60, 10) == nullptr);
+  // one that differs past the end of what's kept isn't either
+  CHECK(s.observe(addr_of(1), longer + "2", -60, 20) == nullptr);
+  // but one that differs within it is
+  auto renamed                        = longer;
+  renamed[common::SEEN_NAME_SIZE - 1] = '!';
+  e                                   = s.observe(addr_of(1), renamed, -60, 30);
+  REQUIRE(e != nullptr);
+  CHECK(e->name().size() == common::SEEN_NAME_SIZE && e->name().back() == '!');
+}
+}
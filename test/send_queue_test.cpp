@@ -0,0 +1,276 @@
+/**
+ * @brief `send_queue::SendQueue`, driven by a fake clock the way
+ *        `SendScheduler` drives it with `esp_timer_get_time`
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+#include <etl/vector.h>
+#include "check.h"
+#include "hr_lora.h"
+#include "send_queue.h"
+
+namespace {
+using namespace send_queue;
+using queue_t = SendQueue<8, 16>;
+
+/**
+ * @brief what `SendScheduler` does around the queue: `schedule` pushes at
+ *        `now + interval`, and the one-shot timer fires after `delay_until_next`
+ *        and sends everything that is due
+ */
+struct fake_scheduler {
+  queue_t queue{};
+  uint32_t now_ms = 0;
+  // the time the timer would fire at, if armed
+  bool armed        = false;
+  uint32_t fires_at = 0;
+
+  struct sent_t {
+    uint32_t at_ms;
+    std::vector<uint8_t> frame;
+  };
+  std::vector<sent_t> sent{};
+
+  void rearm() {
+    armed    = !queue.empty();
+    // `xTimerChangePeriod` won't take a zero period
+    fires_at = now_ms + std::max<uint32_t>(queue.delay_until_next(now_ms), 1);
+  }
+
+  push_result schedule(std::span<const uint8_t> frame, uint32_t interval_ms, priority prio = priority::normal) {
+    const auto res = queue.push(frame, now_ms + interval_ms, prio);
+    rearm();
+    return res;
+  }
+
+  void run() {
+    auto e = queue_t::entry_t{};
+    while (queue.pop_due(now_ms, e)) {
+      sent.push_back(sent_t{now_ms, std::vector<uint8_t>{e.frame().begin(), e.frame().end()}});
+    }
+    rearm();
+  }
+
+  /**
+   * @brief move the clock forward, firing the timer on the way
+   */
+  void advance(uint32_t ms) {
+    const auto until = now_ms + ms;
+    while (armed && !is_before(until, fires_at)) {
+      now_ms = fires_at;
+      run();
+    }
+    now_ms = until;
+  }
+};
+
+TEST(frames_are_sent_when_due) {
+  auto s                = fake_scheduler{};
+  constexpr uint8_t a[] = {0x01, 0xaa};
+  constexpr uint8_t b[] = {0x02, 0xbb};
+  s.schedule(a, 300);
+  s.advance(100);
+  s.schedule(b, 50);
+  s.advance(1'000);
+  REQUIRE(s.sent.size() == 2);
+  CHECK(s.sent[0].frame[0] == 0x02 && s.sent[0].at_ms == 150);
+  CHECK(s.sent[1].frame[0] == 0x01 && s.sent[1].at_ms == 300);
+  CHECK(!s.armed);
+}
+
+TEST(ties_are_broken_by_priority_then_insertion) {
+  auto q = queue_t{};
+  for (uint8_t m = 1; m <= 6; ++m) {
+    const uint8_t f[] = {m};
+    const auto prio   = m % 3 == 0 ? priority::high : (m % 3 == 1 ? priority::normal : priority::low);
+    q.push(f, 100, prio);
+  }
+  auto order = std::vector<uint8_t>{};
+  auto e     = queue_t::entry_t{};
+  while (q.pop_due(100, e)) {
+    order.push_back(e.data[0]);
+  }
+  CHECK((order == std::vector<uint8_t>{3, 6, 1, 4, 2, 5}));
+}
+
+TEST(coalesced_frame_keeps_the_earlier_due_time) {
+  auto s                 = fake_scheduler{};
+  constexpr uint8_t a0[] = {0x01, 0x00};
+  constexpr uint8_t a1[] = {0x01, 0x01};
+  constexpr uint8_t a2[] = {0x01, 0x02};
+  CHECK(s.schedule(a0, 500) == push_result::queued);
+  s.advance(100);
+  // due at 150, earlier than 500
+  CHECK(s.schedule(a1, 50) == push_result::coalesced);
+  // due at 1100, later than 150; only the content is replaced
+  CHECK(s.schedule(a2, 1'000) == push_result::coalesced);
+  s.advance(2'000);
+  REQUIRE(s.sent.size() == 1);
+  CHECK(s.sent[0].at_ms == 150 && s.sent[0].frame[1] == 0x02);
+}
+
+TEST(acks_of_different_frames_all_go_out) {
+  auto s = fake_scheduler{};
+  for (uint8_t seq = 0; seq < 3; ++seq) {
+    uint8_t buf[HrLoRa::ack::size_needed()] = {0};
+    const auto ack = HrLoRa::ack::t{.src = {0x24, 0x0a, 0xc4, 0, 0, 1}, .dst = {0x47, 0x57, 0, 0, 0, 1}, .seq = seq};
+    REQUIRE(HrLoRa::ack::marshal(ack, buf) == sizeof(buf));
+    CHECK(s.schedule(buf, 0) == push_result::queued);
+  }
+  s.advance(10);
+  REQUIRE(s.sent.size() == 3);
+  for (uint8_t seq = 0; seq < 3; ++seq) {
+    const auto v = HrLoRa::ack::unmarshal(s.sent[seq].frame.data(), s.sent[seq].frame.size());
+    REQUIRE(v);
+    CHECK(v->seq == seq);
+  }
+}
+
+TEST(coalescing_does_not_take_a_slot) {
+  auto q = queue_t{};
+  for (uint8_t m = 0; m < queue_t::capacity(); ++m) {
+    const uint8_t f[] = {m};
+    REQUIRE(q.push(f, 0) == push_result::queued);
+  }
+  constexpr uint8_t same[]  = {0x00, 0x01};
+  constexpr uint8_t other[] = {0x42};
+  CHECK(q.push(same, 0) == push_result::coalesced);
+  CHECK(q.push(other, 0) == push_result::full);
+  CHECK(q.size() == queue_t::capacity());
+}
+
+TEST(bad_sizes_are_rejected) {
+  auto q                                               = queue_t{};
+  constexpr uint8_t big[queue_t::max_frame_size() + 1] = {0x01};
+  constexpr uint8_t fit[queue_t::max_frame_size()]     = {0x01};
+  CHECK(q.push(std::span<const uint8_t>{}, 0) == push_result::too_large);
+  CHECK(q.push(big, 0) == push_result::too_large);
+  CHECK(q.push(fit, 0) == push_result::queued);
+  auto e = queue_t::entry_t{};
+  REQUIRE(q.pop_due(0, e));
+  CHECK(e.frame().size() == queue_t::max_frame_size());
+}
+
+TEST(millisecond_counter_wraps) {
+  // `esp_timer_get_time() / 1000` truncated to 32 bits wraps every ~49.7 days
+  auto s                = fake_scheduler{.now_ms = UINT32_MAX - 100};
+  constexpr uint8_t a[] = {0x01};
+  constexpr uint8_t b[] = {0x02};
+  // due at 99, after the wrap
+  s.schedule(a, 200);
+  // due at UINT32_MAX - 50, before the wrap
+  s.schedule(b, 50);
+  CHECK(s.queue.delay_until_next(s.now_ms) == 50);
+  s.advance(150);
+  REQUIRE(s.sent.size() == 1);
+  CHECK(s.sent[0].frame[0] == 0x02 && s.sent[0].at_ms == UINT32_MAX - 50);
+  CHECK(s.queue.delay_until_next(s.now_ms) == 50);
+  s.advance(100);
+  REQUIRE(s.sent.size() == 2);
+  CHECK(s.sent[1].frame[0] == 0x01 && s.sent[1].at_ms == 99);
+}
+
+TEST(overdue_frame_has_no_delay) {
+  auto q                = queue_t{};
+  constexpr uint8_t a[] = {0x01};
+  CHECK(q.delay_until_next(0) == 0);
+  q.push(a, 100);
+  CHECK(q.delay_until_next(40) == 60);
+  CHECK(q.delay_until_next(100) == 0);
+  CHECK(q.delay_until_next(5'000) == 0);
+  auto e = queue_t::entry_t{};
+  CHECK(!q.pop_due(99, e));
+  CHECK(q.pop_due(5'000, e));
+}
+
+TEST(late_timer_sends_the_backlog_in_order) {
+  // the timer daemon could be blocked for a while; everything that's due is
+  // sent in one run, still in order
+  auto s = fake_scheduler{};
+  for (uint8_t m = 1; m <= 4; ++m) {
+    const uint8_t f[] = {m};
+    s.schedule(f, 10 * (5 - m));
+  }
+  s.armed  = false;
+  s.now_ms = 1'000;
+  s.run();
+  REQUIRE(s.sent.size() == 4);
+  for (size_t i = 0; i < 4; ++i) {
+    CHECK(s.sent[i].frame[0] == 4 - i && s.sent[i].at_ms == 1'000);
+  }
+}
+
+/**
+ * @brief a random workload against a sorted vector as the model, starting
+ *        close to the wrap around
+ */
+TEST(matches_a_reference_model) {
+  struct model_entry {
+    uint32_t due;
+    priority prio;
+    uint32_t order;
+    uint8_t magic;
+    uint8_t payload;
+  };
+  auto rng   = std::mt19937{0x5eed};
+  auto q     = queue_t{};
+  // never more than the queue holds
+  auto model = etl::vector<model_entry, queue_t::capacity()>{};
+  auto order = uint32_t{0};
+  auto now   = uint32_t{UINT32_MAX - 5'000};
+  auto e     = queue_t::entry_t{};
+  auto next  = [&] {
+    return std::min_element(model.begin(), model.end(), [](const auto &a, const auto &b) {
+      if (a.due != b.due) {
+        return is_before(a.due, b.due);
+      }
+      if (a.prio != b.prio) {
+        return a.prio < b.prio;
+      }
+      return a.order < b.order;
+    });
+  };
+  for (int step = 0; step < 20'000; ++step) {
+    if (rng() % 3 != 0) {
+      const auto magic   = static_cast<uint8_t>(rng() % 12);
+      const auto payload = static_cast<uint8_t>(rng());
+      const auto due     = static_cast<uint32_t>(now + rng() % 1'000);
+      const auto prio    = static_cast<priority>(rng() % 3);
+      const uint8_t f[]  = {magic, payload};
+      const auto res     = q.push(f, due, prio);
+      auto it            = std::find_if(model.begin(), model.end(), [&](const auto &m) { return m.magic == magic; });
+      if (it != model.end()) {
+        REQUIRE(res == push_result::coalesced);
+        if (is_before(due, it->due)) {
+          it->due = due;
+        }
+        it->prio    = prio;
+        it->order   = order++;
+        it->payload = payload;
+      } else if (model.size() >= queue_t::capacity()) {
+        REQUIRE(res == push_result::full);
+      } else {
+        REQUIRE(res == push_result::queued);
+        model.push_back(model_entry{due, prio, order++, magic, payload});
+      }
+    } else {
+      now += static_cast<uint32_t>(rng() % 300);
+      while (!model.empty() && !is_before(now, next()->due)) {
+        const auto it = next();
+        REQUIRE(q.pop_due(now, e));
+        REQUIRE(e.data[0] == it->magic && e.data[1] == it->payload && e.due_ms == it->due);
+        model.erase(it);
+      }
+      REQUIRE(!q.pop_due(now, e));
+      REQUIRE(q.size() == model.size());
+      if (!model.empty()) {
+        REQUIRE(q.delay_until_next(now) == next()->due - now);
+      }
+    }
+  }
+}
+}
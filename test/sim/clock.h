@@ -0,0 +1,143 @@
+#ifndef BLE_LORA_ADAPTER_SIM_CLOCK_H
+#define BLE_LORA_ADAPTER_SIM_CLOCK_H
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "world.h"
+
+namespace sim {
+/**
+ * @brief what `esp_timer_get_time` of a node reads: since its own boot, and
+ *        off by the drift of its crystal
+ */
+class LocalClock {
+  World &world;
+  uint64_t boot_us;
+  double rate;
+  // what the firmware allocates and never frees, e.g. the timers
+  std::vector<std::shared_ptr<void>> resources;
+  static inline LocalClock *_current = nullptr;
+
+public:
+  /**
+   * @brief the node an event runs on behalf of, for `esp_timer_get_time` and
+   *        the FreeRTOS timers of the firmware (see `rtos/`)
+   */
+  class Scope {
+    LocalClock *prev;
+
+  public:
+    explicit Scope(LocalClock &clock) : prev(_current) {
+      _current = &clock;
+    }
+    ~Scope() {
+      _current = prev;
+    }
+    Scope(const Scope &)            = delete;
+    Scope &operator=(const Scope &) = delete;
+  };
+
+  /**
+   * @return nullptr outside of the events of a node
+   */
+  static LocalClock *current() {
+    return _current;
+  }
+
+  /**
+   * @param boot_us when the node boots, in the time of the world
+   * @param drift_ppm how much faster it runs than the world
+   */
+  LocalClock(World &world, uint64_t boot_us, double drift_ppm)
+      : world(world), boot_us(boot_us), rate(1.0 + drift_ppm * 1e-6) {}
+
+  [[nodiscard]] uint64_t now_us() const {
+    const auto now = world.now_us();
+    return now <= boot_us ? 0 : static_cast<uint64_t>(static_cast<double>(now - boot_us) * rate);
+  }
+
+  /**
+   * @brief `esp_timer_get_time() / 1000` as the firmware keeps it, i.e. wrapping
+   */
+  [[nodiscard]] uint32_t now_ms() const {
+    return static_cast<uint32_t>(now_us() / 1000);
+  }
+
+  /**
+   * @return the time of the world when this clock reads `local_us`, rounded
+   *         up so that it doesn't read a microsecond less (and a timer due
+   *         on a tick doesn't fire in the tick before)
+   */
+  [[nodiscard]] uint64_t to_world(uint64_t local_us) const {
+    auto world_us = boot_us + static_cast<uint64_t>(std::ceil(static_cast<double>(local_us) / rate));
+    while (world_us > boot_us && static_cast<uint64_t>(static_cast<double>(world_us - boot_us) * rate) < local_us) {
+      world_us += 1;
+    }
+    return world_us;
+  }
+
+  World &get_world() {
+    return world;
+  }
+
+  /**
+   * @brief free `resource` with the node
+   */
+  void keep(std::shared_ptr<void> resource) {
+    resources.push_back(std::move(resource));
+  }
+};
+
+/**
+ * @brief a one-shot FreeRTOS software timer, run by the timer daemon of a node
+ *
+ * The period is in ticks (`CONFIG_FREERTOS_HZ` = 100), counted from the tick
+ * it's (re)armed in, so it fires on a tick boundary, up to a tick earlier than
+ * the milliseconds it was converted from.
+ */
+class Timer {
+public:
+  static constexpr uint32_t TICK_US = 10'000;
+
+private:
+  LocalClock &clock;
+  std::function<void()> fn;
+  // a pending expiry is stale if this has changed since
+  std::shared_ptr<uint64_t> generation = std::make_shared<uint64_t>(0);
+
+public:
+  Timer(LocalClock &clock, std::function<void()> fn) : clock(clock), fn(std::move(fn)) {}
+
+  Timer(const Timer &)            = delete;
+  Timer &operator=(const Timer &) = delete;
+
+  static uint32_t ms_to_ticks(uint32_t ms) {
+    return static_cast<uint32_t>(uint64_t{ms} * 1000 / TICK_US);
+  }
+
+  /**
+   * @brief `xTimerChangePeriod`, which (re)starts it
+   */
+  void change_period(uint32_t ticks) {
+    const auto gen    = ++*generation;
+    const auto tick   = clock.now_us() / TICK_US;
+    const auto due_us = (tick + (ticks == 0 ? 1 : ticks)) * TICK_US;
+    clock.get_world().at(clock.to_world(due_us), [this, gen, alive = std::weak_ptr<uint64_t>{generation}] {
+      const auto g = alive.lock();
+      if (g && *g == gen) {
+        const auto scope = LocalClock::Scope{clock};
+        fn();
+      }
+    });
+  }
+
+  void stop() {
+    ++*generation;
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_CLOCK_H
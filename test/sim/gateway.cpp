@@ -0,0 +1,177 @@
+#include "gateway.h"
+
+namespace sim {
+Gateway::Listener::Listener(Gateway &gateway, Medium &medium, const radio_profile::profile_t &profile)
+    : gateway(gateway), medium(medium), profile(profile),
+      node(medium.attach(*this, gateway.config.x, gateway.config.y)) {}
+
+void Gateway::Listener::power(bool on) {
+  if (on) {
+    medium.listen(node, profile);
+  } else {
+    medium.idle(node);
+  }
+}
+
+void Gateway::Listener::on_rx(const rx_t &rx) {
+  if (rx.result == rx_result::ok) {
+    gateway.on_frame(rx.data);
+  }
+}
+
+Gateway::Gateway(World &world, Medium &medium, Tracker &tracker, const gateway_config_t &config)
+    : world(world), medium(medium), tracker(tracker), config(config),
+      clock(world, 0, 0),
+      radio(clock, medium, config.x, config.y, config.radio),
+      slot_clock(config.tdma),
+      channels(config.channels),
+      arq(config.addr, arq::config_t{
+                           .max_attempts = 4,
+                           // a frame waits for a superframe of its own
+                           .base_backoff_ms = 2 * slot_clock.superframe_ms(),
+                           .max_backoff_ms  = 16 * slot_clock.superframe_ms(),
+                       }) {
+  radio.on_receive = [this](const Radio::rx_frame_t &rx) { on_frame(rx.data); };
+  for (uint8_t c = 1; c < channels.channel_count(); ++c) {
+    auto profile     = config.radio.rx_profile;
+    profile.freq_mhz = channels.freq_of(c);
+    listeners.push_back(std::make_unique<Listener>(*this, medium, profile));
+  }
+  power(true);
+  // the superframes start on the end of the first frame
+  slot_clock.sync(static_cast<uint32_t>(config.start_us / 1000));
+  // a second early, to pick the frame and line up its end
+  const auto lead_us = uint64_t{1'000'000};
+  world.at(config.start_us > lead_us ? config.start_us - lead_us : 0, [this] { start_superframe(); });
+}
+
+void Gateway::power(bool value) {
+  on = value;
+  radio.power(value);
+  for (auto &l : listeners) {
+    l->power(value);
+  }
+}
+
+void Gateway::start_superframe() {
+  const auto k      = superframe++;
+  const auto end_us = config.start_us + uint64_t{k} * slot_clock.superframe_ms() * 1000;
+  world.at(end_us + uint64_t{slot_clock.superframe_ms()} * 1000 - 1'000'000, [this] { start_superframe(); });
+  if (!on) {
+    return;
+  }
+  // a reliable frame at most, the rest stay due for the next superframes
+  auto data = std::vector<uint8_t>{};
+  arq.poll(now_ms(), [&data](std::span<const uint8_t> frame) {
+    if (!data.empty()) {
+      return false;
+    }
+    data.assign(frame.begin(), frame.end());
+    return true;
+  });
+  if (data.empty()) {
+    const bool query = config.status_superframes != 0 && k % config.status_superframes == 0;
+    const auto req   = HrLoRa::query_device_by_mac::t{.addr = query ? HrLoRa::broadcast_addr : config.addr};
+    data.resize(HrLoRa::query_device_by_mac::size_needed());
+    HrLoRa::query_device_by_mac::marshal(req, data);
+    _stats.queries += query;
+  }
+  const auto toa = radio_profile::time_on_air_us(config.radio.rx_profile, data.size());
+  // the radio starts after the latency of the task
+  const auto send_us = end_us - toa - config.radio.op_latency_us;
+  world.at(send_us, [this, data = std::move(data)] {
+    if (on && radio.send(data)) {
+      _stats.downlink += 1;
+    }
+  });
+}
+
+void Gateway::on_frame(std::span<const uint8_t> data, bool nested) {
+  if (!on) {
+    return;
+  }
+  auto handler = HrLoRa::hr_lora_msg::overloaded{
+      [&](const HrLoRa::named_hr_data::view &) {
+        _stats.hr_frames += 1;
+        tracker.deliver(data, world.now_us());
+      },
+      [&](const HrLoRa::hr_batch::view &) {
+        _stats.hr_frames += 1;
+        tracker.deliver(data, world.now_us());
+      },
+      [&](const HrLoRa::hr_rr::view &) {
+        _stats.hr_frames += 1;
+        tracker.deliver(data, world.now_us());
+      },
+      [&](const HrLoRa::repeater_status::view &) {
+        _stats.statuses += 1;
+      },
+      [&](const HrLoRa::reliable::view &req) {
+        if (nested || req.dst != config.addr) {
+          return;
+        }
+        const auto ack = HrLoRa::ack::t{.src = config.addr, .dst = req.src, .seq = req.seq};
+        auto buf       = std::vector<uint8_t>(HrLoRa::ack::size_needed());
+        HrLoRa::ack::marshal(ack, buf);
+        send_ack(std::move(buf));
+        if (arq.accept(req.src, req.seq, now_ms())) {
+          on_frame(req.payload, true);
+        }
+      },
+      [&](const HrLoRa::ack::view &req) {
+        if (req.dst == config.addr) {
+          arq.on_ack(req.src, req.seq);
+        }
+      },
+      [](const auto &) {},
+  };
+  if (HrLoRa::hr_lora_msg::modules::dispatch(data, handler) != HrLoRa::dispatch_result::ok) {
+    _stats.bad_frames += 1;
+  }
+}
+
+void Gateway::send_ack(std::vector<uint8_t> ack) {
+  // in the guard time of the slot, ending on its boundary as the first frame
+  // of a superframe does; the ones before it end where it starts
+  const auto now      = now_ms();
+  const auto next     = static_cast<uint16_t>((slot_clock.slot_at(now) + 1) % slot_clock.slot_count());
+  const auto boundary = world.now_us() + uint64_t{slot_clock.delay_until_index(next, now)} * 1000;
+  const auto end_us   = boundary == acks_boundary_us ? acks_start_us : boundary;
+  const auto toa      = radio_profile::time_on_air_us(config.radio.rx_profile, ack.size());
+  const auto send_us  = end_us - toa - config.radio.op_latency_us;
+  acks_boundary_us    = boundary;
+  acks_start_us       = send_us;
+  world.at(send_us, [this, ack = std::move(ack)] {
+    if (on && radio.send(ack)) {
+      _stats.acks_sent += 1;
+    }
+  });
+}
+
+void Gateway::set_key(const HrLoRa::addr_t &repeater, const HrLoRa::addr_t &target, uint8_t key) {
+  const auto req = HrLoRa::set_name_map_key::t{.addr = target, .key = key};
+  uint8_t buf[HrLoRa::set_name_map_key::size_needed()];
+  const auto sz = HrLoRa::set_name_map_key::marshal(req, buf);
+  arq.submit(repeater, std::span<const uint8_t>{buf, sz}, now_ms());
+  _stats.requests += 1;
+}
+
+void Gateway::query(const HrLoRa::addr_t &repeater) {
+  const auto req = HrLoRa::query_device_by_mac::t{.addr = repeater};
+  uint8_t buf[HrLoRa::query_device_by_mac::size_needed()];
+  const auto sz = HrLoRa::query_device_by_mac::marshal(req, buf);
+  arq.submit(repeater, std::span<const uint8_t>{buf, sz}, now_ms());
+  _stats.requests += 1;
+}
+
+fate_counts_t Gateway::counts() const {
+  auto sum = medium.counts(radio.node());
+  for (const auto &l : listeners) {
+    const auto &c = medium.counts(l->get_node());
+    for (size_t i = 0; i < FATE_COUNT; ++i) {
+      sum[i] += c[i];
+    }
+  }
+  return sum;
+}
+}
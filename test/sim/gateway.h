@@ -0,0 +1,155 @@
+#ifndef BLE_LORA_ADAPTER_SIM_GATEWAY_H
+#define BLE_LORA_ADAPTER_SIM_GATEWAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "arq.h"
+#include "channel_plan.h"
+#include "clock.h"
+#include "hr_lora.h"
+#include "medium.h"
+#include "radio.h"
+#include "tdma.h"
+#include "tracker.h"
+
+namespace sim {
+struct gateway_config_t {
+  HrLoRa::addr_t addr;
+  float x;
+  float y;
+  radio_config_t radio;
+  channel_plan::config_t channels;
+  tdma::config_t tdma;
+  /**
+   * @brief when the first downlink frame ends
+   */
+  uint64_t start_us = 1'000'000;
+  /**
+   * @brief a `query_device_by_mac` to every repeater in every this many
+   *        superframes, 0 for never; the other superframes start with one
+   *        to the gateway itself, which no one answers
+   */
+  uint32_t status_superframes = 0;
+};
+
+struct gateway_stats_t {
+  /**
+   * @brief downlink frames, i.e. the beacons, the queries and the reliable ones
+   */
+  uint32_t downlink = 0;
+  uint32_t queries  = 0;
+  /**
+   * @brief the reliable `set_name_map_key` and `query_device_by_mac`, each
+   *        answered with a status
+   */
+  uint32_t requests = 0;
+  uint32_t statuses = 0;
+  /**
+   * @brief `named_hr_data`, `hr_batch` and `hr_rr`
+   */
+  uint32_t hr_frames  = 0;
+  uint32_t acks_sent  = 0;
+  uint32_t bad_frames = 0;
+};
+
+/**
+ * @brief the gateway at the other end of the uplink
+ *
+ * It starts every superframe with a frame that ends on the boundary, since
+ * each frame from the gateway re-aligns the superframe of the repeaters that
+ * hear it (see `tdma::SlotClock::sync`). That's a `query_device_by_mac`, or a
+ * `reliable` one waiting to be (re)transmitted in its place. Acks don't
+ * re-align anything, and go out at the end of the slot they're for, when the
+ * repeater is done sending and listens again.
+ *
+ * There's a receiver per uplink channel, which hears what the receivers
+ * hopping as `channel_plan::Plan::listen_channel` tells would, since in any
+ * slot they listen to every channel between them. The first one is the radio
+ * that transmits, on channel 0.
+ */
+class Gateway {
+  class Listener : public Port {
+    Gateway &gateway;
+    Medium &medium;
+    radio_profile::profile_t profile;
+    node_t node;
+
+  public:
+    Listener(Gateway &gateway, Medium &medium, const radio_profile::profile_t &profile);
+    void power(bool on);
+    [[nodiscard]] node_t get_node() const {
+      return node;
+    }
+    void on_rx(const rx_t &rx) override;
+  };
+
+  World &world;
+  Medium &medium;
+  Tracker &tracker;
+  gateway_config_t config;
+  LocalClock clock;
+  Radio radio;
+  tdma::SlotClock slot_clock;
+  channel_plan::Plan channels;
+  std::vector<std::unique_ptr<Listener>> listeners;
+  arq::Endpoint<256, 32, Radio::MAX_FRAME_SIZE> arq;
+  uint32_t superframe = 0;
+  // the acks scheduled to end on this slot boundary start from here on
+  uint64_t acks_boundary_us = 0;
+  uint64_t acks_start_us    = 0;
+  bool on             = true;
+  gateway_stats_t _stats{};
+
+  [[nodiscard]] uint32_t now_ms() const {
+    return clock.now_ms();
+  }
+  void start_superframe();
+  void on_frame(std::span<const uint8_t> data, bool nested = false);
+  void send_ack(std::vector<uint8_t> ack);
+
+public:
+  Gateway(World &world, Medium &medium, Tracker &tracker, const gateway_config_t &config);
+
+  Gateway(const Gateway &)            = delete;
+  Gateway &operator=(const Gateway &) = delete;
+
+  void power(bool on);
+
+  /**
+   * @brief `set_name_map_key` of `target` (a repeater, or a device of one via
+   *        `repeater`) to `key`, reliably
+   */
+  void set_key(const HrLoRa::addr_t &repeater, const HrLoRa::addr_t &target, uint8_t key);
+
+  /**
+   * @brief `query_device_by_mac` of `repeater`, reliably
+   */
+  void query(const HrLoRa::addr_t &repeater);
+
+  [[nodiscard]] const gateway_stats_t &stats() const {
+    return _stats;
+  }
+
+  [[nodiscard]] const arq::stats_t &arq_stats() const {
+    return arq.stats();
+  }
+
+  [[nodiscard]] const radio_stats_t &radio_stats() const {
+    return radio.stats();
+  }
+
+  /**
+   * @brief the frames at the receivers by fate, summed up
+   */
+  [[nodiscard]] fate_counts_t counts() const;
+
+  [[nodiscard]] uint32_t superframe_ms() const {
+    return slot_clock.superframe_ms();
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_GATEWAY_H
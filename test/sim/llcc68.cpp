@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include "llcc68.h"
+
+namespace sim {
+namespace {
+  enum class kind : uint8_t {
+    unknown,
+    write,
+    read,
+  };
+
+  struct command_t {
+    kind type;
+    /**
+     * @brief the bytes after the opcode: the parameters of a write (at least),
+     *        or the ones of a read before its status byte
+     */
+    uint8_t params;
+  };
+
+  constexpr uint8_t LORA = 0x01;
+
+  // DS_SX1261-2 Table 11-1 to 11-5
+  constexpr command_t command_of(uint8_t opcode) {
+    switch (opcode) {
+      case 0xC0: return {kind::read, 0};  // GetStatus
+      case 0x11: return {kind::read, 0};  // GetPacketType
+      case 0x12: return {kind::read, 0};  // GetIrqStatus
+      case 0x13: return {kind::read, 0};  // GetRxBufferStatus
+      case 0x14: return {kind::read, 0};  // GetPacketStatus
+      case 0x15: return {kind::read, 0};  // GetRssiInst
+      case 0x10: return {kind::read, 0};  // GetStats
+      case 0x17: return {kind::read, 0};  // GetDeviceErrors
+      case 0x1D: return {kind::read, 2};  // ReadRegister
+      case 0x1E: return {kind::read, 1};  // ReadBuffer
+      case 0x84: return {kind::write, 1}; // SetSleep
+      case 0x80: return {kind::write, 1}; // SetStandby
+      case 0xC1: return {kind::write, 0}; // SetFs
+      case 0x83: return {kind::write, 3}; // SetTx
+      case 0x82: return {kind::write, 3}; // SetRx
+      case 0x94: return {kind::write, 6}; // SetRxDutyCycle
+      case 0xC5: return {kind::write, 0}; // SetCad
+      case 0xD1: return {kind::write, 0}; // SetTxContinuousWave
+      case 0xD2: return {kind::write, 0}; // SetTxInfinitePreamble
+      case 0x96: return {kind::write, 1}; // SetRegulatorMode
+      case 0x89: return {kind::write, 1}; // Calibrate
+      case 0x98: return {kind::write, 2}; // CalibrateImage
+      case 0x95: return {kind::write, 4}; // SetPaConfig
+      case 0x93: return {kind::write, 1}; // SetRxTxFallbackMode
+      case 0x0D: return {kind::write, 2}; // WriteRegister
+      case 0x0E: return {kind::write, 1}; // WriteBuffer
+      case 0x08: return {kind::write, 8}; // SetDioIrqParams
+      case 0x02: return {kind::write, 2}; // ClearIrqStatus
+      case 0x9D: return {kind::write, 1}; // SetDIO2AsRfSwitchCtrl
+      case 0x97: return {kind::write, 4}; // SetDIO3AsTcxoCtrl
+      case 0x86: return {kind::write, 4}; // SetRfFrequency
+      case 0x8A: return {kind::write, 1}; // SetPacketType
+      case 0x8E: return {kind::write, 2}; // SetTxParams
+      case 0x8B: return {kind::write, 4}; // SetModulationParams
+      case 0x8C: return {kind::write, 6}; // SetPacketParams
+      case 0x88: return {kind::write, 7}; // SetCadParams
+      case 0x8F: return {kind::write, 2}; // SetBufferBaseAddress
+      case 0x9F: return {kind::write, 1}; // StopTimerOnPreamble
+      case 0xA0: return {kind::write, 1}; // SetLoRaSymbNumTimeout
+      case 0x07: return {kind::write, 2}; // ClearDeviceErrors
+      default: return {kind::unknown, 0};
+    }
+  }
+
+  // SetModulationParams, LoRa
+  float bw_of(uint8_t code) {
+    switch (code) {
+      case 0x00: return 7.8f;
+      case 0x08: return 10.4f;
+      case 0x01: return 15.6f;
+      case 0x09: return 20.8f;
+      case 0x02: return 31.25f;
+      case 0x0A: return 41.7f;
+      case 0x03: return 62.5f;
+      case 0x04: return 125.0f;
+      case 0x05: return 250.0f;
+      case 0x06: return 500.0f;
+      default: return 0;
+    }
+  }
+
+  uint32_t be(std::span<const uint8_t> bytes) {
+    uint32_t v = 0;
+    for (const auto b : bytes) {
+      v = (v << 8) | b;
+    }
+    return v;
+  }
+}
+
+Llcc68::Llcc68(World &world, Medium &medium, float x, float y)
+    : world(world), medium(medium), node(medium.attach(*this, x, y)) {
+  reset();
+}
+
+void Llcc68::reset() {
+  set_mode(mode::stby_rc);
+  selected    = false;
+  last_status = cmd_status::ok;
+  command.clear();
+  packet_type  = 0;
+  profile      = radio_profile::DEFAULT_PROFILE;
+  profile.name = "llcc68";
+  payload_len  = 0xff;
+  buffer.fill(0);
+  tx_base   = 0;
+  rx_base   = 0;
+  irq_mask  = 0;
+  dio1_mask = 0;
+  _irq      = 0;
+  registers.clear();
+  // the private LoRa sync word
+  registers[REG_SYNC_WORD]     = 0x14;
+  registers[REG_SYNC_WORD + 1] = 0x24;
+}
+
+uint8_t Llcc68::status() const {
+  return static_cast<uint8_t>(static_cast<uint8_t>(_mode) << 4 | static_cast<uint8_t>(last_status) << 1);
+}
+
+uint8_t Llcc68::read_register(uint16_t addr) const {
+  constexpr auto version_len = std::char_traits<char>::length(VERSION_STRING);
+  if (addr >= REG_VERSION_STRING && addr < REG_VERSION_STRING + 16) {
+    const auto i = static_cast<size_t>(addr - REG_VERSION_STRING);
+    return i < version_len ? static_cast<uint8_t>(VERSION_STRING[i]) : 0;
+  }
+  const auto it = registers.find(addr);
+  return it == registers.end() ? 0 : it->second;
+}
+
+uint8_t Llcc68::response(size_t index) {
+  const auto cmd = command_of(command[0]);
+  if (cmd.type == kind::unknown) {
+    return static_cast<uint8_t>(status() & ~0x0e) | static_cast<uint8_t>(cmd_status::invalid) << 1;
+  }
+  if (cmd.type != kind::read || index < size_t{cmd.params} + 2) {
+    return status();
+  }
+  const auto i  = index - cmd.params - 2;
+  auto u16      = [i](uint16_t v) -> uint8_t { return i == 0 ? v >> 8 : i == 1 ? v & 0xff : 0; };
+  auto rssi_raw = [](float dbm) { return static_cast<uint8_t>(std::clamp(-2.0f * dbm, 0.0f, 255.0f)); };
+  switch (command[0]) {
+    case 0x11: return i == 0 ? packet_type : 0;
+    case 0x12: return u16(_irq);
+    case 0x13: return i == 0 ? rx_len : i == 1 ? rx_start : 0;
+    case 0x14: {
+      const auto snr = static_cast<int8_t>(std::clamp(std::lround(snr_db * 4), -128L, 127L));
+      return i == 0 ? rssi_raw(rssi_dbm) : i == 1 ? static_cast<uint8_t>(snr) : i == 2 ? rssi_raw(rssi_dbm) : 0;
+    }
+    case 0x15: return i == 0 ? rssi_raw(-110) : 0;
+    case 0x1D: return read_register(static_cast<uint16_t>(be({command.data() + 1, 2}) + i));
+    case 0x1E: return buffer[(command[1] + i) % buffer.size()];
+    // GetStatus, GetStats, GetDeviceErrors
+    default: return 0;
+  }
+}
+
+void Llcc68::select() {
+  if (_mode == mode::sleep) {
+    // NSS wakes it up
+    set_mode(mode::stby_rc);
+  }
+  selected = true;
+  command.clear();
+}
+
+uint8_t Llcc68::exchange(uint8_t out) {
+  if (!selected) {
+    return 0;
+  }
+  command.push_back(out);
+  return response(command.size() - 1);
+}
+
+void Llcc68::deselect() {
+  if (!selected) {
+    return;
+  }
+  selected = false;
+  if (!command.empty()) {
+    execute();
+  }
+  command.clear();
+}
+
+std::vector<uint8_t> Llcc68::transfer(std::span<const uint8_t> out) {
+  auto in = std::vector<uint8_t>{};
+  select();
+  for (const auto b : out) {
+    in.push_back(exchange(b));
+  }
+  deselect();
+  return in;
+}
+
+void Llcc68::set_mode(mode m) {
+  generation += 1;
+  if (m != mode::rx) {
+    medium.idle(node);
+  }
+  _mode = m;
+}
+
+void Llcc68::raise(uint16_t bits) {
+  const bool before = dio1();
+  _irq |= bits & irq_mask;
+  if (!before && dio1() && on_dio1 != nullptr) {
+    on_dio1();
+  }
+}
+
+void Llcc68::execute() {
+  const auto cmd = command_of(command[0]);
+  if (cmd.type == kind::unknown || command.size() < size_t{cmd.params} + 1) {
+    last_status = cmd_status::invalid;
+    return;
+  }
+  last_status  = cmd_status::ok;
+  const auto p = std::span<const uint8_t>{command}.subspan(1);
+  switch (command[0]) {
+    case 0x84: set_mode(mode::sleep); break;
+    case 0x80: set_mode(p[0] == 0 ? mode::stby_rc : mode::stby_xosc); break;
+    case 0xC1: set_mode(mode::fs); break;
+    case 0x83: start_tx(); break;
+    case 0x82: start_rx(be(p.subspan(0, 3))); break;
+    case 0x94: start_rx(0xffffff); break;
+    case 0xC5: start_cad(); break;
+    case 0x0D:
+      for (size_t i = 2; i < p.size(); ++i) {
+        registers[static_cast<uint16_t>(be(p.subspan(0, 2)) + i - 2)] = p[i];
+      }
+      break;
+    case 0x0E:
+      for (size_t i = 1; i < p.size(); ++i) {
+        buffer[(p[0] + i - 1) % buffer.size()] = p[i];
+      }
+      break;
+    case 0x08:
+      irq_mask  = static_cast<uint16_t>(be(p.subspan(0, 2)));
+      dio1_mask = static_cast<uint16_t>(be(p.subspan(2, 2)));
+      break;
+    case 0x02: _irq &= static_cast<uint16_t>(~be(p.subspan(0, 2))); break;
+    case 0x86: {
+      // in steps of 32 MHz / 2^25, rounded to kHz to compare with the other radios
+      const auto hz    = static_cast<double>(be(p.subspan(0, 4))) * 32e6 / (1 << 25);
+      profile.freq_mhz = static_cast<float>(std::round(hz / 1e3) / 1e3);
+      break;
+    }
+    case 0x8A: packet_type = p[0]; break;
+    case 0x8E: profile.power_dbm = static_cast<int8_t>(p[0]); break;
+    case 0x8B:
+      profile.sf     = p[0];
+      profile.bw_khz = bw_of(p[1]);
+      profile.cr     = static_cast<uint8_t>(p[2] + 4);
+      break;
+    case 0x8C:
+      profile.preamble_len = static_cast<uint16_t>(be(p.subspan(0, 2)));
+      payload_len          = p[3];
+      break;
+    case 0x88:
+      cad_symbols = static_cast<uint8_t>(1 << std::min<uint8_t>(p[0], 4));
+      cad_exit_rx = p[3] == 0x01;
+      break;
+    case 0x8F:
+      tx_base = p[0];
+      rx_base = p[1];
+      break;
+    default:
+      // the ones that change nothing here, e.g. the calibration, and the reads
+      break;
+  }
+}
+
+void Llcc68::start_tx() {
+  if (packet_type != LORA) {
+    last_status = cmd_status::failed;
+    return;
+  }
+  auto data = std::vector<uint8_t>(payload_len);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = buffer[(tx_base + i) % buffer.size()];
+  }
+  set_mode(mode::tx);
+  const auto end = medium.transmit(node, profile, data);
+  world.at(end, [this, gen = generation] {
+    if (gen != generation) {
+      return;
+    }
+    set_mode(mode::stby_rc);
+    raise(TX_DONE);
+  });
+}
+
+void Llcc68::start_rx(uint32_t timeout) {
+  if (packet_type != LORA) {
+    last_status = cmd_status::failed;
+    return;
+  }
+  set_mode(mode::rx);
+  medium.listen(node, profile);
+  // 0 for single without a timeout, 0xffffff for continuous
+  rx_single = timeout != 0xffffff;
+  if (timeout == 0 || timeout == 0xffffff) {
+    return;
+  }
+  // in steps of 15.625 us
+  const auto timeout_us = uint64_t{timeout} * 15'625 / 1000;
+  world.after(timeout_us, [this, gen = generation, since = received] {
+    if (gen != generation || received != since) {
+      return;
+    }
+    set_mode(mode::stby_rc);
+    raise(TIMEOUT);
+  });
+}
+
+void Llcc68::start_cad() {
+  if (packet_type != LORA) {
+    last_status = cmd_status::failed;
+    return;
+  }
+  set_mode(mode::rx);
+  medium.idle(node);
+  const auto from   = world.now_us();
+  const auto cad_us = cad_symbols * radio_profile::symbol_time_us(profile);
+  world.after(cad_us, [this, gen = generation, from] {
+    if (gen != generation) {
+      return;
+    }
+    const bool detected = medium.cad(node, profile, from);
+    if (detected && cad_exit_rx) {
+      start_rx(0);
+    } else {
+      set_mode(mode::stby_rc);
+    }
+    raise(detected ? CAD_DONE | CAD_DETECTED : CAD_DONE);
+  });
+}
+
+void Llcc68::on_rx(const rx_t &rx) {
+  if (_mode != mode::rx) {
+    return;
+  }
+  received += 1;
+  rssi_dbm = rx.rssi_dbm;
+  snr_db   = rx.snr_db;
+  if (rx.result == rx_result::header_error) {
+    raise(PREAMBLE_DETECTED | SYNC_WORD_VALID | HEADER_ERR);
+    return;
+  }
+  rx_start = rx_base;
+  rx_len   = static_cast<uint8_t>(std::min(rx.data.size(), buffer.size()));
+  for (size_t i = 0; i < rx_len; ++i) {
+    buffer[(rx_base + i) % buffer.size()] = rx.data[i];
+  }
+  if (rx_single) {
+    set_mode(mode::stby_rc);
+  }
+  uint16_t bits = PREAMBLE_DETECTED | SYNC_WORD_VALID | HEADER_VALID | RX_DONE;
+  if (rx.result == rx_result::crc_error) {
+    bits |= CRC_ERR;
+  }
+  raise(bits);
+}
+}
@@ -0,0 +1,184 @@
+#ifndef BLE_LORA_ADAPTER_SIM_LLCC68_H
+#define BLE_LORA_ADAPTER_SIM_LLCC68_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <span>
+#include <vector>
+#include "medium.h"
+#include "radio_profile.h"
+#include "world.h"
+
+/**
+ * @brief an LLCC68 as its SPI commands see it, on the simulated medium
+ *
+ * What's modelled is the command set of the SX126x family (DS_SX1261-2 13)
+ * that RadioLib drives a LoRa radio with: the modes and their transitions,
+ * the packet and modulation parameters, the 256-byte buffer, the registers,
+ * and the IRQ status with DIO1. A command is executed when NSS goes high;
+ * a read command returns its data while it's clocked out. BUSY is always low,
+ * since the commands take no time here.
+ *
+ * Not modelled: FSK, the sync word filter (frames with any sync word are
+ * heard), the RX duty cycle (`SetRxDutyCycle` receives continuously), the TX
+ * timeout, and a preamble detected before the frame ends (RX timeouts fire
+ * unless a frame has ended since).
+ */
+namespace sim {
+class Llcc68 : public Port {
+public:
+  /**
+   * @brief the bits of the IRQ status
+   */
+  enum irq : uint16_t {
+    TX_DONE           = 1 << 0,
+    RX_DONE           = 1 << 1,
+    PREAMBLE_DETECTED = 1 << 2,
+    SYNC_WORD_VALID   = 1 << 3,
+    HEADER_VALID      = 1 << 4,
+    HEADER_ERR        = 1 << 5,
+    CRC_ERR           = 1 << 6,
+    CAD_DONE          = 1 << 7,
+    CAD_DETECTED      = 1 << 8,
+    TIMEOUT           = 1 << 9,
+  };
+
+  /**
+   * @brief the chip mode in bits 6:4 of the status
+   */
+  enum class mode : uint8_t {
+    sleep     = 0,
+    stby_rc   = 2,
+    stby_xosc = 3,
+    fs        = 4,
+    rx        = 5,
+    tx        = 6,
+  };
+
+  /**
+   * @brief the command status in bits 3:1 of the status
+   */
+  enum class cmd_status : uint8_t {
+    ok             = 0,
+    data_available = 2,
+    timeout        = 3,
+    invalid        = 4,
+    failed         = 5,
+    tx_done        = 6,
+  };
+
+  static constexpr uint16_t REG_VERSION_STRING = 0x0320;
+  static constexpr uint16_t REG_SYNC_WORD      = 0x0740;
+  static constexpr auto VERSION_STRING         = "LLCC68 V2D 2D02";
+
+private:
+  World &world;
+  Medium &medium;
+  node_t node;
+
+  // the command being clocked in
+  bool selected = false;
+  std::vector<uint8_t> command;
+
+  mode _mode             = mode::stby_rc;
+  cmd_status last_status = cmd_status::ok;
+  uint8_t packet_type    = 0;
+  radio_profile::profile_t profile;
+  uint8_t payload_len = 0xff;
+  std::array<uint8_t, 256> buffer{};
+  uint8_t tx_base = 0;
+  uint8_t rx_base = 0;
+  std::map<uint16_t, uint8_t> registers;
+  uint16_t irq_mask   = 0;
+  uint16_t dio1_mask  = 0;
+  uint16_t _irq       = 0;
+  uint8_t cad_symbols = 2;
+  bool cad_exit_rx    = false;
+  // single RX (back to standby after a frame) or continuous
+  bool rx_single   = false;
+  uint8_t rx_len   = 0;
+  uint8_t rx_start = 0;
+  float rssi_dbm   = 0;
+  float snr_db     = 0;
+  // bumped whenever the mode changes, so that pending events become stale
+  uint64_t generation = 0;
+  uint64_t received   = 0;
+
+  [[nodiscard]] uint8_t status() const;
+  /**
+   * @return the byte clocked out at `index` of the command being clocked in
+   */
+  [[nodiscard]] uint8_t response(size_t index);
+  [[nodiscard]] uint8_t read_register(uint16_t addr) const;
+  void execute();
+  void set_mode(mode m);
+  void raise(uint16_t bits);
+  void start_tx();
+  void start_rx(uint32_t timeout);
+  void start_cad();
+
+public:
+  /**
+   * @brief called when DIO1 goes high, i.e. the interrupt of the MCU
+   */
+  std::function<void()> on_dio1 = nullptr;
+
+  Llcc68(World &world, Medium &medium, float x, float y);
+
+  Llcc68(const Llcc68 &)            = delete;
+  Llcc68 &operator=(const Llcc68 &) = delete;
+
+  /**
+   * @brief NRST, which puts it in STBY_RC with the defaults
+   */
+  void reset();
+
+  /**
+   * @brief NSS goes low
+   */
+  void select();
+
+  /**
+   * @brief clock a byte in and out
+   */
+  uint8_t exchange(uint8_t out);
+
+  /**
+   * @brief NSS goes high, which executes the command
+   */
+  void deselect();
+
+  /**
+   * @brief a whole command, from NSS low to NSS high
+   * @return the bytes clocked out
+   */
+  std::vector<uint8_t> transfer(std::span<const uint8_t> out);
+
+  [[nodiscard]] bool dio1() const {
+    return (_irq & dio1_mask) != 0;
+  }
+
+  [[nodiscard]] bool busy() const {
+    return false;
+  }
+
+  [[nodiscard]] mode get_mode() const {
+    return _mode;
+  }
+
+  [[nodiscard]] uint16_t irq_status() const {
+    return _irq;
+  }
+
+  [[nodiscard]] node_t get_node() const {
+    return node;
+  }
+
+  void on_rx(const rx_t &rx) override;
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_LLCC68_H
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cmath>
+#include "medium.h"
+
+namespace sim {
+namespace {
+  /**
+   * @brief frames that ended longer ago than this are forgotten; longer than any frame
+   */
+  constexpr uint64_t HISTORY_US = 10'000'000;
+
+  float to_mw(float dbm) {
+    return std::pow(10.0f, dbm / 10.0f);
+  }
+
+  float to_dbm(float mw) {
+    return 10.0f * std::log10(mw);
+  }
+}
+
+node_t Medium::attach(Port &port, float x, float y) {
+  nodes.push_back(node_info_t{.port = &port, .x = x, .y = y});
+  return nodes.size() - 1;
+}
+
+float Medium::link_loss_db(node_t a, node_t b) {
+  const auto key = std::minmax(a, b);
+  auto it        = shadowing.find(key);
+  if (it == shadowing.end()) {
+    const auto s = config.shadowing_db > 0 ? std::normal_distribution<float>{0, config.shadowing_db}(world.rng()) : 0.0f;
+    it           = shadowing.emplace(key, s).first;
+  }
+  const auto dx = nodes[a].x - nodes[b].x;
+  const auto dy = nodes[a].y - nodes[b].y;
+  const auto d  = std::max(1.0f, std::sqrt(dx * dx + dy * dy));
+  return config.ref_loss_db + 10.0f * config.path_loss_exponent * std::log10(d) + it->second;
+}
+
+float Medium::rx_power_dbm(node_t src, node_t dst, int8_t power_dbm) {
+  return static_cast<float>(power_dbm) - link_loss_db(src, dst);
+}
+
+float Medium::noise_dbm(const radio_profile::profile_t &p) const {
+  return -174.0f + 10.0f * std::log10(p.bw_khz * 1000.0f) + config.noise_figure_db;
+}
+
+bool Medium::hears(const radio_profile::profile_t &rx, const radio_profile::profile_t &tx) {
+  return rx.freq_mhz == tx.freq_mhz && rx.bw_khz == tx.bw_khz && rx.sf == tx.sf;
+}
+
+Medium::tx_t *Medium::find(uint64_t id) {
+  const auto it = std::ranges::find_if(txs, [id](const auto &t) { return t.id == id; });
+  return it == txs.end() ? nullptr : &*it;
+}
+
+void Medium::listen(node_t node, const radio_profile::profile_t &profile) {
+  auto &n = nodes[node];
+  if (n.listening && !hears(n.rx_profile, profile)) {
+    n.locked = 0;
+  }
+  n.listening  = true;
+  n.rx_profile = profile;
+}
+
+void Medium::idle(node_t node) {
+  auto &n     = nodes[node];
+  n.listening = false;
+  n.locked    = 0;
+}
+
+uint64_t Medium::transmit(node_t node, const radio_profile::profile_t &profile, std::span<const uint8_t> data) {
+  idle(node);
+  prune();
+  const auto now   = world.now_us();
+  const auto t_sym = radio_profile::symbol_time_us(profile);
+  auto tx          = tx_t{
+               .id      = next_id++,
+               .src     = node,
+               .profile = profile,
+               .data    = std::vector<uint8_t>(data.begin(), data.end()),
+               // preamble, sync word, and the header in the first 8 symbols
+               .start_us      = now,
+               .header_end_us = now + (profile.preamble_len * 4 + 17) * t_sym / 4 + 8 * t_sym,
+               .end_us        = now + radio_profile::time_on_air_us(profile, data.size()),
+  };
+  auto fading = std::normal_distribution<float>{0, config.fading_db > 0 ? config.fading_db : 1e-6f};
+  for (node_t i = 0; i < nodes.size(); ++i) {
+    auto &n = nodes[i];
+    if (i == node || !hears(n.rx_profile, profile)) {
+      continue;
+    }
+    if (!n.listening) {
+      tx.missed.emplace_back(i, fate::deaf);
+      continue;
+    }
+    if (n.locked != 0) {
+      tx.missed.emplace_back(i, fate::busy);
+      continue;
+    }
+    const auto rssi = rx_power_dbm(node, i, profile.power_dbm) + fading(world.rng());
+    const auto snr  = rssi - noise_dbm(profile);
+    if (snr < radio_profile::required_snr_db(profile.sf)) {
+      tx.missed.emplace_back(i, fate::weak);
+      continue;
+    }
+    n.locked = tx.id;
+    tx.receptions.push_back(reception_t{.node = i, .rssi_dbm = rssi, .snr_db = std::min(snr, config.max_snr_db)});
+  }
+  const auto id  = tx.id;
+  const auto end = tx.end_us;
+  txs.push_back(std::move(tx));
+  _frames += 1;
+  world.at(end, [this, id] { finish(id); });
+  return end;
+}
+
+void Medium::finish(uint64_t id) {
+  const auto *tx_ptr = find(id);
+  if (tx_ptr == nullptr) {
+    return;
+  }
+  // the ports might transmit in `on_rx`, which invalidates `tx_ptr`
+  const auto tx = *tx_ptr;
+  for (const auto &[node, f] : tx.missed) {
+    nodes[node].counts[static_cast<size_t>(f)] += 1;
+  }
+  struct delivery_t {
+    Port *port;
+    rx_t rx;
+  };
+  auto deliveries = std::vector<delivery_t>{};
+  for (const auto &r : tx.receptions) {
+    auto &n = nodes[r.node];
+    if (n.locked != id) {
+      n.counts[static_cast<size_t>(fate::deaf)] += 1;
+      continue;
+    }
+    n.locked = 0;
+    if (config.loss > 0 && world.uniform() < config.loss) {
+      n.counts[static_cast<size_t>(fate::lost)] += 1;
+      continue;
+    }
+    // the sum of the frames that overlapped it, in the header and in all
+    float header_mw = 0;
+    float total_mw  = 0;
+    for (const auto &g : txs) {
+      if (g.id == id || g.src == r.node || g.profile.freq_mhz != tx.profile.freq_mhz ||
+          g.start_us >= tx.end_us || g.end_us <= tx.start_us) {
+        continue;
+      }
+      auto p = rx_power_dbm(g.src, r.node, g.profile.power_dbm);
+      if (g.profile.sf != tx.profile.sf || g.profile.bw_khz != tx.profile.bw_khz) {
+        p -= config.sf_rejection_db;
+      }
+      total_mw += to_mw(p);
+      if (g.start_us < tx.header_end_us) {
+        header_mw += to_mw(p);
+      }
+    }
+    auto result = rx_result::ok;
+    if (header_mw > 0 && r.rssi_dbm - to_dbm(header_mw) < config.capture_db) {
+      result = rx_result::header_error;
+    } else if (total_mw > 0 && r.rssi_dbm - to_dbm(total_mw) < config.capture_db) {
+      result = rx_result::crc_error;
+    }
+    n.counts[static_cast<size_t>(result == rx_result::ok ? fate::ok : fate::collided)] += 1;
+    deliveries.push_back(delivery_t{
+        .port = n.port,
+        .rx   = rx_t{
+              .src      = tx.src,
+              .data     = tx.data,
+              .rssi_dbm = r.rssi_dbm,
+              .snr_db   = r.snr_db,
+              .result   = result,
+              .start_us = tx.start_us,
+              .end_us   = tx.end_us,
+        },
+    });
+  }
+  for (const auto &d : deliveries) {
+    d.port->on_rx(d.rx);
+  }
+}
+
+bool Medium::cad(node_t node, const radio_profile::profile_t &profile, uint64_t from_us) {
+  const auto now = world.now_us();
+  auto fading    = std::normal_distribution<float>{0, config.fading_db > 0 ? config.fading_db : 1e-6f};
+  bool detected  = false;
+  for (const auto &g : txs) {
+    if (g.src == node || !hears(profile, g.profile) || g.start_us > now || g.end_us <= from_us) {
+      continue;
+    }
+    const auto snr = rx_power_dbm(g.src, node, g.profile.power_dbm) + fading(world.rng()) - noise_dbm(g.profile);
+    if (snr < radio_profile::required_snr_db(g.profile.sf)) {
+      continue;
+    }
+    const auto t_sym        = radio_profile::symbol_time_us(g.profile);
+    const auto preamble_end = g.start_us + g.profile.preamble_len * t_sym;
+    // CAD looks for chirps; the ones of the preamble are the easiest to find
+    detected = detected || from_us < preamble_end || world.uniform() < config.cad_payload_detect;
+  }
+  return detected;
+}
+
+void Medium::prune() {
+  const auto now = world.now_us();
+  while (!txs.empty() && txs.front().end_us + HISTORY_US < now) {
+    txs.pop_front();
+  }
+}
+}
@@ -0,0 +1,262 @@
+#ifndef BLE_LORA_ADAPTER_SIM_MEDIUM_H
+#define BLE_LORA_ADAPTER_SIM_MEDIUM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+#include "radio_profile.h"
+#include "world.h"
+
+/**
+ * @brief the air between the simulated radios
+ *
+ * A frame takes `radio_profile::time_on_air_us` on the channel. The power
+ * at a receiver is the TX power less a log-distance path loss, a shadowing
+ * fixed per link and a fading drawn per frame. A receiver that is listening
+ * with the same frequency, bandwidth and SF when a frame starts, and hears
+ * it above `radio_profile::required_snr_db`, locks onto it until it ends
+ * (a LoRa receiver demodulates one frame at a time). At the end, the frame
+ * is lost if the other frames that overlapped it on the same frequency
+ * sum up to less than `config_t::capture_db` below it (the ones with another
+ * SF count `config_t::sf_rejection_db` less). An overlap with the preamble
+ * or the header is a header error, and with the payload a CRC error; both
+ * are reported to the receiver, as the radio would raise an IRQ for them.
+ *
+ * A radio is half duplex: one that is not listening (transmitting, in CAD,
+ * in standby) hears nothing, and one that stops listening in the middle of
+ * a frame loses it.
+ */
+namespace sim {
+using node_t = size_t;
+
+enum class rx_result : uint8_t {
+  ok,
+  header_error,
+  crc_error,
+};
+
+struct rx_t {
+  node_t src;
+  std::span<const uint8_t> data;
+  float rssi_dbm;
+  float snr_db;
+  rx_result result;
+  uint64_t start_us;
+  uint64_t end_us;
+};
+
+/**
+ * @brief what became of a frame at a receiver on its channel
+ */
+enum class fate : uint8_t {
+  ok,
+  /**
+   * @brief overlapped by other frames, including the header and CRC errors
+   */
+  collided,
+  /**
+   * @brief already receiving another frame when it started
+   */
+  busy,
+  /**
+   * @brief below the sensitivity
+   */
+  weak,
+  /**
+   * @brief not listening (transmitting, CAD, standby) when it started, or stopped in the middle
+   */
+  deaf,
+  /**
+   * @brief lost at random, see `config_t::loss`
+   */
+  lost,
+};
+
+constexpr size_t FATE_COUNT = 6;
+
+using fate_counts_t = std::array<uint32_t, FATE_COUNT>;
+
+constexpr const char *to_string(fate f) {
+  constexpr const char *names[FATE_COUNT] = {"ok", "collided", "busy", "weak", "deaf", "lost"};
+  return names[static_cast<size_t>(f)];
+}
+
+/**
+ * @brief a radio attached to the medium
+ */
+class Port {
+public:
+  virtual ~Port() = default;
+  /**
+   * @brief the end of a frame this port has locked onto
+   * @note `rx.data` is valid in the call only
+   */
+  virtual void on_rx(const rx_t &rx) = 0;
+};
+
+struct medium_config_t {
+  /**
+   * @brief path loss at 1 m; free space at 433 MHz
+   */
+  float ref_loss_db        = 25.2f;
+  float path_loss_exponent = 2.7f;
+  /**
+   * @brief standard deviation of the shadowing, fixed per link for the run
+   */
+  float shadowing_db = 4.0f;
+  /**
+   * @brief standard deviation of the fading, drawn per frame and receiver
+   */
+  float fading_db       = 2.0f;
+  float noise_figure_db = 6.0f;
+  /**
+   * @brief a frame survives if it's this much stronger than the sum of the overlapping ones
+   */
+  float capture_db = 6.0f;
+  /**
+   * @brief how much weaker a frame with another SF interferes
+   */
+  float sf_rejection_db = 16.0f;
+  /**
+   * @brief the chance a frame is missed anyway, e.g. by what's not modelled
+   */
+  float loss = 0.0f;
+  /**
+   * @brief the chance CAD detects a frame whose preamble it doesn't overlap
+   */
+  float cad_payload_detect = 0.5f;
+  /**
+   * @brief the SNR the radio reports saturates about here
+   */
+  float max_snr_db = 12.0f;
+};
+
+class Medium {
+  struct node_info_t {
+    Port *port;
+    float x;
+    float y;
+    bool listening = false;
+    /**
+     * @brief what it listens (or has last listened) with
+     */
+    radio_profile::profile_t rx_profile{};
+    /**
+     * @brief the frame it's receiving, 0 for none
+     */
+    uint64_t locked = 0;
+    fate_counts_t counts{};
+  };
+
+  struct reception_t {
+    node_t node;
+    float rssi_dbm;
+    float snr_db;
+  };
+
+  struct tx_t {
+    uint64_t id;
+    node_t src;
+    radio_profile::profile_t profile;
+    std::vector<uint8_t> data;
+    uint64_t start_us;
+    uint64_t header_end_us;
+    uint64_t end_us;
+    /**
+     * @brief the receivers locked onto it
+     */
+    std::vector<reception_t> receptions;
+    /**
+     * @brief the fate at the other receivers on the channel, decided at the start
+     */
+    std::vector<std::pair<node_t, fate>> missed;
+  };
+
+  World &world;
+  medium_config_t config;
+  std::vector<node_info_t> nodes;
+  // the frames on the air, and the ones that ended recently (for the overlaps)
+  std::deque<tx_t> txs;
+  uint64_t next_id = 1;
+  std::map<std::pair<node_t, node_t>, float> shadowing;
+  uint64_t _frames = 0;
+
+  [[nodiscard]] float link_loss_db(node_t a, node_t b);
+  [[nodiscard]] float noise_dbm(const radio_profile::profile_t &p) const;
+  [[nodiscard]] static bool hears(const radio_profile::profile_t &rx, const radio_profile::profile_t &tx);
+  void finish(uint64_t id);
+  void prune();
+  tx_t *find(uint64_t id);
+
+public:
+  Medium(World &world, medium_config_t config) : world(world), config(config) {}
+
+  Medium(const Medium &)            = delete;
+  Medium &operator=(const Medium &) = delete;
+
+  node_t attach(Port &port, float x, float y);
+
+  void move(node_t node, float x, float y) {
+    nodes[node].x = x;
+    nodes[node].y = y;
+  }
+
+  /**
+   * @brief start (or keep) listening with the modulation and the frequency of `profile`
+   * @note a frame in progress is kept if the modulation doesn't change
+   */
+  void listen(node_t node, const radio_profile::profile_t &profile);
+
+  /**
+   * @brief stop listening, losing the frame being received
+   */
+  void idle(node_t node);
+
+  /**
+   * @brief put `data` on the air from `node` with `profile` (including the power)
+   * @return when it ends
+   * @note the node stops listening
+   */
+  uint64_t transmit(node_t node, const radio_profile::profile_t &profile, std::span<const uint8_t> data);
+
+  /**
+   * @brief channel activity detection at `node` in [`from_us`, now]
+   * @return whether a frame with the SF of `profile` is detected on its frequency
+   */
+  bool cad(node_t node, const radio_profile::profile_t &profile, uint64_t from_us);
+
+  /**
+   * @brief the power of `src` at `dst` without the fading, in dBm
+   */
+  [[nodiscard]] float rx_power_dbm(node_t src, node_t dst, int8_t power_dbm);
+
+  /**
+   * @brief the frames at `node`, which it (would) listen to, by fate
+   */
+  [[nodiscard]] const fate_counts_t &counts(node_t node) const {
+    return nodes[node].counts;
+  }
+
+  /**
+   * @brief frames put on the air
+   */
+  [[nodiscard]] uint64_t frames() const {
+    return _frames;
+  }
+
+  [[nodiscard]] const medium_config_t &get_config() const {
+    return config;
+  }
+
+  void set_loss(float loss) {
+    config.loss = loss;
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_MEDIUM_H
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include "radio.h"
+
+namespace sim {
+Radio::Radio(LocalClock &clock, Medium &medium, float x, float y, radio_config_t config)
+    : clock(clock), medium(medium), _node(medium.attach(*this, x, y)), config(config),
+      tx_profile(config.rx_profile), backoff(config.lbt), ledger(config.duty_cycle) {}
+
+void Radio::power(bool on) {
+  if (!on) {
+    state = state_t::off;
+    queue.clear();
+    medium.idle(_node);
+    return;
+  }
+  if (state == state_t::off) {
+    state = state_t::idle;
+    start_receive();
+    next();
+  }
+}
+
+radio_profile::profile_t Radio::profile_of(const frame_t &frame) const {
+  auto profile = tx_profile;
+  if (frame.freq_mhz != 0) {
+    profile.freq_mhz = frame.freq_mhz;
+  }
+  return profile;
+}
+
+void Radio::start_receive() {
+  medium.listen(_node, config.rx_profile);
+}
+
+bool Radio::send(std::span<const uint8_t> data, airtime::traffic_class cls, float freq_mhz) {
+  if (state == state_t::off) {
+    return false;
+  }
+  if (data.empty() || data.size() > MAX_FRAME_SIZE || queue.size() >= QUEUE_LENGTH) {
+    _stats.dropped += 1;
+    return false;
+  }
+  queue.push_back(frame_t{
+      .cls       = cls,
+      .freq_mhz  = freq_mhz,
+      .queued_ms = clock.now_ms(),
+      .data      = std::vector<uint8_t>(data.begin(), data.end()),
+  });
+  if (state == state_t::idle) {
+    world().after(config.op_latency_us, [this] { next(); });
+  }
+  return true;
+}
+
+void Radio::next() {
+  if (state != state_t::idle || queue.empty()) {
+    return;
+  }
+  current = std::move(queue.front());
+  queue.pop_front();
+  backoff.reset();
+  try_transmit();
+}
+
+void Radio::try_transmit() {
+  if (!config.lbt.enabled) {
+    start_transmit();
+    return;
+  }
+  // standby, then CAD on the channel to transmit on
+  state               = state_t::cad;
+  const auto profile  = profile_of(current);
+  const auto cad_from = world().now_us();
+  medium.idle(_node);
+  const auto cad_us = config.cad_symbols * radio_profile::symbol_time_us(profile);
+  world().after(cad_us + config.op_latency_us, [this, profile, cad_from] {
+    if (state != state_t::cad) {
+      return;
+    }
+    if (!medium.cad(_node, profile, cad_from)) {
+      start_transmit();
+      return;
+    }
+    _stats.channel_busy += 1;
+    const auto delay_ms = backoff.on_busy(world().rng()());
+    start_receive();
+    if (!delay_ms) {
+      _stats.lbt_dropped += 1;
+      state = state_t::idle;
+      next();
+      return;
+    }
+    state = state_t::backoff;
+    world().after(uint64_t{*delay_ms} * 1000, [this] {
+      if (state == state_t::backoff) {
+        try_transmit();
+      }
+    });
+  });
+}
+
+void Radio::start_transmit() {
+  const auto profile = profile_of(current);
+  const auto toa     = radio_profile::time_on_air_us(profile, current.data.size());
+  const auto now     = clock.now_ms();
+  if (!ledger.admit(current.cls, toa, now)) {
+    _stats.duty_dropped[static_cast<size_t>(current.cls)] += 1;
+    state = state_t::idle;
+    start_receive();
+    next();
+    return;
+  }
+  state          = state_t::transmitting;
+  const auto end = medium.transmit(_node, profile, current.data);
+  ledger.record(toa, now);
+  _stats.airtime_us += toa;
+  // TX done on DIO1, then the task
+  world().at(end + config.op_latency_us, [this] {
+    if (state != state_t::transmitting) {
+      return;
+    }
+    const auto latency        = clock.now_ms() - current.queued_ms;
+    _stats.max_tx_latency_ms  = std::max(_stats.max_tx_latency_ms, latency);
+    _stats.tx_done += 1;
+    state = state_t::idle;
+    start_receive();
+    next();
+  });
+}
+
+void Radio::on_rx(const rx_t &rx) {
+  if (state == state_t::off) {
+    return;
+  }
+  switch (rx.result) {
+    case rx_result::header_error:
+      _stats.header_err += 1;
+      return;
+    case rx_result::crc_error:
+      _stats.crc_err += 1;
+      return;
+    case rx_result::ok:
+      break;
+  }
+  _stats.rx_done += 1;
+  quality.add(rx.rssi_dbm, rx.snr_db);
+  if (on_receive == nullptr) {
+    return;
+  }
+  // read out by the radio task and handled by `recv_task`
+  world().after(config.op_latency_us, [this, data = std::vector<uint8_t>(rx.data.begin(), rx.data.end()),
+                                       rssi = rx.rssi_dbm, snr = rx.snr_db] {
+    on_receive(rx_frame_t{.data = data, .rssi_dbm = rssi, .snr_db = snr});
+  });
+}
+
+HrLoRa::link_stats::t Radio::link_stats() const {
+  auto data = HrLoRa::link_stats::t{
+      .rx_ok      = _stats.rx_done,
+      .crc_err    = _stats.crc_err,
+      .header_err = _stats.header_err,
+      .tx_ok      = _stats.tx_done,
+  };
+  quality.fill(data);
+  return data;
+}
+}
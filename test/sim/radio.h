@@ -0,0 +1,147 @@
+#ifndef BLE_LORA_ADAPTER_SIM_RADIO_H
+#define BLE_LORA_ADAPTER_SIM_RADIO_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+#include <vector>
+#include "airtime.h"
+#include "clock.h"
+#include "hr_lora.h"
+#include "lbt.h"
+#include "link_quality.h"
+#include "medium.h"
+#include "radio_profile.h"
+
+namespace sim {
+/**
+ * @brief the counters of `radio::RadioTask::stats` that mean something here
+ */
+struct radio_stats_t {
+  uint32_t dropped      = 0;
+  uint32_t tx_done      = 0;
+  uint32_t rx_done      = 0;
+  uint32_t crc_err      = 0;
+  uint32_t header_err   = 0;
+  uint32_t channel_busy = 0;
+  uint32_t lbt_dropped  = 0;
+  uint64_t airtime_us   = 0;
+  std::array<uint32_t, airtime::TRAFFIC_CLASS_COUNT> duty_dropped{};
+  uint32_t max_tx_latency_ms = 0;
+};
+
+struct radio_config_t {
+  radio_profile::profile_t rx_profile = radio_profile::DEFAULT_PROFILE;
+  airtime::config_t duty_cycle;
+  lbt::config_t lbt{};
+  /**
+   * @brief from an event (DIO1, a frame queued) to the radio task done with
+   *        the SPI transactions for it
+   */
+  uint32_t op_latency_us = 1'000;
+  /**
+   * @brief the symbols CAD listens for
+   */
+  uint8_t cad_symbols = 2;
+};
+
+/**
+ * @brief `radio::RadioTask` on the simulated medium
+ *
+ * The same queue, states and policies: a bounded queue that drops when full,
+ * CAD and `lbt::Backoff` before each transmission when enabled, the
+ * `airtime::Ledger` admission, and receiving whenever it's not transmitting.
+ * The time the task takes to get to the radio is `radio_config_t::op_latency_us`
+ * per operation.
+ */
+class Radio : public Port {
+public:
+  static constexpr size_t MAX_FRAME_SIZE = 128;
+  static constexpr size_t QUEUE_LENGTH   = 8;
+  static constexpr size_t BUCKETS        = 60;
+
+  struct rx_frame_t {
+    std::span<const uint8_t> data;
+    float rssi_dbm;
+    float snr_db;
+  };
+
+private:
+  struct frame_t {
+    airtime::traffic_class cls;
+    float freq_mhz;
+    uint32_t queued_ms;
+    std::vector<uint8_t> data;
+  };
+  enum class state_t {
+    off,
+    idle,
+    cad,
+    backoff,
+    transmitting,
+  };
+
+  LocalClock &clock;
+  Medium &medium;
+  node_t _node;
+  radio_config_t config;
+  radio_profile::profile_t tx_profile;
+  std::deque<frame_t> queue;
+  frame_t current{};
+  state_t state = state_t::off;
+  lbt::Backoff backoff;
+  airtime::Ledger<BUCKETS> ledger;
+  link_quality::Monitor quality{};
+  radio_stats_t _stats{};
+
+  World &world() {
+    return clock.get_world();
+  }
+  [[nodiscard]] radio_profile::profile_t profile_of(const frame_t &frame) const;
+  void start_receive();
+  void next();
+  void try_transmit();
+  void start_transmit();
+
+public:
+  /**
+   * @brief called with a frame received (with a good CRC), in the task that
+   *        handles it, i.e. after `radio_config_t::op_latency_us`
+   */
+  std::function<void(const rx_frame_t &)> on_receive = nullptr;
+
+  Radio(LocalClock &clock, Medium &medium, float x, float y, radio_config_t config);
+
+  /**
+   * @brief start receiving; a radio that is off hears and sends nothing
+   */
+  void power(bool on);
+
+  bool send(std::span<const uint8_t> data, airtime::traffic_class cls = airtime::traffic_class::control, float freq_mhz = 0);
+
+  void set_tx_profile(const radio_profile::profile_t &profile) {
+    tx_profile = profile;
+  }
+
+  [[nodiscard]] const radio_profile::profile_t &current_tx_profile() const {
+    return tx_profile;
+  }
+
+  [[nodiscard]] node_t node() const {
+    return _node;
+  }
+
+  [[nodiscard]] const radio_stats_t &stats() const {
+    return _stats;
+  }
+
+  [[nodiscard]] HrLoRa::link_stats::t link_stats() const;
+
+  void on_rx(const rx_t &rx) override;
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_RADIO_H
@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <cmath>
+#include "repeater.h"
+
+namespace sim {
+Repeater::Repeater(World &world, Medium &medium, Tracker &tracker, const repeater_config_t &config, uint32_t seed)
+    : world(world), tracker(tracker), config(config),
+      clock(world, config.boot_us, config.drift_ppm),
+      radio(clock, medium, config.x, config.y, config.radio),
+      slot_clock(config.tdma),
+      channels(config.channels),
+      slot_budget(slot_clock.slot_ms(), config.slot_guard_ms),
+      arq(config.addr, arq::config_t{
+                           .max_attempts    = config.reliable_max_attempts,
+                           .base_backoff_ms = slot_clock.superframe_ms() - slot_clock.slot_ms(),
+                           .max_backoff_ms  = 8 * slot_clock.superframe_ms(),
+                       }),
+      name_map_key(config.key), rng(seed) {
+  send_scheduler.now_ms = [] { return static_cast<uint32_t>(esp_timer_get_time() / 1000); };
+  send_scheduler.send   = [this](uint8_t *data, size_t size) {
+    if (!fits_in_slot(size)) {
+      return false;
+    }
+    radio.send(std::span<const uint8_t>{data, size}, airtime::traffic_class::control, uplink_freq_mhz(name_map_key));
+    return true;
+  };
+  send_scheduler.retry_delay_ms = [this](uint32_t now) {
+    if (!this->config.slotted) {
+      return random_delay_ms();
+    }
+    // refused at the start of the slot, the slot is full; 0 would drop it
+    const auto delay = slot_clock.delay_until_slot(name_map_key, now);
+    return delay == 0 ? slot_clock.superframe_ms() : delay;
+  };
+  callbacks = handle_message_callbacks_t{
+      .schedule = [this](uint8_t *data, size_t size, size_t interval_ms) {
+        const auto now   = now_ms();
+        const auto delay = interval_ms + (this->config.slotted ? slot_clock.delay_until_slot(name_map_key, now + interval_ms)
+                                                               : random_delay_ms());
+        send_scheduler.schedule(data, size, delay);
+      },
+      .get_device = [this]() -> etl::optional<HrLoRa::hr_device::t> {
+        // `ScanManager::get_device`, the first monitor connected
+        if (monitors.empty() || this->config.max_devices == 0) {
+          return etl::nullopt;
+        }
+        return HrLoRa::hr_device::t{.addr = monitors.front().config.addr, .name = "HRM"};
+      },
+      .find_device = [this](const HrLoRa::addr_t &addr) -> etl::optional<bridged_device_t> {
+        const auto n  = std::min(monitors.size(), this->config.max_devices);
+        const auto it = std::find_if(monitors.begin(), monitors.begin() + static_cast<long>(n),
+                                     [&addr](const auto &m) { return m.config.addr == addr; });
+        if (it == monitors.begin() + static_cast<long>(n)) {
+          return etl::nullopt;
+        }
+        const auto key = device_keys.find(addr);
+        return bridged_device_t{
+            .device = HrLoRa::hr_device::t{.addr = addr, .name = "HRM"},
+            .key    = key == device_keys.end() ? etl::nullopt : etl::optional<uint8_t>{key->second},
+        };
+      },
+      .get_self_addr    = [this] { return this->config.addr; },
+      .set_name_map_key = [this](HrLoRa::name_map_key_t key) {
+        name_map_key = key;
+        slot_ticker.on_sync();
+      },
+      .get_name_map_key = [this] { return name_map_key; },
+      .set_device_key   = [this](const HrLoRa::addr_t &addr, HrLoRa::name_map_key_t key) {
+        const auto it = std::ranges::find_if(monitors, [&addr](const auto &m) { return m.config.addr == addr; });
+        if (it == monitors.end()) {
+          return false;
+        }
+        device_keys[addr] = key;
+        slot_ticker.on_sync();
+        return true;
+      },
+      .get_link_stats   = [this] {
+        auto stats       = radio.link_stats();
+        const auto d     = dropped();
+        stats.hr_dropped = d.hr_dropped;
+        stats.rr_dropped = d.rr_dropped;
+        return stats;
+      },
+      .on_gateway_frame = [this] {
+        slot_clock.sync(now_ms());
+        slot_ticker.on_sync();
+      },
+      .send_reliable    = [this](const HrLoRa::addr_t &peer, std::span<const uint8_t> data) {
+        arq.submit(peer, data, now_ms());
+      },
+      .accept_reliable = [this](const HrLoRa::addr_t &peer, uint8_t seq) {
+        return arq.accept(peer, seq, now_ms());
+      },
+      .on_ack = [this](const HrLoRa::addr_t &peer, uint8_t seq) { arq.on_ack(peer, seq); },
+  };
+  radio.on_receive = [this](const Radio::rx_frame_t &rx) {
+    if (!on) {
+      return;
+    }
+    const auto scope = LocalClock::Scope{clock};
+    handle_message(rx.data.data(), rx.data.size(), callbacks);
+  };
+  slot_ticker.on_slot = [this](uint16_t slot) { on_slot(slot); };
+  world.at(config.boot_us, [this] {
+    const auto scope = LocalClock::Scope{clock};
+    send_scheduler.init();
+    if (this->config.slotted) {
+      slot_ticker.start(slot_clock, [this] { return slots(); });
+    } else {
+      on_superframe();
+    }
+    power(true);
+    for (size_t i = 0; i < monitors.size(); ++i) {
+      notify(i);
+    }
+  });
+}
+
+void Repeater::add_monitor(const monitor_config_t &monitor) {
+  monitors.push_back(monitor_t{.config = monitor, .tracker_id = tracker.add_device()});
+  if (monitor.key) {
+    device_keys[monitor.addr] = *monitor.key;
+  }
+}
+
+void Repeater::power(bool value) {
+  on = value;
+  radio.power(value);
+}
+
+float Repeater::uplink_freq_mhz(uint8_t key) {
+  const auto now        = now_ms();
+  const auto superframe = slot_clock.superframe_index(now + slot_clock.slot_ms() / 2);
+  return channels.freq_mhz(key, superframe);
+}
+
+bool Repeater::fits_in_slot(size_t size) {
+  if (!config.slotted) {
+    // no slot to keep within; the duty cycle still applies
+    return true;
+  }
+  const auto start = slot_clock.slot_start(now_ms());
+  return slot_budget.take(start, radio_profile::time_on_air_us(radio.current_tx_profile(), size));
+}
+
+etl::optional<uint8_t> Repeater::key_of(const device_t &device) const {
+  const auto it = device_keys.find(device.addr);
+  if (it != device_keys.end()) {
+    return it->second;
+  }
+  if (devices.size() == 1) {
+    return name_map_key;
+  }
+  return etl::nullopt;
+}
+
+tdma::SlotSet Repeater::slots() const {
+  auto res = tdma::SlotSet{};
+  res.add(slot_clock.slot_of(name_map_key));
+  for (const auto &dev : devices) {
+    if (const auto key = key_of(dev)) {
+      res.add(slot_clock.slot_of(*key));
+    }
+  }
+  return res;
+}
+
+Repeater::device_t &Repeater::device_of(const HrLoRa::addr_t &addr) {
+  const auto now = now_ms();
+  auto it        = std::ranges::find_if(devices, [&addr](const auto &d) { return d.addr == addr; });
+  if (it != devices.end()) {
+    return *it;
+  }
+  auto fresh = device_t{
+      .addr           = addr,
+      .hr_accumulator = HrLoRa::hr_batch::accumulator(HrLoRa::hr_batch::max_samples, slot_clock.superframe_ms()),
+      .rr_accumulator = HrLoRa::hr_rr::accumulator(HrLoRa::hr_rr::max_rr, slot_clock.superframe_ms()),
+      .latest         = etl::nullopt,
+      .updated_ms     = now,
+  };
+  if (devices.size() < config.max_devices) {
+    devices.push_back(std::move(fresh));
+    return devices.back();
+  }
+  auto &victim = *std::ranges::max_element(devices, {}, [now](const auto &d) { return now - d.updated_ms; });
+  hr_evicted += victim.hr_accumulator.dropped() + victim.hr_accumulator.size();
+  rr_evicted += victim.rr_accumulator.dropped() + victim.rr_accumulator.size();
+  victim = std::move(fresh);
+  return victim;
+}
+
+void Repeater::notify(size_t index) {
+  auto &m         = monitors[index];
+  const auto hr   = m.config.hr[m.second % m.config.hr.size()];
+  const auto now  = world.now_us();
+  const auto hr_id = tracker.take(m.tracker_id, series::hr, now);
+  // the beats since the last notification, with some variability; the
+  // fraction of a beat is carried over, as it is by the heart
+  auto rr         = std::vector<uint16_t>{};
+  const auto mean = 60.0 * 1024 / hr;
+  auto jitter     = std::normal_distribution<double>{0, 40.0 * 60 / hr};
+  m.beats += hr / 60.0 * config.notify_period_ms / 1000;
+  const auto beats = static_cast<long>(m.beats);
+  m.beats -= static_cast<double>(beats);
+  for (long i = 0; i < beats; ++i) {
+    rr.push_back(static_cast<uint16_t>(std::clamp(mean + jitter(rng), 200.0, 4000.0)));
+  }
+  auto rr_ids = std::vector<Tracker::id_t>{};
+  for (size_t i = 0; i < rr.size(); ++i) {
+    rr_ids.push_back(tracker.take(m.tracker_id, series::rr, now));
+  }
+  m.second += 1;
+  world.after(uint64_t{config.notify_period_ms} * 1000, [this, index] { notify(index); });
+  // the ones past `max_devices` are never connected
+  if (!on || index >= config.max_devices) {
+    return;
+  }
+  // `scan_manager.on_data`
+  const auto scope = LocalClock::Scope{clock};
+  const auto ms    = now_ms();
+  auto &dev        = device_of(m.config.addr);
+  if (dev.hr_accumulator.size() == HrLoRa::hr_batch::max_samples) {
+    // the oldest one is dropped
+    dev.hr_ids.pop_front();
+  }
+  dev.hr_accumulator.push(hr, ms);
+  dev.hr_ids.push_back(hr_id);
+  const auto before = dev.rr_accumulator.dropped();
+  dev.rr_accumulator.push(rr, ms);
+  // the newest ones are dropped
+  const auto kept = rr.size() - (dev.rr_accumulator.dropped() - before);
+  dev.rr_ids.insert(dev.rr_ids.end(), rr_ids.begin(), rr_ids.begin() + static_cast<long>(kept));
+  dev.latest     = hr;
+  dev.latest_id  = hr_id;
+  dev.updated_ms = ms;
+}
+
+void Repeater::on_superframe() {
+  const auto set = slots();
+  for (uint16_t slot = 0; slot < slot_clock.slot_count(); ++slot) {
+    if (!set.contains(slot)) {
+      continue;
+    }
+    world.after(uint64_t{random_delay_ms()} * 1000, [this, slot] {
+      const auto scope = LocalClock::Scope{clock};
+      on_slot(slot);
+    });
+  }
+  world.after(uint64_t{slot_clock.superframe_ms()} * 1000, [this] { on_superframe(); });
+}
+
+uint32_t Repeater::random_delay_ms() {
+  return std::uniform_int_distribution<uint32_t>{0, MAX_RANDOM_DELAY_MS}(rng);
+}
+
+void Repeater::send_slot_frame(std::span<const uint8_t> frame, airtime::traffic_class cls, std::vector<Tracker::id_t> ids, float freq_mhz) {
+  if (frame.empty()) {
+    return;
+  }
+  tracker.carry(frame, std::move(ids), world.now_us());
+  radio.send(frame, cls, freq_mhz);
+}
+
+void Repeater::on_slot(uint16_t slot) {
+  if (!on) {
+    return;
+  }
+  struct slot_frame_t {
+    std::vector<uint8_t> data;
+    airtime::traffic_class cls;
+    std::vector<Tracker::id_t> ids;
+    float freq_mhz;
+  };
+  const auto now        = now_ms();
+  const auto key        = name_map_key;
+  const auto superframe = slot_clock.superframe_index(now + slot_clock.slot_ms() / 2);
+  const bool named_turn = superframe % config.named_hr_superframes == 0;
+  const auto n          = devices.size();
+  auto keys             = std::vector<etl::optional<uint8_t>>(n);
+  auto demands          = std::vector<slot_plan::demand_t>(n);
+  for (size_t i = 0; i < n; ++i) {
+    const auto &dev = devices[i];
+    keys[i]         = key_of(dev);
+    // in the slot of its key, or in the one of this repeater without
+    if (slot_clock.slot_of(keys[i].value_or(key)) != slot) {
+      continue;
+    }
+    demands[i] = slot_plan::demand_t{
+        .has_key = keys[i].has_value(),
+        .named   = dev.latest && (named_turn || !keys[i]),
+        .batch   = !dev.hr_accumulator.empty(),
+        .rr      = !dev.rr_accumulator.empty(),
+    };
+  }
+  // control frames go first in the slot of this repeater, as many as it has room for
+  if (slot_clock.slot_of(key) == slot) {
+    const auto freq_mhz = uplink_freq_mhz(key);
+    arq.poll(now, [this, freq_mhz](std::span<const uint8_t> frame) {
+      if (!fits_in_slot(frame.size())) {
+        return false;
+      }
+      radio.send(frame, airtime::traffic_class::control, freq_mhz);
+      return true;
+    });
+  }
+  const auto plan = slot_plan::plan<MAX_FRAMES_PER_SLOT>(demands, cursor, config.frames_per_slot);
+  auto frames     = std::vector<slot_frame_t>{};
+  // built from a copy, which is only given up if the frame fits
+  for (const auto &f : plan.get_frames()) {
+    auto &dev                                  = devices[f.device];
+    auto hr_acc                                = dev.hr_accumulator;
+    auto rr_acc                                = dev.rr_accumulator;
+    auto latest                                = dev.latest;
+    const auto dev_key                         = keys[f.device].value_or(key);
+    auto frame                                 = slot_frame_t{.freq_mhz = uplink_freq_mhz(dev_key)};
+    uint8_t buf[SendScheduler::MAX_FRAME_SIZE] = {0};
+    switch (f.what) {
+      case slot_plan::kind::named: {
+        const auto named_hr_data = HrLoRa::named_hr_data::t{.key = dev_key, .hr = *latest, .addr = dev.addr};
+        const auto sz            = HrLoRa::named_hr_data::marshal(named_hr_data, buf, sizeof(buf));
+        frame.data               = {buf, buf + sz};
+        frame.cls                = airtime::traffic_class::named;
+        frame.ids                = {*dev.latest_id};
+        latest                   = etl::nullopt;
+        break;
+      }
+      case slot_plan::kind::batch: {
+        const auto batch = hr_acc.take(dev_key, now);
+        const auto sz    = HrLoRa::hr_batch::marshal(batch, buf, sizeof(buf));
+        frame.data       = {buf, buf + sz};
+        frame.cls        = airtime::traffic_class::bulk;
+        frame.ids        = {dev.hr_ids.begin(), dev.hr_ids.end()};
+        break;
+      }
+      case slot_plan::kind::rr: {
+        const auto rr = rr_acc.take(dev_key);
+        const auto sz = HrLoRa::hr_rr::marshal(rr, buf, sizeof(buf));
+        frame.data    = {buf, buf + sz};
+        frame.cls     = airtime::traffic_class::bulk;
+        frame.ids     = {dev.rr_ids.begin(), dev.rr_ids.end()};
+        break;
+      }
+    }
+    if (!fits_in_slot(frame.data.size())) {
+      break;
+    }
+    switch (f.what) {
+      case slot_plan::kind::named: break;
+      case slot_plan::kind::batch: dev.hr_ids.clear(); break;
+      case slot_plan::kind::rr: dev.rr_ids.clear(); break;
+    }
+    dev.hr_accumulator = std::move(hr_acc);
+    dev.rr_accumulator = std::move(rr_acc);
+    dev.latest         = latest;
+    frames.push_back(std::move(frame));
+  }
+  cursor = plan.cursor_after(frames.size());
+
+  for (auto &f : frames) {
+    send_slot_frame(f.data, f.cls, std::move(f.ids), f.freq_mhz);
+  }
+}
+
+HrLoRa::link_stats::t Repeater::dropped() const {
+  auto stats       = HrLoRa::link_stats::t{};
+  stats.hr_dropped = hr_evicted;
+  stats.rr_dropped = rr_evicted;
+  for (const auto &d : devices) {
+    stats.hr_dropped += d.hr_accumulator.dropped();
+    stats.rr_dropped += d.rr_accumulator.dropped();
+  }
+  return stats;
+}
+}
@@ -0,0 +1,201 @@
+#ifndef BLE_LORA_ADAPTER_SIM_REPEATER_H
+#define BLE_LORA_ADAPTER_SIM_REPEATER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+#include <etl/optional.h>
+#include "arq.h"
+#include "channel_plan.h"
+#include "clock.h"
+#include "handle_message.h"
+#include "hr_lora.h"
+#include "radio.h"
+#include "send_scheduler.h"
+#include "slot_plan.h"
+#include "slot_ticker.h"
+#include "tdma.h"
+#include "tracker.h"
+
+namespace sim {
+/**
+ * @brief a heart rate monitor connected to a repeater
+ */
+struct monitor_config_t {
+  HrLoRa::addr_t addr;
+  /**
+   * @brief the name map key given by the gateway, if any
+   */
+  etl::optional<uint8_t> key;
+  /**
+   * @brief a heart rate per second, repeated
+   */
+  std::vector<uint8_t> hr;
+};
+
+struct repeater_config_t {
+  HrLoRa::addr_t addr;
+  /**
+   * @brief the name map key saved in NVS
+   */
+  uint8_t key;
+  float x;
+  float y;
+  uint64_t boot_us;
+  double drift_ppm;
+  radio_config_t radio;
+  channel_plan::config_t channels;
+  tdma::config_t tdma;
+  uint8_t reliable_max_attempts;
+  uint16_t named_hr_superframes;
+  /**
+   * @brief see `slot_plan::Budget`
+   */
+  uint32_t slot_guard_ms;
+  size_t frames_per_slot;
+  /**
+   * @brief the monitors connected at most, as `ScanManager::MAX_CONNECTED`;
+   *        the ones added after are never connected
+   */
+  size_t max_devices;
+  /**
+   * @brief a Heart Rate Measurement notification comes this often
+   */
+  uint32_t notify_period_ms = 1000;
+  /**
+   * @brief false to send as before the TDMA slots, for comparison: the frames
+   *        are due every superframe from boot, and go out (as the responses
+   *        do) after a random delay of up to `Repeater::MAX_RANDOM_DELAY_MS`
+   */
+  bool slotted = true;
+};
+
+/**
+ * @brief `app_main` of a repeater on the simulated medium
+ *
+ * What's wired together here is what `app_main` wires: the real
+ * `handle_message`, `SendScheduler`, `SlotTicker`, `tdma::SlotClock`,
+ * `channel_plan::Plan`, `arq::Endpoint` and the codecs, with `Radio` in place
+ * of `radio::RadioTask` and the monitors in place of `ScanManager`. The slot
+ * is filled as `on_slot` of `app_main` does.
+ */
+class Repeater {
+public:
+  static constexpr size_t MAX_FRAMES_PER_SLOT = 8;
+  /**
+   * @brief `MAX_RF_MSG_SCHEDULE_DELAY_MS`, what a response waited before the
+   *        TDMA slots
+   */
+  static constexpr uint32_t MAX_RANDOM_DELAY_MS = 3000;
+
+private:
+  struct device_t {
+    HrLoRa::addr_t addr;
+    HrLoRa::hr_batch::accumulator hr_accumulator;
+    HrLoRa::hr_rr::accumulator rr_accumulator;
+    etl::optional<uint8_t> latest;
+    uint32_t updated_ms;
+    // the samples in the accumulators, for the tracker
+    std::deque<Tracker::id_t> hr_ids;
+    std::deque<Tracker::id_t> rr_ids;
+    etl::optional<Tracker::id_t> latest_id;
+  };
+  struct monitor_t {
+    monitor_config_t config;
+    uint32_t tracker_id;
+    size_t second = 0;
+    // the fraction of a beat not notified yet
+    double beats = 0;
+  };
+
+  World &world;
+  Tracker &tracker;
+  repeater_config_t config;
+  LocalClock clock;
+  Radio radio;
+  tdma::SlotClock slot_clock;
+  channel_plan::Plan channels;
+  SendScheduler send_scheduler{};
+  SlotTicker slot_ticker{};
+  slot_plan::Budget slot_budget;
+  arq::Endpoint<4, 4, SendScheduler::MAX_FRAME_SIZE> arq;
+  handle_message_callbacks_t callbacks;
+  uint8_t name_map_key;
+  std::map<HrLoRa::addr_t, uint8_t> device_keys;
+  std::vector<monitor_t> monitors;
+  std::vector<device_t> devices;
+  size_t cursor = 0;
+  // the samples of the devices replaced
+  uint32_t hr_evicted = 0;
+  uint32_t rr_evicted = 0;
+  bool on             = false;
+  std::mt19937 rng;
+
+  [[nodiscard]] uint32_t now_ms() const {
+    return clock.now_ms();
+  }
+  [[nodiscard]] float uplink_freq_mhz(uint8_t key);
+  [[nodiscard]] bool fits_in_slot(size_t size);
+  /**
+   * @brief the key a device sends with, whose slot it goes in
+   */
+  [[nodiscard]] etl::optional<uint8_t> key_of(const device_t &device) const;
+  [[nodiscard]] tdma::SlotSet slots() const;
+  device_t &device_of(const HrLoRa::addr_t &addr);
+  void notify(size_t monitor);
+  void on_slot(uint16_t slot);
+  /**
+   * @brief `on_slot` of each slot after a random delay, every superframe,
+   *        when not `repeater_config_t::slotted`
+   */
+  void on_superframe();
+  [[nodiscard]] uint32_t random_delay_ms();
+  void send_slot_frame(std::span<const uint8_t> frame, airtime::traffic_class cls, std::vector<Tracker::id_t> ids, float freq_mhz);
+
+public:
+  Repeater(World &world, Medium &medium, Tracker &tracker, const repeater_config_t &config, uint32_t seed);
+
+  Repeater(const Repeater &)            = delete;
+  Repeater &operator=(const Repeater &) = delete;
+
+  /**
+   * @brief connect a monitor, which notifies from its first second on
+   */
+  void add_monitor(const monitor_config_t &monitor);
+
+  /**
+   * @brief power on (boot, at `repeater_config_t::boot_us` the first time) or off
+   */
+  void power(bool on);
+
+  [[nodiscard]] const HrLoRa::addr_t &addr() const {
+    return config.addr;
+  }
+
+  [[nodiscard]] uint8_t key() const {
+    return name_map_key;
+  }
+
+  [[nodiscard]] const radio_stats_t &radio_stats() const {
+    return radio.stats();
+  }
+
+  [[nodiscard]] const arq::stats_t &arq_stats() const {
+    return arq.stats();
+  }
+
+  [[nodiscard]] node_t node() const {
+    return radio.node();
+  }
+
+  /**
+   * @brief `link_stats` with only the samples dropped, as `app_main` counts them
+   */
+  [[nodiscard]] HrLoRa::link_stats::t dropped() const;
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_REPEATER_H
@@ -0,0 +1,19 @@
+#ifndef BLE_LORA_ADAPTER_SIM_RTOS_ESP_TIMER_H
+#define BLE_LORA_ADAPTER_SIM_RTOS_ESP_TIMER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include "clock.h"
+
+/**
+ * @return the time since the node (of the event being run) booted, in microseconds
+ */
+inline int64_t esp_timer_get_time() {
+  const auto *clock = sim::LocalClock::current();
+  if (clock == nullptr) {
+    std::abort();
+  }
+  return static_cast<int64_t>(clock->now_us());
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_RTOS_ESP_TIMER_H
@@ -0,0 +1,28 @@
+#ifndef BLE_LORA_ADAPTER_SIM_RTOS_FREERTOS_H
+#define BLE_LORA_ADAPTER_SIM_RTOS_FREERTOS_H
+
+/**
+ * @brief the subset of FreeRTOS used by the timers and the locks of the
+ *        firmware (`SendScheduler`, `SlotTicker`), on the simulated clock
+ *
+ * There's a single thread: the events of the world run one at a time, so a
+ * lock is always free and a timer callback runs as an event on behalf of the
+ * node that created the timer (see `sim::LocalClock::Scope`).
+ */
+
+#include <cstdint>
+
+using TickType_t  = uint32_t;
+using BaseType_t  = int;
+using UBaseType_t = unsigned int;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY UINT32_MAX
+#define configTICK_RATE_HZ 100
+#define portTICK_PERIOD_MS (static_cast<TickType_t>(1000) / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>(static_cast<uint64_t>(ms) * configTICK_RATE_HZ / 1000))
+
+#endif // BLE_LORA_ADAPTER_SIM_RTOS_FREERTOS_H
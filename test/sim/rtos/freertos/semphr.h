@@ -0,0 +1,36 @@
+#ifndef BLE_LORA_ADAPTER_SIM_RTOS_SEMPHR_H
+#define BLE_LORA_ADAPTER_SIM_RTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+/**
+ * @brief a mutex that is never contended, since nothing runs in parallel
+ */
+struct StaticSemaphore_t {
+  bool taken = false;
+};
+using SemaphoreHandle_t = StaticSemaphore_t *;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf) {
+  return buf;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new StaticSemaphore_t{};
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t) {
+  // taken twice without being given, i.e. a deadlock on the target
+  if (sem->taken) {
+    __builtin_trap();
+  }
+  sem->taken = true;
+  return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  sem->taken = false;
+  return pdTRUE;
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_RTOS_SEMPHR_H
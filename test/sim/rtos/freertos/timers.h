@@ -0,0 +1,58 @@
+#ifndef BLE_LORA_ADAPTER_SIM_RTOS_TIMERS_H
+#define BLE_LORA_ADAPTER_SIM_RTOS_TIMERS_H
+
+#include <cstdlib>
+#include <memory>
+#include "FreeRTOS.h"
+#include "clock.h"
+
+struct StaticTimer_t;
+using TimerHandle_t          = StaticTimer_t *;
+using TimerCallbackFunction_t = void (*)(TimerHandle_t);
+
+/**
+ * @brief a one-shot timer on the clock of the node that creates it
+ */
+struct StaticTimer_t {
+  void *id                         = nullptr;
+  TimerCallbackFunction_t callback = nullptr;
+  std::unique_ptr<sim::Timer> timer;
+};
+
+inline TimerHandle_t xTimerCreateStatic(const char *, TickType_t, UBaseType_t auto_reload, void *id,
+                                        TimerCallbackFunction_t callback, StaticTimer_t *buf) {
+  auto *clock = sim::LocalClock::current();
+  if (auto_reload != pdFALSE || clock == nullptr) {
+    // only one-shot timers are simulated, and only from the events of a node
+    std::abort();
+  }
+  buf->id       = id;
+  buf->callback = callback;
+  buf->timer    = std::make_unique<sim::Timer>(*clock, [buf] { buf->callback(buf); });
+  return buf;
+}
+
+inline TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+                                  TimerCallbackFunction_t callback) {
+  auto buf     = std::make_shared<StaticTimer_t>();
+  auto *handle = xTimerCreateStatic(name, period, auto_reload, id, callback, buf.get());
+  // freed with the node, rather than by `xTimerDelete`
+  sim::LocalClock::current()->keep(std::move(buf));
+  return handle;
+}
+
+inline void *pvTimerGetTimerID(TimerHandle_t timer) {
+  return timer->id;
+}
+
+inline BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t) {
+  timer->timer->change_period(period);
+  return pdPASS;
+}
+
+inline BaseType_t xTimerStop(TimerHandle_t timer, TickType_t) {
+  timer->timer->stop();
+  return pdPASS;
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_RTOS_TIMERS_H
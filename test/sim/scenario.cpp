@@ -0,0 +1,402 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include "common.h"
+#include "gateway.h"
+#include "hr_trace.h"
+#include "repeater.h"
+#include "scenario.h"
+
+namespace sim {
+namespace {
+  template <typename T>
+  bool parse_number(const std::string &s, T &out) {
+    auto in = std::istringstream{s};
+    double v;
+    if (!(in >> v) || !(in >> std::ws).eof()) {
+      return false;
+    }
+    out = static_cast<T>(v);
+    return true;
+  }
+
+  bool parse_bool(const std::string &s, bool &out) {
+    if (s == "on" || s == "true" || s == "1") {
+      out = true;
+      return true;
+    }
+    if (s == "off" || s == "false" || s == "0") {
+      out = false;
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<std::string> split(const std::string &line) {
+    auto in     = std::istringstream{line};
+    auto tokens = std::vector<std::string>{};
+    for (std::string t; in >> t;) {
+      tokens.push_back(t);
+    }
+    return tokens;
+  }
+
+  HrLoRa::addr_t repeater_addr(uint32_t i) {
+    return {0x24, 0x0a, 0xc4, 0x00, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i)};
+  }
+
+  HrLoRa::addr_t monitor_addr(uint32_t i, uint32_t m) {
+    return {0xc0, 0x1d, 0x00, static_cast<uint8_t>(i >> 8), static_cast<uint8_t>(i), static_cast<uint8_t>(m)};
+  }
+
+  constexpr auto GATEWAY_ADDR = HrLoRa::addr_t{0x47, 0x57, 0x00, 0x00, 0x00, 0x01};
+
+  double percentile(std::vector<double> &sorted, double p) {
+    if (sorted.empty()) {
+      return 0;
+    }
+    const auto rank = static_cast<size_t>(std::ceil(p / 100 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+  }
+}
+
+scenario_t::scenario_t()
+    : lbt(common::LBT_ENABLED),
+      channels(common::CHANNEL_COUNT),
+      slot_count(common::TDMA_SLOT_COUNT),
+      slot_ms(common::TDMA_SLOT_TIME.count()),
+      slot_guard_ms(common::TDMA_SLOT_GUARD_TIME.count()),
+      frames_per_slot(common::LORA_FRAMES_PER_SLOT),
+      max_devices(common::MAX_BRIDGED_DEVICES) {}
+
+std::string scenario_t::set(const std::string &key, const std::string &value) {
+  auto number = [&value, &key](auto &out) -> std::string {
+    return parse_number(value, out) ? "" : "bad number for " + key + ": " + value;
+  };
+  if (key == "name") {
+    name = value;
+    return "";
+  }
+  if (key == "keys") {
+    if (value == "distinct") {
+      keys = key_policy::distinct;
+    } else if (value == "zero") {
+      keys = key_policy::zero;
+    } else if (value == "random") {
+      keys = key_policy::random;
+    } else if (value == "derived") {
+      keys = key_policy::derived;
+    } else {
+      return "keys should be distinct, zero, random or derived: " + value;
+    }
+    return "";
+  }
+  if (key == "lbt") {
+    return parse_bool(value, lbt) ? "" : "lbt should be on or off: " + value;
+  }
+  if (key == "slotted") {
+    return parse_bool(value, slotted) ? "" : "slotted should be on or off: " + value;
+  }
+  const auto numbers = std::map<std::string, std::function<std::string()>>{
+      {"seed", [&] { return number(seed); }},
+      {"duration_s", [&] { return number(duration_s); }},
+      {"warmup_s", [&] { return number(warmup_s); }},
+      {"repeaters", [&] { return number(repeaters); }},
+      {"monitors", [&] { return number(monitors); }},
+      {"area_m", [&] { return number(area_m); }},
+      {"channels", [&] { return number(channels); }},
+      {"slot_count", [&] { return number(slot_count); }},
+      {"slot_ms", [&] { return number(slot_ms); }},
+      {"slot_guard_ms", [&] { return number(slot_guard_ms); }},
+      {"frames_per_slot", [&] { return number(frames_per_slot); }},
+      {"max_devices", [&] { return number(max_devices); }},
+      {"loss", [&] { return number(loss); }},
+      {"path_loss_exponent", [&] { return number(path_loss_exponent); }},
+      {"shadowing_db", [&] { return number(shadowing_db); }},
+      {"fading_db", [&] { return number(fading_db); }},
+      {"capture_db", [&] { return number(capture_db); }},
+      {"drift_ppm", [&] { return number(drift_ppm); }},
+      {"boot_spread_s", [&] { return number(boot_spread_s); }},
+      {"status_superframes", [&] { return number(status_superframes); }},
+  };
+  const auto it = numbers.find(key);
+  if (it == numbers.end()) {
+    return "unknown setting: " + key;
+  }
+  return it->second();
+}
+
+std::optional<scenario_t> parse_scenario(std::istream &in, std::string &error) {
+  auto s         = scenario_t{};
+  size_t line_no = 0;
+  for (std::string line; std::getline(in, line);) {
+    line_no += 1;
+    const auto where = "line " + std::to_string(line_no) + ": ";
+    line             = line.substr(0, line.find('#'));
+    const auto tokens = split(line);
+    if (tokens.empty()) {
+      continue;
+    }
+    if (tokens[0] == "at" && tokens.size() >= 3) {
+      auto e = scenario_t::event_t{};
+      if (!parse_number(tokens[1], e.at_s)) {
+        error = where + "bad time: " + tokens[1];
+        return std::nullopt;
+      }
+      e.args.assign(tokens.begin() + 2, tokens.end());
+      s.events.push_back(std::move(e));
+      continue;
+    }
+    if (tokens[0] == "expect" && tokens.size() == 4) {
+      auto e = scenario_t::expect_t{.metric = tokens[1], .op = tokens[2]};
+      if ((e.op != "<=" && e.op != ">=" && e.op != "<" && e.op != ">") || !parse_number(tokens[3], e.value)) {
+        error = where + "expected `expect <metric> <=|>=|<|> <value>`";
+        return std::nullopt;
+      }
+      s.expects.push_back(std::move(e));
+      continue;
+    }
+    if (const auto eq = line.find('='); eq != std::string::npos) {
+      const auto key   = split(line.substr(0, eq));
+      const auto value = split(line.substr(eq + 1));
+      if (key.size() != 1 || value.size() != 1) {
+        error = where + "expected key = value";
+        return std::nullopt;
+      }
+      if (auto e = s.set(key[0], value[0]); !e.empty()) {
+        error = where + e;
+        return std::nullopt;
+      }
+      continue;
+    }
+    error = where + "unknown statement: " + tokens[0];
+    return std::nullopt;
+  }
+  return s;
+}
+
+metrics_t run_scenario(const scenario_t &s) {
+  auto world   = World{s.seed};
+  auto medium  = Medium{world, medium_config_t{
+                                  .path_loss_exponent = static_cast<float>(s.path_loss_exponent),
+                                  .shadowing_db       = static_cast<float>(s.shadowing_db),
+                                  .fading_db          = static_cast<float>(s.fading_db),
+                                  .capture_db         = static_cast<float>(s.capture_db),
+                                  .loss               = static_cast<float>(s.loss),
+                              }};
+  auto tracker = Tracker{};
+
+  const auto profile  = radio_profile::DEFAULT_PROFILE;
+  const auto channels = channel_plan::config_t{
+      .base_freq_mhz = profile.freq_mhz,
+      .spacing_mhz   = common::CHANNEL_SPACING_MHZ,
+      .channel_count = s.channels,
+      .slot_count    = s.slot_count,
+  };
+  const auto tdma = tdma::config_t{.slot_count = s.slot_count, .slot_ms = s.slot_ms};
+
+  auto gateway = Gateway{world, medium, tracker, gateway_config_t{
+                                                     .addr = GATEWAY_ADDR,
+                                                     .x    = 0,
+                                                     .y    = 0,
+                                                     .radio = radio_config_t{
+                                                         .rx_profile = profile,
+                                                         // not bound by the duty cycle of the repeaters
+                                                         .duty_cycle = {.window_ms = 3'600'000, .duty_permille = 1000},
+                                                     },
+                                                     .channels           = channels,
+                                                     .tdma               = tdma,
+                                                     .status_superframes = s.status_superframes,
+                                                 }};
+
+  auto repeaters = std::vector<std::unique_ptr<Repeater>>{};
+  auto rng       = std::mt19937{s.seed ^ 0x5eed'cafeu};
+  auto uniform   = std::uniform_real_distribution<double>{0, 1};
+  auto random_key = [&rng] { return static_cast<uint8_t>(rng() % 256); };
+  const auto seconds = static_cast<size_t>(s.duration_s) + 1;
+  for (uint32_t i = 0; i < s.repeaters; ++i) {
+    auto key = uint8_t{0};
+    switch (s.keys) {
+      case key_policy::distinct: key = static_cast<uint8_t>(i); break;
+      case key_policy::zero: key = 0; break;
+      case key_policy::random: key = random_key(); break;
+      case key_policy::derived: key = tdma::default_key(repeater_addr(i)); break;
+    }
+    const auto x = static_cast<float>((uniform(rng) - 0.5) * s.area_m);
+    const auto y = static_cast<float>((uniform(rng) - 0.5) * s.area_m);
+    const auto boot_us = static_cast<uint64_t>((2 + uniform(rng) * s.boot_spread_s) * 1e6);
+    const auto drift   = (uniform(rng) * 2 - 1) * s.drift_ppm;
+    auto r = std::make_unique<Repeater>(world, medium, tracker, repeater_config_t{
+                                                                    .addr    = repeater_addr(i),
+                                                                    .key     = key,
+                                                                    .x       = x,
+                                                                    .y       = y,
+                                                                    .boot_us = boot_us,
+                                                                    .drift_ppm = drift,
+                                                                    .radio     = radio_config_t{
+                                                                            .rx_profile = profile,
+                                                                            .duty_cycle = {
+                                                                                .window_ms     = static_cast<uint32_t>(common::DUTY_CYCLE_WINDOW.count()),
+                                                                                .duty_permille = common::DUTY_CYCLE_PERMILLE,
+                                                                        },
+                                                                            .lbt = lbt::config_t{.enabled = s.lbt},
+                                                                    },
+                                                                    .channels              = channels,
+                                                                    .tdma                  = tdma,
+                                                                    .reliable_max_attempts = common::RELIABLE_MAX_ATTEMPTS,
+                                                                    .named_hr_superframes  = common::INTERVAL_SEND_NAMED_HR_SUPERFRAMES,
+                                                                    .slot_guard_ms         = s.slot_guard_ms,
+                                                                    .frames_per_slot       = s.frames_per_slot,
+                                                                    .max_devices           = s.max_devices,
+                                                                    .slotted               = s.slotted,
+                                                                }, rng());
+    for (uint32_t m = 0; m < s.monitors; ++m) {
+      auto device_key = etl::optional<uint8_t>{};
+      if (s.monitors > 1) {
+        switch (s.keys) {
+          // past the ones of the repeaters, since each goes in the slot of its key
+          case key_policy::distinct: device_key = static_cast<uint8_t>(s.repeaters + i * s.monitors + m); break;
+          case key_policy::zero: break;
+          case key_policy::random: device_key = random_key(); break;
+          case key_policy::derived: break;
+        }
+      }
+      r->add_monitor(monitor_config_t{
+          .addr = monitor_addr(i, m),
+          .key  = device_key,
+          .hr   = hr_trace::synthetic(seconds, s.seed * 1000 + i * s.monitors + m),
+      });
+    }
+    repeaters.push_back(std::move(r));
+  }
+
+  for (const auto &e : s.events) {
+    world.at(static_cast<uint64_t>(e.at_s * 1e6), [&, args = e.args] {
+      const auto &cmd = args[0];
+      if (cmd == "loss" && args.size() == 2) {
+        medium.set_loss(std::stof(args[1]));
+      } else if (cmd == "gateway" && args.size() == 2) {
+        gateway.power(args[1] == "on");
+      } else if (cmd == "repeater" && args.size() == 3) {
+        const bool on = args[2] == "on";
+        if (args[1] == "all") {
+          for (auto &r : repeaters) {
+            r->power(on);
+          }
+        } else if (const auto i = std::stoul(args[1]); i < repeaters.size()) {
+          repeaters[i]->power(on);
+        }
+      } else if (cmd == "assign") {
+        for (uint32_t i = 0; i < repeaters.size(); ++i) {
+          gateway.set_key(repeaters[i]->addr(), repeaters[i]->addr(), static_cast<uint8_t>(i));
+        }
+      } else if (cmd == "status") {
+        for (const auto &r : repeaters) {
+          gateway.query(r->addr());
+        }
+      } else {
+        std::fprintf(stderr, "unknown command at %.0f s: %s\n", static_cast<double>(world.now_us()) / 1e6, cmd.c_str());
+      }
+    });
+  }
+
+  const auto end_us = static_cast<uint64_t>(s.duration_s * 1e6);
+  world.run_until(end_us);
+
+  // what's taken too late could still be on its way
+  const auto settle_us = std::max<uint64_t>(30'000'000, uint64_t{3} * gateway.superframe_ms() * 1000);
+  const auto from_us   = static_cast<uint64_t>(s.warmup_s * 1e6);
+  const auto to_us     = end_us > settle_us ? end_us - settle_us : 0;
+  auto m               = metrics_t{};
+  auto latencies       = std::vector<double>{};
+  double taken[2]      = {0, 0};
+  double delivered[2]  = {0, 0};
+  for (uint32_t d = 0; d < tracker.device_count(); ++d) {
+    for (const auto kind : {series::hr, series::rr}) {
+      for (const auto &sample : tracker.samples(d, kind)) {
+        if (sample.taken_us < from_us || sample.taken_us >= to_us) {
+          continue;
+        }
+        const auto k = static_cast<size_t>(kind);
+        taken[k] += 1;
+        if (sample.delivered_us != 0) {
+          delivered[k] += 1;
+          if (kind == series::hr) {
+            latencies.push_back(static_cast<double>(sample.delivered_us - sample.taken_us) / 1e6);
+          }
+        }
+      }
+    }
+  }
+  std::ranges::sort(latencies);
+  const auto window_s = static_cast<double>(to_us - std::min(from_us, to_us)) / 1e6;
+  m["hr_loss_pct"]    = taken[0] == 0 ? 100 : 100 * (1 - delivered[0] / taken[0]);
+  m["rr_loss_pct"]    = taken[1] == 0 ? 100 : 100 * (1 - delivered[1] / taken[1]);
+  m["latency_p50_s"]  = percentile(latencies, 50);
+  m["latency_p90_s"]  = percentile(latencies, 90);
+  m["latency_p99_s"]  = percentile(latencies, 99);
+  m["latency_max_s"]  = latencies.empty() ? 0 : latencies.back();
+  m["throughput_sps"] = window_s == 0 ? 0 : (delivered[0] + delivered[1]) / window_s;
+
+  auto sum = [&repeaters](auto of) {
+    double n = 0;
+    for (const auto &r : repeaters) {
+      n += of(*r);
+    }
+    return n;
+  };
+  m["uplink_frames"] = sum([](const Repeater &r) { return r.radio_stats().tx_done; });
+  m["airtime_pct"]   = repeaters.empty() ? 0 : 100 * sum([](const Repeater &r) { return static_cast<double>(r.radio_stats().airtime_us); }) / static_cast<double>(repeaters.size()) / static_cast<double>(end_us);
+  m["queue_dropped"] = sum([](const Repeater &r) { return r.radio_stats().dropped; });
+  m["channel_busy"]  = sum([](const Repeater &r) { return r.radio_stats().channel_busy; });
+  m["lbt_dropped"]   = sum([](const Repeater &r) { return r.radio_stats().lbt_dropped; });
+  m["duty_dropped"]  = sum([](const Repeater &r) {
+    const auto &d = r.radio_stats().duty_dropped;
+    return std::accumulate(d.begin(), d.end(), 0u);
+  });
+  m["hr_dropped"]    = sum([](const Repeater &r) { return r.dropped().hr_dropped; });
+  m["rr_dropped"]    = sum([](const Repeater &r) { return r.dropped().rr_dropped; });
+  m["arq_given_up"]  = sum([](const Repeater &r) { return r.arq_stats().given_up; }) + gateway.arq_stats().given_up;
+
+  const auto counts = gateway.counts();
+  double heard      = 0;
+  for (size_t f = 0; f < FATE_COUNT; ++f) {
+    m[std::string{"gw_"} + to_string(static_cast<fate>(f))] = counts[f];
+    heard += counts[f];
+  }
+  m["collided_pct"] = heard == 0 ? 0 : 100 * counts[static_cast<size_t>(fate::collided)] / heard;
+  m["statuses"]     = gateway.stats().statuses;
+  const auto asked  = static_cast<double>(gateway.stats().queries) * s.repeaters + gateway.stats().requests;
+  m["status_pct"]   = asked == 0 ? 0 : 100 * gateway.stats().statuses / asked;
+  return m;
+}
+
+bool report(const scenario_t &s, const metrics_t &metrics, std::ostream &out) {
+  out << "scenario " << s.name << " (seed " << s.seed << ", " << s.repeaters << " repeaters x " << s.monitors
+      << " monitors, " << s.duration_s << " s, lbt " << (s.lbt ? "on" : "off")
+      << (s.slotted ? "" : ", random delays") << ")\n";
+  for (const auto &[name, value] : metrics) {
+    out << "  " << std::left << std::setw(16) << name << std::fixed << std::setprecision(2) << value << "\n";
+  }
+  bool ok = true;
+  for (const auto &e : s.expects) {
+    const auto it = metrics.find(e.metric);
+    if (it == metrics.end()) {
+      out << "expect " << e.metric << ": unknown metric\n";
+      ok = false;
+      continue;
+    }
+    const auto v    = it->second;
+    const bool pass = e.op == "<=" ? v <= e.value : e.op == ">=" ? v >= e.value
+                                                : e.op == "<"    ? v < e.value
+                                                                 : v > e.value;
+    out << "expect " << e.metric << " " << e.op << " " << e.value << ": " << v << (pass ? " ok" : " FAILED") << "\n";
+    ok = ok && pass;
+  }
+  return ok;
+}
+}
@@ -0,0 +1,154 @@
+#ifndef BLE_LORA_ADAPTER_SIM_SCENARIO_H
+#define BLE_LORA_ADAPTER_SIM_SCENARIO_H
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief a fleet of repeaters and a gateway, run on the simulated medium as
+ *        a script tells, and measured
+ *
+ * A script is a list of lines, `#` for comments:
+ *
+ *     repeaters = 40          # a setting, see `scenario_t`
+ *     at 600 loss 0.2         # from 600 s on, lose 20% of the frames
+ *     at 900 gateway off      # also `gateway on`
+ *     at 300 repeater 3 off   # also `on`, and `all` for every repeater
+ *     at 60 assign            # the gateway gives every repeater a distinct key
+ *     at 300 status           # and asks every repeater for its status, reliably
+ *     expect hr_loss_pct <= 1 # fail the run unless the metric holds
+ *
+ * The settings could also be given on the command line of `sim_run` as
+ * `key=value`, which override the script.
+ */
+namespace sim {
+enum class key_policy : uint8_t {
+  /**
+   * @brief as if the gateway has assigned them: one slot (and lane) each, to the repeaters
+   *        and then to their monitors, while there are enough
+   */
+  distinct,
+  /**
+   * @brief all left at the default 0
+   */
+  zero,
+  random,
+  /**
+   * @brief none saved, so each goes by the one derived from its address, see `tdma::default_key`
+   */
+  derived,
+};
+
+struct scenario_t {
+  std::string name = "unnamed";
+  uint32_t seed    = 1;
+  double duration_s = 600;
+  /**
+   * @brief the samples taken before are not measured
+   */
+  double warmup_s = 60;
+  uint32_t repeaters = 8;
+  /**
+   * @brief per repeater
+   */
+  uint32_t monitors = 1;
+  /**
+   * @brief the side of the square the repeaters are spread over, with the gateway in the middle
+   */
+  double area_m = 300;
+  key_policy keys = key_policy::distinct;
+  /**
+   * @brief off to send at random times instead of in the TDMA slots, see
+   *        `repeater_config_t::slotted`
+   */
+  bool slotted = true;
+  bool lbt;
+  uint8_t channels;
+  uint16_t slot_count;
+  uint32_t slot_ms;
+  /**
+   * @brief see `common::TDMA_SLOT_GUARD_TIME`
+   */
+  uint32_t slot_guard_ms;
+  uint32_t frames_per_slot;
+  /**
+   * @brief the monitors a repeater connects to, see `common::MAX_BRIDGED_DEVICES`
+   */
+  uint32_t max_devices;
+  double loss               = 0;
+  double path_loss_exponent = 2.7;
+  double shadowing_db       = 4;
+  double fading_db          = 2;
+  double capture_db         = 6;
+  double drift_ppm          = 20;
+  /**
+   * @brief the repeaters boot in this long after the start, at random
+   */
+  double boot_spread_s = 10;
+  /**
+   * @brief see `gateway_config_t::status_superframes`
+   */
+  uint32_t status_superframes = 0;
+
+  struct event_t {
+    double at_s;
+    std::vector<std::string> args;
+  };
+  struct expect_t {
+    std::string metric;
+    std::string op;
+    double value;
+  };
+  std::vector<event_t> events;
+  std::vector<expect_t> expects;
+
+  /**
+   * @brief the defaults of `common.h`
+   */
+  scenario_t();
+
+  /**
+   * @return an error message, empty if ok
+   */
+  std::string set(const std::string &key, const std::string &value);
+};
+
+/**
+ * @return nullopt with `error` set if the script is malformed
+ */
+std::optional<scenario_t> parse_scenario(std::istream &in, std::string &error);
+
+/**
+ * @brief the measurements of a run, by name (see `run_scenario`)
+ */
+using metrics_t = std::map<std::string, double>;
+
+/**
+ * @brief run the scenario to the end
+ * @return the metrics:
+ *   - `hr_loss_pct`, `rr_loss_pct`: the samples taken that never reach the gateway
+ *   - `latency_p50_s`, `latency_p90_s`, `latency_p99_s`, `latency_max_s`: from a
+ *     heart rate being notified to the frame carrying it being decoded
+ *   - `throughput_sps`: samples (heart rates and RR intervals) delivered per second
+ *   - `uplink_frames`, `airtime_pct` (per repeater, on average), `queue_dropped`,
+ *     `channel_busy`, `lbt_dropped`, `duty_dropped`, `hr_dropped` and `rr_dropped` (by the accumulators,
+ *     as `link_stats` counts them)
+ *   - `gw_<fate>` and `collided_pct`: the frames at the gateway by `sim::fate`
+ *   - `statuses`, `status_pct` (of the queries times the repeaters, and of the
+ *     reliable requests of `assign` and `status`), `arq_given_up`
+ */
+metrics_t run_scenario(const scenario_t &scenario);
+
+/**
+ * @brief print `metrics` and the checks of `expects`
+ * @return whether every expectation holds
+ */
+bool report(const scenario_t &scenario, const metrics_t &metrics, std::ostream &out);
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_SCENARIO_H
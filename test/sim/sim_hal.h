@@ -0,0 +1,158 @@
+#ifndef BLE_LORA_ADAPTER_SIM_SIM_HAL_H
+#define BLE_LORA_ADAPTER_SIM_SIM_HAL_H
+
+#include <RadioLib.h>
+#include <cstdint>
+#include "llcc68.h"
+#include "world.h"
+
+/**
+ * @brief the RadioLib HAL of a simulated `Llcc68`, in place of `ESPHal`
+ *
+ * The pins are the chip's: NSS selects it and executes the command when it
+ * goes high, NRST resets it, BUSY is low and DIO1 is its IRQ line. Waiting
+ * (`delay`, `yield`, polling a pin) runs the world, so that RadioLib's
+ * blocking calls see the frame go out and come in.
+ */
+namespace sim {
+struct hal_pins_t {
+  uint32_t nss  = 0;
+  uint32_t rst  = 1;
+  uint32_t busy = 2;
+  uint32_t dio1 = 3;
+};
+
+class SimHal : public RadioLibHal {
+public:
+  using pins_t = hal_pins_t;
+
+  /**
+   * @brief how long a `yield` lets the world run
+   */
+  static constexpr uint64_t YIELD_US = 100;
+
+private:
+  World &world;
+  Llcc68 &chip;
+  pins_t pins;
+  void (*dio1_cb)() = nullptr;
+
+  void run_for(uint64_t us) {
+    world.run_until(world.now_us() + us);
+  }
+
+public:
+  static constexpr uint32_t SIM_INPUT   = 0x01;
+  static constexpr uint32_t SIM_OUTPUT  = 0x03;
+  static constexpr uint32_t SIM_LOW     = 0x0;
+  static constexpr uint32_t SIM_HIGH    = 0x1;
+  static constexpr uint32_t SIM_RISING  = 0x01;
+  static constexpr uint32_t SIM_FALLING = 0x02;
+
+  SimHal(World &world, Llcc68 &chip, pins_t pins = {})
+      : RadioLibHal(SIM_INPUT, SIM_OUTPUT, SIM_LOW, SIM_HIGH, SIM_RISING, SIM_FALLING),
+        world(world), chip(chip), pins(pins) {
+  }
+
+  [[nodiscard]] const pins_t &get_pins() const {
+    return pins;
+  }
+
+  void pinMode(uint32_t, uint32_t) override {
+  }
+
+  void digitalWrite(uint32_t pin, uint32_t value) override {
+    if (pin == RADIOLIB_NC) {
+      return;
+    }
+    if (pin == pins.nss) {
+      value == SIM_LOW ? chip.select() : chip.deselect();
+    } else if (pin == pins.rst && value == SIM_LOW) {
+      chip.reset();
+    }
+  }
+
+  uint32_t digitalRead(uint32_t pin) override {
+    if (pin == pins.busy) {
+      return chip.busy() ? SIM_HIGH : SIM_LOW;
+    }
+    if (pin == pins.dio1) {
+      return chip.dio1() ? SIM_HIGH : SIM_LOW;
+    }
+    return SIM_LOW;
+  }
+
+  /**
+   * @note called from the world, i.e. where an ISR would preempt the task
+   */
+  void attachInterrupt(uint32_t interruptNum, void (*interruptCb)(), uint32_t) override {
+    if (interruptNum != pins.dio1) {
+      return;
+    }
+    dio1_cb      = interruptCb;
+    chip.on_dio1 = [this] {
+      if (dio1_cb != nullptr) {
+        dio1_cb();
+      }
+    };
+  }
+
+  void detachInterrupt(uint32_t interruptNum) override {
+    if (interruptNum == pins.dio1) {
+      dio1_cb      = nullptr;
+      chip.on_dio1 = nullptr;
+    }
+  }
+
+  void delay(unsigned long ms) override {
+    run_for(uint64_t{ms} * 1000);
+  }
+
+  void delayMicroseconds(unsigned long us) override {
+    run_for(us);
+  }
+
+  unsigned long millis() override {
+    return static_cast<unsigned long>(world.now_us() / 1000);
+  }
+
+  unsigned long micros() override {
+    return static_cast<unsigned long>(world.now_us());
+  }
+
+  long pulseIn(uint32_t pin, uint32_t state, unsigned long timeout) override {
+    const auto start = world.now_us();
+    while (digitalRead(pin) == state) {
+      if (world.now_us() - start > timeout) {
+        return 0;
+      }
+      run_for(YIELD_US);
+    }
+    return static_cast<long>(world.now_us() - start);
+  }
+
+  void spiBegin() override {
+  }
+
+  void spiBeginTransaction() override {
+  }
+
+  void spiTransfer(uint8_t *out, size_t len, uint8_t *in) override {
+    for (size_t i = 0; i < len; ++i) {
+      in[i] = chip.exchange(out[i]);
+    }
+  }
+
+  void spiEndTransaction() override {
+  }
+
+  void spiEnd() override {
+  }
+
+  void yield() override {
+    run_for(YIELD_US);
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_SIM_HAL_H
@@ -0,0 +1,38 @@
+// sim_run <script> [key=value...]
+//
+// Runs a scenario (see `scenario.h`) and prints its metrics; fails if an
+// expectation of the script doesn't hold.
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "scenario.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <script> [key=value...]\n", argv[0]);
+    return 2;
+  }
+  auto in = std::ifstream{argv[1]};
+  if (!in) {
+    std::fprintf(stderr, "cannot open %s\n", argv[1]);
+    return 2;
+  }
+  auto error    = std::string{};
+  auto scenario = sim::parse_scenario(in, error);
+  if (!scenario) {
+    std::fprintf(stderr, "%s: %s\n", argv[1], error.c_str());
+    return 2;
+  }
+  for (int i = 2; i < argc; ++i) {
+    const auto arg = std::string{argv[i]};
+    const auto eq  = arg.find('=');
+    const auto e   = eq == std::string::npos ? "expected key=value: " + arg : scenario->set(arg.substr(0, eq), arg.substr(eq + 1));
+    if (!e.empty()) {
+      std::fprintf(stderr, "%s\n", e.c_str());
+      return 2;
+    }
+  }
+  const auto metrics = sim::run_scenario(*scenario);
+  return sim::report(*scenario, metrics, std::cout) ? 0 : 1;
+}
@@ -0,0 +1,31 @@
+#!/bin/sh
+# sweep.sh <sim_run> [script] [key=value...]
+#
+# The delivery ratio of the heart rates against the number of repeaters, sent
+# in the TDMA slots and after random delays as before them (`slotted = off`).
+# The script defaults to baseline.sim, whose expectations are not checked;
+# the settings given override it, e.g. `duration_s=1800`.
+set -e
+
+sim_run=${1:?usage: $0 <sim_run> [script] [key=value...]}
+shift
+script=$(dirname "$0")/scenarios/baseline.sim
+if [ $# -gt 0 ] && [ "${1#*=}" = "$1" ]; then
+  script=$1
+  shift
+fi
+
+metric() {
+  awk -v name="$1" '$1 == name { print $2 }'
+}
+
+printf '%-10s %14s %14s %16s %16s\n' repeaters slotted_pct random_pct slotted_coll_pct random_coll_pct
+for n in ${REPEATERS:-4 8 16 24 32 48 64}; do
+  slotted=$("$sim_run" "$script" "$@" repeaters="$n" slotted=on || true)
+  random=$("$sim_run" "$script" "$@" repeaters="$n" slotted=off || true)
+  printf '%-10s %14.2f %14.2f %16.2f %16.2f\n' "$n" \
+    "$(echo "$slotted" | metric hr_loss_pct | awk '{ print 100 - $1 }')" \
+    "$(echo "$random" | metric hr_loss_pct | awk '{ print 100 - $1 }')" \
+    "$(echo "$slotted" | metric collided_pct)" \
+    "$(echo "$random" | metric collided_pct)"
+done
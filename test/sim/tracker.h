@@ -0,0 +1,113 @@
+#ifndef BLE_LORA_ADAPTER_SIM_TRACKER_H
+#define BLE_LORA_ADAPTER_SIM_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief the ground truth of the samples: when each one is taken by a
+ *        monitor, which frames carry it, and when (if ever) it reaches
+ *        the gateway
+ *
+ * A repeater tells which samples a frame carries when it marshals it; the
+ * gateway tells when it decodes a frame. Frames are told apart by their bytes.
+ */
+namespace sim {
+enum class series : uint8_t {
+  hr,
+  rr,
+};
+
+class Tracker {
+public:
+  struct sample_t {
+    uint64_t taken_us;
+    /**
+     * @brief 0 if not delivered
+     */
+    uint64_t delivered_us = 0;
+  };
+  struct id_t {
+    uint32_t device;
+    series kind;
+    uint32_t index;
+  };
+
+private:
+  struct device_t {
+    std::vector<sample_t> hr;
+    std::vector<sample_t> rr;
+  };
+  struct carried_t {
+    uint64_t at_us;
+    std::vector<id_t> ids;
+  };
+  std::vector<device_t> devices;
+  // by the bytes of the frame
+  std::map<std::string, std::deque<carried_t>> frames;
+
+  std::vector<sample_t> &of(uint32_t device, series kind) {
+    return kind == series::hr ? devices[device].hr : devices[device].rr;
+  }
+
+  static std::string key_of(std::span<const uint8_t> frame) {
+    return std::string(frame.begin(), frame.end());
+  }
+
+public:
+  uint32_t add_device() {
+    devices.emplace_back();
+    return static_cast<uint32_t>(devices.size() - 1);
+  }
+
+  id_t take(uint32_t device, series kind, uint64_t at_us) {
+    auto &s = of(device, kind);
+    s.push_back(sample_t{.taken_us = at_us});
+    return id_t{.device = device, .kind = kind, .index = static_cast<uint32_t>(s.size() - 1)};
+  }
+
+  /**
+   * @brief `frame` is marshalled with the samples `ids`
+   */
+  void carry(std::span<const uint8_t> frame, std::vector<id_t> ids, uint64_t at_us) {
+    frames[key_of(frame)].push_back(carried_t{.at_us = at_us, .ids = std::move(ids)});
+  }
+
+  /**
+   * @brief `frame` is decoded by the gateway
+   * @return the number of samples delivered for the first time
+   * @note a frame with the same bytes as an earlier one is taken as the latest of them
+   */
+  size_t deliver(std::span<const uint8_t> frame, uint64_t at_us) {
+    const auto it = frames.find(key_of(frame));
+    if (it == frames.end() || it->second.empty()) {
+      return 0;
+    }
+    size_t n = 0;
+    for (const auto &id : it->second.back().ids) {
+      auto &s = of(id.device, id.kind)[id.index];
+      if (s.delivered_us == 0) {
+        s.delivered_us = at_us;
+        n += 1;
+      }
+    }
+    it->second.pop_back();
+    return n;
+  }
+
+  [[nodiscard]] size_t device_count() const {
+    return devices.size();
+  }
+
+  [[nodiscard]] const std::vector<sample_t> &samples(uint32_t device, series kind) const {
+    return kind == series::hr ? devices[device].hr : devices[device].rr;
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_TRACKER_H
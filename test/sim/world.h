@@ -0,0 +1,91 @@
+#ifndef BLE_LORA_ADAPTER_SIM_WORLD_H
+#define BLE_LORA_ADAPTER_SIM_WORLD_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <random>
+#include <vector>
+
+/**
+ * @brief the virtual time of the simulation and the events scheduled on it
+ *
+ * Everything in the simulation (the medium, the radios, the timers of the
+ * firmware) is an event on a single queue, run in the order of time and
+ * then of scheduling. Nothing runs in parallel, so a run is a pure function
+ * of the scenario and the seed, however many nodes there are.
+ */
+namespace sim {
+class World {
+public:
+  using fn_t = std::function<void()>;
+
+private:
+  struct event_t {
+    uint64_t at_us;
+    uint64_t order;
+    fn_t fn;
+  };
+  struct later {
+    bool operator()(const event_t &a, const event_t &b) const {
+      return a.at_us != b.at_us ? a.at_us > b.at_us : a.order > b.order;
+    }
+  };
+  std::priority_queue<event_t, std::vector<event_t>, later> events;
+  uint64_t _now_us = 0;
+  uint64_t order   = 0;
+  std::mt19937 _rng;
+
+public:
+  explicit World(uint32_t seed) : _rng(seed) {}
+
+  [[nodiscard]] uint64_t now_us() const {
+    return _now_us;
+  }
+
+  /**
+   * @brief run `fn` at `at_us`, or now if that's in the past
+   */
+  void at(uint64_t at_us, fn_t fn) {
+    events.push(event_t{.at_us = std::max(at_us, _now_us), .order = order++, .fn = std::move(fn)});
+  }
+
+  void after(uint64_t delay_us, fn_t fn) {
+    at(_now_us + delay_us, std::move(fn));
+  }
+
+  /**
+   * @brief run the events up to and including `until_us`, then set the clock to it
+   * @note could be called from an event (e.g. a blocking call of RadioLib that
+   *       waits for the medium), which runs the events in between first
+   */
+  void run_until(uint64_t until_us) {
+    while (!events.empty() && events.top().at_us <= until_us) {
+      // moved out before running, since `fn` might schedule more
+      auto e = std::move(const_cast<event_t &>(events.top()));
+      events.pop();
+      _now_us = e.at_us;
+      e.fn();
+    }
+    _now_us = std::max(_now_us, until_us);
+  }
+
+  [[nodiscard]] size_t pending() const {
+    return events.size();
+  }
+
+  std::mt19937 &rng() {
+    return _rng;
+  }
+
+  /**
+   * @return uniformly in [0, 1)
+   */
+  double uniform() {
+    return std::uniform_real_distribution<double>{0, 1}(_rng);
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_SIM_WORLD_H
@@ -0,0 +1,214 @@
+/**
+ * @brief the simulated medium, and the scenarios being a function of the seed
+ */
+
+#include <cstdint>
+#include <sstream>
+#include <vector>
+#include "check.h"
+#include "medium.h"
+#include "radio_profile.h"
+#include "scenario.h"
+#include "world.h"
+
+namespace {
+using namespace sim;
+
+struct Sink : Port {
+  std::vector<rx_result> results;
+  void on_rx(const rx_t &rx) override {
+    results.push_back(rx.result);
+  }
+};
+
+// no randomness in the links, so that the power is a function of the distance
+constexpr auto still = medium_config_t{.shadowing_db = 0, .fading_db = 0};
+
+const auto profile = radio_profile::DEFAULT_PROFILE;
+const uint8_t frame[16] = {0x42};
+
+TEST(a_frame_in_range_is_received) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{};
+  const auto na = medium.attach(a, 0, 0);
+  const auto nb = medium.attach(b, 100, 0);
+  medium.listen(nb, profile);
+  const auto end = medium.transmit(na, profile, frame);
+  CHECK(end == radio_profile::time_on_air_us(profile, sizeof(frame)));
+  world.run_until(end);
+  REQUIRE(b.results.size() == 1);
+  CHECK(b.results[0] == rx_result::ok);
+  CHECK(medium.counts(nb)[static_cast<size_t>(fate::ok)] == 1);
+  // half duplex
+  CHECK(a.results.empty());
+}
+
+TEST(a_frame_out_of_range_is_too_weak) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{};
+  const auto na = medium.attach(a, 0, 0);
+  const auto nb = medium.attach(b, 1e6f, 0);
+  medium.listen(nb, profile);
+  world.run_until(medium.transmit(na, profile, frame));
+  CHECK(b.results.empty());
+  CHECK(medium.counts(nb)[static_cast<size_t>(fate::weak)] == 1);
+}
+
+TEST(overlapping_frames_of_the_same_power_collide) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{}, c = Sink{};
+  const auto na = medium.attach(a, -100, 0);
+  const auto nb = medium.attach(b, 0, 0);
+  const auto nc = medium.attach(c, 100, 0);
+  medium.listen(nb, profile);
+  const auto end = medium.transmit(na, profile, frame);
+  // in the payload of the first one
+  world.run_until(end / 2);
+  world.run_until(medium.transmit(nc, profile, frame));
+  REQUIRE(b.results.size() == 1);
+  CHECK(b.results[0] == rx_result::crc_error);
+  // the second one starts while the first is being received
+  CHECK(medium.counts(nb)[static_cast<size_t>(fate::busy)] == 1);
+  CHECK(medium.counts(nb)[static_cast<size_t>(fate::collided)] == 1);
+}
+
+TEST(a_much_stronger_frame_is_captured) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{}, c = Sink{};
+  const auto na = medium.attach(a, -10, 0);
+  const auto nb = medium.attach(b, 0, 0);
+  const auto nc = medium.attach(c, 1000, 0);
+  medium.listen(nb, profile);
+  const auto end = medium.transmit(na, profile, frame);
+  medium.transmit(nc, profile, frame);
+  world.run_until(end);
+  REQUIRE(!b.results.empty());
+  CHECK(b.results[0] == rx_result::ok);
+}
+
+TEST(another_channel_does_not_interfere) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{}, c = Sink{};
+  const auto na = medium.attach(a, -100, 0);
+  const auto nb = medium.attach(b, 0, 0);
+  const auto nc = medium.attach(c, 100, 0);
+  medium.listen(nb, profile);
+  auto other     = profile;
+  other.freq_mhz = profile.freq_mhz + 0.5f;
+  const auto end = medium.transmit(na, profile, frame);
+  medium.transmit(nc, other, frame);
+  world.run_until(end);
+  REQUIRE(b.results.size() == 1);
+  CHECK(b.results[0] == rx_result::ok);
+}
+
+TEST(a_node_that_stops_listening_loses_the_frame) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{};
+  const auto na = medium.attach(a, 0, 0);
+  const auto nb = medium.attach(b, 100, 0);
+  medium.listen(nb, profile);
+  const auto end = medium.transmit(na, profile, frame);
+  world.run_until(end / 2);
+  medium.idle(nb);
+  world.run_until(end);
+  CHECK(b.results.empty());
+  CHECK(medium.counts(nb)[static_cast<size_t>(fate::deaf)] == 1);
+}
+
+TEST(cad_detects_a_preamble) {
+  auto world  = World{1};
+  auto medium = Medium{world, still};
+  auto a = Sink{}, b = Sink{};
+  const auto na = medium.attach(a, 0, 0);
+  const auto nb = medium.attach(b, 100, 0);
+  CHECK(!medium.cad(nb, profile, 0));
+  medium.transmit(na, profile, frame);
+  const auto t_sym = radio_profile::symbol_time_us(profile);
+  world.run_until(2 * t_sym);
+  CHECK(medium.cad(nb, profile, 0));
+  auto other     = profile;
+  other.freq_mhz = profile.freq_mhz + 0.5f;
+  CHECK(!medium.cad(nb, other, 0));
+}
+
+TEST(the_world_runs_in_order_of_time_then_of_scheduling) {
+  auto world = World{1};
+  auto order = std::vector<int>{};
+  world.at(20, [&] { order.push_back(2); });
+  world.at(10, [&] {
+    order.push_back(1);
+    world.after(10, [&] { order.push_back(3); });
+  });
+  world.run_until(15);
+  CHECK(world.now_us() == 15);
+  world.run_until(100);
+  CHECK((order == std::vector<int>{1, 2, 3}));
+}
+
+TEST(a_scenario_is_a_function_of_the_seed) {
+  auto in       = std::istringstream{"repeaters = 4\nduration_s = 120\nwarmup_s = 20\n"};
+  auto error    = std::string{};
+  auto scenario = parse_scenario(in, error);
+  REQUIRE(scenario.has_value());
+  const auto a = run_scenario(*scenario);
+  const auto b = run_scenario(*scenario);
+  CHECK(a == b);
+  CHECK(a.at("hr_loss_pct") < 100);
+  scenario->seed = 2;
+  CHECK(run_scenario(*scenario) != a);
+}
+
+TEST(lbt_reduces_the_collisions_of_repeaters_sharing_a_slot) {
+  auto in       = std::istringstream{"repeaters = 8\nslot_count = 4\narea_m = 100\nduration_s = 600\n"};
+  auto error    = std::string{};
+  auto scenario = parse_scenario(in, error);
+  REQUIRE(scenario.has_value());
+  // a few seeds, since the placement and the clocks of a single one may favour either
+  auto mean = [&](bool lbt, const char *metric) {
+    double sum = 0;
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+      scenario->seed = seed;
+      scenario->lbt  = lbt;
+      sum += run_scenario(*scenario).at(metric);
+    }
+    return sum / 5;
+  };
+  CHECK(mean(true, "collided_pct") < 0.75 * mean(false, "collided_pct"));
+  CHECK(mean(true, "hr_loss_pct") < 0.75 * mean(false, "hr_loss_pct"));
+}
+
+TEST(slots_deliver_more_than_random_delays) {
+  // what the repeaters did before the slots, with the same frames (see test/sim/sweep.sh)
+  auto in       = std::istringstream{"repeaters = 16\nduration_s = 300\n"};
+  auto error    = std::string{};
+  auto scenario = parse_scenario(in, error);
+  REQUIRE(scenario.has_value());
+  const auto slotted = run_scenario(*scenario);
+  scenario->slotted  = false;
+  const auto random  = run_scenario(*scenario);
+  CHECK(slotted.at("collided_pct") < 1 && random.at("collided_pct") > 5);
+  CHECK(slotted.at("hr_loss_pct") < 1 && random.at("hr_loss_pct") > 10);
+}
+
+TEST(a_malformed_script_is_rejected) {
+  auto error = std::string{};
+  for (const auto *script : {"repeaters = many\n", "what = 1\n", "at soon gateway off\n", "expect hr_loss_pct ~ 1\n", "hello\n"}) {
+    auto in = std::istringstream{script};
+    CHECK(!parse_scenario(in, error).has_value());
+    CHECK(!error.empty());
+  }
+  auto in = std::istringstream{"# a comment\n\nlbt = off # and another\nat 10 loss 0.5\nexpect hr_loss_pct <= 60\n"};
+  const auto s = parse_scenario(in, error);
+  REQUIRE(s.has_value());
+  CHECK(!s->lbt);
+  CHECK(s->events.size() == 1);
+  CHECK(s->expects.size() == 1);
+}
+}
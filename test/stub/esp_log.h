@@ -0,0 +1,34 @@
+#ifndef BLE_LORA_ADAPTER_TEST_STUB_ESP_LOG_H
+#define BLE_LORA_ADAPTER_TEST_STUB_ESP_LOG_H
+
+/**
+ * @brief ESP_LOGx for the host build
+ *
+ * Only errors and warnings are printed (to stderr), so that the fuzzers and
+ * benchmarks stay quiet. The format is not checked, since the firmware's
+ * `%lu` for `uint32_t` is right on the target and wrong on a 64-bit host.
+ */
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace esp_log_stub {
+inline void write(char level, const char *tag, const char *fmt, ...) {
+  std::va_list args;
+  va_start(args, fmt);
+  std::fprintf(stderr, "%c (%s) ", level, tag);
+  std::vfprintf(stderr, fmt, args);
+  std::fputc('\n', stderr);
+  va_end(args);
+}
+// never called; only keeps the arguments "used"
+int discard(const char *fmt, ...);
+}
+
+#define ESP_LOGE(tag, fmt, ...) esp_log_stub::write('E', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) esp_log_stub::write('W', tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ((void)(tag), (void)sizeof(esp_log_stub::discard(fmt, ##__VA_ARGS__)))
+#define ESP_LOGD(tag, fmt, ...) ((void)(tag), (void)sizeof(esp_log_stub::discard(fmt, ##__VA_ARGS__)))
+#define ESP_LOGV(tag, fmt, ...) ((void)(tag), (void)sizeof(esp_log_stub::discard(fmt, ##__VA_ARGS__)))
+
+#endif // BLE_LORA_ADAPTER_TEST_STUB_ESP_LOG_H
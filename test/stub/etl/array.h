@@ -0,0 +1,14 @@
+#ifndef BLE_LORA_ADAPTER_TEST_STUB_ETL_ARRAY_H
+#define BLE_LORA_ADAPTER_TEST_STUB_ETL_ARRAY_H
+
+/**
+ * @brief `etl::array` for the host build when the ETL submodule is not checked out
+ */
+
+#include <array>
+
+namespace etl {
+using std::array;
+}
+
+#endif // BLE_LORA_ADAPTER_TEST_STUB_ETL_ARRAY_H
@@ -0,0 +1,18 @@
+#ifndef BLE_LORA_ADAPTER_TEST_STUB_ETL_OPTIONAL_H
+#define BLE_LORA_ADAPTER_TEST_STUB_ETL_OPTIONAL_H
+
+/**
+ * @brief the subset of `etl::optional` used by the firmware, for the host build
+ *        when the ETL submodule is not checked out
+ */
+
+#include <optional>
+
+namespace etl {
+using std::make_optional;
+using std::nullopt;
+using std::nullopt_t;
+using std::optional;
+}
+
+#endif // BLE_LORA_ADAPTER_TEST_STUB_ETL_OPTIONAL_H
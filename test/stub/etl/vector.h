@@ -0,0 +1,91 @@
+#ifndef BLE_LORA_ADAPTER_TEST_STUB_ETL_VECTOR_H
+#define BLE_LORA_ADAPTER_TEST_STUB_ETL_VECTOR_H
+
+/**
+ * @brief the subset of `etl::vector` used by the firmware, for the host build
+ *        when the ETL submodule is not checked out
+ * @note going past the capacity is an assertion failure here, where ETL
+ *       would be undefined behaviour (or an error, with `ETL_CHECK_PUSH_POP`)
+ */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+namespace etl {
+template <typename T, size_t N>
+class vector {
+  std::array<T, N> _data{};
+  size_t _size = 0;
+
+public:
+  using value_type     = T;
+  using size_type      = size_t;
+  using iterator       = T *;
+  using const_iterator = const T *;
+
+  constexpr vector() = default;
+
+  [[nodiscard]] constexpr size_t size() const { return _size; }
+  [[nodiscard]] constexpr bool empty() const { return _size == 0; }
+  [[nodiscard]] constexpr bool full() const { return _size == N; }
+  [[nodiscard]] static constexpr size_t max_size() { return N; }
+  [[nodiscard]] static constexpr size_t capacity() { return N; }
+  [[nodiscard]] constexpr size_t available() const { return N - _size; }
+
+  constexpr T *data() { return _data.data(); }
+  constexpr const T *data() const { return _data.data(); }
+  constexpr iterator begin() { return _data.data(); }
+  constexpr iterator end() { return _data.data() + _size; }
+  constexpr const_iterator begin() const { return _data.data(); }
+  constexpr const_iterator end() const { return _data.data() + _size; }
+
+  constexpr T &operator[](size_t i) {
+    assert(i < _size);
+    return _data[i];
+  }
+  constexpr const T &operator[](size_t i) const {
+    assert(i < _size);
+    return _data[i];
+  }
+  constexpr T &front() { return (*this)[0]; }
+  constexpr const T &front() const { return (*this)[0]; }
+  constexpr T &back() { return (*this)[_size - 1]; }
+  constexpr const T &back() const { return (*this)[_size - 1]; }
+
+  constexpr void clear() { _size = 0; }
+  constexpr void resize(size_t n) {
+    assert(n <= N);
+    std::fill(_data.begin() + _size, _data.begin() + std::max(n, _size), T{});
+    _size = n;
+  }
+  constexpr void push_back(const T &v) {
+    assert(_size < N);
+    _data[_size++] = v;
+  }
+  template <typename... Args>
+  constexpr T &emplace_back(Args &&...args) {
+    assert(_size < N);
+    _data[_size] = T{std::forward<Args>(args)...};
+    return _data[_size++];
+  }
+  constexpr void pop_back() {
+    assert(_size > 0);
+    _size -= 1;
+  }
+  constexpr iterator erase(iterator it) {
+    assert(it >= begin() && it < end());
+    std::move(it + 1, end(), it);
+    _size -= 1;
+    return it;
+  }
+
+  friend constexpr bool operator==(const vector &a, const vector &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+};
+}
+
+#endif // BLE_LORA_ADAPTER_TEST_STUB_ETL_VECTOR_H